@@ -9,6 +9,8 @@
 #include <string>
 #include <vector>
 
+#include "include/allowance_tracker.h"
+
 using json = nlohmann::json;
 
 // HTTP Client for blockchain interactions
@@ -41,6 +43,11 @@ public:
             curl_easy_cleanup(curl);
     }
 
+    const std::string &getUrl() const
+    {
+        return rpc_url;
+    }
+
     json call(const std::string &method, const json &params)
     {
         json request = {{"jsonrpc", "2.0"}, {"method", method}, {"params", params}, {"id", 1}};
@@ -329,6 +336,9 @@ private:
     std::unique_ptr<CurveMetaRegistry> registry;
     std::string user_address;
     std::string private_key;
+    // The tracker's worker approves on its own connection; a CURL handle is single-threaded
+    std::unique_ptr<EthereumRPC> approval_rpc;
+    std::unique_ptr<AllowanceTracker> allowances;
 
 public:
     CurveSwapper(EthereumRPC *ethereum_rpc, const std::string &user_addr, const std::string &priv_key)
@@ -338,6 +348,27 @@ public:
         // Initialize Meta Registry
         const std::string METAREGISTRY = "0xF98B45FA17DE75FB1aD0e7aFD971b0ca00e379fC";
         registry = std::make_unique<CurveMetaRegistry>(METAREGISTRY, rpc);
+
+        // Approvals are sent from the tracker's background worker, not from the swap path
+        approval_rpc = std::make_unique<EthereumRPC>(rpc->getUrl());
+        allowances = std::make_unique<AllowanceTracker>(
+            [this](const std::string &token, const std::string &spender, uint64_t amount)
+            {
+                return ERC20Token(token, approval_rpc.get()).approve(spender, amount, private_key);
+            });
+    }
+
+    // Pre-approve the pool for an upcoming swap so the fill itself needs no approve
+    std::string prepareSwap(const std::string &from_token_addr, const std::string &to_token_addr, uint64_t amount)
+    {
+        std::string pool_addr = registry->find_pool_for_coins(from_token_addr, to_token_addr);
+        if (pool_addr.empty())
+        {
+            throw std::runtime_error("No pool found for token pair");
+        }
+
+        allowances->reserve(from_token_addr, pool_addr, amount);
+        return pool_addr;
     }
 
     // Method 1: Traditional exchange with approval
@@ -377,13 +408,23 @@ public:
         std::cout << "Expected output: " << expected_output << std::endl;
         std::cout << "Minimum output (with slippage): " << min_output << std::endl;
 
-        // 5. Approve pool to spend tokens
-        std::string approve_tx = from_token.approve(pool_addr, amount, private_key);
-        std::cout << "Approval transaction: " << approve_tx << std::endl;
+        // 5. Make sure the pool can spend our tokens (normally pre-approved by prepareSwap)
+        if (!allowances->canSpend(from_token_addr, pool_addr, amount))
+        {
+            std::cout << "Allowance not pre-approved; waiting for background approval" << std::endl;
+            allowances->reserve(from_token_addr, pool_addr, amount);
+            allowances->waitIdle(std::chrono::seconds(30));
+            if (!allowances->canSpend(from_token_addr, pool_addr, amount))
+            {
+                throw std::runtime_error("Approval for pool did not complete");
+            }
+        }
+        std::cout << "Approval transaction: " << allowances->getLastApproveTx(from_token_addr, pool_addr) << std::endl;
 
         // 6. Execute exchange
         std::string swap_tx = pool.exchange(0, 1, amount, min_output, user_address, private_key);
         std::cout << "Swap transaction: " << swap_tx << std::endl;
+        allowances->recordSpend(from_token_addr, pool_addr, amount);
 
         return swap_tx;
     }
@@ -526,6 +567,7 @@ int main()
         // Example 1: Simple USDC -> WETH swap with approval
         try
         {
+            swapper.prepareSwap(USDC, WETH, amount);
             std::string tx1 = swapper.swapWithApproval(USDC, WETH, amount);
             std::cout << "\nFinal transaction hash: " << tx1 << std::endl;
         }
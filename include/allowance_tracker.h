@@ -0,0 +1,309 @@
+#ifndef ALLOWANCE_TRACKER_H
+#define ALLOWANCE_TRACKER_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <iostream>
+
+// Allowance Tracker - caches ERC20 allowances per (token, spender) and tops them up
+// from a background worker so an approve never sits on the order fill path
+class AllowanceTracker
+{
+public:
+    // Sends approve(spender, amount) on token and returns the transaction hash (throws on failure)
+    using ApproveSender = std::function<std::string(const std::string &token, const std::string &spender, uint64_t amount)>;
+
+    // Reads the current on-chain allowance(owner, spender) for token
+    using AllowanceReader = std::function<uint64_t(const std::string &token, const std::string &spender)>;
+
+    // Approve for this multiple of the committed amount so repeated fills don't re-approve every time
+    static constexpr uint64_t DEFAULT_HEADROOM = 4;
+
+private:
+    struct Entry
+    {
+        uint64_t allowance = 0;     // Last known (or optimistically assumed) allowance
+        uint64_t committed = 0;     // Amount resting orders expect to spend
+        bool known = false;         // Allowance has been read from chain or set explicitly
+        bool topup_pending = false; // A top-up is queued or in flight
+        std::string last_approve_tx;
+    };
+
+    ApproveSender approve_sender;
+    AllowanceReader allowance_reader;
+    uint64_t headroom;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::map<std::string, Entry> entries;
+    std::deque<std::string> queue;
+    uint64_t epoch = 0; // Bumped by forgetAll(); a top-up that straddles it is redone
+    bool worker_busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    static std::string normalize(const std::string &address)
+    {
+        std::string lower = address;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return lower;
+    }
+
+    static std::string makeKey(const std::string &token, const std::string &spender)
+    {
+        return normalize(token) + ":" + normalize(spender);
+    }
+
+    static uint64_t saturatingMul(uint64_t value, uint64_t factor)
+    {
+        if (factor != 0 && value > std::numeric_limits<uint64_t>::max() / factor)
+            return std::numeric_limits<uint64_t>::max();
+        return value * factor;
+    }
+
+    // Queue a top-up if the allowance no longer covers committed spend (mutex must be held)
+    void scheduleIfNeeded(const std::string &key, Entry &entry)
+    {
+        if (entry.topup_pending)
+            return;
+        if (entry.known && entry.allowance >= entry.committed)
+            return;
+
+        entry.topup_pending = true;
+        queue.push_back(key);
+        work_cv.notify_one();
+    }
+
+    // The entry was forgotten mid top-up: drop what was learned and queue it afresh (mutex must be held)
+    void redo(const std::string &key, Entry &entry)
+    {
+        entry.topup_pending = false;
+        if (entry.committed > 0)
+            scheduleIfNeeded(key, entry);
+    }
+
+    void processEntry(const std::string &key)
+    {
+        std::string token = key.substr(0, key.find(':'));
+        std::string spender = key.substr(key.find(':') + 1);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        Entry &entry = entries[key];
+        const uint64_t started = epoch;
+
+        // Refresh from chain first: a previous approval may already cover us
+        if (!entry.known && allowance_reader)
+        {
+            lock.unlock();
+            uint64_t on_chain = 0;
+            bool read_ok = true;
+            try
+            {
+                on_chain = allowance_reader(token, spender);
+            }
+            catch (const std::exception &e)
+            {
+                read_ok = false;
+                std::cerr << "⚠️ Allowance read failed for " << token << ": " << e.what() << std::endl;
+            }
+            lock.lock();
+            if (epoch != started)
+            {
+                redo(key, entry);
+                return;
+            }
+            if (read_ok)
+            {
+                entry.allowance = on_chain;
+                entry.known = true;
+            }
+        }
+
+        if (entry.known && entry.allowance >= entry.committed)
+        {
+            entry.topup_pending = false;
+            return;
+        }
+
+        uint64_t target = saturatingMul(entry.committed, headroom);
+        lock.unlock();
+
+        std::string tx_hash;
+        bool sent = false;
+        try
+        {
+            std::cout << "🔓 Pre-approving " << target << " of " << token << " for " << spender << std::endl;
+            tx_hash = approve_sender(token, spender, target);
+            sent = true;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Background approval failed for " << token << ": " << e.what() << std::endl;
+        }
+
+        lock.lock();
+        if (epoch != started)
+        {
+            redo(key, entry);
+            return;
+        }
+        entry.topup_pending = false;
+        if (sent)
+        {
+            // Optimistic: the approve is broadcast ahead of the swap and lands first by nonce order
+            entry.allowance = std::max(entry.allowance, target);
+            entry.known = true;
+            entry.last_approve_tx = tx_hash;
+        }
+    }
+
+    void workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            work_cv.wait(lock, [this]
+                         { return stopping || !queue.empty(); });
+            if (stopping)
+                break;
+
+            std::string key = queue.front();
+            queue.pop_front();
+            worker_busy = true;
+            lock.unlock();
+
+            processEntry(key);
+
+            lock.lock();
+            worker_busy = false;
+            if (queue.empty())
+                idle_cv.notify_all();
+        }
+        idle_cv.notify_all();
+    }
+
+public:
+    AllowanceTracker(ApproveSender sender,
+                     AllowanceReader reader = nullptr,
+                     uint64_t approval_headroom = DEFAULT_HEADROOM)
+        : approve_sender(std::move(sender)),
+          allowance_reader(std::move(reader)),
+          headroom(std::max<uint64_t>(approval_headroom, 1))
+    {
+        worker = std::thread(&AllowanceTracker::workerLoop, this);
+    }
+
+    ~AllowanceTracker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    AllowanceTracker(const AllowanceTracker &) = delete;
+    AllowanceTracker &operator=(const AllowanceTracker &) = delete;
+
+    // Seed a known allowance (e.g. read at startup or after an external approve)
+    void setAllowance(const std::string &token, const std::string &spender, uint64_t amount)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry &entry = entries[makeKey(token, spender)];
+        entry.allowance = amount;
+        entry.known = true;
+    }
+
+    // Register spend an order will need; queues a background top-up if required
+    void reserve(const std::string &token, const std::string &spender, uint64_t amount)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string key = makeKey(token, spender);
+        Entry &entry = entries[key];
+        entry.committed = entry.committed > std::numeric_limits<uint64_t>::max() - amount
+                              ? std::numeric_limits<uint64_t>::max()
+                              : entry.committed + amount;
+        scheduleIfNeeded(key, entry);
+    }
+
+    // Drop spend an order no longer needs (canceled, expired, failed)
+    void release(const std::string &token, const std::string &spender, uint64_t amount)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry &entry = entries[makeKey(token, spender)];
+        entry.committed -= std::min(entry.committed, amount);
+    }
+
+    // Hot path: does the cached allowance cover this fill? Never does I/O
+    bool canSpend(const std::string &token, const std::string &spender, uint64_t amount) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(makeKey(token, spender));
+        return it != entries.end() && it->second.known && it->second.allowance >= amount;
+    }
+
+    // Account for a completed fill and keep the remaining allowance topped up
+    void recordSpend(const std::string &token, const std::string &spender, uint64_t amount)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string key = makeKey(token, spender);
+        Entry &entry = entries[key];
+        entry.allowance -= std::min(entry.allowance, amount);
+        entry.committed -= std::min(entry.committed, amount);
+        scheduleIfNeeded(key, entry);
+    }
+
+    // Drop every cached allowance so each is read from chain again, e.g. when the ones so far
+    // came from mock approvals. Committed spend is kept and re-queued.
+    void forgetAll()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++epoch;
+        for (auto &[key, entry] : entries)
+        {
+            entry.allowance = 0;
+            entry.known = false;
+            entry.last_approve_tx.clear();
+            if (entry.committed > 0)
+                scheduleIfNeeded(key, entry);
+        }
+    }
+
+    uint64_t getAllowance(const std::string &token, const std::string &spender) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(makeKey(token, spender));
+        return it == entries.end() ? 0 : it->second.allowance;
+    }
+
+    std::string getLastApproveTx(const std::string &token, const std::string &spender) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(makeKey(token, spender));
+        return it == entries.end() ? std::string() : it->second.last_approve_tx;
+    }
+
+    // Block until queued top-ups have been processed (startup warm-up, tests, shutdown)
+    bool waitIdle(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return idle_cv.wait_for(lock, timeout, [this]
+                                { return stopping || (queue.empty() && !worker_busy); });
+    }
+};
+
+#endif // ALLOWANCE_TRACKER_H
@@ -0,0 +1,275 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <map>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+
+// A request refused without being sent because its provider's circuit is open
+class CircuitOpen : public std::runtime_error
+{
+public:
+    explicit CircuitOpen(const std::string &what) : std::runtime_error(what) {}
+};
+
+// Circuit Breaker - one per provider, shared by every connection to it. FAILURE_THRESHOLD
+// provider failures in a row open the circuit: requests are refused at once instead of piling
+// onto a failing endpoint. After a cooldown (doubling each time it reopens, up to a cap) it
+// half-opens and lets probes through, one at a time at first, then twice as many with each
+// success; PROBES_TO_CLOSE successes close it, any failure reopens it. Listeners hear every
+// state change, outside the lock. Thread-safe.
+class CircuitBreaker
+{
+public:
+    enum class State
+    {
+        CLOSED,   // Normal
+        OPEN,     // Refusing requests until the cooldown ends
+        HALF_OPEN // Letting a growing number of probes through
+    };
+
+    // How a request was let through; hand it back to record() or release()
+    enum class Admission
+    {
+        DENIED,
+        ALLOWED,
+        PROBE
+    };
+
+    using Listener = std::function<void(const std::string &endpoint, State from, State to)>;
+
+    static constexpr int FAILURE_THRESHOLD = 5;
+    static constexpr int PROBES_TO_CLOSE = 7; // 1 + 2 + 4 probes
+    static constexpr std::chrono::milliseconds OPEN_BASE{1000};
+    static constexpr std::chrono::milliseconds OPEN_MAX{30000};
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string endpoint;
+    std::chrono::milliseconds open_base;
+    std::chrono::milliseconds open_max;
+    mutable std::mutex mutex;
+    State state = State::CLOSED;
+    int consecutive_failures = 0;
+    int trips = 0; // Opens since the circuit was last closed
+    Clock::time_point reopen_at;
+    int probe_window = 1;
+    int probes_in_flight = 0;
+    int probe_successes = 0;
+    uint64_t opened = 0;
+    uint64_t denied = 0;
+    std::map<size_t, Listener> listeners;
+    size_t next_listener = 1;
+
+    struct Transition
+    {
+        State from;
+        State to;
+    };
+
+    // Caller holds the mutex
+    Transition moveTo(State next, Clock::time_point now)
+    {
+        Transition change{state, next};
+        state = next;
+        if (next == State::OPEN)
+        {
+            trips++;
+            opened++;
+            auto cooldown = open_base;
+            for (int k = 1; k < trips && cooldown < open_max; ++k)
+                cooldown *= 2;
+            reopen_at = now + std::min(cooldown, open_max);
+        }
+        else if (next == State::HALF_OPEN)
+        {
+            probe_window = 1;
+            probes_in_flight = 0;
+            probe_successes = 0;
+        }
+        else
+        {
+            trips = 0;
+            consecutive_failures = 0;
+        }
+        return change;
+    }
+
+    void announce(const std::vector<Transition> &changes)
+    {
+        if (changes.empty())
+            return;
+        std::vector<Listener> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto &[id, listener] : listeners)
+                targets.push_back(listener);
+        }
+        for (const Transition &change : changes)
+        {
+            for (const Listener &listener : targets)
+                listener(endpoint, change.from, change.to);
+        }
+    }
+
+public:
+    explicit CircuitBreaker(const std::string &name, std::chrono::milliseconds cooldown = OPEN_BASE,
+                            std::chrono::milliseconds max_cooldown = OPEN_MAX)
+        : endpoint(name), open_base(cooldown), open_max(max_cooldown) {}
+
+    // May a request go out now? DENIED means don't send it.
+    Admission admit()
+    {
+        std::vector<Transition> changes;
+        Admission admission = Admission::ALLOWED;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Clock::time_point now = Clock::now();
+            if (state == State::OPEN && now >= reopen_at)
+                changes.push_back(moveTo(State::HALF_OPEN, now));
+
+            if (state == State::OPEN)
+            {
+                admission = Admission::DENIED;
+            }
+            else if (state == State::HALF_OPEN)
+            {
+                if (probes_in_flight < probe_window)
+                {
+                    probes_in_flight++;
+                    admission = Admission::PROBE;
+                }
+                else
+                {
+                    admission = Admission::DENIED;
+                }
+            }
+            if (admission == Admission::DENIED)
+                denied++;
+        }
+        announce(changes);
+        return admission;
+    }
+
+    // The request's outcome: `provider_ok` unless the provider itself failed (transport / 5xx)
+    void record(Admission admission, bool provider_ok)
+    {
+        if (admission == Admission::DENIED)
+            return;
+        std::vector<Transition> changes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Clock::time_point now = Clock::now();
+            bool probe = admission == Admission::PROBE && state == State::HALF_OPEN;
+            if (probe)
+                probes_in_flight = std::max(probes_in_flight - 1, 0);
+
+            if (provider_ok)
+            {
+                consecutive_failures = 0;
+                if (probe && ++probe_successes >= PROBES_TO_CLOSE)
+                    changes.push_back(moveTo(State::CLOSED, now));
+                else if (probe && probe_successes >= probe_window)
+                    probe_window *= 2;
+            }
+            else if (state == State::HALF_OPEN && probe)
+            {
+                changes.push_back(moveTo(State::OPEN, now));
+            }
+            else if (state == State::CLOSED && ++consecutive_failures >= FAILURE_THRESHOLD)
+            {
+                changes.push_back(moveTo(State::OPEN, now));
+            }
+        }
+        announce(changes);
+    }
+
+    // A request that never reached the provider (e.g. its deadline passed first)
+    void release(Admission admission)
+    {
+        if (admission != Admission::PROBE)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state == State::HALF_OPEN)
+            probes_in_flight = std::max(probes_in_flight - 1, 0);
+    }
+
+    size_t subscribe(Listener listener)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listeners[next_listener] = std::move(listener);
+        return next_listener++;
+    }
+
+    void unsubscribe(size_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listeners.erase(id);
+    }
+
+    State currentState() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return state;
+    }
+
+    // Open and still cooling down: a request now would be denied
+    bool refusing() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return state == State::OPEN && Clock::now() < reopen_at;
+    }
+
+    uint64_t openCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return opened;
+    }
+
+    // Requests refused without being sent
+    uint64_t deniedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return denied;
+    }
+
+    const std::string &name() const
+    {
+        return endpoint;
+    }
+
+    static const char *stateName(State state)
+    {
+        switch (state)
+        {
+        case State::CLOSED:
+            return "closed";
+        case State::OPEN:
+            return "open";
+        default:
+            return "half-open";
+        }
+    }
+
+    // The breaker for `url`, shared by every connection to it
+    static std::shared_ptr<CircuitBreaker> shared(const std::string &url)
+    {
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::shared_ptr<CircuitBreaker>> registry;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::shared_ptr<CircuitBreaker> &breaker = registry[url];
+        if (!breaker)
+            breaker = std::make_shared<CircuitBreaker>(url);
+        return breaker;
+    }
+};
+
+#endif // CIRCUIT_BREAKER_H
@@ -0,0 +1,206 @@
+#ifndef CRYPTOSWAP_MATH_H
+#define CRYPTOSWAP_MATH_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "pool_state.h"
+
+// CryptoSwap (Curve v2: two-coin and tricrypto) pool state as the contract stores it. Balances
+// are native units; every other coin is priced in coin 0 through price_scale.
+struct CryptoPoolState
+{
+    std::vector<PoolAmount> balances;
+    std::vector<uint64_t> precisions;    // Per-coin multiplier to 18 decimals (10^(18 - decimals))
+    std::vector<PoolAmount> price_scale; // Coin k + 1 in units of coin 0, 1e18 precision
+    PoolAmount D = 0;
+    uint64_t A = 0;         // A * N^N * A_MULTIPLIER, as stored
+    uint64_t gamma = 0;     // 1e18 precision
+    uint64_t mid_fee = 0;   // 1e10 precision, charged at balance
+    uint64_t out_fee = 0;   // 1e10 precision, charged far from balance
+    uint64_t fee_gamma = 0; // 1e18 precision; how fast the fee moves between the two
+    uint64_t block = 0;     // Block the state was read at
+
+    static constexpr uint64_t A_MULTIPLIER = 10000;
+    static constexpr uint64_t FEE_DENOMINATOR = 10000000000ULL;
+};
+
+// CryptoSwap invariant math in long double. With K0 = prod(x) N^N / D^N the contract's
+// invariant is
+//     K D^(N-1) sum(x) + prod(x) = K D^N + (D/N)^N,   K = A K0 gamma^2 / (gamma + 1 - K0)^2
+// newton_D and newton_y are solved here as bracketed root finds on it rather than by porting
+// the contract's integer Newton steps, which stop at ~1e-14 relative; quotes are therefore
+// within uncertainty() of the pool's get_dy, not bit-exact.
+namespace CryptoSwapMath
+{
+    using Real = long double;
+
+    constexpr int MAX_ITERATIONS = 255;
+    constexpr Real PRECISION = 1e18L;
+    constexpr Real CONTRACT_TOLERANCE = 1e-13L; // The contract's own Newton stopping rule, with margin
+
+    // Balances in 18-decimal units of coin 0 (the contract's xp)
+    inline std::vector<Real> scaledBalances(const CryptoPoolState &state, const std::vector<Real> &balances)
+    {
+        std::vector<Real> xp(balances.size());
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            Real precision = k < state.precisions.size() ? static_cast<Real>(state.precisions[k]) : 1.0L;
+            Real scale = k == 0 ? 1.0L : static_cast<Real>(state.price_scale[k - 1]) / PRECISION;
+            xp[k] = balances[k] * precision * scale;
+        }
+        return xp;
+    }
+
+    // The invariant divided through by K D^(N-1): zero on the curve, increasing in any one
+    // balance and decreasing in D
+    inline Real residual(const std::vector<Real> &xp, Real d, Real ann, Real gamma)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real sum = 0;
+        Real k0 = 1;
+        for (Real x : xp)
+        {
+            sum += x;
+            k0 *= x * n / d;
+        }
+        Real g1k0 = gamma + 1 - k0;
+        return sum - d + (k0 - 1) * d * g1k0 * g1k0 / (ann * k0 * gamma * gamma);
+    }
+
+    // Root of f between lo (f <= 0) and hi (f >= 0), by regula falsi with the Illinois tweak
+    template <typename F>
+    inline Real solveBracketed(F f, Real lo, Real hi)
+    {
+        Real f_lo = f(lo), f_hi = f(hi);
+        if (f_lo == 0)
+            return lo;
+        if (f_hi == 0)
+            return hi;
+        int side = 0;
+        Real x = lo;
+        for (int k = 0; k < MAX_ITERATIONS && hi - lo > hi * 1e-19L; ++k)
+        {
+            x = (lo * f_hi - hi * f_lo) / (f_hi - f_lo);
+            if (!(x > lo && x < hi))
+                x = (lo + hi) / 2;
+            Real f_x = f(x);
+            if (f_x == 0)
+                return x;
+            if (f_x < 0)
+            {
+                lo = x;
+                f_lo = f_x;
+                if (side == -1)
+                    f_hi /= 2;
+                side = -1;
+            }
+            else
+            {
+                hi = x;
+                f_hi = f_x;
+                if (side == 1)
+                    f_lo /= 2;
+                side = 1;
+            }
+        }
+        return x;
+    }
+
+    // The contract's newton_D: D for scaled balances xp
+    inline Real newtonD(const std::vector<Real> &xp, Real ann, Real gamma)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real sum = 0, log_product = 0;
+        for (Real x : xp)
+        {
+            if (x <= 0)
+                return 0;
+            sum += x;
+            log_product += std::log(x);
+        }
+        // Between the constant-product D (K0 = 1) and the constant-sum D
+        Real lo = n * std::exp(log_product / n);
+        Real hi = sum;
+        if (hi <= lo)
+            return lo;
+        return solveBracketed([&](Real d)
+                              { return -residual(xp, d, ann, gamma); },
+                              lo * (1 - 1e-15L), hi * (1 + 1e-15L));
+    }
+
+    // The contract's newton_y: balance of coin j that keeps D with the other coins at xp
+    inline Real newtonY(std::vector<Real> xp, Real ann, Real gamma, Real d, size_t j)
+    {
+        auto f = [&](Real y)
+        {
+            xp[j] = y;
+            return residual(xp, d, ann, gamma);
+        };
+        Real hi = d;
+        for (int k = 0; k < 64 && f(hi) < 0; ++k)
+            hi *= 2;
+        Real lo = hi / 2;
+        for (int k = 0; k < 256 && f(lo) > 0; ++k)
+            lo /= 2;
+        return solveBracketed(f, lo, hi);
+    }
+
+    // Dynamic fee (1e10 precision, truncated like the contract's): mid_fee at balance, sliding
+    // to out_fee as xp skews
+    inline Real feeRate(const CryptoPoolState &state, const std::vector<Real> &xp)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real sum = 0;
+        for (Real x : xp)
+            sum += x;
+        Real k = 1;
+        for (Real x : xp)
+            k *= n * x / sum;
+        Real fee_gamma = static_cast<Real>(state.fee_gamma) / PRECISION;
+        Real f = state.fee_gamma > 0 ? fee_gamma / (fee_gamma + 1 - k) : k;
+        return std::floor(static_cast<Real>(state.mid_fee) * f + static_cast<Real>(state.out_fee) * (1 - f));
+    }
+
+    // Output (native units of j, after fee) for dx native units of i, like the pool's get_dy
+    inline Real getDy(const CryptoPoolState &state, size_t i, size_t j, Real dx)
+    {
+        size_t n = state.balances.size();
+        if (i >= n || j >= n || i == j || state.price_scale.size() + 1 < n || state.gamma == 0 || state.A == 0)
+            return 0;
+        std::vector<Real> balances(n);
+        for (size_t k = 0; k < n; ++k)
+            balances[k] = static_cast<Real>(state.balances[k]);
+        Real ann = static_cast<Real>(state.A) / static_cast<Real>(CryptoPoolState::A_MULTIPLIER);
+        Real gamma = static_cast<Real>(state.gamma) / PRECISION;
+        Real d = state.D > 0 ? static_cast<Real>(state.D) : newtonD(scaledBalances(state, balances), ann, gamma);
+
+        balances[i] += dx;
+        std::vector<Real> xp = scaledBalances(state, balances);
+        Real y = newtonY(xp, ann, gamma, d, j);
+        Real dy = xp[j] - y - 1;
+        if (dy <= 0)
+            return 0;
+        xp[j] = y;
+        Real unscale = j == 0 ? 1.0L : PRECISION / static_cast<Real>(state.price_scale[j - 1]);
+        Real precision = j < state.precisions.size() ? static_cast<Real>(state.precisions[j]) : 1.0L;
+        dy = dy * unscale / precision;
+        return dy - dy * feeRate(state, xp) / static_cast<Real>(CryptoPoolState::FEE_DENOMINATOR);
+    }
+
+    // How far the contract's integer get_dy may sit from getDy(): its Newton stopping rule on y,
+    // in native units of j, plus rounding
+    inline Real uncertainty(const CryptoPoolState &state, size_t j)
+    {
+        if (j >= state.balances.size())
+            return 0;
+        Real d = static_cast<Real>(state.D);
+        Real unscale = j == 0 ? 1.0L : PRECISION / static_cast<Real>(state.price_scale[j - 1]);
+        Real precision = j < state.precisions.size() ? static_cast<Real>(state.precisions[j]) : 1.0L;
+        return d * CONTRACT_TOLERANCE * unscale / precision + 2;
+    }
+}
+
+#endif // CRYPTOSWAP_MATH_H
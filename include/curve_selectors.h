@@ -0,0 +1,31 @@
+#ifndef CURVE_SELECTORS_H
+#define CURVE_SELECTORS_H
+
+#include <string>
+
+// Curve Selectors - the 4-byte selectors of the pool calls the agent quotes and swaps through.
+// StableSwap and metapools index coins as int128, CryptoSwap (v2 and tricrypto) as uint256, so
+// the same call has a different selector per family. Only the four-argument exchange forms are
+// used: every pool generation has them and the receiver would be the sender anyway.
+namespace CurveSelectors
+{
+    // get_dy(i, j, dx) quoting an exchange(i, j, dx, min_dy) on the same pool
+    inline std::string getDy(bool cryptoswap, bool underlying)
+    {
+        if (underlying)
+            return "0x07211ef7"; // get_dy_underlying(int128,int128,uint256)
+        return cryptoswap ? "0x556d6e9f"  // get_dy(uint256,uint256,uint256)
+                          : "0x5e0d443f"; // get_dy(int128,int128,uint256)
+    }
+
+    // exchange(i, j, dx, min_dy), or exchange_underlying on a metapool's underlying coins
+    inline std::string exchange(bool cryptoswap, bool underlying)
+    {
+        if (underlying)
+            return "0xa6417ed6"; // exchange_underlying(int128,int128,uint256,uint256)
+        return cryptoswap ? "0x5b41b908"  // exchange(uint256,uint256,uint256,uint256)
+                          : "0x3df02124"; // exchange(int128,int128,uint256,uint256)
+    }
+}
+
+#endif // CURVE_SELECTORS_H
@@ -0,0 +1,283 @@
+#ifndef GAS_MODEL_H
+#define GAS_MODEL_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+#include "sepolia_config.h"
+
+// Gas Model - learns gas used per (pool, method) from past swap receipts and keeps an
+// eth_estimateGas fallback per pool, both maintained off the swap path
+class GasModel
+{
+public:
+    // eth_estimateGas for calldata sent to pool (runs on the model's worker thread)
+    using Estimator = std::function<uint64_t(const std::string &pool, const std::string &calldata)>;
+
+    // Fetch a receipt's gasUsed; returns false while the transaction is still pending. A mined
+    // receipt that shouldn't be learned from (reverted) reports gas_used 0.
+    using ReceiptFetcher = std::function<bool(const std::string &tx_hash, uint64_t &gas_used)>;
+
+    static constexpr uint64_t MIN_SAMPLES = 3;          // Receipts needed before trusting the learned limit
+    static constexpr double STDDEV_MULTIPLIER = 3.0;    // Learned limit covers mean + 3 sigma
+    static constexpr double LEARNED_MARGIN = 0.10;      // Extra headroom on top of the learned limit
+    static constexpr double ESTIMATE_MARGIN = 0.20;     // eth_estimateGas is a point estimate, pad more
+    static constexpr int MAX_RECEIPT_POLLS = 30;         // Give up on a receipt after this many polls
+
+private:
+    struct Stats
+    {
+        uint64_t samples = 0;
+        double mean = 0.0;
+        double m2 = 0.0; // Welford running sum of squared deviations
+        uint64_t max_seen = 0;
+        uint64_t estimate = 0;
+        bool estimate_pending = false;
+    };
+
+    struct EstimateJob
+    {
+        std::string key;
+        std::string pool;
+        std::string calldata;
+    };
+
+    struct ReceiptJob
+    {
+        std::string key;
+        std::string tx_hash;
+        int polls = 0;
+    };
+
+    Estimator estimator;
+    ReceiptFetcher receipt_fetcher;
+    std::chrono::milliseconds receipt_poll_interval;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_cv;
+    std::map<std::string, Stats> stats;
+    std::deque<EstimateJob> estimate_jobs;
+    std::deque<ReceiptJob> receipt_jobs;
+    bool worker_busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    static std::string makeKey(const std::string &pool, const std::string &selector)
+    {
+        std::string key = pool + ":" + selector;
+        std::transform(key.begin(), key.end(), key.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return key;
+    }
+
+    static uint64_t padded(double gas, double margin)
+    {
+        return static_cast<uint64_t>(std::ceil(gas * (1.0 + margin)));
+    }
+
+    void runEstimate(const EstimateJob &job)
+    {
+        uint64_t estimate = 0;
+        try
+        {
+            estimate = estimator(job.pool, job.calldata);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Gas estimate failed for " << job.pool << ": " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats &entry = stats[job.key];
+        entry.estimate_pending = false;
+        if (estimate > 0)
+            entry.estimate = estimate;
+    }
+
+    // Returns true when the job is finished (mined, or given up)
+    bool pollReceipt(ReceiptJob &job)
+    {
+        uint64_t gas_used = 0;
+        bool mined = false;
+        try
+        {
+            mined = receipt_fetcher(job.tx_hash, gas_used);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Receipt fetch failed for " << job.tx_hash << ": " << e.what() << std::endl;
+        }
+
+        if (mined)
+        {
+            if (gas_used > 0)
+                recordSample(job.key, gas_used);
+            return true;
+        }
+        return ++job.polls >= MAX_RECEIPT_POLLS;
+    }
+
+    void recordSample(const std::string &key, uint64_t gas_used)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats &entry = stats[key];
+        entry.samples++;
+        double delta = static_cast<double>(gas_used) - entry.mean;
+        entry.mean += delta / static_cast<double>(entry.samples);
+        entry.m2 += delta * (static_cast<double>(gas_used) - entry.mean);
+        entry.max_seen = std::max(entry.max_seen, gas_used);
+    }
+
+    void workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping)
+        {
+            if (!estimate_jobs.empty())
+            {
+                EstimateJob job = estimate_jobs.front();
+                estimate_jobs.pop_front();
+                worker_busy = true;
+                lock.unlock();
+                runEstimate(job);
+                lock.lock();
+                worker_busy = false;
+                continue;
+            }
+
+            if (!receipt_jobs.empty())
+            {
+                // One pass over the pending receipts, then wait a poll interval
+                std::deque<ReceiptJob> pending;
+                pending.swap(receipt_jobs);
+                worker_busy = true;
+                lock.unlock();
+
+                std::deque<ReceiptJob> still_pending;
+                for (auto &job : pending)
+                {
+                    if (!pollReceipt(job))
+                        still_pending.push_back(job);
+                }
+
+                lock.lock();
+                worker_busy = false;
+                for (auto &job : still_pending)
+                    receipt_jobs.push_back(job);
+                if (!receipt_jobs.empty())
+                {
+                    work_cv.wait_for(lock, receipt_poll_interval, [this]
+                                     { return stopping || !estimate_jobs.empty(); });
+                }
+                continue;
+            }
+
+            work_cv.notify_all();
+            work_cv.wait(lock, [this]
+                         { return stopping || !estimate_jobs.empty() || !receipt_jobs.empty(); });
+        }
+    }
+
+public:
+    GasModel(Estimator estimate_fn,
+             ReceiptFetcher receipt_fn,
+             std::chrono::milliseconds poll_interval = std::chrono::seconds(3))
+        : estimator(std::move(estimate_fn)),
+          receipt_fetcher(std::move(receipt_fn)),
+          receipt_poll_interval(poll_interval)
+    {
+        worker = std::thread(&GasModel::workerLoop, this);
+    }
+
+    ~GasModel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    GasModel(const GasModel &) = delete;
+    GasModel &operator=(const GasModel &) = delete;
+
+    // 4-byte selector of a calldata hex string ("0x" + 8 hex chars)
+    static std::string selectorOf(const std::string &calldata)
+    {
+        return calldata.substr(0, std::min<size_t>(calldata.size(), 10));
+    }
+
+    // Hot path: gas limit for this call from what we already know; never blocks on I/O.
+    // Without history it returns the static limit and queues an async estimate for next time.
+    uint64_t gasLimit(const std::string &pool, const std::string &calldata)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string key = makeKey(pool, selectorOf(calldata));
+        Stats &entry = stats[key];
+
+        if (entry.samples >= MIN_SAMPLES)
+        {
+            double variance = entry.m2 / static_cast<double>(entry.samples - 1);
+            double learned = std::max(static_cast<double>(entry.max_seen),
+                                      entry.mean + STDDEV_MULTIPLIER * std::sqrt(variance));
+            return padded(learned, LEARNED_MARGIN);
+        }
+
+        if (entry.estimate > 0)
+            return padded(static_cast<double>(entry.estimate), ESTIMATE_MARGIN);
+
+        if (!entry.estimate_pending && estimator)
+        {
+            entry.estimate_pending = true;
+            estimate_jobs.push_back({key, pool, calldata});
+            work_cv.notify_all();
+        }
+        return SepoliaConfig::Gas::SWAP_GAS_LIMIT;
+    }
+
+    // Feed a known gasUsed (e.g. from a receipt we already have)
+    void recordGasUsed(const std::string &pool, const std::string &calldata, uint64_t gas_used)
+    {
+        recordSample(makeKey(pool, selectorOf(calldata)), gas_used);
+    }
+
+    // Poll the receipt of a broadcast swap in the background and learn from its gasUsed
+    void trackReceipt(const std::string &pool, const std::string &calldata, const std::string &tx_hash)
+    {
+        if (!receipt_fetcher)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        receipt_jobs.push_back({makeKey(pool, selectorOf(calldata)), tx_hash, 0});
+        work_cv.notify_all();
+    }
+
+    uint64_t sampleCount(const std::string &pool, const std::string &selector) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = stats.find(makeKey(pool, selector));
+        return it == stats.end() ? 0 : it->second.samples;
+    }
+
+    // Block until queued estimates and receipt polls are done (tests, shutdown)
+    bool waitIdle(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return work_cv.wait_for(lock, timeout, [this]
+                                { return stopping || (estimate_jobs.empty() && receipt_jobs.empty() && !worker_busy); });
+    }
+};
+
+#endif // GAS_MODEL_H
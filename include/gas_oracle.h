@@ -0,0 +1,210 @@
+#ifndef GAS_ORACLE_H
+#define GAS_ORACLE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+
+#include "limit_order.h"
+#include "sepolia_config.h"
+
+// How fast a transaction needs to land: IOC/FOK pay up, GTC/GTT can wait a block or two
+enum class FeeUrgency
+{
+    IMMEDIATE,
+    PASSIVE
+};
+
+inline FeeUrgency urgencyForTif(TimeInForce tif)
+{
+    return (tif == TimeInForce::IOC || tif == TimeInForce::FOK) ? FeeUrgency::IMMEDIATE : FeeUrgency::PASSIVE;
+}
+
+// EIP-1559 fee pair ready to drop into a transaction
+struct FeeQuote
+{
+    uint64_t max_fee_per_gas;
+    uint64_t max_priority_fee_per_gas;
+    uint64_t base_fee;     // Base fee of the next block at sampling time
+    uint64_t block_number; // Newest block the quote was derived from (0 = defaults)
+};
+
+// Parsed eth_feeHistory window
+struct FeeHistory
+{
+    uint64_t newest_block = 0;
+    uint64_t next_base_fee = 0;        // Last baseFeePerGas entry (pending block)
+    std::vector<uint64_t> passive_tips; // Per-block reward at the passive percentile
+    std::vector<uint64_t> urgent_tips;  // Per-block reward at the urgent percentile
+};
+
+// Gas Oracle - samples fee history once per block off the hot path and publishes
+// per-urgency fee quotes that readers fetch with a few atomic loads
+class GasOracle
+{
+public:
+    // Fills history when a block newer than last_block is available; returns false otherwise
+    using Sampler = std::function<bool(uint64_t last_block, FeeHistory &history)>;
+
+    // Reward percentiles requested from eth_feeHistory for each urgency class
+    static constexpr int PASSIVE_PERCENTILE = 50;
+    static constexpr int URGENT_PERCENTILE = 90;
+
+private:
+    // One published quote; fields are atomics so a torn read is never undefined behaviour
+    struct Slot
+    {
+        std::atomic<uint64_t> max_fee{0};
+        std::atomic<uint64_t> max_priority_fee{0};
+        std::atomic<uint64_t> base_fee{0};
+        std::atomic<uint64_t> block_number{0};
+    };
+
+    // Seqlock: odd while the sampler thread is writing
+    std::atomic<uint64_t> sequence{0};
+    Slot slots[2];
+
+    std::thread sampler_thread;
+    std::mutex sampler_mutex;
+    std::condition_variable sampler_cv;
+    bool stopping = false;
+
+    static size_t slotIndex(FeeUrgency urgency)
+    {
+        return urgency == FeeUrgency::IMMEDIATE ? 0 : 1;
+    }
+
+    static uint64_t median(std::vector<uint64_t> values)
+    {
+        if (values.empty())
+            return 0;
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    }
+
+    void publish(FeeUrgency urgency, const FeeQuote &quote)
+    {
+        Slot &slot = slots[slotIndex(urgency)];
+        slot.max_fee.store(quote.max_fee_per_gas, std::memory_order_relaxed);
+        slot.max_priority_fee.store(quote.max_priority_fee_per_gas, std::memory_order_relaxed);
+        slot.base_fee.store(quote.base_fee, std::memory_order_relaxed);
+        slot.block_number.store(quote.block_number, std::memory_order_relaxed);
+    }
+
+public:
+    GasOracle()
+    {
+        // Until the first sample lands, fall back to the static config values
+        FeeQuote fallback{SepoliaConfig::Gas::DEFAULT_GAS_PRICE, SepoliaConfig::Gas::DEFAULT_PRIORITY_FEE, 0, 0};
+        publish(FeeUrgency::IMMEDIATE, fallback);
+        publish(FeeUrgency::PASSIVE, fallback);
+    }
+
+    ~GasOracle()
+    {
+        stop();
+    }
+
+    GasOracle(const GasOracle &) = delete;
+    GasOracle &operator=(const GasOracle &) = delete;
+
+    // Derive fee quotes from a history window; base fee headroom covers the blocks we may wait
+    static FeeQuote computeQuote(const FeeHistory &history, FeeUrgency urgency)
+    {
+        bool urgent = urgency == FeeUrgency::IMMEDIATE;
+        uint64_t tip = median(urgent ? history.urgent_tips : history.passive_tips);
+        tip = std::max(tip, SepoliaConfig::Gas::DEFAULT_PRIORITY_FEE);
+
+        // 2x survives six full blocks of +12.5%; passive orders re-sign if they sit longer
+        uint64_t base_headroom = urgent ? history.next_base_fee * 2 : history.next_base_fee + history.next_base_fee / 4;
+
+        return FeeQuote{base_headroom + tip, tip, history.next_base_fee, history.newest_block};
+    }
+
+    // Publish quotes for a new block; stale or repeated blocks are ignored
+    void update(const FeeHistory &history)
+    {
+        if (history.newest_block <= slots[0].block_number.load(std::memory_order_relaxed))
+            return;
+
+        FeeQuote urgent = computeQuote(history, FeeUrgency::IMMEDIATE);
+        FeeQuote passive = computeQuote(history, FeeUrgency::PASSIVE);
+
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        publish(FeeUrgency::IMMEDIATE, urgent);
+        publish(FeeUrgency::PASSIVE, passive);
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    // Hot path: no locks, no I/O
+    FeeQuote quote(FeeUrgency urgency) const
+    {
+        const Slot &slot = slots[slotIndex(urgency)];
+        while (true)
+        {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            FeeQuote result{slot.max_fee.load(std::memory_order_relaxed),
+                            slot.max_priority_fee.load(std::memory_order_relaxed),
+                            slot.base_fee.load(std::memory_order_relaxed),
+                            slot.block_number.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((before & 1) == 0 && sequence.load(std::memory_order_relaxed) == before)
+                return result;
+        }
+    }
+
+    uint64_t lastBlock() const
+    {
+        return slots[0].block_number.load(std::memory_order_relaxed);
+    }
+
+    // Poll the sampler from a background thread; it only fetches history on a new block
+    void start(Sampler sampler, std::chrono::milliseconds poll_interval)
+    {
+        stop();
+        stopping = false;
+        sampler_thread = std::thread([this, sampler, poll_interval]
+                                     {
+            std::unique_lock<std::mutex> lock(sampler_mutex);
+            while (!stopping)
+            {
+                lock.unlock();
+                try
+                {
+                    FeeHistory history;
+                    if (sampler(lastBlock(), history))
+                    {
+                        update(history);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "⚠️ Gas oracle sample failed: " << e.what() << std::endl;
+                }
+                lock.lock();
+                sampler_cv.wait_for(lock, poll_interval, [this]
+                                    { return stopping; });
+            } });
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sampler_mutex);
+            stopping = true;
+        }
+        sampler_cv.notify_all();
+        if (sampler_thread.joinable())
+            sampler_thread.join();
+    }
+};
+
+#endif // GAS_ORACLE_H
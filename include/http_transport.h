@@ -0,0 +1,476 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+// HTTP Transport - raw HTTP/1.1 keep-alive client for plain-http JSON-RPC endpoints
+// (a node on localhost). One non-blocking socket driven by epoll, requests pipelined
+// back to back, send/receive buffers reused across calls and responses parsed in place.
+// Returned bodies are views into the receive buffer, valid until the next call.
+class HttpTransport
+{
+public:
+    static constexpr int DEFAULT_TIMEOUT_MS = 10000;
+    static constexpr size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+
+    static bool supportsUrl(const std::string &url)
+    {
+        return url.rfind("http://", 0) == 0;
+    }
+
+#if defined(__linux__)
+private:
+    struct BodySpan
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    std::string host;
+    std::string port;
+    std::string path;
+    int timeout_ms;
+
+    int socket_fd = -1;
+    int epoll_fd = -1;
+
+    std::string send_buffer;
+    std::vector<char> recv_buffer;
+    size_t recv_length = 0;
+    std::vector<BodySpan> spans;
+    std::vector<std::string_view> views;
+    uint64_t connects = 0;
+
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    void parseUrl(const std::string &url)
+    {
+        std::string rest = url.substr(7); // After "http://"
+        size_t slash = rest.find('/');
+        std::string authority = rest.substr(0, slash);
+        path = slash == std::string::npos ? "/" : rest.substr(slash);
+
+        size_t colon = authority.rfind(':');
+        if (colon != std::string::npos && authority.find(']') == std::string::npos)
+        {
+            host = authority.substr(0, colon);
+            port = authority.substr(colon + 1);
+        }
+        else
+        {
+            host = authority;
+            port = "80";
+        }
+        if (!host.empty() && host.front() == '[')
+            host = host.substr(1, host.size() - 2);
+        if (host.empty())
+            throw std::runtime_error("Invalid RPC URL: " + url);
+    }
+
+    void closeSocket()
+    {
+        if (socket_fd >= 0)
+        {
+            ::close(socket_fd);
+            socket_fd = -1;
+        }
+    }
+
+    int remainingMs(Deadline deadline) const
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<int64_t>(left.count(), 0));
+    }
+
+    // Wait until the socket is ready for any of events; returns the ready set
+    uint32_t waitReady(uint32_t events, Deadline deadline)
+    {
+        epoll_event interest{};
+        interest.events = events;
+        interest.data.fd = socket_fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &interest) != 0)
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+
+        while (true)
+        {
+            epoll_event ready{};
+            int count = epoll_wait(epoll_fd, &ready, 1, remainingMs(deadline));
+            if (count > 0)
+                return ready.events;
+            if (count == 0)
+                throw std::runtime_error("HTTP transport timed out");
+            if (errno != EINTR)
+                throw std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+        }
+    }
+
+    void connectSocket(Deadline deadline)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses = nullptr;
+        int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+        if (rc != 0)
+            throw std::runtime_error("Cannot resolve " + host + ": " + gai_strerror(rc));
+
+        std::string last_error = "no addresses";
+        for (addrinfo *address = addresses; address; address = address->ai_next)
+        {
+            socket_fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+            if (socket_fd < 0)
+                continue;
+
+            int one = 1;
+            setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            epoll_event interest{};
+            interest.events = EPOLLOUT;
+            interest.data.fd = socket_fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &interest);
+
+            if (::connect(socket_fd, address->ai_addr, address->ai_addrlen) == 0)
+                break;
+            if (errno == EINPROGRESS)
+            {
+                waitReady(EPOLLOUT, deadline);
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error == 0)
+                    break;
+                last_error = std::strerror(error);
+            }
+            else
+            {
+                last_error = std::strerror(errno);
+            }
+            closeSocket();
+        }
+        freeaddrinfo(addresses);
+
+        if (socket_fd < 0)
+            throw std::runtime_error("Cannot connect to " + host + ":" + port + ": " + last_error);
+        connects++;
+    }
+
+    void appendRequest(std::string_view body)
+    {
+        send_buffer.append("POST ").append(path).append(" HTTP/1.1\r\nHost: ").append(host);
+        send_buffer.append("\r\nContent-Type: application/json\r\nConnection: keep-alive\r\nContent-Length: ");
+        send_buffer.append(std::to_string(body.size())).append("\r\n\r\n");
+        send_buffer.append(body.data(), body.size());
+    }
+
+    // Read whatever is available; returns false on EOF
+    bool readAvailable()
+    {
+        while (true)
+        {
+            if (recv_length == recv_buffer.size())
+                recv_buffer.resize(recv_buffer.size() * 2);
+
+            ssize_t received = ::recv(socket_fd, recv_buffer.data() + recv_length, recv_buffer.size() - recv_length, 0);
+            if (received > 0)
+            {
+                recv_length += static_cast<size_t>(received);
+                continue;
+            }
+            if (received == 0)
+                return false;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            if (errno != EINTR)
+                throw std::runtime_error(std::string("recv failed: ") + std::strerror(errno));
+        }
+    }
+
+    static bool headerIs(std::string_view line, std::string_view name)
+    {
+        if (line.size() <= name.size() || line[name.size()] != ':')
+            return false;
+        for (size_t k = 0; k < name.size(); ++k)
+        {
+            if (std::tolower(static_cast<unsigned char>(line[k])) != name[k])
+                return false;
+        }
+        return true;
+    }
+
+    static std::string_view headerValue(std::string_view line)
+    {
+        size_t start = line.find(':') + 1;
+        while (start < line.size() && line[start] == ' ')
+            start++;
+        return line.substr(start);
+    }
+
+    // Decode a chunked body in place starting at offset; false if not all of it has arrived.
+    // The first pass only checks completeness, so a partial body leaves the buffer untouched.
+    bool decodeChunked(size_t offset, size_t &consumed_end, size_t &body_length)
+    {
+        char *data = recv_buffer.data();
+        for (bool compact : {false, true})
+        {
+            size_t read_pos = offset;
+            size_t write_pos = offset;
+            while (true)
+            {
+                std::string_view rest(data + read_pos, recv_length - read_pos);
+                size_t line_end = rest.find("\r\n");
+                if (line_end == std::string_view::npos)
+                    return false;
+                size_t chunk = std::stoul(std::string(rest.substr(0, line_end)), nullptr, 16);
+                size_t chunk_start = read_pos + line_end + 2;
+                if (chunk == 0)
+                {
+                    if (chunk_start + 2 > recv_length)
+                        return false;
+                    consumed_end = chunk_start + 2; // Final CRLF (no trailers)
+                    body_length = write_pos - offset;
+                    break;
+                }
+                if (chunk_start + chunk + 2 > recv_length)
+                    return false;
+                if (compact)
+                    std::memmove(data + write_pos, data + chunk_start, chunk);
+                write_pos += chunk;
+                read_pos = chunk_start + chunk + 2;
+            }
+        }
+        return true;
+    }
+
+    // Parse one response at pos; false if it hasn't fully arrived yet
+    bool parseResponse(size_t &pos, BodySpan &body, bool &close_after)
+    {
+        std::string_view available(recv_buffer.data() + pos, recv_length - pos);
+        size_t header_end = available.find("\r\n\r\n");
+        if (header_end == std::string_view::npos)
+            return false;
+
+        std::string_view headers = available.substr(0, header_end);
+        if (headers.size() < 12 || headers.substr(0, 5) != "HTTP/")
+            throw std::runtime_error("Malformed HTTP response");
+        int status = std::atoi(std::string(headers.substr(9, 3)).c_str());
+
+        size_t content_length = std::string::npos;
+        bool chunked = false;
+        close_after = headers.substr(0, 8) == "HTTP/1.0";
+        size_t line_start = headers.find("\r\n") + 2;
+        while (line_start < headers.size())
+        {
+            size_t line_end = headers.find("\r\n", line_start);
+            std::string_view line = headers.substr(line_start, line_end == std::string_view::npos ? std::string_view::npos : line_end - line_start);
+            if (headerIs(line, "content-length"))
+                content_length = std::stoul(std::string(headerValue(line)));
+            else if (headerIs(line, "transfer-encoding"))
+                chunked = headerValue(line).find("chunked") != std::string_view::npos;
+            else if (headerIs(line, "connection"))
+                close_after = headerValue(line).find("close") != std::string_view::npos;
+            if (line_end == std::string_view::npos)
+                break;
+            line_start = line_end + 2;
+        }
+
+        size_t body_start = pos + header_end + 4;
+        size_t end = 0;
+        if (chunked)
+        {
+            size_t length = 0;
+            if (!decodeChunked(body_start, end, length))
+                return false;
+            body = {body_start, length};
+        }
+        else
+        {
+            if (content_length == std::string::npos)
+                throw std::runtime_error("HTTP response without Content-Length");
+            if (body_start + content_length > recv_length)
+                return false;
+            body = {body_start, content_length};
+            end = body_start + content_length;
+        }
+
+        if (status < 200 || status >= 300)
+            throw std::runtime_error("HTTP " + std::to_string(status) + " from RPC endpoint");
+        pos = end;
+        return true;
+    }
+
+    // Write every request, then read until every response has been parsed.
+    // Returns false if the connection dropped before any response arrived (safe to resend).
+    bool exchange(size_t count, Deadline deadline)
+    {
+        size_t sent = 0;
+        size_t parse_pos = 0;
+        bool close_after = false;
+        recv_length = 0;
+        spans.clear();
+
+        while (spans.size() < count)
+        {
+            uint32_t wanted = EPOLLIN | EPOLLRDHUP;
+            if (sent < send_buffer.size())
+            {
+                ssize_t written = ::send(socket_fd, send_buffer.data() + sent, send_buffer.size() - sent, MSG_NOSIGNAL);
+                if (written > 0)
+                {
+                    sent += static_cast<size_t>(written);
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    if (spans.empty() && recv_length == 0)
+                        return false;
+                    throw std::runtime_error(std::string("send failed: ") + std::strerror(errno));
+                }
+                if (sent < send_buffer.size())
+                    wanted |= EPOLLOUT;
+            }
+
+            // Drain responses that already arrived while requests are still going out
+            uint32_t ready = waitReady(wanted, deadline);
+            if (!(ready & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+                continue;
+
+            bool open = readAvailable();
+            BodySpan body{};
+            while (spans.size() < count && parseResponse(parse_pos, body, close_after))
+                spans.push_back(body);
+
+            if (!open && spans.size() < count)
+            {
+                if (spans.empty() && recv_length == 0)
+                    return false;
+                throw std::runtime_error("RPC endpoint closed the connection mid-response");
+            }
+            if (close_after && spans.size() < count)
+                throw std::runtime_error("RPC endpoint closed keep-alive connection mid-pipeline");
+        }
+
+        if (close_after)
+            closeSocket();
+        return true;
+    }
+
+    // Send what is in send_buffer, retrying once on a fresh connection if the kept-alive
+    // one turns out to have been closed by the server. Both attempts share one timeout.
+    const std::vector<std::string_view> &transmit(size_t count, int timeout)
+    {
+        views.clear();
+        if (count == 0)
+            return views;
+
+        Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout >= 0 ? timeout : timeout_ms);
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            if (socket_fd < 0)
+                connectSocket(deadline);
+            try
+            {
+                if (exchange(count, deadline))
+                {
+                    for (const auto &span : spans)
+                        views.emplace_back(recv_buffer.data() + span.offset, span.length);
+                    return views;
+                }
+            }
+            catch (...)
+            {
+                closeSocket();
+                throw;
+            }
+            closeSocket();
+        }
+        throw std::runtime_error("RPC endpoint closed the connection");
+    }
+
+public:
+    explicit HttpTransport(const std::string &url, int timeout = DEFAULT_TIMEOUT_MS)
+        : timeout_ms(timeout), recv_buffer(INITIAL_BUFFER_SIZE)
+    {
+        if (!supportsUrl(url))
+            throw std::runtime_error("Raw HTTP transport only supports http:// URLs");
+        parseUrl(url);
+        send_buffer.reserve(INITIAL_BUFFER_SIZE);
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0)
+            throw std::runtime_error(std::string("epoll_create1 failed: ") + std::strerror(errno));
+    }
+
+    ~HttpTransport()
+    {
+        closeSocket();
+        if (epoll_fd >= 0)
+            ::close(epoll_fd);
+    }
+
+    HttpTransport(const HttpTransport &) = delete;
+    HttpTransport &operator=(const HttpTransport &) = delete;
+
+    // Send several JSON-RPC bodies back to back on the kept-alive connection; responses come
+    // back in request order. Views point into the receive buffer until the next call.
+    // `timeout` (ms) overrides the transport's own for this call.
+    const std::vector<std::string_view> &pipeline(const std::vector<std::string> &bodies, int timeout = -1)
+    {
+        send_buffer.clear();
+        for (const auto &body : bodies)
+            appendRequest(body);
+        return transmit(bodies.size(), timeout);
+    }
+
+    std::string_view post(std::string_view body, int timeout = -1)
+    {
+        send_buffer.clear();
+        appendRequest(body);
+        return transmit(1, timeout).front();
+    }
+
+    uint64_t connectCount() const
+    {
+        return connects;
+    }
+
+#else
+public:
+    explicit HttpTransport(const std::string &, int = DEFAULT_TIMEOUT_MS)
+    {
+        throw std::runtime_error("Raw HTTP transport requires epoll (Linux)");
+    }
+
+    const std::vector<std::string_view> &pipeline(const std::vector<std::string> &, int = -1)
+    {
+        throw std::runtime_error("Raw HTTP transport requires epoll (Linux)");
+    }
+
+    std::string_view post(std::string_view, int = -1)
+    {
+        throw std::runtime_error("Raw HTTP transport requires epoll (Linux)");
+    }
+
+    uint64_t connectCount() const
+    {
+        return 0;
+    }
+#endif
+};
+
+#endif // HTTP_TRANSPORT_H
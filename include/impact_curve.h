@@ -0,0 +1,263 @@
+#ifndef IMPACT_CURVE_H
+#define IMPACT_CURVE_H
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+// Impact Curve - one market's get_dy sampled at a geometric ladder of sizes, answering quotes
+// for any size from the samples. Swap output is increasing and concave in the input for any
+// convex invariant (StableSwap, CryptoSwap, constant product), so the samples bracket the true
+// output: the chord between neighbouring samples lies below it and the extended chords of the
+// neighbouring intervals lie above it. A trigger only needs an exact get_dy when its threshold
+// falls inside that bracket.
+class ImpactCurve
+{
+public:
+    static constexpr size_t LADDER_POINTS = 8;
+    static constexpr long double ROUNDING_SLACK = 2; // get_dy floors; wei of slack per sample
+
+    struct Estimate
+    {
+        uint64_t value = 0; // Monotone cubic (Fritsch-Carlson) through the samples
+        uint64_t low = 0;   // The true output is at least this...
+        uint64_t high = 0;  // ...and at most this
+    };
+
+    enum class Decision
+    {
+        MET,     // Output reaches the threshold anywhere in the bracket
+        NOT_MET, // Output falls short anywhere in the bracket
+        UNSURE   // Threshold inside the bracket: quote exactly
+    };
+
+private:
+    using Real = long double;
+
+    // Samples with the origin prepended: xs[0] = ys[0] = 0
+    std::vector<Real> xs;
+    std::vector<Real> ys;
+    std::vector<Real> tangents;
+    bool fitted = false;
+
+    // Line through samples a and b evaluated at x, widened by how far rounding can push it
+    Real extended(size_t a, size_t b, Real x) const
+    {
+        Real slope = (ys[b] - ys[a]) / (xs[b] - xs[a]);
+        Real leverage = (std::fabs(x - xs[a]) + std::fabs(x - xs[b])) / (xs[b] - xs[a]);
+        return ys[a] + slope * (x - xs[a]) + ROUNDING_SLACK * leverage;
+    }
+
+    static uint64_t clampToWord(Real value)
+    {
+        if (value <= 0)
+            return 0;
+        if (value >= static_cast<Real>(std::numeric_limits<uint64_t>::max()))
+            return std::numeric_limits<uint64_t>::max();
+        return static_cast<uint64_t>(value);
+    }
+
+    void fitTangents()
+    {
+        size_t n = xs.size();
+        std::vector<Real> slopes(n - 1);
+        for (size_t k = 0; k + 1 < n; ++k)
+            slopes[k] = (ys[k + 1] - ys[k]) / (xs[k + 1] - xs[k]);
+
+        tangents.assign(n, 0);
+        tangents[0] = slopes[0];
+        tangents[n - 1] = slopes[n - 2];
+        for (size_t k = 1; k + 1 < n; ++k)
+        {
+            if (slopes[k - 1] <= 0 || slopes[k] <= 0)
+                continue;
+            Real h0 = xs[k] - xs[k - 1], h1 = xs[k + 1] - xs[k];
+            Real w0 = 2 * h1 + h0, w1 = h1 + 2 * h0;
+            tangents[k] = (w0 + w1) / (w0 / slopes[k - 1] + w1 / slopes[k]);
+        }
+    }
+
+public:
+    // `points` sizes spaced geometrically from smallest, the second-to-last being largest. The
+    // extra rung above gives the top interval an upper bound from both sides.
+    static std::vector<uint64_t> ladder(uint64_t smallest, uint64_t largest, size_t points = LADDER_POINTS)
+    {
+        std::vector<uint64_t> sizes;
+        if (smallest == 0 || largest < smallest || points < 3)
+            return sizes;
+        Real ratio = std::pow(static_cast<Real>(largest) / smallest, 1.0L / (points - 2));
+        for (size_t k = 0; k < points; ++k)
+        {
+            uint64_t size = k + 2 == points ? largest : clampToWord(std::round(smallest * std::pow(ratio, static_cast<Real>(k))));
+            if (sizes.empty() || size > sizes.back())
+                sizes.push_back(size);
+        }
+        return sizes;
+    }
+
+    // Fit sampled outputs for increasing sizes. False (and nothing is answered) unless the
+    // samples are increasing and concave to within rounding, as every AMM curve must be.
+    bool fit(const std::vector<uint64_t> &sizes, const std::vector<uint64_t> &outputs)
+    {
+        fitted = false;
+        xs.assign(1, 0);
+        ys.assign(1, 0);
+        if (sizes.empty() || sizes.size() != outputs.size())
+            return false;
+        for (size_t k = 0; k < sizes.size(); ++k)
+        {
+            if (sizes[k] <= xs.back() || outputs[k] < ys.back())
+                return false;
+            xs.push_back(static_cast<Real>(sizes[k]));
+            ys.push_back(static_cast<Real>(outputs[k]));
+        }
+        for (size_t k = 1; k + 1 < xs.size(); ++k)
+        {
+            Real before = (ys[k] - ys[k - 1]) / (xs[k] - xs[k - 1]);
+            Real after = (ys[k + 1] - ys[k]) / (xs[k + 1] - xs[k]);
+            Real tolerance = 2 * ROUNDING_SLACK / (xs[k + 1] - xs[k - 1]);
+            if (after > before + tolerance)
+                return false;
+        }
+        fitTangents();
+        fitted = true;
+        return true;
+    }
+
+    bool usable() const
+    {
+        return fitted;
+    }
+
+    Estimate estimate(uint64_t dx) const
+    {
+        Estimate result;
+        if (!fitted || dx == 0)
+            return result;
+
+        Real x = static_cast<Real>(dx);
+        size_t last = xs.size() - 1;
+        Real low, high, value;
+        if (x >= xs[last])
+        {
+            // Past the ladder only monotonicity bounds below; the last chord still bounds above
+            low = ys[last] - ROUNDING_SLACK;
+            high = extended(last - 1, last, x);
+            value = std::min<Real>(ys[last] + tangents[last] * (x - xs[last]), high);
+        }
+        else
+        {
+            size_t k = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin() - 1;
+            Real h = xs[k + 1] - xs[k];
+            Real t = (x - xs[k]) / h;
+            low = ys[k] + (ys[k + 1] - ys[k]) * t - ROUNDING_SLACK;
+
+            high = std::numeric_limits<Real>::infinity();
+            if (k >= 1)
+                high = std::min(high, extended(k - 1, k, x));
+            if (k + 2 <= last)
+                high = std::min(high, extended(k + 1, k + 2, x));
+
+            Real t2 = t * t, t3 = t2 * t;
+            value = (2 * t3 - 3 * t2 + 1) * ys[k] + (t3 - 2 * t2 + t) * h * tangents[k] +
+                    (-2 * t3 + 3 * t2) * ys[k + 1] + (t3 - t2) * h * tangents[k + 1];
+        }
+
+        result.low = clampToWord(low);
+        result.high = std::isinf(high) ? std::numeric_limits<uint64_t>::max() : clampToWord(std::ceil(high));
+        result.value = std::clamp(clampToWord(value), result.low, std::max(result.low, result.high));
+        return result;
+    }
+
+    // Whether an output known to lie within `bounds` reaches `required`
+    static Decision decide(const Estimate &bounds, uint64_t required)
+    {
+        if (bounds.low >= required)
+            return Decision::MET;
+        if (bounds.high < required)
+            return Decision::NOT_MET;
+        return Decision::UNSURE;
+    }
+
+    // Whether a quote of `dx` reaches `required`, if the bracket settles it
+    Decision decide(uint64_t dx, uint64_t required) const
+    {
+        if (!fitted)
+            return Decision::UNSURE;
+        return decide(estimate(dx), required);
+    }
+};
+
+// Impact Curve Cache - the curves fitted this block, per market (pool and direction). A curve
+// is only trusted for the block it was sampled in. Not thread-safe; owned by one engine.
+class ImpactCurveCache
+{
+private:
+    struct Entry
+    {
+        uint64_t block = 0;
+        ImpactCurve curve;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t answered = 0;
+    uint64_t fallbacks = 0;
+    uint64_t samples = 0;
+
+public:
+    static std::string keyFor(const std::string &pool, int32_t i, int32_t j, bool underlying = false)
+    {
+        return pool + (underlying ? ":underlying:" : ":") + std::to_string(i) + ":" + std::to_string(j);
+    }
+
+    // The curve sampled for `market` at `block`, if any (it may be unusable)
+    const ImpactCurve *find(const std::string &market, uint64_t block) const
+    {
+        auto it = entries.find(market);
+        if (it == entries.end() || it->second.block != block)
+            return nullptr;
+        return &it->second.curve;
+    }
+
+    const ImpactCurve &store(const std::string &market, uint64_t block, const ImpactCurve &curve, size_t sample_count)
+    {
+        samples += sample_count;
+        Entry &entry = entries[market];
+        entry.block = block;
+        entry.curve = curve;
+        return entry.curve;
+    }
+
+    void recordAnswered()
+    {
+        answered++;
+    }
+
+    void recordFallback()
+    {
+        fallbacks++;
+    }
+
+    // Quotes settled from a curve without their own get_dy
+    uint64_t answeredCount() const
+    {
+        return answered;
+    }
+
+    // Quotes whose threshold fell inside a curve's bracket
+    uint64_t fallbackCount() const
+    {
+        return fallbacks;
+    }
+
+    uint64_t sampleCount() const
+    {
+        return samples;
+    }
+};
+
+#endif // IMPACT_CURVE_H
@@ -0,0 +1,398 @@
+#ifndef IPC_TRANSPORT_H
+#define IPC_TRANSPORT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// JSON Stream Framer - splits a byte stream into top-level JSON values without parsing them.
+// Nodes write IPC replies back to back with no length prefix (newlines optional), so
+// message boundaries come from bracket depth, skipping brackets inside strings.
+class JsonStreamFramer
+{
+private:
+    std::string buffer;
+    size_t scan_pos = 0;
+    size_t message_start = std::string::npos;
+    int depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+
+public:
+    void append(const char *data, size_t length)
+    {
+        buffer.append(data, length);
+    }
+
+    // Extract the next complete message; false if more bytes are needed
+    bool next(std::string &message)
+    {
+        for (; scan_pos < buffer.size(); ++scan_pos)
+        {
+            char c = buffer[scan_pos];
+            if (in_string)
+            {
+                if (escaped)
+                    escaped = false;
+                else if (c == '\\')
+                    escaped = true;
+                else if (c == '"')
+                    in_string = false;
+                continue;
+            }
+
+            if (c == '"')
+            {
+                in_string = true;
+            }
+            else if (c == '{' || c == '[')
+            {
+                if (depth++ == 0)
+                    message_start = scan_pos;
+            }
+            else if ((c == '}' || c == ']') && depth > 0 && --depth == 0)
+            {
+                message.assign(buffer, message_start, scan_pos + 1 - message_start);
+                buffer.erase(0, scan_pos + 1);
+                scan_pos = 0;
+                message_start = std::string::npos;
+                return true;
+            }
+        }
+
+        // Drop inter-message whitespace so the buffer doesn't grow between messages
+        if (depth == 0 && !buffer.empty())
+        {
+            buffer.clear();
+            scan_pos = 0;
+        }
+        return false;
+    }
+
+    size_t buffered() const
+    {
+        return buffer.size();
+    }
+
+    void reset()
+    {
+        buffer.clear();
+        scan_pos = 0;
+        message_start = std::string::npos;
+        depth = 0;
+        in_string = false;
+        escaped = false;
+    }
+
+    // Raw text of the top-level "id" member ("7", "\"abc\"", or "" if absent / null)
+    static std::string topLevelId(std::string_view message)
+    {
+        int level = 0;
+        bool inside = false;
+        bool escape = false;
+        for (size_t k = 0; k < message.size(); ++k)
+        {
+            char c = message[k];
+            if (inside)
+            {
+                if (escape)
+                    escape = false;
+                else if (c == '\\')
+                    escape = true;
+                else if (c == '"')
+                    inside = false;
+                continue;
+            }
+            if (c == '{' || c == '[')
+            {
+                level++;
+            }
+            else if (c == '}' || c == ']')
+            {
+                level--;
+            }
+            else if (c == '"')
+            {
+                if (level == 1 && message.compare(k, 5, "\"id\":") == 0)
+                {
+                    size_t start = k + 5;
+                    while (start < message.size() && message[start] == ' ')
+                        start++;
+                    size_t end = start;
+                    if (end < message.size() && message[end] == '"')
+                        end = message.find('"', end + 1) + 1;
+                    else
+                        end = message.find_first_of(",}", start);
+                    std::string_view id = message.substr(start, end - start);
+                    while (!id.empty() && id.back() == ' ')
+                        id.remove_suffix(1);
+                    return id == "null" ? std::string() : std::string(id);
+                }
+                inside = true;
+            }
+        }
+        return std::string();
+    }
+};
+
+// IPC Transport - JSON-RPC over a node's Unix domain socket (geth.ipc). Any number of threads
+// may have requests in flight on the one connection; a reader thread frames the reply stream
+// and hands each reply to the caller waiting on its id. Messages without an id (subscription
+// notifications) go to the notification handler.
+class IpcTransport
+{
+public:
+    using NotificationHandler = std::function<void(const std::string &message)>;
+
+    static constexpr int DEFAULT_TIMEOUT_MS = 10000;
+
+    // "ipc:///path/geth.ipc", "/path/geth.ipc" or anything ending in ".ipc"
+    static bool supportsUrl(const std::string &url)
+    {
+        return url.rfind("ipc://", 0) == 0 || (!url.empty() && url.front() == '/') ||
+               (url.size() > 4 && url.compare(url.size() - 4, 4, ".ipc") == 0);
+    }
+
+private:
+    struct Pending
+    {
+        bool done = false;
+        std::string reply;
+        std::string error;
+    };
+
+    std::string socket_path;
+    int timeout_ms;
+    NotificationHandler notification_handler;
+
+    std::mutex write_mutex; // One writer at a time so messages don't interleave
+    std::mutex state_mutex;
+    std::condition_variable reply_cv;
+    std::map<std::string, std::shared_ptr<Pending>> pending;
+    int socket_fd = -1;
+    bool connected = false;
+    std::atomic<uint64_t> connects{0};
+    std::thread reader;
+
+    // Caller holds state_mutex
+    void failPending(const std::string &reason)
+    {
+        for (auto &[id, waiter] : pending)
+        {
+            waiter->error = reason;
+            waiter->done = true;
+        }
+        pending.clear();
+        reply_cv.notify_all();
+    }
+
+    void readLoop(int fd)
+    {
+        JsonStreamFramer framer;
+        std::vector<char> chunk(64 * 1024);
+        std::string message;
+        while (true)
+        {
+            ssize_t received = ::recv(fd, chunk.data(), chunk.size(), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+
+            framer.append(chunk.data(), static_cast<size_t>(received));
+            while (framer.next(message))
+            {
+                std::string id = JsonStreamFramer::topLevelId(message);
+                if (id.empty())
+                {
+                    if (notification_handler)
+                        notification_handler(message);
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(state_mutex);
+                auto it = pending.find(id);
+                if (it == pending.end())
+                    continue; // Caller timed out and left
+                it->second->reply = std::move(message);
+                it->second->done = true;
+                pending.erase(it);
+                reply_cv.notify_all();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (socket_fd == fd)
+            connected = false;
+        failPending("IPC connection closed");
+    }
+
+    // Caller holds state_mutex
+    void connectLocked()
+    {
+        if (connected)
+            return;
+        if (reader.joinable())
+        {
+            // Previous reader is on its way out (it clears connected last); reap it unlocked
+            std::thread finished = std::move(reader);
+            state_mutex.unlock();
+            finished.join();
+            state_mutex.lock();
+            if (connected)
+                return; // Another caller reconnected meanwhile
+        }
+        if (socket_fd >= 0)
+        {
+            ::close(socket_fd);
+            socket_fd = -1;
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("IPC path too long: " + socket_path);
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            std::string reason = std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            throw std::runtime_error("Cannot connect to " + socket_path + ": " + reason);
+        }
+
+        socket_fd = fd;
+        connected = true;
+        connects++;
+        reader = std::thread(&IpcTransport::readLoop, this, fd);
+    }
+
+    void writeAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw std::runtime_error(std::string("IPC write failed: ") + std::strerror(errno));
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+public:
+    explicit IpcTransport(const std::string &url, int timeout = DEFAULT_TIMEOUT_MS,
+                          NotificationHandler on_notification = nullptr)
+        : socket_path(url.rfind("ipc://", 0) == 0 ? url.substr(6) : url),
+          timeout_ms(timeout),
+          notification_handler(std::move(on_notification)) {}
+
+    ~IpcTransport()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (socket_fd >= 0)
+                ::shutdown(socket_fd, SHUT_RDWR);
+        }
+        if (reader.joinable())
+            reader.join();
+        if (socket_fd >= 0)
+            ::close(socket_fd);
+    }
+
+    IpcTransport(const IpcTransport &) = delete;
+    IpcTransport &operator=(const IpcTransport &) = delete;
+
+    // Send requests (each body carries the matching numeric id) and wait for every reply.
+    // Replies may arrive in any order and interleave with other threads' requests. `timeout`
+    // (ms) overrides the transport's own for this call; late replies are dropped by the reader.
+    std::vector<std::string> exchange(const std::vector<std::string> &bodies, const std::vector<uint64_t> &ids,
+                                      int timeout = -1)
+    {
+        std::vector<std::shared_ptr<Pending>> waiters;
+        std::string outgoing;
+        int fd;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            connectLocked();
+            fd = socket_fd;
+            for (size_t k = 0; k < bodies.size(); ++k)
+            {
+                auto waiter = std::make_shared<Pending>();
+                pending[std::to_string(ids[k])] = waiter;
+                waiters.push_back(waiter);
+                outgoing.append(bodies[k]).push_back('\n');
+            }
+        }
+
+        try
+        {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            writeAll(fd, outgoing);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            for (uint64_t id : ids)
+                pending.erase(std::to_string(id));
+            throw;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex);
+        bool all_done = reply_cv.wait_for(lock, std::chrono::milliseconds(timeout >= 0 ? timeout : timeout_ms), [&waiters]
+                                          {
+            for (const auto &waiter : waiters)
+            {
+                if (!waiter->done)
+                    return false;
+            }
+            return true; });
+        if (!all_done)
+        {
+            for (uint64_t id : ids)
+                pending.erase(std::to_string(id));
+            throw std::runtime_error("IPC request timed out");
+        }
+
+        std::vector<std::string> replies;
+        replies.reserve(waiters.size());
+        for (auto &waiter : waiters)
+        {
+            if (!waiter->error.empty())
+                throw std::runtime_error(waiter->error);
+            replies.push_back(std::move(waiter->reply));
+        }
+        return replies;
+    }
+
+    std::string call(const std::string &body, uint64_t id, int timeout = -1)
+    {
+        return exchange({body}, {id}, timeout).front();
+    }
+
+    uint64_t connectCount() const
+    {
+        return connects.load();
+    }
+};
+
+#endif // IPC_TRANSPORT_H
@@ -0,0 +1,132 @@
+#ifndef KECCAK_H
+#define KECCAK_H
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Keccak-256 (the pre-standard SHA-3 padding Ethereum uses), for deriving event topics and
+// function selectors from their signatures instead of hard-coding the hashes.
+namespace Keccak
+{
+    inline void permute(uint64_t state[25])
+    {
+        static constexpr uint64_t ROUND_CONSTANTS[24] = {
+            0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+            0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+            0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+            0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+            0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+            0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+        static constexpr int ROTATIONS[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+                                              27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+        static constexpr int LANES[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+                                          15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+        auto rotl = [](uint64_t value, int shift)
+        { return (value << shift) | (value >> (64 - shift)); };
+
+        for (uint64_t round_constant : ROUND_CONSTANTS)
+        {
+            // Theta
+            uint64_t columns[5];
+            for (int x = 0; x < 5; ++x)
+                columns[x] = state[x] ^ state[x + 5] ^ state[x + 10] ^ state[x + 15] ^ state[x + 20];
+            for (int x = 0; x < 5; ++x)
+            {
+                uint64_t t = columns[(x + 4) % 5] ^ rotl(columns[(x + 1) % 5], 1);
+                for (int y = 0; y < 25; y += 5)
+                    state[y + x] ^= t;
+            }
+
+            // Rho and pi
+            uint64_t carried = state[1];
+            for (int k = 0; k < 24; ++k)
+            {
+                uint64_t next = state[LANES[k]];
+                state[LANES[k]] = rotl(carried, ROTATIONS[k]);
+                carried = next;
+            }
+
+            // Chi
+            for (int y = 0; y < 25; y += 5)
+            {
+                uint64_t row[5];
+                for (int x = 0; x < 5; ++x)
+                    row[x] = state[y + x];
+                for (int x = 0; x < 5; ++x)
+                    state[y + x] ^= (~row[(x + 1) % 5]) & row[(x + 2) % 5];
+            }
+
+            // Iota
+            state[0] ^= round_constant;
+        }
+    }
+
+    inline std::array<uint8_t, 32> hash256(std::string_view data)
+    {
+        constexpr size_t RATE = 136;
+        uint64_t state[25] = {};
+
+        auto absorb = [&state](const uint8_t *block)
+        {
+            for (size_t lane = 0; lane < RATE / 8; ++lane)
+            {
+                uint64_t value = 0;
+                for (int b = 7; b >= 0; --b)
+                    value = (value << 8) | block[lane * 8 + b];
+                state[lane] ^= value;
+            }
+            permute(state);
+        };
+
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+        size_t remaining = data.size();
+        while (remaining >= RATE)
+        {
+            absorb(bytes);
+            bytes += RATE;
+            remaining -= RATE;
+        }
+
+        uint8_t last[RATE] = {};
+        for (size_t k = 0; k < remaining; ++k)
+            last[k] = bytes[k];
+        last[remaining] ^= 0x01;
+        last[RATE - 1] ^= 0x80;
+        absorb(last);
+
+        std::array<uint8_t, 32> digest{};
+        for (size_t k = 0; k < 32; ++k)
+            digest[k] = static_cast<uint8_t>(state[k / 8] >> (8 * (k % 8)));
+        return digest;
+    }
+
+    inline std::string toHex(const uint8_t *bytes, size_t length)
+    {
+        static const char *digits = "0123456789abcdef";
+        std::string hex = "0x";
+        for (size_t k = 0; k < length; ++k)
+        {
+            hex.push_back(digits[bytes[k] >> 4]);
+            hex.push_back(digits[bytes[k] & 0x0F]);
+        }
+        return hex;
+    }
+
+    // topic0 of an event, e.g. "TokenExchange(address,int128,uint256,int128,uint256)"
+    inline std::string eventTopic(std::string_view signature)
+    {
+        auto digest = hash256(signature);
+        return toHex(digest.data(), digest.size());
+    }
+
+    // 4-byte selector of a function, e.g. "balances(uint256)" -> "0x4903b0d1"
+    inline std::string functionSelector(std::string_view signature)
+    {
+        auto digest = hash256(signature);
+        return toHex(digest.data(), 4);
+    }
+}
+
+#endif // KECCAK_H
@@ -16,6 +16,14 @@ enum class TimeInForce
     FOK  // Fill-Or-Kill: Execute entire order immediately or cancel completely
 };
 
+// Execution style enumeration - how a parent order is worked, independent of its TIF
+enum class ExecutionStyle
+{
+    SINGLE,  // One full-size swap when the limit is met
+    TWAP,    // Split evenly over N blocks, one child slice per block
+    ICEBERG  // Only a visible clip is worked at a time, re-posted until filled
+};
+
 // Order status enumeration
 enum class OrderStatus
 {
@@ -45,6 +53,7 @@ struct LimitOrder
     std::string pool_address;
     int32_t input_token_index;  // Token index in the Curve pool (e.g., 0, 1)
     int32_t output_token_index; // Token index in the Curve pool
+    bool underlying = false;    // Indices are a metapool's underlying coins (paired coin, then base pool coins)
 
     // Price and slippage settings
     double limit_price;        // Target exchange rate (output/input)
@@ -54,6 +63,12 @@ struct LimitOrder
     TimeInForce tif_policy;
     std::chrono::system_clock::time_point expiry_time; // Used for GTT orders
 
+    // Slicing (parent-child execution)
+    ExecutionStyle execution_style;
+    uint32_t twap_slices;        // Number of blocks a TWAP is spread over
+    uint64_t iceberg_clip;       // Visible clip size for ICEBERG orders
+    std::string parent_order_id; // Set on child slices, empty otherwise
+
     // Execution settings
     std::string user_address; // Address to receive output tokens
     std::string private_key;  // Private key for signing transactions (TODO: secure storage)
@@ -88,6 +103,9 @@ struct LimitOrder
           limit_price(limit_rate),
           slippage_tolerance(slippage),
           tif_policy(tif),
+          execution_style(ExecutionStyle::SINGLE),
+          twap_slices(0),
+          iceberg_clip(0),
           user_address(user_addr),
           private_key(priv_key),
           status(OrderStatus::PENDING),
@@ -129,6 +147,18 @@ struct LimitOrder
         return static_cast<double>(filled_amount) / static_cast<double>(input_amount) * 100.0;
     }
 
+    // Parent orders are worked through child slices by the engine scheduler
+    bool isSliced() const
+    {
+        return execution_style != ExecutionStyle::SINGLE;
+    }
+
+    // Child slice of a sliced parent
+    bool isChildSlice() const
+    {
+        return !parent_order_id.empty();
+    }
+
     // Check if price meets limit order criteria
     bool isPriceMet(uint64_t current_output) const
     {
@@ -220,10 +250,31 @@ struct LimitOrder
         }
     }
 
+    // Convert execution style enum to string for display
+    std::string getExecutionStyleString() const
+    {
+        switch (execution_style)
+        {
+        case ExecutionStyle::SINGLE:
+            return "SINGLE";
+        case ExecutionStyle::TWAP:
+            return "TWAP";
+        case ExecutionStyle::ICEBERG:
+            return "ICEBERG";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
     // Convert status enum to string for display
     std::string getStatusString() const
     {
-        switch (status)
+        return statusString(status);
+    }
+
+    static std::string statusString(OrderStatus value)
+    {
+        switch (value)
         {
         case OrderStatus::PENDING:
             return "PENDING";
@@ -251,6 +302,14 @@ struct LimitOrder
         std::cout << "ID: " << order_id << std::endl;
         std::cout << "Status: " << getStatusString() << std::endl;
         std::cout << "TIF: " << getTifString() << std::endl;
+        if (execution_style == ExecutionStyle::TWAP)
+        {
+            std::cout << "Execution: TWAP over " << twap_slices << " blocks" << std::endl;
+        }
+        else if (execution_style == ExecutionStyle::ICEBERG)
+        {
+            std::cout << "Execution: ICEBERG, clip " << iceberg_clip << std::endl;
+        }
         std::cout << "Input: " << input_amount << " tokens" << std::endl;
         std::cout << "Limit Price: " << limit_price << std::endl;
         std::cout << "Slippage: " << (slippage_tolerance * 100) << "%" << std::endl;
@@ -353,6 +412,50 @@ namespace OrderFactory
             limit_price, slippage, TimeInForce::FOK,
             user_address, private_key);
     }
+
+    // Create TWAP parent order (GTC) spread over a number of blocks
+    std::unique_ptr<LimitOrder> createTWAP(
+        const std::string &id,
+        const std::string &input_token,
+        const std::string &output_token,
+        uint64_t input_amount,
+        double limit_price,
+        double slippage,
+        uint32_t slices,
+        const std::string &user_address,
+        const std::string &private_key)
+    {
+
+        auto order = std::make_unique<LimitOrder>(
+            id, input_token, output_token, input_amount,
+            limit_price, slippage, TimeInForce::GTC,
+            user_address, private_key);
+        order->execution_style = ExecutionStyle::TWAP;
+        order->twap_slices = slices > 0 ? slices : 1;
+        return order;
+    }
+
+    // Create ICEBERG parent order (GTC) with a visible clip size
+    std::unique_ptr<LimitOrder> createIceberg(
+        const std::string &id,
+        const std::string &input_token,
+        const std::string &output_token,
+        uint64_t input_amount,
+        double limit_price,
+        double slippage,
+        uint64_t clip_size,
+        const std::string &user_address,
+        const std::string &private_key)
+    {
+
+        auto order = std::make_unique<LimitOrder>(
+            id, input_token, output_token, input_amount,
+            limit_price, slippage, TimeInForce::GTC,
+            user_address, private_key);
+        order->execution_style = ExecutionStyle::ICEBERG;
+        order->iceberg_clip = clip_size > 0 ? clip_size : input_amount;
+        return order;
+    }
 }
 
 #endif // LIMIT_ORDER_H
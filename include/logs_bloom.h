@@ -0,0 +1,114 @@
+#ifndef LOGS_BLOOM_H
+#define LOGS_BLOOM_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "keccak.h"
+
+// Block header logsBloom (2048 bits). Every log sets three bits for its address and three for
+// each topic, taken from the Keccak-256 of the raw bytes. A clear bit proves the block has no
+// such log, so scanners can skip the block without fetching its logs or transactions.
+class LogsBloom
+{
+public:
+    // The three bit positions of one address or topic; precompute once per watched item
+    struct Bits
+    {
+        std::array<uint16_t, 3> positions{};
+    };
+
+private:
+    std::array<uint8_t, 256> bytes{};
+
+    static int nibble(char c)
+    {
+        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                            : c >= 'A' && c <= 'F'   ? c - 'A' + 10
+                                                                     : -1;
+    }
+
+    // 0x-prefixed hex to raw bytes; empty on malformed input
+    static std::string decodeHex(const std::string &hex)
+    {
+        size_t start = hex.rfind("0x", 0) == 0 ? 2 : 0;
+        if ((hex.size() - start) % 2 != 0)
+            return {};
+        std::string raw;
+        raw.reserve((hex.size() - start) / 2);
+        for (size_t k = start; k < hex.size(); k += 2)
+        {
+            int high = nibble(hex[k]), low = nibble(hex[k + 1]);
+            if (high < 0 || low < 0)
+                return {};
+            raw.push_back(static_cast<char>((high << 4) | low));
+        }
+        return raw;
+    }
+
+    bool test(uint16_t position) const
+    {
+        return bytes[255 - position / 8] & (1u << (position % 8));
+    }
+
+public:
+    // Bits for an address (20 bytes) or topic (32 bytes) given as hex
+    static Bits bitsOf(const std::string &hex)
+    {
+        auto digest = Keccak::hash256(decodeHex(hex));
+        Bits bits;
+        for (size_t k = 0; k < 3; ++k)
+            bits.positions[k] = static_cast<uint16_t>(((digest[2 * k] << 8) | digest[2 * k + 1]) & 2047);
+        return bits;
+    }
+
+    static std::vector<Bits> bitsOf(const std::vector<std::string> &items)
+    {
+        std::vector<Bits> all;
+        for (const auto &item : items)
+            all.push_back(bitsOf(item));
+        return all;
+    }
+
+    // Parse a header's logsBloom; false unless it is exactly 256 bytes of hex
+    static bool parse(const std::string &hex, LogsBloom &bloom)
+    {
+        std::string raw = decodeHex(hex);
+        if (raw.size() != bloom.bytes.size())
+            return false;
+        for (size_t k = 0; k < raw.size(); ++k)
+            bloom.bytes[k] = static_cast<uint8_t>(raw[k]);
+        return true;
+    }
+
+    void add(const Bits &bits)
+    {
+        for (uint16_t position : bits.positions)
+            bytes[255 - position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+    }
+
+    // False means definitely absent; true may be a false positive
+    bool mayContain(const Bits &bits) const
+    {
+        return test(bits.positions[0]) && test(bits.positions[1]) && test(bits.positions[2]);
+    }
+
+    bool mayContainAny(const std::vector<Bits> &items) const
+    {
+        for (const auto &bits : items)
+        {
+            if (mayContain(bits))
+                return true;
+        }
+        return false;
+    }
+
+    std::string toHex() const
+    {
+        return Keccak::toHex(bytes.data(), bytes.size());
+    }
+};
+
+#endif // LOGS_BLOOM_H
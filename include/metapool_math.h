@@ -0,0 +1,151 @@
+#ifndef METAPOOL_MATH_H
+#define METAPOOL_MATH_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "pool_state.h"
+#include "stableswap_math.h"
+
+// A base pool as its metapools see it, read at one block
+struct BasePoolSnapshot
+{
+    PoolState state;
+    PoolAmount supply = 0;        // LP tokens outstanding
+    PoolAmount virtual_price = 0; // get_virtual_price(), 1e18 precision
+};
+
+// A metapool pairs one coin with a base pool's LP token: coins [coin, LP]. Its underlying coins
+// are the paired coin followed by the base pool's coins, so underlying index k >= MAX_COIN is
+// base coin k - MAX_COIN. The LP token is valued at the base pool's virtual price.
+struct MetapoolState
+{
+    PoolState meta; // The metapool's own two balances; rates[0] scales the paired coin
+    BasePoolSnapshot base;
+    PoolAmount cached_virtual_price = 0; // The metapool's stored base_virtual_price...
+    uint64_t cache_updated = 0;          // ...and when it was refreshed; 0 = no cache (factory metapools)
+    uint64_t timestamp = 0;              // Block time the state was read at
+    uint64_t block = 0;
+
+    static constexpr size_t MAX_COIN = 1;
+    static constexpr uint64_t BASE_CACHE_EXPIRES = 600; // Seconds the stored virtual price is trusted
+
+    // The LP price get_dy_underlying uses: the stored one while fresh, else the base pool's own
+    PoolAmount virtualPrice() const
+    {
+        if (cache_updated > 0 && timestamp <= cache_updated + BASE_CACHE_EXPIRES)
+            return cached_virtual_price;
+        return base.virtual_price;
+    }
+};
+
+// get_dy_underlying as the metapool computes it, over the long double StableSwap math:
+//  - both coins in the base pool: the base pool's own get_dy
+//  - base coin in: deposit dx into the base pool (calc_token_amount, less half the base fee as
+//    the contract approximates it) and swap that LP value through the metapool
+//  - base coin out: swap through the metapool, then withdraw the LP as coin j
+//    (calc_withdraw_one_coin)
+// Quotes are within uncertainty() of the pool's, not bit-exact.
+namespace MetapoolMath
+{
+    using Real = StableSwapMath::Real;
+
+    constexpr Real PRECISION = 1e18L;
+    constexpr Real RELATIVE_TOLERANCE = 1e-12L; // Integer rounding through two pools, with margin
+
+    // Base LP minted for depositing `amounts` (native units), before fees
+    inline Real calcTokenAmount(const BasePoolSnapshot &base, const std::vector<Real> &amounts, uint64_t timestamp)
+    {
+        std::vector<Real> xp = StableSwapMath::normalizedBalances(base.state);
+        Real amp = static_cast<Real>(base.state.amplification(timestamp));
+        Real d0 = StableSwapMath::getD(xp, amp);
+        if (d0 <= 0)
+            return 0;
+        for (size_t k = 0; k < xp.size() && k < amounts.size(); ++k)
+            xp[k] += amounts[k] * StableSwapMath::rateOf(base.state, k);
+        Real d1 = StableSwapMath::getD(xp, amp);
+        return (d1 - d0) * static_cast<Real>(base.supply) / d0;
+    }
+
+    // Coin i (native units, after the base pool's fee) for burning `token_amount` base LP
+    inline Real calcWithdrawOneCoin(const BasePoolSnapshot &base, Real token_amount, size_t i, uint64_t timestamp)
+    {
+        size_t n = base.state.balances.size();
+        if (i >= n || n < 2 || base.supply == 0)
+            return 0;
+        std::vector<Real> xp = StableSwapMath::normalizedBalances(base.state);
+        Real amp = static_cast<Real>(base.state.amplification(timestamp));
+        Real fee = static_cast<Real>(base.state.fee) * n / (4 * (n - 1)) / static_cast<Real>(PoolState::FEE_DENOMINATOR);
+
+        Real d0 = StableSwapMath::getD(xp, amp);
+        Real d1 = d0 - token_amount * d0 / static_cast<Real>(base.supply);
+        Real new_y = StableSwapMath::getYD(i, xp, amp, d1);
+
+        // Imbalance fee on what each coin would move by against a proportional withdrawal
+        std::vector<Real> reduced = xp;
+        for (size_t k = 0; k < n; ++k)
+        {
+            Real expected = k == i ? xp[k] * d1 / d0 - new_y : xp[k] - xp[k] * d1 / d0;
+            reduced[k] -= fee * expected;
+        }
+        Real dy = reduced[i] - StableSwapMath::getYD(i, reduced, amp, d1);
+        dy = (dy - 1) / StableSwapMath::rateOf(base.state, i);
+        return dy > 0 ? dy : 0;
+    }
+
+    // Output (native units of underlying coin j, after fees) for dx of underlying coin i, like
+    // the metapool's get_dy_underlying
+    inline Real getDyUnderlying(const MetapoolState &state, size_t i, size_t j, Real dx)
+    {
+        constexpr size_t max_coin = MetapoolState::MAX_COIN;
+        size_t base_n = state.base.state.balances.size();
+        if (i == j || i >= max_coin + base_n || j >= max_coin + base_n || state.meta.balances.size() != max_coin + 1)
+            return 0;
+        if (i >= max_coin && j >= max_coin)
+            return StableSwapMath::getDy(state.base.state, i - max_coin, j - max_coin, dx, state.timestamp);
+
+        Real vp = static_cast<Real>(state.virtualPrice()) / PRECISION;
+        if (vp <= 0 || state.base.supply == 0)
+            return 0;
+        std::vector<Real> xp{static_cast<Real>(state.meta.balances[0]) * StableSwapMath::rateOf(state.meta, 0),
+                             static_cast<Real>(state.meta.balances[max_coin]) * vp};
+
+        Real x;
+        if (i < max_coin)
+        {
+            x = xp[i] + dx * StableSwapMath::rateOf(state.meta, i);
+        }
+        else
+        {
+            std::vector<Real> amounts(base_n, 0);
+            amounts[i - max_coin] = dx;
+            x = calcTokenAmount(state.base, amounts, state.timestamp) * vp;
+            x -= x * static_cast<Real>(state.base.state.fee) / (2 * static_cast<Real>(PoolState::FEE_DENOMINATOR));
+            x += xp[max_coin];
+        }
+
+        size_t meta_i = std::min(i, max_coin);
+        size_t meta_j = std::min(j, max_coin);
+        Real amp = static_cast<Real>(state.meta.amplification(state.timestamp));
+        Real d = StableSwapMath::getD(xp, amp);
+        Real y = StableSwapMath::getY(meta_i, meta_j, x, xp, amp, d);
+        Real dy = xp[meta_j] - y - 1;
+        if (dy <= 0)
+            return 0;
+        dy -= dy * static_cast<Real>(state.meta.fee) / static_cast<Real>(PoolState::FEE_DENOMINATOR);
+
+        if (j < max_coin)
+            return dy / StableSwapMath::rateOf(state.meta, j);
+        return calcWithdrawOneCoin(state.base, dy / vp, j - max_coin, state.timestamp);
+    }
+
+    // How far the contract's integer get_dy_underlying may sit from getDyUnderlying()
+    inline Real uncertainty(Real output)
+    {
+        return output * RELATIVE_TOLERANCE + 4;
+    }
+}
+
+#endif // METAPOOL_MATH_H
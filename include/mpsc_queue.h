@@ -0,0 +1,75 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Lock-free multi-producer / single-consumer queue (Vyukov linked list).
+// push() is wait-free: one atomic exchange plus one release store. tryPop() never blocks,
+// but may briefly report empty while a producer is between those two steps; the consumer
+// simply picks the item up on its next drain. T must be default-constructible.
+template <typename T>
+class MpscQueue
+{
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node *> head; // Most recently pushed node (producers)
+    Node *tail;               // Stub / last consumed node (consumer only)
+
+public:
+    MpscQueue()
+    {
+        Node *stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue()
+    {
+        Node *node = tail;
+        while (node)
+        {
+            Node *next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // Any thread
+    void push(T value)
+    {
+        Node *node = new Node();
+        node->value = std::move(value);
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only; returns false when nothing is (yet) visible
+    bool tryPop(T &out)
+    {
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        out = std::move(next->value);
+        delete tail;
+        tail = next; // next becomes the new stub
+        return true;
+    }
+
+    // Consumer thread only
+    bool empty() const
+    {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,100 @@
+#ifndef NONCE_ALLOCATOR_H
+#define NONCE_ALLOCATOR_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+// Nonce Allocator - the one source of transaction nonces for a wallet, shared by approvals and
+// swaps on every thread and shard. Each nonce is the larger of the node's pending count and
+// one past the last we handed out, so two transactions signed before either is mined (a
+// top-up approve still in the mempool, two shards filling in one block) never share a nonce.
+// A nonce signed but never sent is released and handed out again before any higher one, so
+// it leaves no gap for later transactions to get stuck behind. Thread-safe.
+class NonceAllocator
+{
+public:
+    // eth_getTransactionCount(wallet, "pending"); throws when the node can't say
+    using PendingReader = std::function<uint64_t()>;
+
+private:
+    std::mutex mutex;
+    bool seeded = false;  // next_nonce follows a pending count the node gave us
+    bool guessed = false; // next_nonce follows the fallback; the node hasn't answered yet
+    uint64_t next_nonce = 0;
+    std::set<uint64_t> released;
+
+public:
+    // The next nonce to sign with. Asks the node for its pending count (under the lock, so
+    // callers take turns); `fallback` is asked only if the node never answered.
+    uint64_t acquire(const PendingReader &pending, const std::function<uint64_t()> &fallback)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool answered = false;
+        uint64_t node_pending = 0;
+        try
+        {
+            node_pending = pending();
+            answered = true;
+        }
+        catch (...)
+        {
+        }
+
+        uint64_t nonce;
+        if (answered)
+        {
+            // Released nonces the node has since seen used are gone for good; a count we
+            // only guessed at gives way to the node's
+            released.erase(released.begin(), released.lower_bound(node_pending));
+            nonce = seeded ? std::max(node_pending, next_nonce) : node_pending;
+            seeded = true;
+            guessed = false;
+        }
+        else
+        {
+            nonce = seeded || guessed ? next_nonce : fallback();
+            guessed = !seeded;
+        }
+
+        if (!released.empty() && *released.begin() < nonce)
+        {
+            uint64_t reused = *released.begin();
+            released.erase(released.begin());
+            return reused;
+        }
+        next_nonce = nonce + 1;
+        return nonce;
+    }
+
+    // A nonce that was signed with but never reached the node
+    void release(uint64_t nonce)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (nonce + 1 == next_nonce && released.empty())
+            next_nonce = nonce;
+        else if (nonce < next_nonce)
+            released.insert(nonce);
+    }
+
+    // The allocator every signer for `address` shares
+    static NonceAllocator &forWallet(const std::string &address)
+    {
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::unique_ptr<NonceAllocator>> registry;
+        std::string key = address;
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::unique_ptr<NonceAllocator> &allocator = registry[key];
+        if (!allocator)
+            allocator = std::make_unique<NonceAllocator>();
+        return *allocator;
+    }
+};
+
+#endif // NONCE_ALLOCATOR_H
@@ -0,0 +1,273 @@
+#ifndef ORDER_AGGREGATOR_H
+#define ORDER_AGGREGATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+#include "limit_order.h"
+
+// An order whose limit was met this tick, with the get_dy quote for its own size
+struct TriggeredOrder
+{
+    LimitOrder *order;
+    uint64_t quoted_output;
+};
+
+// What one order gets out of an aggregated execution
+struct FillAllocation
+{
+    LimitOrder *order;
+    uint64_t input_filled;
+    uint64_t output_received;
+    bool fully_netted; // Filled entirely by crossing against our own opposite orders
+};
+
+// One on-chain exchange (or none, if everything netted) covering several orders
+struct AggregatedSwap
+{
+    std::string pool_address;
+    int32_t input_index = 0;
+    int32_t output_index = 0;
+    uint64_t dx = 0;          // Net amount sent to the pool
+    uint64_t expected_dy = 0; // get_dy for dx
+    uint64_t min_dy = 0;      // expected_dy less the tightest slippage among participants
+    uint64_t netted_orders = 0;
+    std::vector<FillAllocation> allocations;
+
+    bool needsSwap() const
+    {
+        return dx > 0;
+    }
+};
+
+struct AggregationResult
+{
+    std::vector<AggregatedSwap> swaps;
+    std::vector<TriggeredOrder> deferred; // Orders whose limit fails at the aggregate size; execute alone
+};
+
+// Order Aggregator - nets opposite-direction orders on the same pool pair and coalesces
+// the remainder into a single exchange, allocating proceeds pro rata
+class OrderAggregator
+{
+public:
+    // get_dy(i, j, dx) on pool
+    using Quoter = std::function<uint64_t(const std::string &pool, int32_t i, int32_t j, uint64_t dx)>;
+
+private:
+    struct Side
+    {
+        std::vector<TriggeredOrder> orders;
+        double input_total = 0.0;
+        double quoted_total = 0.0;
+
+        void recompute()
+        {
+            input_total = 0.0;
+            quoted_total = 0.0;
+            for (const auto &t : orders)
+            {
+                input_total += static_cast<double>(t.order->input_amount - t.order->filled_amount);
+                quoted_total += static_cast<double>(t.quoted_output);
+            }
+        }
+    };
+
+    static uint64_t remainingInput(const LimitOrder &order)
+    {
+        return order.input_amount - order.filled_amount;
+    }
+
+    // Split total output across a side in proportion to each order's input; rounding dust goes last
+    static void allocate(const Side &side, uint64_t total_output, bool netted, AggregatedSwap &swap)
+    {
+        uint64_t assigned = 0;
+        for (size_t k = 0; k < side.orders.size(); ++k)
+        {
+            LimitOrder *order = side.orders[k].order;
+            uint64_t input = remainingInput(*order);
+            uint64_t share = (k + 1 == side.orders.size())
+                                 ? total_output - assigned
+                                 : static_cast<uint64_t>(static_cast<double>(total_output) * input / side.input_total);
+            assigned += share;
+            swap.allocations.push_back({order, input, share, netted});
+        }
+    }
+
+    // Remove the order with the highest limit from a side (it is the one most likely to fail)
+    static TriggeredOrder popStrictest(Side &side)
+    {
+        auto it = std::max_element(side.orders.begin(), side.orders.end(),
+                                   [](const TriggeredOrder &a, const TriggeredOrder &b)
+                                   { return a.order->limit_price < b.order->limit_price; });
+        TriggeredOrder removed = *it;
+        side.orders.erase(it);
+        side.recompute();
+        return removed;
+    }
+
+    static bool sideMeetsLimits(const Side &side, double rate)
+    {
+        for (const auto &t : side.orders)
+        {
+            if (rate < t.order->limit_price)
+                return false;
+        }
+        return true;
+    }
+
+    // Plan one pool pair; low/high are the pair's coin indices, forward means low -> high
+    AggregatedSwap planPair(const std::string &pool, int32_t low, int32_t high,
+                            Side forward, Side reverse,
+                            const Quoter &quoter, std::vector<TriggeredOrder> &deferred)
+    {
+        while (true)
+        {
+            AggregatedSwap swap;
+            swap.pool_address = pool;
+
+            if (forward.orders.empty() && reverse.orders.empty())
+                return swap;
+
+            // Internal crossing at the geometric mid of both sides' quotes (high per low)
+            double forward_internal_out = 0.0; // high-coin the forward side receives internally
+            double reverse_internal_out = 0.0; // low-coin the reverse side receives internally
+            double residual_in = 0.0;
+            bool residual_forward = !forward.orders.empty();
+            double cross_rate = 0.0;
+
+            if (!forward.orders.empty() && !reverse.orders.empty())
+            {
+                double forward_rate = forward.quoted_total / forward.input_total; // high per low
+                double reverse_rate = reverse.quoted_total / reverse.input_total; // low per high
+                cross_rate = std::sqrt(forward_rate / reverse_rate);
+
+                double reverse_in_low = reverse.input_total / cross_rate;
+                if (forward.input_total >= reverse_in_low)
+                {
+                    residual_forward = true;
+                    forward_internal_out = reverse.input_total;
+                    reverse_internal_out = reverse_in_low;
+                    residual_in = forward.input_total - reverse_in_low;
+                }
+                else
+                {
+                    residual_forward = false;
+                    reverse_internal_out = forward.input_total;
+                    forward_internal_out = forward.input_total * cross_rate;
+                    residual_in = reverse.input_total - forward.input_total * cross_rate;
+                }
+            }
+            else
+            {
+                residual_in = residual_forward ? forward.input_total : reverse.input_total;
+            }
+
+            Side &residual = residual_forward ? forward : reverse;
+            Side &crossed = residual_forward ? reverse : forward;
+
+            swap.input_index = residual_forward ? low : high;
+            swap.output_index = residual_forward ? high : low;
+            swap.dx = static_cast<uint64_t>(residual_in);
+            if (crossed.orders.empty() && residual.orders.size() == 1)
+            {
+                // A lone order already has a quote for exactly this size
+                swap.expected_dy = residual.orders.front().quoted_output;
+            }
+            else
+            {
+                swap.expected_dy = swap.dx > 0 ? quoter(pool, swap.input_index, swap.output_index, swap.dx) : 0;
+            }
+
+            // Every participant must still meet its own limit at the aggregate price
+            double residual_internal = residual_forward ? forward_internal_out : reverse_internal_out;
+            double residual_rate = (residual_internal + static_cast<double>(swap.expected_dy)) / residual.input_total;
+            if (!sideMeetsLimits(residual, residual_rate))
+            {
+                deferred.push_back(popStrictest(residual));
+                continue;
+            }
+
+            double crossed_rate = residual_forward ? 1.0 / cross_rate : cross_rate;
+            if (!crossed.orders.empty() && !sideMeetsLimits(crossed, crossed_rate))
+            {
+                deferred.push_back(popStrictest(crossed));
+                continue;
+            }
+
+            double tightest_slippage = 1.0;
+            for (const auto &t : residual.orders)
+                tightest_slippage = std::min(tightest_slippage, t.order->slippage_tolerance);
+            swap.min_dy = static_cast<uint64_t>(swap.expected_dy * (1.0 - tightest_slippage));
+
+            allocate(residual, static_cast<uint64_t>(residual_internal) + swap.expected_dy, swap.dx == 0, swap);
+            if (!crossed.orders.empty())
+            {
+                double crossed_out = residual_forward ? reverse_internal_out : forward_internal_out;
+                allocate(crossed, static_cast<uint64_t>(crossed_out), true, swap);
+                swap.netted_orders = crossed.orders.size();
+            }
+            return swap;
+        }
+    }
+
+public:
+    // Group triggered orders by pool pair, net and coalesce them
+    AggregationResult aggregate(const std::vector<TriggeredOrder> &triggered, const Quoter &quoter)
+    {
+        struct PairBook
+        {
+            int32_t low;
+            int32_t high;
+            Side forward;
+            Side reverse;
+        };
+
+        std::map<std::string, PairBook> books;
+        for (const auto &t : triggered)
+        {
+            const LimitOrder &order = *t.order;
+            int32_t low = std::min(order.input_token_index, order.output_token_index);
+            int32_t high = std::max(order.input_token_index, order.output_token_index);
+            std::string key = order.pool_address + ":" + std::to_string(low) + ":" + std::to_string(high);
+
+            PairBook &book = books[key];
+            book.low = low;
+            book.high = high;
+            (order.input_token_index == low ? book.forward : book.reverse).orders.push_back(t);
+        }
+
+        AggregationResult result;
+        for (auto &[key, book] : books)
+        {
+            book.forward.recompute();
+            book.reverse.recompute();
+            std::string pool = key.substr(0, key.find(':'));
+
+            AggregatedSwap swap = planPair(pool, book.low, book.high, book.forward, book.reverse, quoter, result.deferred);
+            if (!swap.allocations.empty())
+                result.swaps.push_back(std::move(swap));
+        }
+        return result;
+    }
+
+    // Write the outcome back to every participating order
+    static void applyFills(const AggregatedSwap &swap, const std::string &tx_hash)
+    {
+        for (const auto &fill : swap.allocations)
+        {
+            LimitOrder &order = *fill.order;
+            order.filled_amount += fill.input_filled;
+            order.received_amount += fill.output_received;
+            order.transaction_hash = fill.fully_netted ? "internal-netting" : tx_hash;
+            order.updateStatus(OrderStatus::FILLED, fill.fully_netted ? "Netted against opposite order" : "");
+        }
+    }
+};
+
+#endif // ORDER_AGGREGATOR_H
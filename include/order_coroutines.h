@@ -0,0 +1,402 @@
+#ifndef ORDER_COROUTINES_H
+#define ORDER_COROUTINES_H
+
+#include <coroutine>
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <iostream>
+
+// get_dy request raised by a suspended order lifecycle
+struct QuoteRequest
+{
+    std::string pool_address;
+    int32_t input_index = 0;
+    int32_t output_index = 0;
+    uint64_t dx = 0;
+    uint64_t decide_at = 0; // Smallest output that triggers the caller; 0 = needs the exact figure
+    uint64_t block = 0;     // Block the quote is for (stamped by the event loop)
+    bool underlying = false; // Metapool underlying-coin indices (get_dy_underlying)
+};
+
+struct QuoteResult
+{
+    bool ok = false;
+    uint64_t output = 0;
+    std::string error;
+};
+
+// Order Task - coroutine handle for one order lifecycle. Created suspended; the event loop
+// starts it, resumes it, and frees the frame once it finishes.
+class OrderTask
+{
+public:
+    struct promise_type
+    {
+        OrderTask get_return_object()
+        {
+            return OrderTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            try
+            {
+                throw;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "❌ Order lifecycle failed: " << e.what() << std::endl;
+            }
+        }
+
+        // Frame accounting: what a suspended order actually costs
+        static void *operator new(size_t size)
+        {
+            live_frame_bytes.fetch_add(size, std::memory_order_relaxed);
+            return ::operator new(size);
+        }
+
+        static void operator delete(void *frame, size_t size)
+        {
+            live_frame_bytes.fetch_sub(size, std::memory_order_relaxed);
+            ::operator delete(frame);
+        }
+    };
+
+    explicit OrderTask(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+    OrderTask(OrderTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    OrderTask &operator=(OrderTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    OrderTask(const OrderTask &) = delete;
+    OrderTask &operator=(const OrderTask &) = delete;
+
+    ~OrderTask()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    bool done() const
+    {
+        return !handle || handle.done();
+    }
+
+    std::coroutine_handle<> coroutine() const
+    {
+        return handle;
+    }
+
+    // Bytes held by all live order coroutine frames
+    static size_t liveFrameBytes()
+    {
+        return live_frame_bytes.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+    static inline std::atomic<size_t> live_frame_bytes{0};
+};
+
+// Event Loop - single thread driving every order lifecycle. Orders co_await the next block,
+// a timer, or a quote; quotes raised in the same turn are resolved together as one batch.
+class EventLoop
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Resolve a batch of quotes (results is pre-sized to requests)
+    using QuoteResolver = std::function<void(const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)>;
+
+private:
+    struct Timer
+    {
+        Clock::time_point due;
+        uint64_t sequence;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer &other) const
+        {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    struct PendingQuote
+    {
+        QuoteRequest request;
+        std::coroutine_handle<> handle;
+    };
+
+    struct BlockWaiter
+    {
+        uint64_t *block;
+        std::coroutine_handle<> handle;
+    };
+
+    std::chrono::milliseconds block_interval;
+    QuoteResolver resolver;
+
+    std::vector<OrderTask> tasks;
+    std::deque<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::vector<PendingQuote> pending_quotes;
+    std::vector<QuoteResult> resolved_quotes; // Last batch, read by the waiters as they resume
+    std::vector<BlockWaiter> block_waiters;
+    uint64_t timer_sequence = 0;
+    uint64_t current_block = 0;
+    Clock::time_point next_block_at;
+    uint64_t quote_batches = 0;
+
+    // Heads posted from other threads (e.g. a newHeads subscription)
+    std::mutex posted_mutex;
+    std::condition_variable posted_cv;
+    uint64_t posted_block = 0;
+    bool block_posted = false;
+
+    void resolveQuotes()
+    {
+        std::vector<PendingQuote> batch;
+        batch.swap(pending_quotes);
+
+        std::vector<QuoteRequest> requests;
+        requests.reserve(batch.size());
+        for (const auto &pending : batch)
+            requests.push_back(pending.request);
+
+        std::vector<QuoteResult> &results = resolved_quotes;
+        results.assign(batch.size(), QuoteResult());
+        if (resolver)
+        {
+            try
+            {
+                resolver(requests, results);
+            }
+            catch (const std::exception &e)
+            {
+                for (auto &result : results)
+                    result = {false, 0, e.what()};
+            }
+        }
+        else
+        {
+            for (auto &result : results)
+                result = {false, 0, "No quote resolver"};
+        }
+        quote_batches++;
+
+        for (const auto &pending : batch)
+            ready.push_back(pending.handle);
+    }
+
+    void reapFinished()
+    {
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                                   [](const OrderTask &task)
+                                   { return task.done(); }),
+                    tasks.end());
+    }
+
+public:
+    struct TimerAwaiter
+    {
+        EventLoop &loop;
+        Clock::time_point due;
+
+        bool await_ready() const { return Clock::now() >= due; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            loop.timers.push({due, loop.timer_sequence++, handle});
+        }
+        void await_resume() const {}
+    };
+
+    struct BlockAwaiter
+    {
+        EventLoop &loop;
+        uint64_t block = 0;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            loop.block_waiters.push_back({&block, handle});
+        }
+        uint64_t await_resume() const { return block; }
+    };
+
+    // Holds only a slot index: the request itself is queued on the loop when quote() is called,
+    // so nothing non-trivial lives in the awaiter temporary inside the coroutine frame
+    struct QuoteAwaiter
+    {
+        EventLoop &loop;
+        size_t slot;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            loop.pending_quotes[slot].handle = handle;
+        }
+        QuoteResult await_resume() { return std::move(loop.resolved_quotes[slot]); }
+    };
+
+    // Without a head subscription, a block is assumed every block_interval
+    explicit EventLoop(std::chrono::milliseconds interval, QuoteResolver quote_resolver = nullptr)
+        : block_interval(interval), resolver(std::move(quote_resolver)), next_block_at(Clock::now() + interval) {}
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    // Take ownership of a lifecycle; it starts on the next turn of run()
+    void spawn(OrderTask task)
+    {
+        ready.push_back(task.coroutine());
+        tasks.push_back(std::move(task));
+    }
+
+    TimerAwaiter sleepFor(std::chrono::milliseconds duration)
+    {
+        return TimerAwaiter{*this, Clock::now() + duration};
+    }
+
+    BlockAwaiter nextBlock()
+    {
+        return BlockAwaiter{*this};
+    }
+
+    // Must be co_awaited straight away; the quote is resolved with the rest of this turn's batch.
+    // Pass a named request: GCC 12 mis-relocates string-holding temporaries built inside a
+    // co_await expression.
+    QuoteAwaiter quote(const QuoteRequest &request)
+    {
+        pending_quotes.push_back({request, nullptr});
+        pending_quotes.back().request.block = current_block;
+        return QuoteAwaiter{*this, pending_quotes.size() - 1};
+    }
+
+    // A new head arrived (from the block interval, or an external source); wake block waiters
+    void notifyBlock(uint64_t block)
+    {
+        current_block = std::max(current_block, block);
+        next_block_at = Clock::now() + block_interval;
+
+        std::vector<BlockWaiter> waiters;
+        waiters.swap(block_waiters);
+        for (auto &waiter : waiters)
+        {
+            *waiter.block = current_block;
+            ready.push_back(waiter.handle);
+        }
+    }
+
+    // Thread-safe: hand a new head to the loop; wakes it if it is sleeping
+    void postBlock(uint64_t block)
+    {
+        {
+            std::lock_guard<std::mutex> lock(posted_mutex);
+            posted_block = std::max(posted_block, block);
+            block_posted = true;
+        }
+        posted_cv.notify_one();
+    }
+
+    // Run until every lifecycle has finished
+    void run()
+    {
+        while (true)
+        {
+            while (!ready.empty())
+            {
+                std::coroutine_handle<> handle = ready.front();
+                ready.pop_front();
+                handle.resume();
+            }
+
+            reapFinished();
+            if (tasks.empty())
+                return;
+
+            if (!pending_quotes.empty())
+            {
+                resolveQuotes();
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(posted_mutex);
+                if (block_posted)
+                {
+                    block_posted = false;
+                    notifyBlock(posted_block);
+                }
+            }
+
+            Clock::time_point now = Clock::now();
+            while (!timers.empty() && timers.top().due <= now)
+            {
+                ready.push_back(timers.top().handle);
+                timers.pop();
+            }
+            if (!block_waiters.empty() && now >= next_block_at)
+            {
+                notifyBlock(current_block + 1);
+            }
+            if (!ready.empty())
+                continue;
+
+            if (timers.empty() && block_waiters.empty())
+            {
+                std::cerr << "⚠️ Event loop stalled with " << tasks.size() << " orders waiting on nothing" << std::endl;
+                return;
+            }
+
+            Clock::time_point wake = Clock::time_point::max();
+            if (!timers.empty())
+                wake = timers.top().due;
+            if (!block_waiters.empty())
+                wake = std::min(wake, next_block_at);
+            std::unique_lock<std::mutex> lock(posted_mutex);
+            posted_cv.wait_until(lock, wake, [this]
+                                 { return block_posted; });
+        }
+    }
+
+    size_t liveTasks() const
+    {
+        return tasks.size();
+    }
+
+    uint64_t currentBlock() const
+    {
+        return current_block;
+    }
+
+    uint64_t quoteBatches() const
+    {
+        return quote_batches;
+    }
+};
+
+#endif // ORDER_COROUTINES_H
@@ -0,0 +1,150 @@
+#ifndef ORDER_SHARDS_H
+#define ORDER_SHARDS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <cctype>
+
+#include "limit_order.h"
+#include "mpsc_queue.h"
+
+// Fill / status change reported by a shard to the coordinator
+struct OrderUpdate
+{
+    size_t shard = 0;
+    std::string order_id;
+    OrderStatus status = OrderStatus::PENDING;
+    uint64_t filled_amount = 0;
+    uint64_t received_amount = 0;
+    std::string transaction_hash;
+    std::string failure_reason;
+    bool shard_done = false; // Last message a shard sends; carries no order
+};
+
+// Shard Router - pins every pool to one shard so a pool's orders, quotes and swaps
+// stay on a single thread
+class ShardRouter
+{
+public:
+    // FNV-1a over the lowercased address: stable across runs and checksum casing
+    static size_t shardFor(const std::string &pool_address, size_t shard_count)
+    {
+        if (shard_count <= 1)
+            return 0;
+
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : pool_address)
+        {
+            hash ^= static_cast<uint64_t>(std::tolower(c));
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash % shard_count);
+    }
+};
+
+// Shard Publisher - owned by one shard thread; pushes only orders that changed since the last call
+class ShardPublisher
+{
+private:
+    struct Published
+    {
+        OrderStatus status;
+        uint64_t filled_amount;
+    };
+
+    size_t shard;
+    MpscQueue<OrderUpdate> &queue;
+    std::unordered_map<const LimitOrder *, Published> published;
+
+public:
+    ShardPublisher(size_t shard_index, MpscQueue<OrderUpdate> &updates)
+        : shard(shard_index), queue(updates) {}
+
+    size_t publish(const std::vector<std::unique_ptr<LimitOrder>> &orders)
+    {
+        size_t sent = 0;
+        for (const auto &order : orders)
+        {
+            auto it = published.find(order.get());
+            if (it != published.end() && it->second.status == order->status &&
+                it->second.filled_amount == order->filled_amount)
+                continue;
+
+            published[order.get()] = {order->status, order->filled_amount};
+
+            OrderUpdate update;
+            update.shard = shard;
+            update.order_id = order->order_id;
+            update.status = order->status;
+            update.filled_amount = order->filled_amount;
+            update.received_amount = order->received_amount;
+            update.transaction_hash = order->transaction_hash;
+            update.failure_reason = order->failure_reason;
+            queue.push(std::move(update));
+            sent++;
+        }
+        return sent;
+    }
+
+    void finish()
+    {
+        OrderUpdate done;
+        done.shard = shard;
+        done.shard_done = true;
+        queue.push(std::move(done));
+    }
+};
+
+// Shard Coordinator - single consumer of every shard's updates; keeps the latest view per order
+class ShardCoordinator
+{
+private:
+    size_t shard_count;
+    size_t shards_done = 0;
+    MpscQueue<OrderUpdate> queue;
+    std::map<std::string, OrderUpdate> latest;
+
+public:
+    explicit ShardCoordinator(size_t shards) : shard_count(shards) {}
+
+    MpscQueue<OrderUpdate> &updates()
+    {
+        return queue;
+    }
+
+    // Apply everything visible so far; returns the number of order updates applied
+    size_t drain(const std::function<void(const OrderUpdate &)> &on_update = nullptr)
+    {
+        size_t applied = 0;
+        OrderUpdate update;
+        while (queue.tryPop(update))
+        {
+            if (update.shard_done)
+            {
+                shards_done++;
+                continue;
+            }
+            if (on_update)
+                on_update(update);
+            latest[update.order_id] = update;
+            applied++;
+        }
+        return applied;
+    }
+
+    bool allDone() const
+    {
+        return shards_done >= shard_count;
+    }
+
+    const std::map<std::string, OrderUpdate> &orders() const
+    {
+        return latest;
+    }
+};
+
+#endif // ORDER_SHARDS_H
@@ -0,0 +1,123 @@
+#ifndef POLL_SCHEDULER_H
+#define POLL_SCHEDULER_H
+
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+// Poll Scheduler - decides how many blocks an order may go unquoted. Each market (pool and
+// direction) keeps an EWMA of realized per-block variance from the quotes the engine already
+// takes. The chance that an order `gap` (log distance) from its limit triggers within h blocks
+// is then ~ 2 * (1 - N(gap / (sigma * sqrt(h)))), from the reflection principle for a random
+// walk. Orders back off exponentially (1, 2, 4 ... blocks) while that chance stays small and
+// drop straight back to every block once it isn't.
+class PollScheduler
+{
+public:
+    static constexpr double TRIGGER_PROBABILITY = 0.05; // Check before crossing odds exceed this
+    static constexpr uint64_t MAX_INTERVAL = 32;        // Blocks; far orders are still re-checked
+    static constexpr double SMOOTHING = 0.2;            // EWMA weight of the newest return
+    static constexpr double DEFAULT_SIGMA = 0.001;      // Per-block volatility before any history
+    static constexpr double MIN_SIGMA = 0.00001;        // Flat quotes don't prove a flat market
+
+private:
+    struct Market
+    {
+        double last_price = 0;
+        uint64_t last_block = 0;
+        double variance = DEFAULT_SIGMA * DEFAULT_SIGMA;
+        bool has_return = false;
+    };
+
+    struct Schedule
+    {
+        uint64_t interval = 1;
+        uint64_t due = 0;
+    };
+
+    std::unordered_map<std::string, Market> markets;
+    std::unordered_map<std::string, Schedule> schedules;
+    uint64_t deferred = 0;
+
+public:
+    // Record a quote (output per unit input) seen at `block`
+    void observe(const std::string &market, uint64_t block, double price)
+    {
+        if (price <= 0.0)
+            return;
+        Market &state = markets[market];
+        if (state.last_price > 0.0 && block > state.last_block)
+        {
+            double r = std::log(price / state.last_price);
+            double sample = r * r / static_cast<double>(block - state.last_block);
+            state.variance = state.has_return ? SMOOTHING * sample + (1.0 - SMOOTHING) * state.variance : sample;
+            state.has_return = true;
+        }
+        if (block >= state.last_block)
+        {
+            state.last_price = price;
+            state.last_block = block;
+        }
+    }
+
+    // Realized per-block volatility (log terms)
+    double sigma(const std::string &market) const
+    {
+        auto it = markets.find(market);
+        if (it == markets.end())
+            return DEFAULT_SIGMA;
+        return std::max(std::sqrt(it->second.variance), MIN_SIGMA);
+    }
+
+    // Chance a price `gap` below its limit (log terms) reaches it within `blocks`
+    static double crossProbability(double gap, double sigma, uint64_t blocks)
+    {
+        if (gap <= 0.0)
+            return 1.0;
+        double spread = sigma * std::sqrt(static_cast<double>(std::max<uint64_t>(blocks, 1)));
+        if (spread <= 0.0)
+            return 0.0;
+        return std::erfc(gap / (spread * std::sqrt(2.0))); // 2 * (1 - N(gap / spread))
+    }
+
+    // After a check at `block` that didn't trigger: how many blocks until the order's next
+    // quote. Doubles the previous interval, then halves until the crossing odds are acceptable.
+    uint64_t schedule(const std::string &order_id, const std::string &market, uint64_t block,
+                      double quoted_output, double required_output)
+    {
+        Schedule &entry = schedules[order_id];
+        double gap = quoted_output > 0.0 && required_output > 0.0 ? std::log(required_output / quoted_output) : 0.0;
+        double vol = sigma(market);
+
+        uint64_t interval = std::min(entry.interval * 2, MAX_INTERVAL);
+        while (interval > 1 && crossProbability(gap, vol, interval) > TRIGGER_PROBABILITY)
+            interval /= 2;
+
+        entry.interval = interval;
+        entry.due = block + interval;
+        deferred += interval - 1;
+        return interval;
+    }
+
+    // True if the order should be quoted at `block`
+    bool due(const std::string &order_id, uint64_t block) const
+    {
+        auto it = schedules.find(order_id);
+        return it == schedules.end() || block >= it->second.due;
+    }
+
+    void forget(const std::string &order_id)
+    {
+        schedules.erase(order_id);
+    }
+
+    // Order-blocks that went unquoted because of backoff
+    uint64_t deferredChecks() const
+    {
+        return deferred;
+    }
+};
+
+#endif // POLL_SCHEDULER_H
@@ -0,0 +1,539 @@
+#ifndef POOL_STATE_H
+#define POOL_STATE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+
+#include "keccak.h"
+#include "ws_subscriber.h"
+
+// Token amounts in pool units; 128 bits covers any real stablecoin balance at 18 decimals
+using PoolAmount = unsigned __int128;
+
+// StableSwap pool state as the contract stores it (fees in 1e10 precision, A in plain units)
+struct PoolState
+{
+    std::vector<PoolAmount> balances;
+    std::vector<uint64_t> rates; // Per-coin multiplier to 18 decimals (10^(18 - decimals)); empty = all 18
+    uint64_t fee = 0;
+    uint64_t admin_fee = 0;
+    uint64_t initial_A = 0;
+    uint64_t future_A = 0;
+    uint64_t initial_A_time = 0;
+    uint64_t future_A_time = 0;
+    uint64_t a_precision = 1; // A_PRECISION: ramps are stored and logged as A times this (100 on newer pools)
+    uint64_t block = 0;       // Last block folded into this state
+
+    static constexpr uint64_t FEE_DENOMINATOR = 10000000000ULL;
+
+    // The contract's _A(): linear ramp between initial and future A
+    uint64_t amplification(uint64_t timestamp) const
+    {
+        if (timestamp >= future_A_time || future_A_time <= initial_A_time)
+            return future_A;
+        uint64_t elapsed = timestamp > initial_A_time ? timestamp - initial_A_time : 0;
+        uint64_t span = future_A_time - initial_A_time;
+        if (future_A > initial_A)
+            return initial_A + (future_A - initial_A) * elapsed / span;
+        return initial_A - (initial_A - future_A) * elapsed / span;
+    }
+
+    // FNV-1a over everything a quote depends on, at the given block time
+    uint64_t checksum(uint64_t timestamp) const
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](uint64_t word)
+        {
+            for (int shift = 0; shift < 64; shift += 8)
+            {
+                hash ^= (word >> shift) & 0xFF;
+                hash *= 1099511628211ULL;
+            }
+        };
+        for (PoolAmount balance : balances)
+        {
+            mix(static_cast<uint64_t>(balance));
+            mix(static_cast<uint64_t>(balance >> 64));
+        }
+        mix(fee);
+        mix(admin_fee);
+        mix(amplification(timestamp));
+        return hash;
+    }
+};
+
+// Pool State Store - event-sourced StableSwap state. Seeded once from the chain, then kept
+// current by folding in TokenExchange / AddLiquidity / RemoveLiquidity* / RampA logs, with a
+// per-block undo log so reorged blocks roll back. Heads are checked for continuity: a skipped
+// height (logs may have been missed) flags every pool for a resync, a head that doesn't extend
+// the last one rolls the orphaned blocks back. Events that can't be replayed exactly
+// (RemoveLiquidityOne carries no coin index) flag the pool for a resync; a periodic checksum
+// against on-chain values catches rounding drift. Thread-safe.
+class PoolStateStore
+{
+public:
+    enum class ApplyResult
+    {
+        APPLIED,
+        IGNORED,      // Unknown pool or event, or already in the seed snapshot
+        DUPLICATE,    // Same log delivered twice (e.g. after a resubscribe)
+        ROLLED_BACK,  // removed=true log: its block was undone
+        NEEDS_RESYNC  // State can no longer be trusted until re-read from the chain
+    };
+
+    // How a head relates to the one before it
+    enum class HeadCheck
+    {
+        IN_SEQUENCE, // Extends the last head (or is the first / a repeat of it)
+        GAP,         // Heights were skipped: pools are flagged for resync
+        REORG        // Replaces a block we saw: orphaned blocks were rolled back
+    };
+
+    static constexpr uint64_t DEFAULT_UNDO_DEPTH = 64;
+
+private:
+    enum class EventKind
+    {
+        TOKEN_EXCHANGE,
+        ADD_LIQUIDITY,
+        REMOVE_LIQUIDITY,
+        REMOVE_LIQUIDITY_IMBALANCE,
+        REMOVE_LIQUIDITY_ONE,
+        RAMP_A,
+        STOP_RAMP_A
+    };
+
+    struct EventSpec
+    {
+        EventKind kind;
+        size_t coins; // For fixed-size array events; 0 otherwise
+    };
+
+    struct UndoEntry
+    {
+        uint64_t block;
+        PoolState before; // State before this block's first log
+        std::vector<std::pair<std::string, uint64_t>> applied; // (block hash, log index)
+    };
+
+    struct TrackedPool
+    {
+        PoolState state;
+        std::deque<UndoEntry> undo;
+        uint64_t pruned_through = 0; // Undo history ends here
+        bool needs_resync = false;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, TrackedPool> pools;
+    uint64_t undo_depth;
+    uint64_t latest_timestamp = 0;
+    uint64_t last_head = 0; // 0: no head seen yet
+    std::string last_head_hash;
+    uint64_t applied_count = 0;
+    uint64_t rollback_count = 0;
+    uint64_t resync_count = 0;
+    uint64_t gap_count = 0;
+    uint64_t reorg_count = 0;
+
+    static std::string normalize(const std::string &address)
+    {
+        std::string key = address;
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        return key;
+    }
+
+    // topic0 -> event, for 2-4 coin pools
+    static const std::map<std::string, EventSpec> &eventTopics()
+    {
+        static const std::map<std::string, EventSpec> topics = []
+        {
+            std::map<std::string, EventSpec> table;
+            table[Keccak::eventTopic("TokenExchange(address,int128,uint256,int128,uint256)")] = {EventKind::TOKEN_EXCHANGE, 0};
+            table[Keccak::eventTopic("RemoveLiquidityOne(address,uint256,uint256)")] = {EventKind::REMOVE_LIQUIDITY_ONE, 0};
+            table[Keccak::eventTopic("RampA(uint256,uint256,uint256,uint256)")] = {EventKind::RAMP_A, 0};
+            table[Keccak::eventTopic("StopRampA(uint256,uint256)")] = {EventKind::STOP_RAMP_A, 0};
+            for (size_t n = 2; n <= 4; ++n)
+            {
+                std::string array = "uint256[" + std::to_string(n) + "]";
+                table[Keccak::eventTopic("AddLiquidity(address," + array + "," + array + ",uint256,uint256)")] = {EventKind::ADD_LIQUIDITY, n};
+                table[Keccak::eventTopic("RemoveLiquidity(address," + array + "," + array + ",uint256)")] = {EventKind::REMOVE_LIQUIDITY, n};
+                table[Keccak::eventTopic("RemoveLiquidityImbalance(address," + array + "," + array + ",uint256,uint256)")] = {EventKind::REMOVE_LIQUIDITY_IMBALANCE, n};
+            }
+            return table;
+        }();
+        return topics;
+    }
+
+    // 32-byte word `index` of a log's data; false if missing or wider than 128 bits
+    static bool word(const std::string &data, size_t index, PoolAmount &value)
+    {
+        size_t start = 2 + index * 64;
+        if (data.size() < start + 64)
+            return false;
+        for (size_t k = start; k < start + 32; ++k)
+        {
+            if (data[k] != '0')
+                return false;
+        }
+        return parseAmount(data.substr(start + 32, 32), value);
+    }
+
+    static PoolAmount adminShare(PoolAmount fee_amount, uint64_t admin_fee)
+    {
+        return fee_amount * admin_fee / PoolState::FEE_DENOMINATOR;
+    }
+
+    // Fold one log into state; false if it can't be replayed exactly
+    static bool fold(PoolState &state, const EventSpec &spec, const std::string &data)
+    {
+        size_t n = state.balances.size();
+        PoolAmount a = 0, b = 0, c = 0, d = 0;
+        switch (spec.kind)
+        {
+        case EventKind::TOKEN_EXCHANGE:
+        {
+            // sold_id, tokens_sold, bought_id, tokens_bought. The pool also kept the admin
+            // share of the fee, which the event doesn't carry: recover it from the fee rate.
+            if (!word(data, 0, a) || !word(data, 1, b) || !word(data, 2, c) || !word(data, 3, d) ||
+                a >= n || c >= n || state.fee >= PoolState::FEE_DENOMINATOR)
+                return false;
+            PoolAmount fee_amount = d * state.fee / (PoolState::FEE_DENOMINATOR - state.fee);
+            PoolAmount removed = d + adminShare(fee_amount, state.admin_fee);
+            if (state.balances[static_cast<size_t>(c)] < removed)
+                return false;
+            state.balances[static_cast<size_t>(a)] += b;
+            state.balances[static_cast<size_t>(c)] -= removed;
+            return true;
+        }
+        case EventKind::ADD_LIQUIDITY:
+        case EventKind::REMOVE_LIQUIDITY:
+        case EventKind::REMOVE_LIQUIDITY_IMBALANCE:
+        {
+            if (spec.coins != n)
+                return false; // Same signature from a pool with a different coin count
+            for (size_t i = 0; i < n; ++i)
+            {
+                PoolAmount amount = 0, fee_amount = 0;
+                if (!word(data, i, amount) || !word(data, n + i, fee_amount))
+                    return false;
+                PoolAmount admin = adminShare(fee_amount, state.admin_fee);
+                if (spec.kind == EventKind::ADD_LIQUIDITY)
+                {
+                    state.balances[i] += amount - std::min(amount, admin);
+                }
+                else
+                {
+                    PoolAmount removed = amount + (spec.kind == EventKind::REMOVE_LIQUIDITY_IMBALANCE ? admin : 0);
+                    if (state.balances[i] < removed)
+                        return false;
+                    state.balances[i] -= removed;
+                }
+            }
+            return true;
+        }
+        case EventKind::RAMP_A:
+            if (!word(data, 0, a) || !word(data, 1, b) || !word(data, 2, c) || !word(data, 3, d))
+                return false;
+            state.initial_A = static_cast<uint64_t>(a / state.a_precision);
+            state.future_A = static_cast<uint64_t>(b / state.a_precision);
+            state.initial_A_time = static_cast<uint64_t>(c);
+            state.future_A_time = static_cast<uint64_t>(d);
+            return true;
+        case EventKind::STOP_RAMP_A:
+            if (!word(data, 0, a) || !word(data, 1, b))
+                return false;
+            state.initial_A = state.future_A = static_cast<uint64_t>(a / state.a_precision);
+            state.initial_A_time = state.future_A_time = static_cast<uint64_t>(b);
+            return true;
+        case EventKind::REMOVE_LIQUIDITY_ONE:
+            return false; // No coin index in the event
+        }
+        return false;
+    }
+
+    // Caller holds the lock. Undo every block after `block`; false if history doesn't reach back
+    bool rollbackPool(TrackedPool &pool, uint64_t block)
+    {
+        if (pool.state.block <= block)
+            return true;
+        if (block < pool.pruned_through)
+            return false;
+
+        auto first = std::find_if(pool.undo.begin(), pool.undo.end(), [block](const UndoEntry &entry)
+                                  { return entry.block > block; });
+        if (first == pool.undo.end())
+            return false;
+        pool.state = first->before;
+        pool.undo.erase(first, pool.undo.end());
+        rollback_count++;
+        return true;
+    }
+
+    // Caller holds the lock. True if a log from a block after `block` carried one of `hashes`
+    static bool foldedFrom(const TrackedPool &pool, uint64_t block, const std::vector<std::string> &hashes)
+    {
+        for (const auto &entry : pool.undo)
+        {
+            if (entry.block <= block)
+                continue;
+            for (const auto &[hash, index] : entry.applied)
+            {
+                if (std::find(hashes.begin(), hashes.end(), hash) != hashes.end())
+                    return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    explicit PoolStateStore(uint64_t depth = DEFAULT_UNDO_DEPTH) : undo_depth(depth) {}
+
+    // "0x..." hex (or bare hex digits) to an amount; false if empty, malformed or over 128 bits
+    static bool parseAmount(const std::string &hex, PoolAmount &value)
+    {
+        size_t start = hex.rfind("0x", 0) == 0 ? 2 : 0;
+        while (start < hex.size() && hex[start] == '0')
+            start++;
+        if (hex.size() - start > 32)
+            return false;
+        value = 0;
+        for (size_t k = start; k < hex.size(); ++k)
+        {
+            char c = hex[k];
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                                     : c >= 'A' && c <= 'F'   ? c - 'A' + 10
+                                                                              : -1;
+            if (digit < 0)
+                return false;
+            value = (value << 4) | static_cast<PoolAmount>(digit);
+        }
+        return true;
+    }
+
+    // Start (or restart) tracking a pool from a chain snapshot taken at state.block
+    void seed(const std::string &pool, const PoolState &state)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        TrackedPool &tracked = pools[normalize(pool)];
+        tracked.state = state;
+        tracked.undo.clear();
+        tracked.pruned_through = state.block;
+        tracked.needs_resync = false;
+    }
+
+    ApplyResult apply(const PoolLog &log)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pools.find(normalize(log.address));
+        if (it == pools.end())
+            return ApplyResult::IGNORED;
+        TrackedPool &pool = it->second;
+
+        if (log.removed)
+        {
+            if (rollbackPool(pool, log.block_number - 1))
+                return ApplyResult::ROLLED_BACK;
+            pool.needs_resync = true;
+            return ApplyResult::NEEDS_RESYNC;
+        }
+        if (pool.needs_resync)
+            return ApplyResult::NEEDS_RESYNC;
+        if (log.block_number <= pool.pruned_through)
+            return ApplyResult::IGNORED; // Already in the seed snapshot
+
+        auto spec = log.topics.empty() ? eventTopics().end() : eventTopics().find(log.topics.front());
+        if (spec == eventTopics().end())
+            return ApplyResult::IGNORED;
+
+        std::pair<std::string, uint64_t> key{log.block_hash, log.log_index};
+        for (const auto &entry : pool.undo)
+        {
+            if (entry.block == log.block_number &&
+                std::find(entry.applied.begin(), entry.applied.end(), key) != entry.applied.end())
+                return ApplyResult::DUPLICATE;
+        }
+        if (log.block_number < pool.state.block)
+        {
+            pool.needs_resync = true; // Out of order: the undo log can't express it
+            return ApplyResult::NEEDS_RESYNC;
+        }
+
+        PoolState next = pool.state;
+        if (!fold(next, spec->second, log.data))
+        {
+            pool.needs_resync = true;
+            return ApplyResult::NEEDS_RESYNC;
+        }
+        next.block = log.block_number;
+
+        if (pool.undo.empty() || pool.undo.back().block != log.block_number)
+            pool.undo.push_back({log.block_number, pool.state, {}});
+        pool.undo.back().applied.push_back(key);
+        pool.state = std::move(next);
+        applied_count++;
+        return ApplyResult::APPLIED;
+    }
+
+    // New head: check it extends the last one, remember its time (for A ramps) and drop undo
+    // history past the reorg horizon. A head at or below the last height, or whose parent isn't
+    // the last head, replaced blocks we folded: those are rolled back, unless logs from the new
+    // chain already landed on top of them (then the pool resyncs, as it can't be unwound).
+    HeadCheck onHead(const NewHead &head)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest_timestamp = std::max(latest_timestamp, head.timestamp);
+
+        HeadCheck check = HeadCheck::IN_SEQUENCE;
+        bool repeat = head.number == last_head && !head.hash.empty() && head.hash == last_head_hash;
+        if (last_head != 0 && !repeat)
+        {
+            bool extends = head.parent_hash.empty() || last_head_hash.empty() || head.parent_hash == last_head_hash;
+            if (head.number > last_head + 1)
+                check = HeadCheck::GAP;
+            else if (head.number <= last_head || !extends)
+                check = HeadCheck::REORG;
+        }
+
+        if (check == HeadCheck::GAP)
+        {
+            for (auto &[address, pool] : pools)
+                pool.needs_resync = true;
+            gap_count++;
+        }
+        else if (check == HeadCheck::REORG)
+        {
+            // First replaced height: the head's own if it isn't above the last, else its parent's
+            uint64_t replaced = head.number <= last_head ? head.number : head.number - 1;
+            uint64_t fork = replaced > 0 ? replaced - 1 : 0;
+            std::vector<std::string> canonical = {head.hash, head.parent_hash};
+            for (auto &[address, pool] : pools)
+            {
+                if (foldedFrom(pool, fork, canonical) || !rollbackPool(pool, fork))
+                    pool.needs_resync = true;
+            }
+            reorg_count++;
+        }
+        last_head = head.number;
+        last_head_hash = head.hash;
+
+        if (head.number <= undo_depth)
+            return check;
+        uint64_t horizon = head.number - undo_depth;
+        for (auto &[address, pool] : pools)
+        {
+            while (!pool.undo.empty() && pool.undo.front().block <= horizon)
+            {
+                pool.pruned_through = std::max(pool.pruned_through, pool.undo.front().block);
+                pool.undo.pop_front();
+            }
+        }
+        return check;
+    }
+
+    // The feed dropped: logs may have been missed, so no pool is trusted until re-read
+    void resyncAll()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &[address, pool] : pools)
+            pool.needs_resync = true;
+    }
+
+    // Undo every block after `block` on all pools (e.g. a head whose parent we never saw)
+    void rollbackTo(uint64_t block)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &[address, pool] : pools)
+        {
+            if (!rollbackPool(pool, block))
+                pool.needs_resync = true;
+        }
+    }
+
+    // Compare with a fresh chain snapshot; on mismatch adopt the chain's values. True if equal.
+    bool verify(const std::string &pool, const PoolState &onchain)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pools.find(normalize(pool));
+        uint64_t timestamp = latest_timestamp;
+        bool matches = it != pools.end() && !it->second.needs_resync &&
+                       it->second.state.checksum(timestamp) == onchain.checksum(timestamp);
+        if (matches)
+            return true;
+
+        TrackedPool &tracked = pools[normalize(pool)];
+        tracked.state = onchain;
+        tracked.undo.clear();
+        tracked.pruned_through = onchain.block;
+        tracked.needs_resync = false;
+        resync_count++;
+        return false;
+    }
+
+    std::optional<PoolState> state(const std::string &pool) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pools.find(normalize(pool));
+        if (it == pools.end() || it->second.needs_resync)
+            return std::nullopt;
+        return it->second.state;
+    }
+
+    bool needsResync(const std::string &pool) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pools.find(normalize(pool));
+        return it != pools.end() && it->second.needs_resync;
+    }
+
+    size_t undoDepth(const std::string &pool) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pools.find(normalize(pool));
+        return it == pools.end() ? 0 : it->second.undo.size();
+    }
+
+    uint64_t latestTimestamp() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return latest_timestamp;
+    }
+
+    uint64_t appliedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return applied_count;
+    }
+
+    uint64_t rollbackCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rollback_count;
+    }
+
+    uint64_t resyncCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return resync_count;
+    }
+
+    uint64_t gapCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return gap_count;
+    }
+
+    uint64_t reorgCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reorg_count;
+    }
+};
+
+#endif // POOL_STATE_H
@@ -0,0 +1,114 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+// What went wrong with an RPC request, as far as retrying it is concerned
+enum class RpcErrorClass
+{
+    TRANSPORT,    // Connection refused / reset / timed out: the provider may be down
+    RATE_LIMITED, // HTTP 429, JSON-RPC -32005: back off harder
+    SERVER,       // HTTP 5xx, JSON-RPC -32603: the provider is struggling
+    REJECTED,     // The node answered (revert, bad params): asking again gets the same answer
+    DEADLINE      // The caller ran out of time: nothing left to retry with
+};
+
+// Retry Policy - whether and when to retry an RPC request, per error class. Delays grow
+// exponentially from the class's base up to its cap with full jitter (uniform in [0, delay]),
+// so callers that failed together don't come back together. Only the first three classes are
+// retried; transport and server errors also count against the provider's circuit breaker.
+class RetryPolicy
+{
+public:
+    struct Backoff
+    {
+        int max_attempts; // Including the first
+        std::chrono::milliseconds base;
+        std::chrono::milliseconds cap;
+    };
+
+    static Backoff backoffFor(RpcErrorClass cls)
+    {
+        switch (cls)
+        {
+        case RpcErrorClass::TRANSPORT:
+            return {3, std::chrono::milliseconds(100), std::chrono::milliseconds(2000)};
+        case RpcErrorClass::RATE_LIMITED:
+            return {4, std::chrono::milliseconds(250), std::chrono::milliseconds(5000)};
+        case RpcErrorClass::SERVER:
+            return {3, std::chrono::milliseconds(200), std::chrono::milliseconds(3000)};
+        default:
+            return {1, std::chrono::milliseconds(0), std::chrono::milliseconds(0)};
+        }
+    }
+
+    // Class of a failure from its exception text (transports report HTTP status as "HTTP <code>")
+    static RpcErrorClass classify(const std::string &message)
+    {
+        auto has = [&message](const char *text)
+        { return message.find(text) != std::string::npos; };
+        if (has("deadline"))
+            return RpcErrorClass::DEADLINE;
+        if (has("HTTP 429") || has("rate limit") || has("Too Many Requests"))
+            return RpcErrorClass::RATE_LIMITED;
+        if (has("HTTP 5"))
+            return RpcErrorClass::SERVER;
+        if (has("HTTP 4"))
+            return RpcErrorClass::REJECTED;
+        if (has("revert") || has("rejected") || has("RPC Error") || has("invalid"))
+            return RpcErrorClass::REJECTED;
+        return RpcErrorClass::TRANSPORT;
+    }
+
+    // Class of a JSON-RPC error object's code
+    static RpcErrorClass classifyCode(int64_t code, const std::string &message)
+    {
+        if (code == 429 || code == -32005 || message.find("rate limit") != std::string::npos)
+            return RpcErrorClass::RATE_LIMITED;
+        if (code == -32603 || (code <= -32000 && code >= -32099 && message.find("timeout") != std::string::npos))
+            return RpcErrorClass::SERVER;
+        return RpcErrorClass::REJECTED;
+    }
+
+    static bool retryable(RpcErrorClass cls)
+    {
+        return backoffFor(cls).max_attempts > 1;
+    }
+
+    // A sign the provider (not the request) is failing
+    static bool countsAgainstProvider(RpcErrorClass cls)
+    {
+        return cls == RpcErrorClass::TRANSPORT || cls == RpcErrorClass::SERVER;
+    }
+
+    // Whether a request that has failed `attempts` times with `cls` gets another go
+    static bool shouldRetry(RpcErrorClass cls, int attempts)
+    {
+        return attempts < backoffFor(cls).max_attempts;
+    }
+
+    // Wait before retry number `attempt` (1 = first retry): uniform in [0, min(cap, base * 2^(attempt-1))]
+    static std::chrono::milliseconds delay(RpcErrorClass cls, int attempt)
+    {
+        Backoff backoff = backoffFor(cls);
+        return jittered(backoff.base, backoff.cap, attempt);
+    }
+
+    static std::chrono::milliseconds jittered(std::chrono::milliseconds base, std::chrono::milliseconds cap, int attempt)
+    {
+        int64_t ceiling = base.count();
+        for (int k = 1; k < attempt && ceiling < cap.count(); ++k)
+            ceiling *= 2;
+        ceiling = std::min<int64_t>(ceiling, cap.count());
+        if (ceiling <= 0)
+            return std::chrono::milliseconds(0);
+        thread_local std::mt19937_64 rng{std::random_device{}()};
+        return std::chrono::milliseconds(std::uniform_int_distribution<int64_t>(0, ceiling)(rng));
+    }
+};
+
+#endif // RETRY_POLICY_H
@@ -0,0 +1,97 @@
+#ifndef RPC_DEADLINE_H
+#define RPC_DEADLINE_H
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#include "limit_order.h"
+
+// A request that ran out of its order's time budget (before sending or in flight)
+class DeadlineExceeded : public std::runtime_error
+{
+public:
+    explicit DeadlineExceeded(const std::string &what) : std::runtime_error(what) {}
+};
+
+// RPC Deadline - when an order needs its RPC answers by, carried from the order down to the
+// transport. A Scope installs a deadline for the calls its thread makes; every request is
+// bounded by what is left of it (never more than the per-call default), and one whose deadline
+// already passed isn't sent. Scopes nest and an inner one can only tighten. Thread-local: work
+// handed to another thread takes current() along and opens its own Scope.
+class RpcDeadline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int DEFAULT_CALL_MS = 10000; // Any one request, deadline or not
+    static constexpr int CONNECT_MS = 3000;       // TCP / TLS setup within that
+
+private:
+    static Clock::time_point &slot()
+    {
+        thread_local Clock::time_point deadline = Clock::time_point::max();
+        return deadline;
+    }
+
+public:
+    class Scope
+    {
+    private:
+        Clock::time_point previous;
+
+    public:
+        explicit Scope(Clock::time_point deadline) : previous(slot())
+        {
+            slot() = std::min(previous, deadline);
+        }
+
+        explicit Scope(std::chrono::milliseconds budget) : Scope(Clock::now() + budget) {}
+
+        ~Scope()
+        {
+            slot() = previous;
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    // This thread's deadline; time_point::max() when there is none
+    static Clock::time_point current()
+    {
+        return slot();
+    }
+
+    static bool expired()
+    {
+        return slot() != Clock::time_point::max() && Clock::now() >= slot();
+    }
+
+    // How long the next request may take: what's left of the deadline, capped at `cap_ms`.
+    // Throws DeadlineExceeded once nothing is left.
+    static int budgetMs(int cap_ms = DEFAULT_CALL_MS)
+    {
+        Clock::time_point deadline = slot();
+        if (deadline == Clock::time_point::max())
+            return cap_ms;
+        int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0)
+            throw DeadlineExceeded("RPC deadline passed before the request was sent");
+        return static_cast<int>(std::min<int64_t>(left, cap_ms));
+    }
+};
+
+// Time an order may spend on RPC: IOC/FOK get a tight budget for the whole order, GTC/GTT a
+// looser one for each attempt (they simply try again next block)
+constexpr std::chrono::milliseconds IMMEDIATE_RPC_BUDGET{2000};
+constexpr std::chrono::milliseconds RESTING_RPC_BUDGET{15000};
+
+inline std::chrono::milliseconds rpcBudgetForTif(TimeInForce tif)
+{
+    return (tif == TimeInForce::IOC || tif == TimeInForce::FOK) ? IMMEDIATE_RPC_BUDGET : RESTING_RPC_BUDGET;
+}
+
+#endif // RPC_DEADLINE_H
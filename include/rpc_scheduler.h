@@ -0,0 +1,213 @@
+#ifndef RPC_SCHEDULER_H
+#define RPC_SCHEDULER_H
+
+#include <array>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
+
+#include "rpc_deadline.h"
+
+// Request classes, most urgent first. A queued call only goes out when no call of a more
+// urgent class is waiting, so discovery or monitoring bursts can't hold up a broadcast.
+enum class RpcPriority
+{
+    BROADCAST,  // eth_sendRawTransaction
+    TRIGGER,    // Quotes that decide whether an order fires
+    MONITORING, // Gas sampling, receipts, pool-state audits
+    BACKGROUND  // Discovery, balances, allowances
+};
+
+// RPC Scheduler - one token bucket per provider, shared by every connection to it. Each call
+// costs a token; callers queue by priority class (FIFO within a class) and are released as
+// tokens refill. A slice of the burst is held back for broadcasts so a drained bucket still
+// lets a swap out at once. Batches take whatever the budget allows and go out in chunks.
+// Thread-safe.
+class RpcScheduler
+{
+public:
+    static constexpr size_t CLASS_COUNT = 4;
+
+    struct ClassStats
+    {
+        size_t queued = 0;      // Callers waiting right now
+        size_t max_queued = 0;  // Deepest the queue has been
+        uint64_t granted = 0;   // Calls let through
+        uint64_t waited = 0;    // Requests that had to queue at all
+        std::chrono::microseconds max_wait{0};
+    };
+
+    using Clock = RpcDeadline::Clock;
+
+private:
+    const double rate;  // Tokens per second
+    const double burst; // Bucket size
+    const double reserve; // Only broadcasts may dip below this
+
+    mutable std::mutex mutex;
+    std::condition_variable released;
+    double tokens;
+    Clock::time_point refilled_at;
+    uint64_t next_ticket = 0;
+    std::array<std::deque<uint64_t>, CLASS_COUNT> queues;
+    std::array<ClassStats, CLASS_COUNT> stats;
+
+    void refill(Clock::time_point now)
+    {
+        std::chrono::duration<double> elapsed = now - refilled_at;
+        tokens = std::min(burst, tokens + elapsed.count() * rate);
+        refilled_at = now;
+    }
+
+    bool isTurn(size_t cls, uint64_t ticket) const
+    {
+        for (size_t higher = 0; higher < cls; ++higher)
+        {
+            if (!queues[higher].empty())
+                return false;
+        }
+        return queues[cls].front() == ticket;
+    }
+
+    double usable(size_t cls) const
+    {
+        return cls == static_cast<size_t>(RpcPriority::BROADCAST) ? tokens : tokens - reserve;
+    }
+
+public:
+    RpcScheduler(double rate_per_second, double burst_size)
+        : rate(std::max(rate_per_second, 0.001)),
+          burst(std::max(burst_size, 1.0)),
+          reserve(burst >= 10 ? burst / 10 : 0),
+          tokens(burst),
+          refilled_at(Clock::now())
+    {
+    }
+
+    // Wait for this class's turn and budget for `wanted` calls. With `partial`, returns as soon
+    // as at least one call fits and grants as many as the bucket holds (for chunking a batch).
+    // Otherwise waits until the bucket is full enough (or as full as it can get for this class)
+    // and takes all of them, running the bucket into debt for anything larger. A caller still
+    // queued at `deadline` leaves the queue and gets DeadlineExceeded.
+    size_t acquire(RpcPriority priority, size_t wanted = 1, bool partial = false,
+                   Clock::time_point deadline = Clock::time_point::max())
+    {
+        size_t cls = static_cast<size_t>(priority);
+        double ceiling = cls == static_cast<size_t>(RpcPriority::BROADCAST) ? burst : burst - reserve;
+        double needed = partial ? 1.0 : std::min(static_cast<double>(std::max<size_t>(wanted, 1)), ceiling);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t ticket = next_ticket++;
+        queues[cls].push_back(ticket);
+        ClassStats &cls_stats = stats[cls];
+        cls_stats.queued++;
+        cls_stats.max_queued = std::max(cls_stats.max_queued, cls_stats.queued);
+
+        Clock::time_point arrived = Clock::now();
+        bool queued = false;
+        for (;;)
+        {
+            Clock::time_point now = Clock::now();
+            refill(now);
+            if (isTurn(cls, ticket) && usable(cls) >= needed)
+                break;
+            if (now >= deadline)
+            {
+                queues[cls].erase(std::find(queues[cls].begin(), queues[cls].end(), ticket));
+                cls_stats.queued--;
+                lock.unlock();
+                released.notify_all(); // Whoever queued behind us may be up now
+                throw DeadlineExceeded("RPC deadline passed while queued for the rate limit");
+            }
+            queued = true;
+            // Sleep until the deficit refills, or until a release changes whose turn it is
+            double deficit = std::max(needed - usable(cls), 0.0);
+            auto refill_wait = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(deficit / rate));
+            Clock::time_point wake = now + std::max(refill_wait, Clock::duration(std::chrono::microseconds(200)));
+            released.wait_until(lock, std::min(wake, deadline));
+        }
+
+        size_t granted = partial ? std::min(wanted, static_cast<size_t>(usable(cls))) : std::max<size_t>(wanted, 1);
+        granted = std::max<size_t>(granted, 1);
+        tokens -= static_cast<double>(granted);
+        queues[cls].pop_front();
+        cls_stats.queued--;
+        cls_stats.granted += granted;
+        if (queued)
+        {
+            cls_stats.waited++;
+            cls_stats.max_wait = std::max(cls_stats.max_wait,
+                                          std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - arrived));
+        }
+        lock.unlock();
+        released.notify_all();
+        return granted;
+    }
+
+    ClassStats classStats(RpcPriority priority) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats[static_cast<size_t>(priority)];
+    }
+
+    size_t queueDepth(RpcPriority priority) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats[static_cast<size_t>(priority)].queued;
+    }
+
+    size_t totalQueueDepth() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t depth = 0;
+        for (const auto &cls_stats : stats)
+            depth += cls_stats.queued;
+        return depth;
+    }
+
+    double ratePerSecond() const
+    {
+        return rate;
+    }
+
+    static const char *className(RpcPriority priority)
+    {
+        switch (priority)
+        {
+        case RpcPriority::BROADCAST:
+            return "broadcast";
+        case RpcPriority::TRIGGER:
+            return "trigger";
+        case RpcPriority::MONITORING:
+            return "monitoring";
+        case RpcPriority::BACKGROUND:
+            return "background";
+        }
+        return "unknown";
+    }
+
+    // The scheduler every connection to `url` shares: `rate_limit` calls/second, bursts of
+    // `burst` (0: one second's worth). Null when unlimited. The first caller for a URL sets
+    // its budget.
+    static std::shared_ptr<RpcScheduler> shared(const std::string &url, double rate_limit, double burst = 0)
+    {
+        if (rate_limit <= 0)
+            return nullptr;
+
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::shared_ptr<RpcScheduler>> registry;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::shared_ptr<RpcScheduler> &scheduler = registry[url];
+        if (!scheduler)
+            scheduler = std::make_shared<RpcScheduler>(rate_limit, burst > 0 ? burst : rate_limit);
+        return scheduler;
+    }
+};
+
+#endif // RPC_SCHEDULER_H
@@ -0,0 +1,526 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cstdlib>
+#include <cctype>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Runtime Settings - what the agent reads while it runs, parsed once into an immutable
+// snapshot. Keys are the environment variables they replace. Flags are hot-reloadable (read
+// on every use); everything else is read once while the agent starts and kept across reloads.
+struct RuntimeSettings
+{
+    // Hot-reloadable
+    bool use_mock_pricing = false;     // USE_MOCK_PRICING
+    bool execute_onchain = false;      // EXECUTE_ONCHAIN
+    bool broadcast_tx = false;         // BROADCAST_TX
+    bool skip_liquidity_check = false; // SKIP_LIQUIDITY_CHECK
+
+    // Startup-only: endpoints and limits
+    std::string rpc_url;       // RPC_URL; empty: the compiled-in Sepolia endpoint
+    std::string rpc_transport; // RPC_TRANSPORT ("epoll" for raw HTTP)
+    std::string ws_url;        // WS_URL
+    double rpc_rate_limit = 0; // RPC_RATE_LIMIT calls/second; 0: unlimited
+    double rpc_burst = 0;      // RPC_BURST; 0: one second's worth
+
+    // Startup-only: the order (positional arguments win where noted) and how it runs
+    std::string pool_address;                   // POOL_ADDRESS; the pool argument wins
+    std::optional<int32_t> token_in_index;      // TOKEN_IN_INDEX; wins over the argument
+    std::optional<int32_t> token_out_index;     // TOKEN_OUT_INDEX; wins over the argument
+    std::optional<uint64_t> order_input_amount; // ORDER_INPUT_AMOUNT; wins over the argument
+    std::string tif_policy;                     // TIF_POLICY; the argument wins
+    std::optional<double> limit_price;          // LIMIT_PRICE; the argument wins
+    std::optional<int> gtt_expiry_minutes;      // GTT_EXPIRY_MINUTES; the argument wins
+    std::string execution_style;                // EXECUTION_STYLE: TWAP or ICEBERG; empty: one swap
+    uint32_t twap_slices = 5;                   // TWAP_SLICES
+    uint64_t iceberg_clip = 0;                  // ICEBERG_CLIP; 0: a quarter of the order
+    bool underlying_coins = false;              // UNDERLYING_COINS
+    std::string engine_mode;                    // ENGINE_MODE: batch or sharded
+    size_t engine_shards = 0;                   // ENGINE_SHARDS; 0: one per hardware thread
+    size_t engine_workers = 0;                  // ENGINE_WORKERS; 0 or 1: quote on the tick thread
+    std::vector<std::string> watch_pools;       // WATCH_POOLS, comma-separated
+
+    uint64_t generation = 0; // 0 until load(), then bumped by every reload that changed something
+
+    bool operator==(const RuntimeSettings &other) const = default;
+
+    bool sameValues(const RuntimeSettings &other) const
+    {
+        RuntimeSettings unnumbered = other;
+        unnumbered.generation = generation;
+        return *this == unnumbered;
+    }
+
+    // This snapshot with the hot-reloadable values of `reloaded`; startup-only ones stay put
+    RuntimeSettings withReloadable(const RuntimeSettings &reloaded) const
+    {
+        RuntimeSettings next = *this;
+        next.use_mock_pricing = reloaded.use_mock_pricing;
+        next.execute_onchain = reloaded.execute_onchain;
+        next.broadcast_tx = reloaded.broadcast_tx;
+        next.skip_liquidity_check = reloaded.skip_liquidity_check;
+        return next;
+    }
+};
+
+// Runtime Config - the current settings snapshot, layered from a KEY=VALUE file (CONFIG_FILE
+// or --config), the environment and --key-name=value options, later layers winning. Reading it
+// is one atomic pointer load. reload() re-reads the file over the same environment and options
+// and swaps a new snapshot in, carrying startup-only values over; snapshots are never freed
+// (reloads are rare and small), so a reference taken before a reload stays valid. Until load()
+// runs, the environment alone is used.
+class RuntimeConfig
+{
+public:
+    using Values = std::map<std::string, std::string>;
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<const RuntimeSettings>> snapshots;
+        Values file;
+        Values environment;
+        Values options;
+        std::string path;
+    };
+
+    static State &state()
+    {
+        static State shared;
+        return shared;
+    }
+
+    static std::atomic<const RuntimeSettings *> &slot()
+    {
+        static std::atomic<const RuntimeSettings *> current{nullptr};
+        return current;
+    }
+
+    static const RuntimeSettings &fromEnvironmentOnly()
+    {
+        static const RuntimeSettings settings = []
+        {
+            try
+            {
+                return build({}, fromEnvironment(), {});
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "⚠️ " << e.what() << "; using defaults" << std::endl;
+                return RuntimeSettings();
+            }
+        }();
+        return settings;
+    }
+
+    static std::string trim(const std::string &text)
+    {
+        size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos)
+            return "";
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    static bool parseFlag(const std::string &key, const std::string &value)
+    {
+        std::string lowered = value;
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+        if (lowered == "1" || lowered == "true" || lowered == "yes" || lowered == "on")
+            return true;
+        if (lowered.empty() || lowered == "0" || lowered == "false" || lowered == "no" || lowered == "off")
+            return false;
+        throw std::invalid_argument("Config " + key + ": expected a flag (1/0, true/false), got '" + value + "'");
+    }
+
+    // The whole value as a number; throws naming the key otherwise
+    static double parseNumber(const std::string &key, const std::string &value)
+    {
+        size_t used = 0;
+        double number = 0;
+        try
+        {
+            number = std::stod(value, &used);
+        }
+        catch (const std::exception &)
+        {
+            used = 0;
+        }
+        if (used == 0 || used != value.size())
+            throw std::invalid_argument("Config " + key + ": expected a number, got '" + value + "'");
+        return number;
+    }
+
+    // The whole value as a whole number, at least `minimum`; throws naming the key otherwise
+    static int64_t parseInteger(const std::string &key, const std::string &value, int64_t minimum)
+    {
+        size_t used = 0;
+        int64_t number = 0;
+        try
+        {
+            number = std::stoll(value, &used);
+        }
+        catch (const std::exception &)
+        {
+            used = 0;
+        }
+        if (used == 0 || used != value.size() || number < minimum)
+            throw std::invalid_argument("Config " + key + ": expected a whole number >= " + std::to_string(minimum) +
+                                        ", got '" + value + "'");
+        return number;
+    }
+
+    // Caller holds the state mutex
+    static const RuntimeSettings *publish(RuntimeSettings settings)
+    {
+        State &shared = state();
+        const RuntimeSettings *previous = slot().load(std::memory_order_acquire);
+        settings.generation = previous ? previous->generation + 1 : 1;
+        shared.snapshots.push_back(std::make_unique<const RuntimeSettings>(std::move(settings)));
+        const RuntimeSettings *next = shared.snapshots.back().get();
+        slot().store(next, std::memory_order_release);
+        return next;
+    }
+
+public:
+    // Every key the agent reads
+    static const std::vector<std::string> &keys()
+    {
+        static const std::vector<std::string> known = {
+            "USE_MOCK_PRICING", "EXECUTE_ONCHAIN", "BROADCAST_TX", "SKIP_LIQUIDITY_CHECK",
+            "RPC_URL", "RPC_TRANSPORT", "WS_URL", "RPC_RATE_LIMIT", "RPC_BURST",
+            "POOL_ADDRESS", "TOKEN_IN_INDEX", "TOKEN_OUT_INDEX", "ORDER_INPUT_AMOUNT", "TIF_POLICY", "LIMIT_PRICE",
+            "GTT_EXPIRY_MINUTES", "EXECUTION_STYLE", "TWAP_SLICES", "ICEBERG_CLIP", "UNDERLYING_COINS",
+            "ENGINE_MODE", "ENGINE_SHARDS", "ENGINE_WORKERS", "WATCH_POOLS"};
+        return known;
+    }
+
+    static bool known(const std::string &key)
+    {
+        return std::find(keys().begin(), keys().end(), key) != keys().end();
+    }
+
+    // Keys a reload applies; the rest take effect on the next start
+    static bool reloadable(const std::string &key)
+    {
+        return key == "USE_MOCK_PRICING" || key == "EXECUTE_ONCHAIN" || key == "BROADCAST_TX" ||
+               key == "SKIP_LIQUIDITY_CHECK";
+    }
+
+    // The hot-path read
+    static const RuntimeSettings &get()
+    {
+        const RuntimeSettings *settings = slot().load(std::memory_order_acquire);
+        return settings ? *settings : fromEnvironmentOnly();
+    }
+
+    // KEY=VALUE lines; blank lines and # comments skipped. Throws if the file can't be read.
+    static Values readFile(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file)
+            throw std::runtime_error("Cannot read config file " + path);
+        Values values;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+            size_t eq = line.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument("Config " + path + ": expected KEY=VALUE, got '" + line + "'");
+            std::string key = trim(line.substr(0, eq));
+            if (!known(key))
+                std::cerr << "⚠️ Unknown config key " << key << " in " << path << std::endl;
+            values[key] = trim(line.substr(eq + 1));
+        }
+        return values;
+    }
+
+    static Values fromEnvironment()
+    {
+        Values values;
+        for (const std::string &key : keys())
+        {
+            if (const char *value = std::getenv(key.c_str()))
+                values[key] = value;
+        }
+        return values;
+    }
+
+    // Takes --config PATH / --config=PATH and --key-name=value (e.g. --execute-onchain=1) out
+    // of `args`, leaving the positional arguments
+    static Values fromArgs(std::vector<std::string> &args, std::string &config_path)
+    {
+        Values values;
+        std::vector<std::string> positional;
+        for (size_t k = 0; k < args.size(); ++k)
+        {
+            const std::string &arg = args[k];
+            if (arg == "--config" && k + 1 < args.size())
+            {
+                config_path = args[++k];
+                continue;
+            }
+            if (arg.rfind("--config=", 0) == 0)
+            {
+                config_path = arg.substr(9);
+                continue;
+            }
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                positional.push_back(arg);
+                continue;
+            }
+            std::string key = arg.substr(2, eq - 2);
+            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c)
+                           { return c == '-' ? '_' : static_cast<char>(std::toupper(c)); });
+            if (!known(key))
+                throw std::invalid_argument("Unknown option " + arg.substr(0, eq));
+            values[key] = arg.substr(eq + 1);
+        }
+        args = positional;
+        return values;
+    }
+
+    // Settings from the layers, later ones winning. Throws on a malformed value.
+    static RuntimeSettings build(const Values &file, const Values &environment, const Values &options)
+    {
+        Values merged = file;
+        for (const Values *layer : {&environment, &options})
+        {
+            for (const auto &[key, value] : *layer)
+                merged[key] = value;
+        }
+        auto text = [&merged](const char *key)
+        {
+            auto it = merged.find(key);
+            return it == merged.end() ? std::string() : it->second;
+        };
+
+        RuntimeSettings settings;
+        settings.use_mock_pricing = parseFlag("USE_MOCK_PRICING", text("USE_MOCK_PRICING"));
+        settings.execute_onchain = parseFlag("EXECUTE_ONCHAIN", text("EXECUTE_ONCHAIN"));
+        settings.broadcast_tx = parseFlag("BROADCAST_TX", text("BROADCAST_TX"));
+        settings.skip_liquidity_check = parseFlag("SKIP_LIQUIDITY_CHECK", text("SKIP_LIQUIDITY_CHECK"));
+        settings.rpc_url = text("RPC_URL");
+        settings.rpc_transport = text("RPC_TRANSPORT");
+        settings.ws_url = text("WS_URL");
+        if (std::string value = text("RPC_RATE_LIMIT"); !value.empty())
+            settings.rpc_rate_limit = std::max(parseNumber("RPC_RATE_LIMIT", value), 0.0);
+        if (std::string value = text("RPC_BURST"); !value.empty())
+            settings.rpc_burst = std::max(parseNumber("RPC_BURST", value), 0.0);
+
+        settings.pool_address = text("POOL_ADDRESS");
+        if (std::string value = text("TOKEN_IN_INDEX"); !value.empty())
+            settings.token_in_index = static_cast<int32_t>(parseInteger("TOKEN_IN_INDEX", value, 0));
+        if (std::string value = text("TOKEN_OUT_INDEX"); !value.empty())
+            settings.token_out_index = static_cast<int32_t>(parseInteger("TOKEN_OUT_INDEX", value, 0));
+        if (std::string value = text("ORDER_INPUT_AMOUNT"); !value.empty())
+            settings.order_input_amount = static_cast<uint64_t>(parseInteger("ORDER_INPUT_AMOUNT", value, 1));
+        settings.tif_policy = text("TIF_POLICY");
+        if (std::string value = text("LIMIT_PRICE"); !value.empty())
+            settings.limit_price = parseNumber("LIMIT_PRICE", value);
+        if (std::string value = text("GTT_EXPIRY_MINUTES"); !value.empty())
+            settings.gtt_expiry_minutes = static_cast<int>(parseInteger("GTT_EXPIRY_MINUTES", value, 0));
+        settings.execution_style = text("EXECUTION_STYLE");
+        if (std::string value = text("TWAP_SLICES"); !value.empty())
+            settings.twap_slices = static_cast<uint32_t>(parseInteger("TWAP_SLICES", value, 1));
+        if (std::string value = text("ICEBERG_CLIP"); !value.empty())
+            settings.iceberg_clip = static_cast<uint64_t>(parseInteger("ICEBERG_CLIP", value, 0));
+        settings.underlying_coins = parseFlag("UNDERLYING_COINS", text("UNDERLYING_COINS"));
+        settings.engine_mode = text("ENGINE_MODE");
+        if (std::string value = text("ENGINE_SHARDS"); !value.empty())
+            settings.engine_shards = static_cast<size_t>(parseInteger("ENGINE_SHARDS", value, 0));
+        if (std::string value = text("ENGINE_WORKERS"); !value.empty())
+            settings.engine_workers = static_cast<size_t>(parseInteger("ENGINE_WORKERS", value, 0));
+        std::stringstream pools(text("WATCH_POOLS"));
+        for (std::string pool; std::getline(pools, pool, ',');)
+        {
+            pool = trim(pool);
+            if (!pool.empty())
+                settings.watch_pools.push_back(pool);
+        }
+        return settings;
+    }
+
+    // Load the first snapshot: takes its options out of `args`; the file is --config or
+    // CONFIG_FILE (none is fine). Throws on an unreadable file or a malformed value.
+    static const RuntimeSettings &load(std::vector<std::string> &args)
+    {
+        std::string path;
+        if (const char *env = std::getenv("CONFIG_FILE"))
+            path = env;
+        Values options = fromArgs(args, path);
+        Values environment = fromEnvironment();
+        Values file = path.empty() ? Values() : readFile(path);
+        RuntimeSettings settings = build(file, environment, options);
+
+        State &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.file = file;
+        shared.environment = environment;
+        shared.options = options;
+        shared.path = path;
+        return *publish(settings);
+    }
+
+    // Re-read the file over the environment and options load() saw. True if a new snapshot was
+    // swapped in; a file that is unreadable or malformed leaves the current one in place. Only
+    // reloadable keys change; an edited startup-only key is reported and waits for a restart.
+    static bool reload()
+    {
+        State &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.path.empty())
+            return false;
+        Values file;
+        RuntimeSettings settings;
+        try
+        {
+            file = readFile(shared.path);
+            settings = build(file, shared.environment, shared.options);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Config reload skipped: " << e.what() << std::endl;
+            return false;
+        }
+
+        for (const std::string &key : keys())
+        {
+            bool overridden = shared.environment.count(key) > 0 || shared.options.count(key) > 0;
+            auto before = shared.file.find(key);
+            auto after = file.find(key);
+            bool edited = (before == shared.file.end()) != (after == file.end()) ||
+                          (before != shared.file.end() && before->second != after->second);
+            if (edited && !overridden && !reloadable(key))
+                std::cerr << "⚠️ " << key << " changed in " << shared.path << "; applies on restart" << std::endl;
+        }
+        shared.file = file;
+
+        settings = get().withReloadable(settings);
+        if (settings.sameValues(get()))
+            return false;
+        publish(settings);
+        return true;
+    }
+
+    static std::string path()
+    {
+        State &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        return shared.path;
+    }
+};
+
+// Config Watcher - calls back when a file changes, from a background inotify thread. Watches
+// the directory, since editors and deploy tools replace files by renaming a new one over them.
+class ConfigWatcher
+{
+private:
+    std::string directory;
+    std::string name;
+    std::function<void()> on_change;
+    std::thread watcher_thread;
+    int inotify_fd = -1;
+    int wake_pipe[2] = {-1, -1};
+
+#if defined(__linux__)
+    void run()
+    {
+        alignas(struct inotify_event) char buffer[4096];
+        pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+        while (true)
+        {
+            if (poll(fds, 2, -1) < 0)
+                continue;
+            if (fds[1].revents)
+                return;
+            ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+            bool changed = false;
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+                if (event->len > 0 && name == event->name)
+                    changed = true;
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+            if (!changed)
+                continue;
+            try
+            {
+                on_change();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "⚠️ Config watcher callback failed: " << e.what() << std::endl;
+            }
+        }
+    }
+#endif
+
+public:
+    ConfigWatcher(const std::string &path, std::function<void()> callback) : on_change(std::move(callback))
+    {
+        size_t slash = path.find_last_of('/');
+        directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        name = slash == std::string::npos ? path : path.substr(slash + 1);
+#if defined(__linux__)
+        inotify_fd = inotify_init1(IN_CLOEXEC);
+        if (inotify_fd < 0)
+            throw std::runtime_error("inotify unavailable");
+        if (inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0 ||
+            pipe(wake_pipe) != 0)
+        {
+            close(inotify_fd);
+            throw std::runtime_error("Cannot watch " + directory);
+        }
+        watcher_thread = std::thread([this]
+                                     { run(); });
+#else
+        throw std::runtime_error("Config watching requires inotify (Linux)");
+#endif
+    }
+
+    ~ConfigWatcher()
+    {
+#if defined(__linux__)
+        if (write(wake_pipe[1], "x", 1) < 0)
+            std::cerr << "⚠️ Config watcher wake-up failed" << std::endl;
+        if (watcher_thread.joinable())
+            watcher_thread.join();
+        close(wake_pipe[0]);
+        close(wake_pipe[1]);
+        close(inotify_fd);
+#endif
+    }
+
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    ConfigWatcher &operator=(const ConfigWatcher &) = delete;
+};
+
+#endif // RUNTIME_CONFIG_H
@@ -91,6 +91,8 @@ namespace SepoliaConfig
         const uint64_t SWAP_GAS_LIMIT = 300000;
         const uint64_t APPROVE_GAS_LIMIT = 100000;
         const uint64_t DEFAULT_GAS_PRICE = 20000000000; // 20 gwei
+        const uint64_t DEFAULT_PRIORITY_FEE = 1500000000; // 1.5 gwei, floor for EIP-1559 tips
+        const uint64_t FEE_HISTORY_BLOCKS = 10;          // eth_feeHistory window for the gas oracle
     }
 
     // Wallet Configuration
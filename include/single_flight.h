@@ -0,0 +1,141 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+#include <condition_variable>
+
+// Single Flight - collapses identical concurrent requests. The first caller for a key becomes
+// the leader and does the work; anyone asking for the same key before it finishes waits and
+// gets a copy of the leader's result (or its exception). Nothing is cached: once the leader
+// completes, the next request for the key goes out again. Thread-safe.
+template <typename Value>
+class SingleFlight
+{
+public:
+    struct Flight
+    {
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        bool done = false;
+        Value value{};
+        std::exception_ptr error;
+    };
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> in_flight;
+    std::atomic<uint64_t> led{0};
+    std::atomic<uint64_t> shared{0};
+
+    void finish(const std::string &key, const std::shared_ptr<Flight> &flight)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = in_flight.find(key);
+            if (it != in_flight.end() && it->second == flight)
+                in_flight.erase(it);
+        }
+        {
+            std::lock_guard<std::mutex> lock(flight->mutex);
+            flight->done = true;
+        }
+        flight->done_cv.notify_all();
+    }
+
+public:
+    // The flight for `key`; `leader` is set if the caller must do the work and then
+    // complete() or fail() it
+    std::shared_ptr<Flight> join(const std::string &key, bool &leader)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<Flight> &flight = in_flight[key];
+        leader = !flight;
+        if (leader)
+        {
+            flight = std::make_shared<Flight>();
+            led++;
+        }
+        else
+        {
+            shared++;
+        }
+        return flight;
+    }
+
+    void complete(const std::string &key, const std::shared_ptr<Flight> &flight, const Value &value)
+    {
+        flight->value = value;
+        finish(key, flight);
+    }
+
+    void fail(const std::string &key, const std::shared_ptr<Flight> &flight, std::exception_ptr error)
+    {
+        flight->error = error;
+        finish(key, flight);
+    }
+
+    // Block until the leader is done (or `until` passes: throws); rethrows its exception. A
+    // waiter with a tighter deadline than the leader's gives up without cancelling the leader.
+    static Value wait(const std::shared_ptr<Flight> &flight,
+                      std::chrono::steady_clock::time_point until = std::chrono::steady_clock::time_point::max())
+    {
+        std::unique_lock<std::mutex> lock(flight->mutex);
+        auto finished = [&flight]
+        { return flight->done; };
+        if (until == std::chrono::steady_clock::time_point::max())
+            flight->done_cv.wait(lock, finished);
+        else if (!flight->done_cv.wait_until(lock, until, finished))
+            throw std::runtime_error("Shared request still in flight at the caller's deadline");
+        if (flight->error)
+            std::rethrow_exception(flight->error);
+        return flight->value;
+    }
+
+    // Run `work` unless an identical request is already in flight, in which case share its result
+    template <typename Work>
+    Value run(const std::string &key, Work &&work,
+              std::chrono::steady_clock::time_point until = std::chrono::steady_clock::time_point::max())
+    {
+        bool leader = false;
+        std::shared_ptr<Flight> flight = join(key, leader);
+        if (!leader)
+            return wait(flight, until);
+        try
+        {
+            Value value = work();
+            complete(key, flight, value);
+            return value;
+        }
+        catch (...)
+        {
+            fail(key, flight, std::current_exception());
+            throw;
+        }
+    }
+
+    uint64_t leaderCount() const
+    {
+        return led.load();
+    }
+
+    // Requests answered by someone else's round trip
+    uint64_t sharedCount() const
+    {
+        return shared.load();
+    }
+
+    size_t inFlight()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return in_flight.size();
+    }
+};
+
+#endif // SINGLE_FLIGHT_H
@@ -0,0 +1,234 @@
+#ifndef SLICE_SCHEDULER_H
+#define SLICE_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include "limit_order.h"
+
+// Price Impact Model - linear impact estimate per pool direction, learned from quotes.
+// impact(dx) = 1 - rate(dx) / reference_rate ~= slope * dx
+class PriceImpactModel
+{
+private:
+    static constexpr double SMOOTHING = 0.3; // EWMA weight of the newest observation
+
+    std::unordered_map<std::string, double> slopes;
+
+public:
+    static std::string keyFor(const std::string &pool, int32_t i, int32_t j)
+    {
+        return pool + ":" + std::to_string(i) + ":" + std::to_string(j);
+    }
+
+    // Record a quote of size dx against a near-zero-size reference rate for the same direction
+    void observe(const std::string &key, double reference_rate, uint64_t dx, double rate)
+    {
+        if (dx == 0 || reference_rate <= 0.0)
+            return;
+
+        double impact = std::max(0.0, 1.0 - rate / reference_rate);
+        double slope = impact / static_cast<double>(dx);
+
+        auto it = slopes.find(key);
+        if (it == slopes.end())
+            slopes[key] = slope;
+        else
+            it->second = SMOOTHING * slope + (1.0 - SMOOTHING) * it->second;
+    }
+
+    bool hasEstimate(const std::string &key) const
+    {
+        return slopes.count(key) > 0;
+    }
+
+    // Estimated fractional price impact of a swap of size dx (0 if unknown)
+    double estimateImpact(const std::string &key, uint64_t dx) const
+    {
+        auto it = slopes.find(key);
+        return it == slopes.end() ? 0.0 : it->second * static_cast<double>(dx);
+    }
+
+    // Largest size whose estimated impact stays within max_impact (0 if unknown or impact-free)
+    uint64_t sizeForImpact(const std::string &key, double max_impact) const
+    {
+        auto it = slopes.find(key);
+        if (it == slopes.end() || it->second <= 0.0)
+            return 0;
+        return static_cast<uint64_t>(max_impact / it->second);
+    }
+};
+
+// Slice Scheduler - owns the child schedule of every TWAP / ICEBERG parent.
+// Due slices sit in a min-heap by block, so a tick touches only the parents that are due.
+class SliceScheduler
+{
+private:
+    struct Schedule
+    {
+        uint64_t start_block;
+        uint64_t end_block; // Last block of a TWAP window (unused for ICEBERG)
+        uint32_t slices_sent;
+    };
+
+    struct DueEntry
+    {
+        uint64_t block;
+        uint64_t sequence; // FIFO among parents due in the same block
+        LimitOrder *parent;
+
+        bool operator>(const DueEntry &other) const
+        {
+            return block != other.block ? block > other.block : sequence > other.sequence;
+        }
+    };
+
+    std::priority_queue<DueEntry, std::vector<DueEntry>, std::greater<DueEntry>> due_heap;
+    std::unordered_map<const LimitOrder *, Schedule> schedules;
+    uint64_t next_sequence = 0;
+
+    static uint64_t remainingInput(const LimitOrder &order)
+    {
+        return order.input_amount - order.filled_amount;
+    }
+
+    void push(LimitOrder *parent, uint64_t block)
+    {
+        due_heap.push({block, next_sequence++, parent});
+    }
+
+public:
+    // Start working a sliced parent from start_block
+    void schedule(LimitOrder *parent, uint64_t start_block)
+    {
+        uint32_t slices = std::max<uint32_t>(parent->twap_slices, 1);
+        schedules[parent] = {start_block, start_block + slices - 1, 0};
+        push(parent, start_block);
+    }
+
+    // Pop every parent with a slice due at or before block
+    std::vector<LimitOrder *> popDue(uint64_t block)
+    {
+        std::vector<LimitOrder *> due;
+        while (!due_heap.empty() && due_heap.top().block <= block)
+        {
+            LimitOrder *parent = due_heap.top().parent;
+            due_heap.pop();
+            if (schedules.count(parent))
+                due.push_back(parent);
+        }
+        return due;
+    }
+
+    // Size of the next child slice. TWAP spreads the remainder over the blocks left and backs
+    // off (down to 0.5x) when the even share would blow the impact budget; later slices catch
+    // up. ICEBERG shows its clip, trimmed to what the impact budget allows.
+    uint64_t nextSliceSize(const LimitOrder &parent, uint64_t block,
+                           const PriceImpactModel &impact, const std::string &impact_key) const
+    {
+        uint64_t remaining = remainingInput(parent);
+        if (remaining == 0)
+            return 0;
+
+        // Keep a slice's own impact well inside the order's slippage budget
+        double impact_budget = parent.slippage_tolerance / 2.0;
+
+        if (parent.execution_style == ExecutionStyle::ICEBERG)
+        {
+            uint64_t clip = std::min(parent.iceberg_clip, remaining);
+            uint64_t impact_cap = impact.sizeForImpact(impact_key, impact_budget);
+            if (impact_cap > 0)
+                clip = std::min(clip, std::max(impact_cap, parent.iceberg_clip / 4));
+            return std::max<uint64_t>(clip, 1);
+        }
+
+        auto it = schedules.find(&parent);
+        if (it == schedules.end() || block >= it->second.end_block)
+            return remaining; // Last block of the window takes whatever is left
+
+        uint64_t blocks_left = it->second.end_block - block + 1;
+        uint64_t even = (remaining + blocks_left - 1) / blocks_left;
+
+        if (impact.hasEstimate(impact_key))
+        {
+            double estimated = impact.estimateImpact(impact_key, even);
+            double factor = estimated > 0.0 ? impact_budget / estimated : 1.0;
+            factor = std::min(1.0, std::max(0.5, factor));
+            even = static_cast<uint64_t>(static_cast<double>(even) * factor);
+        }
+        return std::min(remaining, std::max<uint64_t>(even, 1));
+    }
+
+    // Child slice order: inherits the parent's terms, sized to one slice, IOC within its block
+    std::unique_ptr<LimitOrder> makeChild(LimitOrder &parent, uint64_t size)
+    {
+        uint32_t index = schedules[&parent].slices_sent++;
+        auto child = std::make_unique<LimitOrder>(
+            parent.order_id + "#" + std::to_string(index + 1),
+            parent.input_token_address, parent.output_token_address, size,
+            parent.limit_price, parent.slippage_tolerance, TimeInForce::IOC,
+            parent.user_address, parent.private_key);
+        child->pool_address = parent.pool_address;
+        child->input_token_index = parent.input_token_index;
+        child->output_token_index = parent.output_token_index;
+        child->underlying = parent.underlying;
+        child->parent_order_id = parent.order_id;
+        child->updateStatus(OrderStatus::ACTIVE);
+        return child;
+    }
+
+    // Roll a finished slice into its parent and schedule the next one (or finish the parent)
+    void completeSlice(LimitOrder &parent, const LimitOrder &child, uint64_t block)
+    {
+        parent.filled_amount += child.filled_amount;
+        parent.received_amount += child.received_amount;
+        parent.price_check_count += child.price_check_count;
+        parent.last_quoted_output = child.last_quoted_output;
+        if (!child.transaction_hash.empty())
+            parent.transaction_hash = child.transaction_hash;
+
+        if (remainingInput(parent) == 0)
+        {
+            parent.updateStatus(OrderStatus::FILLED);
+            schedules.erase(&parent);
+            return;
+        }
+
+        auto it = schedules.find(&parent);
+        if (it == schedules.end())
+            return;
+
+        if (parent.execution_style == ExecutionStyle::TWAP && block >= it->second.end_block)
+        {
+            parent.updateStatus(parent.filled_amount > 0 ? OrderStatus::PARTIALLY_FILLED : OrderStatus::CANCELED,
+                                "TWAP window ended");
+            schedules.erase(it);
+            return;
+        }
+
+        push(&parent, block + 1);
+    }
+
+    // Stop working a parent (canceled, expired)
+    void cancel(LimitOrder &parent)
+    {
+        schedules.erase(&parent);
+    }
+
+    bool isScheduled(const LimitOrder &parent) const
+    {
+        return schedules.count(&parent) > 0;
+    }
+
+    size_t activeSchedules() const
+    {
+        return schedules.size();
+    }
+};
+
+#endif // SLICE_SCHEDULER_H
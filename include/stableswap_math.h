@@ -0,0 +1,244 @@
+#ifndef STABLESWAP_MATH_H
+#define STABLESWAP_MATH_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include "pool_state.h"
+
+// StableSwap invariant math (Curve's get_D / get_y / get_dy) in long double. Good to ~1e-18
+// relative, which is plenty for locating thresholds; fills are still confirmed on-chain.
+// Works in normalized balances (xp: every coin scaled to 18 decimals).
+namespace StableSwapMath
+{
+    using Real = long double;
+
+    constexpr int MAX_ITERATIONS = 255;
+
+    inline std::vector<Real> normalizedBalances(const PoolState &state)
+    {
+        std::vector<Real> xp(state.balances.size());
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            Real rate = k < state.rates.size() ? static_cast<Real>(state.rates[k]) : 1.0L;
+            xp[k] = static_cast<Real>(state.balances[k]) * rate;
+        }
+        return xp;
+    }
+
+    inline Real rateOf(const PoolState &state, size_t coin)
+    {
+        return coin < state.rates.size() ? static_cast<Real>(state.rates[coin]) : 1.0L;
+    }
+
+    // Invariant D for normalized balances xp and amplification amp
+    inline Real getD(const std::vector<Real> &xp, Real amp)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real sum = 0;
+        for (Real x : xp)
+            sum += x;
+        if (sum <= 0)
+            return 0;
+
+        Real d = sum;
+        Real ann = amp * n;
+        for (int k = 0; k < MAX_ITERATIONS; ++k)
+        {
+            Real d_p = d;
+            for (Real x : xp)
+                d_p = d_p * d / (x * n);
+            Real previous = d;
+            d = (ann * sum + d_p * n) * d / ((ann - 1) * d + (n + 1) * d_p);
+            if (std::fabs(d - previous) <= d * 1e-18L)
+                break;
+        }
+
+        // That iteration contracts slowly near its root, so in long double its fixed point can
+        // sit ~1e-16 off, which matters once two D's are differenced (calc_token_amount). Finish
+        // with Newton on the invariant ann (sum - D) + D - D_P = 0, free of cancelling terms.
+        for (int k = 0; k < 2; ++k)
+        {
+            Real d_p = d;
+            for (Real x : xp)
+                d_p = d_p * d / (x * n);
+            Real f = ann * (sum - d) + d - d_p;
+            Real slope = 1 - ann - (n + 1) * d_p / d;
+            d -= f / slope;
+        }
+        return d;
+    }
+
+    // Balance of coin j that keeps D when coin i is set to x (other coins unchanged)
+    inline Real getY(size_t i, size_t j, Real x, const std::vector<Real> &xp, Real amp, Real d)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real ann = amp * n;
+        Real c = d;
+        Real sum = 0;
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            if (k == j)
+                continue;
+            Real value = k == i ? x : xp[k];
+            sum += value;
+            c = c * d / (value * n);
+        }
+        c = c * d / (ann * n);
+        Real b = sum + d / ann;
+
+        Real y = d;
+        for (int k = 0; k < MAX_ITERATIONS; ++k)
+        {
+            Real previous = y;
+            y = (y * y + c) / (2 * y + b - d);
+            if (std::fabs(y - previous) <= y * 1e-18L)
+                break;
+        }
+        return y;
+    }
+
+    // Balance of coin i that gives invariant d with the other coins at xp (the contract's get_y_D)
+    inline Real getYD(size_t i, const std::vector<Real> &xp, Real amp, Real d)
+    {
+        Real n = static_cast<Real>(xp.size());
+        Real ann = amp * n;
+        Real c = d;
+        Real sum = 0;
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            if (k == i)
+                continue;
+            sum += xp[k];
+            c = c * d / (xp[k] * n);
+        }
+        c = c * d / (ann * n);
+        Real b = sum + d / ann;
+
+        Real y = d;
+        for (int k = 0; k < MAX_ITERATIONS; ++k)
+        {
+            Real previous = y;
+            y = (y * y + c) / (2 * y + b - d);
+            if (std::fabs(y - previous) <= y * 1e-18L)
+                break;
+        }
+        return y;
+    }
+
+    // Output (native units of j, after fee) for dx native units of i, like the pool's get_dy
+    inline Real getDy(const std::vector<Real> &xp, Real amp, uint64_t fee, size_t i, size_t j,
+                      Real dx, Real rate_i, Real rate_j)
+    {
+        Real d = getD(xp, amp);
+        Real y = getY(i, j, xp[i] + dx * rate_i, xp, amp, d);
+        Real dy = (xp[j] - y) / rate_j;
+        if (dy <= 0)
+            return 0;
+        return dy - dy * static_cast<Real>(fee) / static_cast<Real>(PoolState::FEE_DENOMINATOR);
+    }
+
+    inline Real getDy(const PoolState &state, size_t i, size_t j, Real dx, uint64_t timestamp)
+    {
+        return getDy(normalizedBalances(state), static_cast<Real>(state.amplification(timestamp)), state.fee,
+                     i, j, dx, rateOf(state, i), rateOf(state, j));
+    }
+
+    // Batch get_dy: many amounts against one state. D and everything that doesn't depend on dx
+    // are computed once in long double; the amounts then solve for y in double SIMD vectors of
+    // LANES. Each lane iterates on delta = xp[j] - y (the quadratic get_y solves, shifted so
+    // the small output isn't lost against the large balance): at most BATCH_ITERATIONS Newton
+    // steps, converged lanes masked off, stopping once every lane has converged. The error is
+    // absolute, not relative: it stays within BATCH_TOLERANCE of the output coin's balance
+    // (worst seen ~1e-13, at A near 1e5), so the smaller the output, the larger its share.
+    constexpr Real BATCH_TOLERANCE = 1e-12L;
+    constexpr size_t LANES = 2; // One 128-bit register: SSE2 / NEON baseline, no -m flags needed
+    constexpr int BATCH_ITERATIONS = 16;
+    typedef double Lanes __attribute__((vector_size(LANES * sizeof(double))));
+    typedef long long LaneMask __attribute__((vector_size(LANES * sizeof(long long))));
+
+    inline std::vector<Real> getDyBatch(const std::vector<Real> &xp, Real amp, uint64_t fee, size_t i, size_t j,
+                                        const std::vector<Real> &amounts, Real rate_i, Real rate_j)
+    {
+        std::vector<Real> outputs(amounts.size(), 0);
+        if (i == j || i >= xp.size() || j >= xp.size() || amounts.empty())
+            return outputs;
+
+        // With x_i' = x_i + dx and S' the sum of every coin but j, get_y solves
+        //     y^2 + (S' + D/ann - D) y = c,   c = c_fixed * D / (x_i' n)
+        // At y = X - delta (X = xp[j]) that is delta^2 - B delta + F = 0 with
+        //     B = X + (sum - D) + dx + D/ann,   F = X (sum - D + dx + D/ann) - c
+        // where sum - D is formed once in long double, so nothing cancels per lane.
+        Real n = static_cast<Real>(xp.size());
+        Real d = getD(xp, amp);
+        Real ann = amp * n;
+        Real x_out = xp[j];
+        Real sum = 0;
+        Real c_fixed = d * d / (ann * n);
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            sum += xp[k];
+            if (k != i && k != j)
+                c_fixed = c_fixed * d / (xp[k] * n);
+        }
+        const double excess = static_cast<double>(sum - d + d / ann);
+        const double x_j = static_cast<double>(x_out);
+        const double x_i = static_cast<double>(xp[i]);
+        const double c_scale = static_cast<double>(c_fixed * d / n);
+        const double rate_in = static_cast<double>(rate_i);
+        const double keep = (1.0 - static_cast<double>(fee) / static_cast<double>(PoolState::FEE_DENOMINATOR)) /
+                            static_cast<double>(rate_j);
+        const double tolerance = static_cast<double>(d) * 1e-17;
+
+        // Step-major over all blocks, so the divisions of independent blocks overlap
+        size_t blocks = (amounts.size() + LANES - 1) / LANES;
+        std::vector<Lanes> b(blocks), f(blocks), delta(blocks);
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            Lanes dx = {};
+            for (size_t lane = 0; lane < LANES && block * LANES + lane < amounts.size(); ++lane)
+                dx[lane] = static_cast<double>(amounts[block * LANES + lane]);
+            dx *= rate_in;
+            Lanes shift = excess + dx;
+            b[block] = x_j + shift;
+            f[block] = x_j * shift - c_scale / (x_i + dx);
+            delta[block] = f[block] / b[block]; // First step from delta = 0
+        }
+
+        for (int step = 0; step < BATCH_ITERATIONS; ++step)
+        {
+            LaneMask any = {};
+            for (size_t block = 0; block < blocks; ++block)
+            {
+                Lanes next = (delta[block] * delta[block] - f[block]) / (2 * delta[block] - b[block]);
+                Lanes change = next - delta[block];
+                LaneMask active = (change > tolerance) | (change < -tolerance);
+                delta[block] = active ? next : delta[block];
+                any |= active;
+            }
+            bool converged = true;
+            for (size_t lane = 0; lane < LANES; ++lane)
+                converged = converged && !any[lane];
+            if (converged)
+                break;
+        }
+
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            Lanes dy = delta[block] * keep;
+            for (size_t lane = 0; lane < LANES && block * LANES + lane < amounts.size(); ++lane)
+                outputs[block * LANES + lane] = dy[lane] > 0 ? static_cast<Real>(dy[lane]) : 0;
+        }
+        return outputs;
+    }
+
+    inline std::vector<Real> getDyBatch(const PoolState &state, size_t i, size_t j, const std::vector<Real> &amounts,
+                                        uint64_t timestamp)
+    {
+        return getDyBatch(normalizedBalances(state), static_cast<Real>(state.amplification(timestamp)), state.fee,
+                          i, j, amounts, rateOf(state, i), rateOf(state, j));
+    }
+}
+
+#endif // STABLESWAP_MATH_H
@@ -0,0 +1,336 @@
+#ifndef SWAP_SIMULATOR_H
+#define SWAP_SIMULATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <cctype>
+
+#include "keccak.h"
+
+// Swap Simulator - pre-flight for swaps. Each swap's exact exchange calldata is run through
+// eth_call from the sender with the input token's balance and pool allowance overridden in
+// state, so a swap that would revert (output under min_dy, pool paused, bad index) is caught
+// before it costs gas and a nonce, whether or not the funds and approval are in place yet.
+//
+// Overrides need the token's balance and allowance mapping slots. They are found once per
+// token with one eth_call each: every candidate slot (0..MAX_PROBED_SLOT, Solidity and Vyper
+// key layouts) is overridden with its own marker value and the marker balanceOf / allowance
+// returns names the slot. Not thread-safe; owned by one engine.
+class SwapSimulator
+{
+public:
+    // One eth_call; state_diff maps contract -> storage key -> value (32-byte hex words)
+    struct Call
+    {
+        std::string from;
+        std::string to;
+        std::string data;
+        std::map<std::string, std::map<std::string, std::string>> state_diff;
+    };
+
+    struct CallResult
+    {
+        bool ok = false;    // False when the call reverted or the node refused it
+        std::string output; // Return data when ok
+        std::string error;
+    };
+
+    // Runs the calls in one round trip, results in call order
+    using BatchCaller = std::function<std::vector<CallResult>(const std::vector<Call> &calls)>;
+
+    enum class MappingLayout
+    {
+        SOLIDITY, // keccak(key . slot)
+        VYPER     // keccak(slot . key)
+    };
+
+    struct Swap
+    {
+        std::string pool;
+        std::string token; // Coin the swap spends
+        std::string calldata;
+        uint64_t dx = 0;
+        uint64_t min_dy = 0;
+    };
+
+    struct Outcome
+    {
+        bool passed = false;     // Would execute and return at least min_dy
+        bool overridden = false; // Balance and allowance were overridden (else real state was used)
+        bool has_output = false; // The pool returned its output (older pools' exchange returns nothing)
+        uint64_t output = 0;
+        std::string error;
+    };
+
+    static constexpr uint64_t MAX_PROBED_SLOT = 16;
+    static constexpr uint64_t PROBE_MARKER = 0x5117f00d00000000ULL; // Plus the candidate's index
+
+private:
+    struct TokenSlots
+    {
+        bool found = false;
+        uint64_t balance_slot = 0;
+        MappingLayout balance_layout = MappingLayout::SOLIDITY;
+        uint64_t allowance_slot = 0;
+        MappingLayout allowance_layout = MappingLayout::SOLIDITY;
+    };
+
+    BatchCaller caller;
+    std::string sender;
+    std::map<std::string, TokenSlots> tokens; // Lowercased address -> probed slots
+    uint64_t simulated = 0;
+    uint64_t rejected = 0;
+    uint64_t probed = 0;
+
+    static std::string lower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    static int nibble(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    // 32 raw bytes of a 0x-prefixed (or bare) hex value, left-padded
+    static std::string wordBytes(const std::string &hex)
+    {
+        std::string digits = hex.rfind("0x", 0) == 0 ? hex.substr(2) : hex;
+        if (digits.size() > 64)
+            digits = digits.substr(digits.size() - 64);
+        digits = std::string(64 - digits.size(), '0') + digits;
+        std::string bytes(32, '\0');
+        for (size_t k = 0; k < 32; ++k)
+            bytes[k] = static_cast<char>((nibble(digits[2 * k]) << 4) | nibble(digits[2 * k + 1]));
+        return bytes;
+    }
+
+    static std::string bytesHex(const std::string &bytes)
+    {
+        return Keccak::toHex(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    }
+
+    // First 32-byte word of return data; false unless it fits in 64 bits
+    static bool parseWord(const std::string &output, uint64_t &value)
+    {
+        std::string digits = output.rfind("0x", 0) == 0 ? output.substr(2) : output;
+        if (digits.size() < 64)
+            return false;
+        value = 0;
+        for (size_t k = 0; k < 64; ++k)
+        {
+            int v = nibble(digits[k]);
+            if (v < 0 || (k < 48 && v != 0))
+                return false;
+            if (k >= 48)
+                value = (value << 4) | static_cast<uint64_t>(v);
+        }
+        return true;
+    }
+
+    static std::string calldataFor(const std::string &selector, const std::vector<std::string> &addresses)
+    {
+        std::string data = selector;
+        for (const std::string &address : addresses)
+            data += wordHex(address).substr(2);
+        return data;
+    }
+
+    // The token's balanceOf(sender) / allowance(sender, pool) with every candidate key overridden
+    Call probeCall(const std::string &token, const std::string &pool, bool allowance) const
+    {
+        Call call;
+        call.from = sender;
+        call.to = token;
+        call.data = allowance ? calldataFor("0xdd62ed3e", {sender, pool}) : calldataFor("0x70a08231", {sender});
+        auto &diff = call.state_diff[token];
+        for (uint64_t slot = 0; slot < MAX_PROBED_SLOT; ++slot)
+        {
+            for (MappingLayout layout : {MappingLayout::SOLIDITY, MappingLayout::VYPER})
+            {
+                std::string key = allowance ? allowanceKey(sender, pool, slot, layout) : balanceKey(sender, slot, layout);
+                diff[key] = wordHex(PROBE_MARKER + candidateIndex(slot, layout));
+            }
+        }
+        return call;
+    }
+
+    static uint64_t candidateIndex(uint64_t slot, MappingLayout layout)
+    {
+        return slot * 2 + (layout == MappingLayout::VYPER ? 1 : 0);
+    }
+
+    // The candidate a probe's return value marks, if any
+    static bool probedCandidate(const CallResult &result, uint64_t &slot, MappingLayout &layout)
+    {
+        uint64_t value = 0;
+        if (!result.ok || !parseWord(result.output, value) || value < PROBE_MARKER ||
+            value >= PROBE_MARKER + 2 * MAX_PROBED_SLOT)
+            return false;
+        uint64_t index = value - PROBE_MARKER;
+        slot = index / 2;
+        layout = index % 2 ? MappingLayout::VYPER : MappingLayout::SOLIDITY;
+        return true;
+    }
+
+    // Find slots for tokens not seen before, all in one round trip. The spender doesn't change
+    // the slot, so the first swap's pool stands in for every pool on a token.
+    void probeTokens(const std::vector<Swap> &swaps)
+    {
+        std::vector<Call> calls;
+        std::vector<std::string> pending;
+        for (const Swap &swap : swaps)
+        {
+            std::string token = lower(swap.token);
+            if (tokens.count(token) ||
+                std::find(pending.begin(), pending.end(), token) != pending.end())
+                continue;
+            pending.push_back(token);
+            calls.push_back(probeCall(token, lower(swap.pool), false));
+            calls.push_back(probeCall(token, lower(swap.pool), true));
+        }
+        if (calls.empty())
+            return;
+
+        probed += pending.size();
+        std::vector<CallResult> results = caller(calls);
+        for (size_t k = 0; k < pending.size(); ++k)
+        {
+            TokenSlots slots;
+            if (2 * k + 1 < results.size())
+            {
+                slots.found = probedCandidate(results[2 * k], slots.balance_slot, slots.balance_layout) &&
+                              probedCandidate(results[2 * k + 1], slots.allowance_slot, slots.allowance_layout);
+            }
+            tokens[pending[k]] = slots; // Not found: simulate against real balances from now on
+        }
+    }
+
+public:
+    SwapSimulator(BatchCaller batch_caller, const std::string &sender_address)
+        : caller(std::move(batch_caller)), sender(lower(sender_address)) {}
+
+    // 32-byte hex word of a value or address
+    static std::string wordHex(uint64_t value)
+    {
+        static const char *digits = "0123456789abcdef";
+        std::string hex(64, '0');
+        for (size_t k = 0; k < 16; ++k)
+            hex[63 - k] = digits[(value >> (4 * k)) & 0x0F];
+        return "0x" + hex;
+    }
+
+    static std::string wordHex(const std::string &hex)
+    {
+        return bytesHex(wordBytes(lower(hex)));
+    }
+
+    // Storage key of mapping[key] for a mapping whose base is the word `base`
+    static std::string mappingKey(const std::string &key, const std::string &base, MappingLayout layout)
+    {
+        std::string preimage = layout == MappingLayout::SOLIDITY ? wordBytes(key) + wordBytes(base)
+                                                                 : wordBytes(base) + wordBytes(key);
+        auto digest = Keccak::hash256(preimage);
+        return Keccak::toHex(digest.data(), digest.size());
+    }
+
+    // balances[owner] for a balance mapping declared at `slot`
+    static std::string balanceKey(const std::string &owner, uint64_t slot, MappingLayout layout)
+    {
+        return mappingKey(owner, wordHex(slot), layout);
+    }
+
+    // allowance[owner][spender] for an allowance mapping declared at `slot`
+    static std::string allowanceKey(const std::string &owner, const std::string &spender, uint64_t slot, MappingLayout layout)
+    {
+        return mappingKey(spender, mappingKey(owner, wordHex(slot), layout), layout);
+    }
+
+    // Simulate every swap in one round trip (plus one more the first time a token is seen)
+    std::vector<Outcome> simulate(const std::vector<Swap> &swaps)
+    {
+        std::vector<Outcome> outcomes(swaps.size());
+        if (swaps.empty())
+            return outcomes;
+        probeTokens(swaps);
+
+        std::vector<Call> calls;
+        for (size_t k = 0; k < swaps.size(); ++k)
+        {
+            const Swap &swap = swaps[k];
+            Call call;
+            call.from = sender;
+            call.to = swap.pool;
+            call.data = swap.calldata;
+
+            std::string token = lower(swap.token);
+            const TokenSlots &slots = tokens[token];
+            if (slots.found)
+            {
+                auto &diff = call.state_diff[token];
+                diff[balanceKey(sender, slots.balance_slot, slots.balance_layout)] = wordHex(swap.dx);
+                diff[allowanceKey(sender, lower(swap.pool), slots.allowance_slot, slots.allowance_layout)] = wordHex(swap.dx);
+                outcomes[k].overridden = true;
+            }
+            calls.push_back(call);
+        }
+
+        simulated += calls.size();
+        std::vector<CallResult> results = caller(calls);
+        for (size_t k = 0; k < swaps.size(); ++k)
+        {
+            Outcome &outcome = outcomes[k];
+            if (k >= results.size())
+            {
+                outcome.error = "no simulation result";
+            }
+            else if (!results[k].ok)
+            {
+                outcome.error = results[k].error.empty() ? "execution reverted" : results[k].error;
+            }
+            else
+            {
+                outcome.has_output = parseWord(results[k].output, outcome.output);
+                outcome.passed = !outcome.has_output || outcome.output >= swaps[k].min_dy;
+                if (!outcome.passed)
+                    outcome.error = "simulated output " + std::to_string(outcome.output) + " below min_dy " +
+                                    std::to_string(swaps[k].min_dy);
+            }
+            if (!outcome.passed)
+                rejected++;
+        }
+        return outcomes;
+    }
+
+    // Swaps simulated / caught before broadcast
+    uint64_t simulatedCount() const
+    {
+        return simulated;
+    }
+
+    uint64_t rejectedCount() const
+    {
+        return rejected;
+    }
+
+    // Tokens whose slots were probed
+    uint64_t probedTokens() const
+    {
+        return probed;
+    }
+};
+
+#endif // SWAP_SIMULATOR_H
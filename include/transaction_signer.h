@@ -18,8 +18,18 @@ struct EthereumTransaction
     std::string data;
     uint64_t chain_id;
 
+    // EIP-1559 fees; when max_fee_per_gas is set the transaction is type 2 and gas_price is unused
+    uint64_t max_fee_per_gas;
+    uint64_t max_priority_fee_per_gas;
+
     EthereumTransaction() : nonce(0), gas_price(20000000000), gas_limit(200000),
-                            value(0), chain_id(11155111) {} // Sepolia chain ID
+                            value(0), chain_id(11155111), // Sepolia chain ID
+                            max_fee_per_gas(0), max_priority_fee_per_gas(0) {}
+
+    bool isEip1559() const
+    {
+        return max_fee_per_gas > 0;
+    }
 };
 
 // Simplified transaction signer (production would use secp256k1 library)
@@ -55,6 +65,19 @@ private:
     std::string encodeTransaction(const EthereumTransaction &tx)
     {
         std::stringstream rlp;
+        if (tx.isEip1559())
+        {
+            rlp << "02:" << std::hex << tx.chain_id << ":"
+                << tx.nonce << ":"
+                << tx.max_priority_fee_per_gas << ":"
+                << tx.max_fee_per_gas << ":"
+                << tx.gas_limit << ":"
+                << tx.to_address << ":"
+                << tx.value << ":"
+                << tx.data;
+            return rlp.str();
+        }
+
         rlp << std::hex << tx.nonce << ":"
             << tx.gas_price << ":"
             << tx.gas_limit << ":"
@@ -75,6 +98,10 @@ public:
         std::cout << "   To: " << tx.to_address << std::endl;
         std::cout << "   Data: " << tx.data.substr(0, 20) << "..." << std::endl;
         std::cout << "   Gas Limit: " << tx.gas_limit << std::endl;
+        if (tx.isEip1559())
+        {
+            std::cout << "   Max Fee: " << tx.max_fee_per_gas << " (tip " << tx.max_priority_fee_per_gas << ")" << std::endl;
+        }
 
         // Encode transaction for signing
         std::string encoded = encodeTransaction(tx);
@@ -0,0 +1,320 @@
+#ifndef TRIGGER_INDEX_H
+#define TRIGGER_INDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "pool_state.h"
+#include "stableswap_math.h"
+
+// Trigger Index - inverts each resting order's limit into pool-state space. For an i->j order,
+// the output of get_dy(dx) only grows as the pool holds more j relative to i, so along the
+// pair's swap curve there is one balance ratio xp_j / xp_i at which the limit becomes
+// reachable. That ratio is solved once when the order is armed and kept in an ordered
+// multimap per (pool, i, j); each state update is then a range scan up to the pool's current
+// ratio instead of a get_dy per order. Liquidity events, moves in the other coins, or an A /
+// fee change bend the curve, so the affected books are re-solved ("rebased"). Thresholds carry
+// a small margin so orders fire slightly early; a fired order is still confirmed on-chain.
+// Thread-safe.
+class TriggerIndex
+{
+public:
+    using Real = StableSwapMath::Real;
+
+    struct Arm
+    {
+        std::string order_id;
+        std::string pool;
+        size_t i = 0;
+        size_t j = 0;
+        Real dx = 0;         // Input, native units of coin i
+        Real min_output = 0; // Required get_dy, native units of coin j
+    };
+
+    static constexpr Real TRIGGER_MARGIN = 0.001L;     // Fire 10 bps early
+    static constexpr Real REBASE_TOLERANCE = 0.0005L;  // Curve drift that forces a re-solve
+    static constexpr Real MISS_STEP = 0.0001L;         // Re-armed after a miss: ratio must improve 1 bp
+    static constexpr Real MIN_SHARE = 0.005L;          // Most one-sided pool the solver considers
+    static constexpr int SOLVE_ITERATIONS = 96;
+
+private:
+    // All orders of one pool trading i -> j, solved against the same reference curve
+    struct Book
+    {
+        std::vector<Real> xp; // Reference normalized balances
+        uint64_t amp = 0;
+        uint64_t fee = 0;
+        Real d = 0;
+        std::multimap<Real, std::string> thresholds;
+    };
+
+    struct Entry
+    {
+        Arm spec;
+        Real floor_ratio = 0; // Threshold never below this (set after a missed confirmation)
+        std::multimap<Real, std::string>::iterator position;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::map<std::pair<size_t, size_t>, Book>> books;
+    std::map<std::string, Entry> entries;
+    std::set<std::string> fired;
+    uint64_t evaluations = 0;
+    uint64_t rebase_count = 0;
+    uint64_t fired_count = 0;
+
+    static std::string normalize(const std::string &address)
+    {
+        std::string key = address;
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        return key;
+    }
+
+    static bool usable(const PoolState &state, size_t i, size_t j)
+    {
+        return i != j && i < state.balances.size() && j < state.balances.size() &&
+               state.rates.size() == state.balances.size();
+    }
+
+    static Real ratio(const std::vector<Real> &xp, size_t i, size_t j)
+    {
+        return xp[i] > 0 ? xp[j] / xp[i] : std::numeric_limits<Real>::infinity();
+    }
+
+    static bool drifted(Real reference, Real current)
+    {
+        return std::fabs(current - reference) > std::fabs(reference) * REBASE_TOLERANCE;
+    }
+
+    // Ratio xp_j / xp_i at which the order's output reaches min_output, moving along the i<->j
+    // swap curve of the book's reference state (D and the other coins fixed). Infinite if the
+    // limit is out of reach on this curve.
+    Real solve(const Book &book, const Entry &entry, Real rate_i, Real rate_j)
+    {
+        evaluations++;
+        const Arm &spec = entry.spec;
+        size_t i = spec.i, j = spec.j;
+        Real amp = static_cast<Real>(book.amp);
+        auto pointAt = [&](Real x)
+        {
+            std::vector<Real> xp = book.xp;
+            xp[i] = x;
+            xp[j] = StableSwapMath::getY(i, j, x, book.xp, amp, book.d);
+            return xp;
+        };
+        auto reaches = [&](const std::vector<Real> &xp)
+        {
+            return StableSwapMath::getDy(xp, amp, book.fee, i, j, spec.dx, rate_i, rate_j) >= spec.min_output;
+        };
+
+        // Less of coin i (x smaller) means a higher ratio and a better price for i -> j. The
+        // search stops at a 0.5% share of a balanced pool; beyond that the pool is broken anyway.
+        Real lo = book.d * MIN_SHARE / static_cast<Real>(book.xp.size());
+        Real hi = book.d;
+        Real threshold;
+        if (!reaches(pointAt(lo)))
+        {
+            threshold = std::numeric_limits<Real>::infinity();
+        }
+        else if (reaches(pointAt(hi)))
+        {
+            threshold = 0;
+        }
+        else
+        {
+            // Bisect in log space: lo reaches the limit, hi doesn't
+            for (int k = 0; k < SOLVE_ITERATIONS; ++k)
+            {
+                Real mid = std::sqrt(lo * hi);
+                if (reaches(pointAt(mid)))
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            threshold = ratio(pointAt(lo), i, j) * (1 - TRIGGER_MARGIN);
+        }
+        return std::max(threshold, entry.floor_ratio);
+    }
+
+    void place(Book &book, const std::string &order_id, Entry &entry, const PoolState &state)
+    {
+        Real threshold = solve(book, entry, StableSwapMath::rateOf(state, entry.spec.i),
+                               StableSwapMath::rateOf(state, entry.spec.j));
+        entry.position = book.thresholds.emplace(threshold, order_id);
+    }
+
+    static void rebaseReference(Book &book, const std::vector<Real> &xp, const PoolState &state, uint64_t timestamp)
+    {
+        book.xp = xp;
+        book.amp = state.amplification(timestamp);
+        book.fee = state.fee;
+        book.d = StableSwapMath::getD(xp, static_cast<Real>(book.amp));
+    }
+
+    // True if the pair's swap curve no longer matches the one its thresholds were solved on
+    static bool curveMoved(const Book &book, const std::vector<Real> &xp, Real d, uint64_t amp, uint64_t fee,
+                           size_t i, size_t j)
+    {
+        if (amp != book.amp || fee != book.fee || xp.size() != book.xp.size() || drifted(book.d, d))
+            return true;
+        for (size_t k = 0; k < xp.size(); ++k)
+        {
+            if (k != i && k != j && drifted(book.xp[k], xp[k]))
+                return true;
+        }
+        return false;
+    }
+
+public:
+    // Start watching an order against the pool's current state. False if the state can't be
+    // used (unknown coin decimals, bad indices); the caller keeps quoting that order.
+    // after_miss: a fired order failed its confirmation, so don't fire again until the ratio
+    // improves on where it stands now.
+    bool arm(const Arm &spec, const PoolState &state, uint64_t timestamp, bool after_miss = false)
+    {
+        if (!usable(state, spec.i, spec.j))
+            return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        disarmLocked(spec.order_id);
+
+        std::vector<Real> xp = StableSwapMath::normalizedBalances(state);
+        Book &book = books[normalize(spec.pool)][{spec.i, spec.j}];
+        if (book.thresholds.empty())
+            rebaseReference(book, xp, state, timestamp);
+
+        Entry &entry = entries[spec.order_id];
+        entry.spec = spec;
+        entry.spec.pool = normalize(spec.pool);
+        entry.floor_ratio = after_miss ? ratio(xp, spec.i, spec.j) * (1 + MISS_STEP) : 0;
+        place(book, spec.order_id, entry, state);
+
+        // Already past its threshold: fire right away rather than waiting for the next update
+        if (entry.position->first <= ratio(xp, spec.i, spec.j))
+        {
+            book.thresholds.erase(entry.position);
+            entries.erase(spec.order_id);
+            fired.insert(spec.order_id);
+            fired_count++;
+        }
+        return true;
+    }
+
+    void disarm(const std::string &order_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        disarmLocked(order_id);
+        fired.erase(order_id);
+    }
+
+    // Fold in a new pool state: re-solve books whose curve moved, then fire every order whose
+    // threshold the current ratio has reached. Returns how many orders fired.
+    size_t onState(const std::string &pool, const PoolState &state, uint64_t timestamp)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto pool_it = books.find(normalize(pool));
+        if (pool_it == books.end())
+            return 0;
+
+        std::vector<Real> xp = StableSwapMath::normalizedBalances(state);
+        uint64_t amp = state.amplification(timestamp);
+        Real d = StableSwapMath::getD(xp, static_cast<Real>(amp));
+        size_t count = 0;
+        for (auto &[pair, book] : pool_it->second)
+        {
+            if (book.thresholds.empty() || !usable(state, pair.first, pair.second))
+                continue;
+
+            if (curveMoved(book, xp, d, amp, state.fee, pair.first, pair.second))
+            {
+                rebase_count++;
+                rebaseReference(book, xp, state, timestamp);
+                std::multimap<Real, std::string> previous;
+                previous.swap(book.thresholds);
+                for (auto &[threshold, order_id] : previous)
+                    place(book, order_id, entries[order_id], state);
+            }
+
+            // Range scan: everything at or below the current ratio fires
+            auto end = book.thresholds.upper_bound(ratio(xp, pair.first, pair.second));
+            for (auto it = book.thresholds.begin(); it != end; ++it)
+            {
+                fired.insert(it->second);
+                entries.erase(it->second);
+                count++;
+            }
+            book.thresholds.erase(book.thresholds.begin(), end);
+        }
+        fired_count += count;
+        return count;
+    }
+
+    // True once if the order fired since it was armed; the caller then confirms with a quote
+    bool consume(const std::string &order_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fired.erase(order_id) > 0;
+    }
+
+    bool isArmed(const std::string &order_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.count(order_id) > 0;
+    }
+
+    // Threshold ratio (xp_j / xp_i) an armed order fires at; infinite if unreachable
+    Real threshold(const std::string &order_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(order_id);
+        return it == entries.end() ? std::numeric_limits<Real>::quiet_NaN() : it->second.position->first;
+    }
+
+    size_t armedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    uint64_t evaluationCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return evaluations;
+    }
+
+    uint64_t rebaseCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rebase_count;
+    }
+
+    uint64_t firedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fired_count;
+    }
+
+private:
+    void disarmLocked(const std::string &order_id)
+    {
+        auto it = entries.find(order_id);
+        if (it == entries.end())
+            return;
+        auto pool_it = books.find(it->second.spec.pool);
+        if (pool_it != books.end())
+        {
+            auto book_it = pool_it->second.find({it->second.spec.i, it->second.spec.j});
+            if (book_it != pool_it->second.end())
+                book_it->second.thresholds.erase(it->second.position);
+        }
+        entries.erase(it);
+    }
+};
+
+#endif // TRIGGER_INDEX_H
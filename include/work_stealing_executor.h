@@ -0,0 +1,241 @@
+#ifndef WORK_STEALING_EXECUTOR_H
+#define WORK_STEALING_EXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <iostream>
+
+// Completion latch for a batch of tasks submitted together
+class TaskGroup
+{
+private:
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t pending = 0;
+
+public:
+    void add(size_t count = 1)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending += count;
+    }
+
+    void done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending > 0 && --pending == 0)
+            done_cv.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this]
+                     { return pending == 0; });
+    }
+};
+
+// Work-Stealing Executor - one deque per worker. Owners pop their newest task (cache-warm
+// connection and pool state); idle workers steal the older half of the busiest deque, so a
+// hot pool's backlog spreads out instead of pinning one core.
+class WorkStealingExecutor
+{
+public:
+    // Runs on a worker; the index lets tasks use per-worker resources (e.g. an RPC connection)
+    using Task = std::function<void(size_t worker)>;
+
+    static constexpr size_t NO_AFFINITY = static_cast<size_t>(-1);
+
+private:
+    struct Job
+    {
+        Task task;
+        TaskGroup *group;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::atomic<size_t> size{0}; // Racy hint for victim selection
+        std::atomic<uint64_t> executed{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> next_worker{0};
+    std::atomic<uint64_t> steals{0};
+    bool stopping = false;
+
+    bool popOwn(size_t self, Job &job)
+    {
+        Worker &worker = *workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.jobs.empty())
+            return false;
+        job = std::move(worker.jobs.back());
+        worker.jobs.pop_back();
+        worker.size.store(worker.jobs.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Take the older half of the fullest other deque; run one, keep the rest locally
+    bool stealHalf(size_t self, Job &job)
+    {
+        size_t victim = NO_AFFINITY;
+        size_t victim_size = 0;
+        for (size_t offset = 1; offset < workers.size(); ++offset)
+        {
+            size_t candidate = (self + offset) % workers.size();
+            size_t size = workers[candidate]->size.load(std::memory_order_relaxed);
+            if (size > victim_size)
+            {
+                victim = candidate;
+                victim_size = size;
+            }
+        }
+        if (victim == NO_AFFINITY)
+            return false;
+
+        std::deque<Job> stolen;
+        {
+            Worker &from = *workers[victim];
+            std::lock_guard<std::mutex> lock(from.mutex);
+            size_t take = (from.jobs.size() + 1) / 2;
+            for (size_t k = 0; k < take; ++k)
+            {
+                stolen.push_back(std::move(from.jobs.front()));
+                from.jobs.pop_front();
+            }
+            from.size.store(from.jobs.size(), std::memory_order_relaxed);
+        }
+        if (stolen.empty())
+            return false;
+
+        steals.fetch_add(1, std::memory_order_relaxed);
+        job = std::move(stolen.front());
+        stolen.pop_front();
+
+        if (!stolen.empty())
+        {
+            Worker &own = *workers[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            for (auto &extra : stolen)
+                own.jobs.push_front(std::move(extra)); // Still the oldest work; keep it stealable
+            own.size.store(own.jobs.size(), std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void run(size_t self, Job &job)
+    {
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        try
+        {
+            job.task(self);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Executor task failed: " << e.what() << std::endl;
+        }
+        workers[self]->executed.fetch_add(1, std::memory_order_relaxed);
+        if (job.group)
+            job.group->done();
+    }
+
+    void workerLoop(size_t self)
+    {
+        while (true)
+        {
+            Job job;
+            if (popOwn(self, job) || stealHalf(self, job))
+            {
+                run(self, job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleep_cv.wait(lock, [this]
+                          { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+            if (stopping && queued.load(std::memory_order_relaxed) == 0)
+                return;
+        }
+    }
+
+public:
+    explicit WorkStealingExecutor(size_t worker_count)
+    {
+        size_t count = std::max<size_t>(worker_count, 1);
+        for (size_t k = 0; k < count; ++k)
+            workers.push_back(std::make_unique<Worker>());
+        for (size_t k = 0; k < count; ++k)
+            threads.emplace_back(&WorkStealingExecutor::workerLoop, this, k);
+    }
+
+    // Drains queued tasks before joining
+    ~WorkStealingExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+    WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+    size_t workerCount() const
+    {
+        return workers.size();
+    }
+
+    // Queue a task on its preferred worker (e.g. the pool's home worker); round-robin without a hint
+    void submit(Task task, size_t affinity = NO_AFFINITY, TaskGroup *group = nullptr)
+    {
+        size_t target = affinity == NO_AFFINITY
+                            ? next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size()
+                            : affinity % workers.size();
+        if (group)
+            group->add();
+
+        {
+            // Count before the job is visible so run() never drops the counter below zero;
+            // under the sleep lock so a worker can't miss the wakeup
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            queued.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            Worker &worker = *workers[target];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back({std::move(task), group});
+            worker.size.store(worker.jobs.size(), std::memory_order_relaxed);
+        }
+        sleep_cv.notify_one();
+    }
+
+    uint64_t stealCount() const
+    {
+        return steals.load(std::memory_order_relaxed);
+    }
+
+    uint64_t executedBy(size_t worker) const
+    {
+        return workers[worker]->executed.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // WORK_STEALING_EXECUTOR_H
@@ -0,0 +1,685 @@
+#ifndef WS_SUBSCRIBER_H
+#define WS_SUBSCRIBER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <charconv>
+#include <cerrno>
+#include <stdexcept>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+// newHeads notification
+struct NewHead
+{
+    uint64_t number = 0;
+    uint64_t timestamp = 0;
+    std::string hash;
+    std::string parent_hash;
+    std::string logs_bloom; // Empty if the node left it out
+};
+
+// logs notification for one of the watched pools
+struct PoolLog
+{
+    std::string address; // Lowercased
+    std::vector<std::string> topics;
+    std::string data;
+    uint64_t block_number = 0;
+    std::string block_hash;
+    std::string transaction_hash;
+    uint64_t log_index = 0;
+    bool removed = false; // Log dropped by a reorg
+};
+
+// Pool Activity - last block in which each pool emitted a log, fed by the subscription.
+// Lets pollers skip re-quoting pools whose state cannot have changed.
+class PoolActivity
+{
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, uint64_t> last_log_block;
+    uint64_t screened_from = 0; // First of an unbroken run of bloom-screened heads (0: none)
+    uint64_t screened_to = 0;   // Last head of that run
+
+    static std::string normalize(const std::string &address)
+    {
+        std::string key = address;
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        return key;
+    }
+
+public:
+    void record(const std::string &pool, uint64_t block)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t &last = last_log_block[normalize(pool)];
+        last = std::max(last, block);
+    }
+
+    // True if the pool logged anything in a block after `block`
+    bool changedSince(const std::string &pool, uint64_t block) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = last_log_block.find(normalize(pool));
+        return it != last_log_block.end() && it->second > block;
+    }
+
+    // A head's logsBloom was checked and every pool it may contain was record()ed, so
+    // changedSince() no longer has to wait for late log notifications for this block. A head
+    // that doesn't follow the last screened one (skipped or replaced blocks) starts a new run.
+    void screened(uint64_t block)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (screened_from == 0 || block != screened_to + 1)
+            screened_from = block;
+        screened_to = block;
+    }
+
+    // A head arrived without a usable bloom, or the feed dropped: the unbroken run ends
+    void unscreened()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        screened_from = 0;
+        screened_to = 0;
+    }
+
+    // True if every block after `block` was bloom-screened
+    bool screenedSince(uint64_t block) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return screened_from != 0 && screened_from <= block + 1;
+    }
+};
+
+// WebSocket Subscriber - eth_subscribe client for newHeads and logs on the watched pools.
+// Runs on its own thread; reconnects with backoff and resubscribes after any drop. The feed is
+// live only once the node has confirmed every subscription; a rejected one fails the session.
+// Whatever the node emitted between a drop and the resubscribe is lost, so a disconnect
+// handler hears about every session that ends after subscribing. Frames are
+// parsed in place in the receive buffer and JSON is read straight from the payload span;
+// only fragmented messages are copied. Handlers run on the subscriber thread.
+class WebSocketSubscriber
+{
+public:
+    using HeadHandler = std::function<void(const NewHead &head)>;
+    using LogHandler = std::function<void(const PoolLog &log)>;
+    using DisconnectHandler = std::function<void()>;
+
+    struct Options
+    {
+        std::chrono::milliseconds initial_backoff{250};
+        std::chrono::milliseconds max_backoff{10000};
+        std::chrono::milliseconds idle_timeout{60000}; // No frame for this long: assume dead
+    };
+
+    static bool supportsUrl(const std::string &url)
+    {
+        return url.rfind("ws://", 0) == 0;
+    }
+
+private:
+    enum class Kind
+    {
+        HEADS,
+        LOGS
+    };
+
+    static constexpr uint64_t HEADS_REQUEST_ID = 1;
+    static constexpr uint64_t LOGS_REQUEST_ID = 2;
+    static constexpr uint64_t MAX_MESSAGE_BYTES = 16 * 1024 * 1024; // One frame or reassembled message
+    static constexpr size_t MAX_HANDSHAKE_BYTES = 64 * 1024;
+
+    std::string host;
+    std::string port;
+    std::string path;
+    std::vector<std::string> pools;
+    HeadHandler on_head;
+    LogHandler on_log;
+    DisconnectHandler on_disconnect;
+    Options options;
+
+    std::thread worker;
+    std::mutex state_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+    int socket_fd = -1;
+
+    std::atomic<bool> live{false};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> heads{0};
+    std::atomic<uint64_t> logs{0};
+
+    std::map<std::string, Kind> subscriptions;
+    size_t requested_subscriptions = 0;
+    std::vector<char> recv_buffer;
+    size_t recv_length = 0;
+    std::string fragment;
+    bool fragmented = false;
+    std::mt19937 mask_rng{std::random_device{}()};
+
+    // A "0x" quantity that fits 64 bits; false for anything else
+    static bool hexValue(const nlohmann::json &value, uint64_t &out)
+    {
+        if (!value.is_string())
+            return false;
+        const std::string &text = value.get_ref<const std::string &>();
+        if (text.size() < 3 || text[0] != '0' || (text[1] != 'x' && text[1] != 'X'))
+            return false;
+        const char *end = text.data() + text.size();
+        auto [stop, error] = std::from_chars(text.data() + 2, end, out, 16);
+        return error == std::errc() && stop == end;
+    }
+
+    void parseUrl(const std::string &url)
+    {
+        std::string rest = url.substr(5); // After "ws://"
+        size_t slash = rest.find('/');
+        std::string authority = rest.substr(0, slash);
+        path = slash == std::string::npos ? "/" : rest.substr(slash);
+
+        size_t colon = authority.rfind(':');
+        if (colon != std::string::npos && authority.find(']') == std::string::npos)
+        {
+            host = authority.substr(0, colon);
+            port = authority.substr(colon + 1);
+        }
+        else
+        {
+            host = authority;
+            port = "80";
+        }
+        if (!host.empty() && host.front() == '[')
+            host = host.substr(1, host.size() - 2);
+        if (host.empty())
+            throw std::runtime_error("Invalid WebSocket URL: " + url);
+    }
+
+    void sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw std::runtime_error(std::string("WebSocket write failed: ") + std::strerror(errno));
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // Client frames must be masked (RFC 6455 5.3)
+    void sendFrame(int fd, uint8_t opcode, std::string_view payload)
+    {
+        std::string frame;
+        frame.reserve(payload.size() + 14);
+        frame.push_back(static_cast<char>(0x80 | opcode));
+        if (payload.size() < 126)
+        {
+            frame.push_back(static_cast<char>(0x80 | payload.size()));
+        }
+        else if (payload.size() <= 0xFFFF)
+        {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>(payload.size() >> 8));
+            frame.push_back(static_cast<char>(payload.size() & 0xFF));
+        }
+        else
+        {
+            frame.push_back(static_cast<char>(0x80 | 127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+                frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF));
+        }
+
+        uint32_t mask = mask_rng();
+        char key[4];
+        std::memcpy(key, &mask, 4);
+        frame.append(key, 4);
+        for (size_t k = 0; k < payload.size(); ++k)
+            frame.push_back(static_cast<char>(payload[k] ^ key[k % 4]));
+        sendAll(fd, frame);
+    }
+
+    int openSocket()
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses = nullptr;
+        int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+        if (rc != 0)
+            throw std::runtime_error("Cannot resolve " + host + ": " + gai_strerror(rc));
+
+        int fd = -1;
+        std::string last_error = "no addresses";
+        for (addrinfo *address = addresses; address; address = address->ai_next)
+        {
+            fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd < 0)
+                continue;
+            if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+                break;
+            last_error = std::strerror(errno);
+            ::close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0)
+            throw std::runtime_error("Cannot connect to " + host + ":" + port + ": " + last_error);
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        timeval idle{};
+        idle.tv_sec = options.idle_timeout.count() / 1000;
+        idle.tv_usec = (options.idle_timeout.count() % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+        return fd;
+    }
+
+    // Read more bytes into the receive buffer; false on close, error or idle timeout. It only
+    // grows while a frame is incomplete, and frames are capped at MAX_MESSAGE_BYTES.
+    bool fill(int fd)
+    {
+        if (recv_buffer.size() - recv_length < 16 * 1024)
+            recv_buffer.resize(recv_buffer.size() * 2);
+        ssize_t n;
+        do
+        {
+            n = ::recv(fd, recv_buffer.data() + recv_length, recv_buffer.size() - recv_length, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return false;
+        recv_length += static_cast<size_t>(n);
+        return true;
+    }
+
+    void handshake(int fd)
+    {
+        std::uniform_int_distribution<int> byte(0, 255);
+        static const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        // 16 random bytes, base64 (the key only has to be unique, so any 22 symbols + "==" do)
+        std::string key;
+        for (int k = 0; k < 21; ++k)
+            key.push_back(alphabet[byte(mask_rng) & 63]);
+        key.push_back(alphabet[byte(mask_rng) & 48]);
+        key += "==";
+
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + ":" + port +
+                              "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                              "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        sendAll(fd, request);
+
+        recv_length = 0;
+        while (true)
+        {
+            std::string_view received(recv_buffer.data(), recv_length);
+            size_t header_end = received.find("\r\n\r\n");
+            if (header_end != std::string_view::npos)
+            {
+                if (received.substr(0, 12).find(" 101") == std::string_view::npos)
+                    throw std::runtime_error("WebSocket upgrade refused: " + std::string(received.substr(0, received.find("\r\n"))));
+                // Frames may already follow the handshake
+                size_t consumed = header_end + 4;
+                std::memmove(recv_buffer.data(), recv_buffer.data() + consumed, recv_length - consumed);
+                recv_length -= consumed;
+                return;
+            }
+            if (recv_length > MAX_HANDSHAKE_BYTES)
+                throw std::runtime_error("WebSocket upgrade response too large");
+            if (!fill(fd))
+                throw std::runtime_error("WebSocket handshake failed");
+        }
+    }
+
+    void subscribe(int fd)
+    {
+        subscriptions.clear();
+        requested_subscriptions = pools.empty() ? 1 : 2;
+        nlohmann::json heads_request = {{"jsonrpc", "2.0"}, {"id", HEADS_REQUEST_ID}, {"method", "eth_subscribe"}, {"params", {"newHeads"}}};
+        sendFrame(fd, 0x1, heads_request.dump());
+        if (!pools.empty())
+        {
+            nlohmann::json filter = {{"address", pools}};
+            nlohmann::json logs_request = {{"jsonrpc", "2.0"}, {"id", LOGS_REQUEST_ID}, {"method", "eth_subscribe"}, {"params", {"logs", filter}}};
+            sendFrame(fd, 0x1, logs_request.dump());
+        }
+    }
+
+    void dispatch(const char *begin, const char *end)
+    {
+        nlohmann::json message = nlohmann::json::parse(begin, end, nullptr, false);
+        if (message.is_discarded())
+        {
+            std::cerr << "⚠️ Unparseable subscription message dropped" << std::endl;
+            return;
+        }
+
+        // Subscription confirmations map the node's subscription id to the stream kind
+        if (message.contains("id") && message["id"].is_number())
+        {
+            uint64_t id = message["id"].get<uint64_t>();
+            // Without every stream the feed would look healthy while one of them stays silent
+            if (message.contains("error"))
+                throw std::runtime_error("eth_subscribe rejected: " + message["error"].dump());
+            if (message.contains("result") && message["result"].is_string())
+                subscriptions[message["result"].get<std::string>()] = id == HEADS_REQUEST_ID ? Kind::HEADS : Kind::LOGS;
+            if (subscriptions.size() >= requested_subscriptions)
+                live = true;
+            return;
+        }
+
+        // Notifications: a field of the wrong type or a bad quantity drops the message, not the feed
+        if (!message.is_object() || !message.contains("params") || !message["params"].is_object())
+            return;
+        const nlohmann::json &params = message["params"];
+        NewHead head;
+        PoolLog log;
+        Kind kind = Kind::HEADS;
+        try
+        {
+            if (message.value("method", "") != "eth_subscription")
+                return;
+            auto subscription = subscriptions.find(params.value("subscription", ""));
+            if (subscription == subscriptions.end() || !params.contains("result") || !params["result"].is_object())
+                return;
+            const nlohmann::json &result = params["result"];
+            kind = subscription->second;
+
+            if (kind == Kind::HEADS)
+            {
+                if (!hexValue(result.value("number", nlohmann::json()), head.number) ||
+                    (result.contains("timestamp") && !hexValue(result["timestamp"], head.timestamp)))
+                    throw std::invalid_argument("bad head number or timestamp");
+                head.hash = result.value("hash", "");
+                head.parent_hash = result.value("parentHash", "");
+                head.logs_bloom = result.value("logsBloom", "");
+            }
+            else
+            {
+                log.address = result.value("address", "");
+                std::transform(log.address.begin(), log.address.end(), log.address.begin(), ::tolower);
+                for (const auto &topic : result.value("topics", nlohmann::json::array()))
+                {
+                    if (!topic.is_string())
+                        throw std::invalid_argument("non-string topic");
+                    log.topics.push_back(topic.get<std::string>());
+                }
+                log.data = result.value("data", "0x");
+                if (!hexValue(result.value("blockNumber", nlohmann::json()), log.block_number) ||
+                    !hexValue(result.value("logIndex", nlohmann::json()), log.log_index))
+                    throw std::invalid_argument("bad block number or log index");
+                log.block_hash = result.value("blockHash", "");
+                log.transaction_hash = result.value("transactionHash", "");
+                log.removed = result.value("removed", false);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Malformed subscription message dropped: " << e.what() << std::endl;
+            return;
+        }
+
+        if (kind == Kind::HEADS)
+        {
+            heads++;
+            if (on_head)
+                on_head(head);
+            return;
+        }
+        logs++;
+        if (on_log)
+            on_log(log);
+    }
+
+    // Consume every complete frame in the buffer; false once the server sent close
+    bool drainFrames(int fd)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(recv_buffer.data());
+        size_t offset = 0;
+        while (recv_length - offset >= 2)
+        {
+            bool fin = bytes[offset] & 0x80;
+            uint8_t opcode = bytes[offset] & 0x0F;
+            bool masked = bytes[offset + 1] & 0x80;
+            uint64_t length = bytes[offset + 1] & 0x7F;
+            size_t header = 2;
+            if (length == 126)
+            {
+                if (recv_length - offset < 4)
+                    break;
+                length = (static_cast<uint64_t>(bytes[offset + 2]) << 8) | bytes[offset + 3];
+                header = 4;
+            }
+            else if (length == 127)
+            {
+                if (recv_length - offset < 10)
+                    break;
+                length = 0;
+                for (int k = 0; k < 8; ++k)
+                    length = (length << 8) | bytes[offset + 2 + k];
+                header = 10;
+            }
+            // Checked before header + length is formed, so that sum can't wrap either
+            if (length > MAX_MESSAGE_BYTES)
+                throw std::runtime_error("WebSocket frame of " + std::to_string(length) + " bytes exceeds the message cap");
+            if (masked)
+                header += 4;
+            if (recv_length - offset < header + length)
+                break;
+
+            char *payload = recv_buffer.data() + offset + header;
+            if (masked)
+            {
+                const char *key = payload - 4;
+                for (uint64_t k = 0; k < length; ++k)
+                    payload[k] ^= key[k % 4];
+            }
+
+            switch (opcode)
+            {
+            case 0x0: // Continuation
+            case 0x1: // Text
+            case 0x2: // Binary
+                if (opcode != 0x0)
+                {
+                    fragment.clear();
+                    fragmented = false;
+                }
+                if (fin && !fragmented)
+                {
+                    dispatch(payload, payload + length);
+                }
+                else
+                {
+                    if (fragment.size() + length > MAX_MESSAGE_BYTES)
+                        throw std::runtime_error("Fragmented WebSocket message exceeds the message cap");
+                    fragment.append(payload, length);
+                    fragmented = !fin;
+                    if (fin)
+                        dispatch(fragment.data(), fragment.data() + fragment.size());
+                }
+                break;
+            case 0x8: // Close
+                sendFrame(fd, 0x8, std::string_view(payload, std::min<uint64_t>(length, 2)));
+                return false;
+            case 0x9: // Ping
+                sendFrame(fd, 0xA, std::string_view(payload, length));
+                break;
+            default: // Pong and reserved opcodes
+                break;
+            }
+            offset += header + length;
+        }
+
+        if (offset > 0)
+        {
+            std::memmove(recv_buffer.data(), recv_buffer.data() + offset, recv_length - offset);
+            recv_length -= offset;
+        }
+        return true;
+    }
+
+    void session()
+    {
+        int fd = openSocket();
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (stopping)
+            {
+                ::close(fd);
+                return;
+            }
+            socket_fd = fd;
+        }
+
+        bool subscribed = false;
+        try
+        {
+            handshake(fd);
+            subscribe(fd);
+            subscribed = true;
+            connects++;
+            fragment.clear();
+            fragmented = false;
+            while (drainFrames(fd) && fill(fd))
+            {
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (!stopping)
+                std::cerr << "⚠️ WebSocket session: " << e.what() << std::endl;
+        }
+
+        live = false;
+        bool stopped;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            stopped = stopping;
+            socket_fd = -1;
+            ::close(fd);
+        }
+        if (subscribed && !stopped && on_disconnect)
+            on_disconnect();
+    }
+
+    void run()
+    {
+        std::chrono::milliseconds backoff = options.initial_backoff;
+        while (true)
+        {
+            uint64_t delivered_before = heads + logs;
+            try
+            {
+                session();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "⚠️ WebSocket connect: " << e.what() << std::endl;
+            }
+
+            // A session that delivered events was healthy; start the backoff over
+            if (heads + logs > delivered_before)
+                backoff = options.initial_backoff;
+
+            std::unique_lock<std::mutex> lock(state_mutex);
+            if (stop_cv.wait_for(lock, backoff, [this]
+                                 { return stopping; }))
+                return;
+            backoff = std::min(backoff * 2, options.max_backoff);
+        }
+    }
+
+public:
+    WebSocketSubscriber(const std::string &url, std::vector<std::string> watched_pools,
+                        HeadHandler head_handler, LogHandler log_handler, Options subscriber_options)
+        : pools(std::move(watched_pools)), on_head(std::move(head_handler)), on_log(std::move(log_handler)),
+          options(subscriber_options), recv_buffer(64 * 1024)
+    {
+        if (!supportsUrl(url))
+            throw std::runtime_error("WebSocket subscriber needs a ws:// URL: " + url);
+        parseUrl(url);
+        for (auto &pool : pools)
+            std::transform(pool.begin(), pool.end(), pool.begin(), ::tolower);
+    }
+
+    WebSocketSubscriber(const std::string &url, std::vector<std::string> watched_pools,
+                        HeadHandler head_handler, LogHandler log_handler = nullptr)
+        : WebSocketSubscriber(url, std::move(watched_pools), std::move(head_handler), std::move(log_handler), Options()) {}
+
+    ~WebSocketSubscriber()
+    {
+        stop();
+    }
+
+    WebSocketSubscriber(const WebSocketSubscriber &) = delete;
+    WebSocketSubscriber &operator=(const WebSocketSubscriber &) = delete;
+
+    // Called on the subscriber thread when a session ends after subscribing; set before start()
+    void onDisconnect(DisconnectHandler handler)
+    {
+        on_disconnect = std::move(handler);
+    }
+
+    void start()
+    {
+        if (!worker.joinable())
+            worker = std::thread(&WebSocketSubscriber::run, this);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            stopping = true;
+            if (socket_fd >= 0)
+                ::shutdown(socket_fd, SHUT_RDWR);
+        }
+        stop_cv.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // Connected, with every subscription confirmed by the node
+    bool isLive() const
+    {
+        return live.load();
+    }
+
+    uint64_t connectCount() const
+    {
+        return connects.load();
+    }
+
+    uint64_t headsReceived() const
+    {
+        return heads.load();
+    }
+
+    uint64_t logsReceived() const
+    {
+        return logs.load();
+    }
+};
+
+#endif // WS_SUBSCRIBER_H
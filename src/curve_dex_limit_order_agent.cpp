@@ -7,12 +7,43 @@
 #include <iomanip>
 #include <memory>
 #include <map>
+#include <set>
+#include <cmath>
 #include <sstream>
+#include <algorithm>
+#include <optional>
 
 // Include our limit order structure
 #include "../include/limit_order.h"
 #include "../include/sepolia_config.h"
 #include "../include/transaction_signer.h"
+#include "../include/allowance_tracker.h"
+#include "../include/gas_oracle.h"
+#include "../include/gas_model.h"
+#include "../include/order_aggregator.h"
+#include "../include/slice_scheduler.h"
+#include "../include/order_shards.h"
+#include "../include/work_stealing_executor.h"
+#include "../include/order_coroutines.h"
+#include "../include/http_transport.h"
+#include "../include/ipc_transport.h"
+#include "../include/ws_subscriber.h"
+#include "../include/pool_state.h"
+#include "../include/trigger_index.h"
+#include "../include/logs_bloom.h"
+#include "../include/rpc_scheduler.h"
+#include "../include/single_flight.h"
+#include "../include/poll_scheduler.h"
+#include "../include/impact_curve.h"
+#include "../include/cryptoswap_math.h"
+#include "../include/metapool_math.h"
+#include "../include/swap_simulator.h"
+#include "../include/curve_selectors.h"
+#include "../include/rpc_deadline.h"
+#include "../include/retry_policy.h"
+#include "../include/circuit_breaker.h"
+#include "../include/runtime_config.h"
+#include "../include/nonce_allocator.h"
 
 using json = nlohmann::json;
 
@@ -34,6 +65,13 @@ std::string encodeAddress(const std::string &address)
     return std::string(24, '0') + clean_addr;
 }
 
+std::string toHexQuantity(uint64_t value)
+{
+    std::stringstream ss;
+    ss << "0x" << std::hex << value;
+    return ss.str();
+}
+
 uint64_t hexToUint64(const std::string &hex)
 {
     std::string cleanHex = hex;
@@ -69,6 +107,52 @@ private:
     std::string rpc_url;
     CURL *curl;
 
+    // Optional raw HTTP/1.1 transport for plain-http local nodes (RPC_TRANSPORT=epoll)
+    std::unique_ptr<HttpTransport> raw_http;
+    std::vector<std::string> batch_bodies;
+
+    // Node IPC socket, chosen when the URL is a path (e.g. /data/geth.ipc). Ids are unique per
+    // connection so concurrent callers' replies can be told apart.
+    std::unique_ptr<IpcTransport> ipc;
+    std::atomic<uint64_t> next_ipc_id{1};
+
+    // Shared per-provider rate limit (RPC_RATE_LIMIT); null when unlimited. Calls go out under
+    // this connection's priority class, except broadcasts, which always jump the queue.
+    std::shared_ptr<RpcScheduler> scheduler;
+    RpcPriority priority = RpcPriority::TRIGGER;
+
+    // Identical read-only calls in flight on any connection to this provider share one reply
+    std::shared_ptr<SingleFlight<json>> flights;
+
+    // Shared per-provider breaker: stops sending while the provider keeps failing
+    std::shared_ptr<CircuitBreaker> breaker;
+    std::atomic<uint64_t> retries{0};
+
+    static std::shared_ptr<SingleFlight<json>> flightsFor(const std::string &url)
+    {
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::shared_ptr<SingleFlight<json>>> registry;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::shared_ptr<SingleFlight<json>> &shared = registry[url];
+        if (!shared)
+            shared = std::make_shared<SingleFlight<json>>();
+        return shared;
+    }
+
+    // Reads whose answer doesn't depend on who asked; never sends, nonces or filters
+    static bool coalescable(const std::string &method)
+    {
+        return method == "eth_call" || method == "eth_blockNumber" || method == "eth_getBalance" ||
+               method == "eth_getCode" || method == "eth_estimateGas" || method == "eth_getBlockByNumber" ||
+               method == "eth_feeHistory" || method == "eth_gasPrice" || method == "eth_getTransactionReceipt";
+    }
+
+    // nlohmann::json keeps object keys sorted, so dump() is already canonical
+    static std::string flightKey(const std::string &method, const json &params)
+    {
+        return method + ":" + params.dump();
+    }
+
     static size_t WriteCallback(void *contents, size_t size, size_t nmemb, std::string *response)
     {
         size_t totalSize = size * nmemb;
@@ -76,26 +160,28 @@ private:
         return totalSize;
     }
 
-public:
-    EthereumRPC(const std::string &url) : rpc_url(url)
+    // A transport failure once this thread's deadline has passed is reported as the deadline
+    template <typename Transport>
+    static auto withinDeadline(Transport &&transport) -> decltype(transport())
     {
-        curl = curl_easy_init();
-        if (!curl)
+        try
         {
-            throw std::runtime_error("Failed to initialize CURL");
+            return transport();
+        }
+        catch (const DeadlineExceeded &)
+        {
+            throw;
+        }
+        catch (const std::exception &e)
+        {
+            if (RpcDeadline::expired())
+                throw DeadlineExceeded(std::string("RPC deadline exceeded: ") + e.what());
+            throw;
         }
     }
 
-    ~EthereumRPC()
-    {
-        if (curl)
-            curl_easy_cleanup(curl);
-    }
-
-    json call(const std::string &method, const json &params)
+    std::string post(const std::string &request_str, int timeout_ms)
     {
-        json request = {{"jsonrpc", "2.0"}, {"method", method}, {"params", params}, {"id", 1}};
-        std::string request_str = request.dump();
         std::string response;
 
         struct curl_slist *headers = nullptr;
@@ -106,6 +192,8 @@ public:
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout_ms));
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(std::min(timeout_ms, RpcDeadline::CONNECT_MS)));
 
         CURLcode res = curl_easy_perform(curl);
         curl_slist_free_all(headers);
@@ -114,425 +202,2855 @@ public:
         {
             throw std::runtime_error("CURL request failed: " + std::string(curl_easy_strerror(res)));
         }
-
-        return json::parse(response);
+        long status = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        if (status >= 400)
+        {
+            throw std::runtime_error("HTTP " + std::to_string(status) + " from RPC endpoint");
+        }
+        return response;
     }
-};
-
-// Curve Pool Interface (simplified from original)
-class CurvePool
-{
-private:
-    std::string pool_address;
-    EthereumRPC *rpc;
-
-public:
-    CurvePool(const std::string &address, EthereumRPC *ethereum_rpc)
-        : pool_address(address), rpc(ethereum_rpc) {}
 
-    // Get exchange rate using get_dy
-    uint64_t get_dy(int32_t i, int32_t j, uint64_t dx)
+    // Several calls in one round trip; responses come back in call order.
+    // Raw HTTP pipelines them on the kept-alive socket, IPC writes them back to back and
+    // matches replies by id, curl sends one JSON-RPC batch. Bounded by the thread's deadline.
+    std::vector<json> sendBatchOnce(const std::vector<std::pair<std::string, json>> &calls)
     {
-        // Check if we should use mock mode for demo purposes
-        const char *mock_flag = std::getenv("USE_MOCK_PRICING");
-        bool use_mock = mock_flag && std::string(mock_flag) == "1";
+        std::vector<json> responses(calls.size());
+        if (calls.empty())
+            return responses;
+        int timeout = RpcDeadline::budgetMs();
 
-        if (use_mock)
+        if (ipc)
         {
-            // Mock pricing for demo: return realistic values
-            // Simulate a market where 1 USDC ≈ 0.999 DAI (slight discount)
-            double mock_rate = 0.999;
-            return static_cast<uint64_t>(dx * mock_rate);
+            std::vector<std::string> bodies(calls.size());
+            std::vector<uint64_t> ids(calls.size());
+            for (size_t k = 0; k < calls.size(); ++k)
+            {
+                ids[k] = next_ipc_id++;
+                json request = {{"jsonrpc", "2.0"}, {"method", calls[k].first}, {"params", calls[k].second}, {"id", ids[k]}};
+                bodies[k] = request.dump();
+            }
+            std::vector<std::string> replies = withinDeadline([&]
+                                                              { return ipc->exchange(bodies, ids, timeout); });
+            for (size_t k = 0; k < replies.size(); ++k)
+                responses[k] = json::parse(replies[k]);
+            return responses;
         }
 
-        std::string function_signature = "0x5e0d443f";
-        std::string encoded_i = encodeUint256(static_cast<uint64_t>(i));
-        std::string encoded_j = encodeUint256(static_cast<uint64_t>(j));
-        std::string encoded_dx = encodeUint256(dx);
-        std::string call_data = function_signature + encoded_i + encoded_j + encoded_dx;
-
-        json call_params = {{{"to", pool_address}, {"data", call_data}}, "latest"};
-        auto result = rpc->call("eth_call", call_params);
-
-        if (result.contains("error"))
+        if (raw_http)
         {
-            throw std::runtime_error("RPC Error: " + result["error"]["message"].get<std::string>());
+            batch_bodies.resize(calls.size());
+            for (size_t k = 0; k < calls.size(); ++k)
+            {
+                json request = {{"jsonrpc", "2.0"}, {"method", calls[k].first}, {"params", calls[k].second}, {"id", k + 1}};
+                batch_bodies[k] = request.dump();
+            }
+            const std::vector<std::string_view> &bodies = withinDeadline([&]() -> const std::vector<std::string_view> &
+                                                                         { return raw_http->pipeline(batch_bodies, timeout); });
+            for (size_t k = 0; k < bodies.size(); ++k)
+                responses[k] = json::parse(bodies[k].begin(), bodies[k].end());
+            return responses;
         }
 
-        return hexToUint64(result["result"]);
+        json batch = json::array();
+        for (size_t k = 0; k < calls.size(); ++k)
+        {
+            batch.push_back({{"jsonrpc", "2.0"}, {"method", calls[k].first}, {"params", calls[k].second}, {"id", k + 1}});
+        }
+        json reply = json::parse(withinDeadline([&]
+                                                { return post(batch.dump(), timeout); }));
+        if (!reply.is_array())
+        {
+            throw std::runtime_error("RPC batch rejected: " + reply.dump());
+        }
+        // Batch replies may arrive in any order; match them back up by id
+        for (const auto &item : reply)
+        {
+            size_t id = item.value("id", static_cast<size_t>(0));
+            if (id >= 1 && id <= calls.size())
+                responses[id - 1] = item;
+        }
+        return responses;
     }
 
-    // Mock swap execution (will be replaced with real implementation)
-    std::string executeSwap(int32_t i, int32_t j, uint64_t dx, uint64_t min_dy)
+    // A provider-side failure carried in a JSON-RPC error reply (rate limit, internal error)
+    static std::optional<RpcErrorClass> failureOf(const json &reply)
     {
-        std::cout << "🔄 EXECUTING SWAP: " << dx << " tokens (" << i << " -> " << j << ")" << std::endl;
-        std::cout << "   Minimum output: " << min_dy << std::endl;
-        std::cout << "   Pool: " << pool_address << std::endl;
+        if (!reply.is_object() || !reply.contains("error") || !reply["error"].is_object())
+            return std::nullopt;
+        const json &error = reply["error"];
+        int64_t code = error.contains("code") && error["code"].is_number_integer() ? error["code"].get<int64_t>() : 0;
+        RpcErrorClass cls = RetryPolicy::classifyCode(code, error.value("message", std::string()));
+        if (cls == RpcErrorClass::REJECTED)
+            return std::nullopt; // The node answered; the request was the problem
+        return cls;
+    }
 
-        // If EXECUTE_ONCHAIN is not set, return mock tx hash
-        const char *exec_flag = std::getenv("EXECUTE_ONCHAIN");
-        bool execute_onchain = exec_flag && std::string(exec_flag) == "1";
-        if (!execute_onchain)
+    // Only a batch refused as a whole is retried; single bad items are the caller's business
+    static std::optional<RpcErrorClass> failureOf(const std::vector<json> &replies)
+    {
+        if (replies.empty())
+            return std::nullopt;
+        std::optional<RpcErrorClass> first = failureOf(replies.front());
+        for (const json &reply : replies)
         {
-            std::cout << "[INFO] EXECUTE_ONCHAIN not set. Returning mock transaction hash." << std::endl;
-            return "0x" + std::string(64, 'f');
+            if (failureOf(reply) != first)
+                return std::nullopt;
         }
+        return first;
+    }
 
-        // Build function data for Curve pool exchange: exchange(int128 i, int128 j, uint256 dx, uint256 min_dy, address receiver)
-        // Signature selector (example): 0x394747c5
-        std::string function_selector = "0x394747c5";
-        std::string data = function_selector +
-                           encodeUint256(static_cast<uint64_t>(i)) +
-                           encodeUint256(static_cast<uint64_t>(j)) +
-                           encodeUint256(dx) +
-                           encodeUint256(min_dy) +
-                           encodeAddress(SepoliaConfig::Wallet::ADDRESS);
+    // Whether a retry after `wait` still lands inside the thread's deadline
+    static bool timeForRetry(std::chrono::milliseconds wait)
+    {
+        RpcDeadline::Clock::time_point deadline = RpcDeadline::current();
+        return deadline == RpcDeadline::Clock::time_point::max() || RpcDeadline::Clock::now() + wait < deadline;
+    }
 
-        // Resolve RPC URL
-        std::string rpc_url = SepoliaConfig::SEPOLIA_RPC_URL;
-        if (const char *rpc_env = std::getenv("RPC_URL"); rpc_env && std::string(rpc_env).size() > 0)
+    // Send through the provider's circuit breaker, retrying provider-side failures per their
+    // error class with jittered backoff while the deadline allows. Broadcasts are tried once
+    // and never refused by the breaker: resending a signed transaction is the caller's call.
+    template <typename Request>
+    auto resilient(bool broadcast, Request &&request) -> decltype(request())
+    {
+        for (int attempt = 1;; ++attempt)
         {
-            rpc_url = rpc_env;
-        }
-
-        // Create signer and transaction
-        TransactionSigner signer(SepoliaConfig::Wallet::PRIVATE_KEY);
+            CircuitBreaker::Admission admission = breaker->admit();
+            if (admission == CircuitBreaker::Admission::DENIED)
+            {
+                if (!broadcast)
+                    throw CircuitOpen("RPC circuit open for " + rpc_url);
+                admission = CircuitBreaker::Admission::ALLOWED;
+            }
 
-        // Fetch nonce from network if possible
-        uint64_t nonce = 0;
-        try
-        {
-            json nonce_resp = rpc->call("eth_getTransactionCount", json::array({SepoliaConfig::Wallet::ADDRESS, "latest"}));
-            if (nonce_resp.contains("result"))
+            RpcErrorClass cls;
+            try
             {
-                nonce = std::stoull(std::string(nonce_resp["result"]).substr(2), nullptr, 16);
+                auto reply = request();
+                std::optional<RpcErrorClass> failure = failureOf(reply);
+                breaker->record(admission, !failure || !RetryPolicy::countsAgainstProvider(*failure));
+                if (!failure || broadcast || !RetryPolicy::shouldRetry(*failure, attempt))
+                    return reply;
+                cls = *failure;
             }
+            catch (const DeadlineExceeded &)
+            {
+                breaker->release(admission);
+                throw;
+            }
+            catch (const std::exception &e)
+            {
+                cls = RetryPolicy::classify(e.what());
+                breaker->record(admission, !RetryPolicy::countsAgainstProvider(cls));
+                if (broadcast || !RetryPolicy::shouldRetry(cls, attempt))
+                    throw;
+            }
+
+            std::chrono::milliseconds wait = RetryPolicy::delay(cls, attempt);
+            if (!timeForRetry(wait))
+                throw DeadlineExceeded("RPC deadline leaves no time to retry " + rpc_url);
+            retries++;
+            std::this_thread::sleep_for(wait);
         }
-        catch (...)
-        {
-            nonce = signer.getCurrentNonce(SepoliaConfig::Wallet::ADDRESS);
-        }
+    }
 
-        EthereumTransaction tx;
-        tx.nonce = nonce;
-        tx.to_address = pool_address;
-        tx.data = data;
-        tx.gas_limit = SepoliaConfig::Gas::SWAP_GAS_LIMIT;
-        tx.chain_id = SepoliaConfig::SEPOLIA_CHAIN_ID; // default to Sepolia
+    std::vector<json> sendBatch(const std::vector<std::pair<std::string, json>> &calls)
+    {
+        if (calls.empty())
+            return {};
+        return resilient(false, [&]
+                         { return sendBatchOnce(calls); });
+    }
 
-        std::string raw_tx = signer.signTransaction(tx);
+public:
+    EthereumRPC(const std::string &url) : rpc_url(url)
+    {
+        curl = curl_easy_init();
+        if (!curl)
+        {
+            throw std::runtime_error("Failed to initialize CURL");
+        }
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Timeouts without SIGALRM; calls run on many threads
+        const RuntimeSettings &config = RuntimeConfig::get();
+        scheduler = RpcScheduler::shared(url, config.rpc_rate_limit, config.rpc_burst);
+        flights = flightsFor(url);
+        breaker = CircuitBreaker::shared(url);
 
-        const char *broadcast_flag = std::getenv("BROADCAST_TX");
-        bool broadcast = broadcast_flag && std::string(broadcast_flag) == "1";
-        if (!broadcast)
+        if (IpcTransport::supportsUrl(url))
         {
-            std::cout << "[INFO] BROADCAST_TX not set. Returning signed (demo) tx hash string." << std::endl;
-            return signer.broadcastTransaction(raw_tx); // returns derived hash without network send
+            ipc = std::make_unique<IpcTransport>(url);
+            return;
         }
 
-        // Actually broadcast over RPC
-        try
+        if (config.rpc_transport == "epoll")
         {
-            json send_params = json::array({raw_tx});
-            json send_resp = rpc->call("eth_sendRawTransaction", send_params);
-            if (send_resp.contains("result"))
+            if (!HttpTransport::supportsUrl(url))
             {
-                std::string tx_hash = send_resp["result"];
-                std::cout << "✅ Broadcast succeeded: " << tx_hash << std::endl;
-                return tx_hash;
+                std::cerr << "⚠️ RPC_TRANSPORT=epoll needs an http:// URL; using curl for " << url << std::endl;
+            }
+            else
+            {
+                try
+                {
+                    raw_http = std::make_unique<HttpTransport>(url);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "⚠️ " << e.what() << "; using curl" << std::endl;
+                }
             }
-            std::cout << "⚠️ Broadcast response without result; falling back to local hash." << std::endl;
-        }
-        catch (const std::exception &e)
-        {
-            std::cout << "⚠️ Broadcast failed: " << e.what() << ". Returning local hash." << std::endl;
         }
-
-        return signer.broadcastTransaction(raw_tx);
     }
-};
-
-// 🚀 MAIN LIMIT ORDER EXECUTION ENGINE
-class LimitOrderEngine
-{
-private:
-    EthereumRPC *rpc;
-    std::vector<std::unique_ptr<LimitOrder>> active_orders;
 
-public:
-    LimitOrderEngine(EthereumRPC *ethereum_rpc) : rpc(ethereum_rpc) {}
-
-    // Add an order to the engine
-    void addOrder(std::unique_ptr<LimitOrder> order)
+    ~EthereumRPC()
     {
-        order->updateStatus(OrderStatus::ACTIVE);
-        std::cout << "\n📝 ORDER ADDED: " << order->order_id << " (" << order->getTifString() << ")" << std::endl;
-        order->printSummary();
-        active_orders.push_back(std::move(order));
+        if (curl)
+            curl_easy_cleanup(curl);
     }
 
-    // Execute GTC policy: Monitor continuously until filled or canceled
-    void executeGTC(LimitOrder &order)
+private:
+    // One call straight to the transport (after the rate limiter), bounded by the thread's deadline
+    json sendOnce(const std::string &method, const json &params)
     {
-        std::cout << "\n🔄 Executing GTC Policy for " << order.order_id << std::endl;
+        if (scheduler)
+            scheduler->acquire(method == "eth_sendRawTransaction" ? RpcPriority::BROADCAST : priority, 1, false,
+                               RpcDeadline::current());
+        int timeout = RpcDeadline::budgetMs();
 
-        // Create pool connection
-        CurvePool pool(order.pool_address, rpc);
+        if (ipc)
+        {
+            uint64_t id = next_ipc_id++;
+            json request = {{"jsonrpc", "2.0"}, {"method", method}, {"params", params}, {"id", id}};
+            return json::parse(withinDeadline([&]
+                                              { return ipc->call(request.dump(), id, timeout); }));
+        }
 
-        int check_count = 0;
-        const int max_checks = 10; // Limit for demo
+        json request = {{"jsonrpc", "2.0"}, {"method", method}, {"params", params}, {"id", 1}};
+        std::string request_str = request.dump();
 
-        while (order.isExecutable() && check_count < max_checks)
+        if (raw_http)
         {
-            try
-            {
-                // Get current price
-                uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
-                order.recordPriceCheck(current_output);
+            std::string_view body = withinDeadline([&]
+                                                   { return raw_http->post(request_str, timeout); });
+            return json::parse(body.begin(), body.end());
+        }
+        return json::parse(withinDeadline([&]
+                                          { return post(request_str, timeout); }));
+    }
 
-                std::cout << "💰 Price Check #" << (check_count + 1) << ": " << current_output << " output tokens" << std::endl;
+    json send(const std::string &method, const json &params)
+    {
+        return resilient(method == "eth_sendRawTransaction", [&]
+                         { return sendOnce(method, params); });
+    }
 
-                // Check if price meets limit
-                if (order.isPriceMet(current_output))
-                {
-                    std::cout << "✅ PRICE TARGET MET! Executing swap..." << std::endl;
+    // Several calls in one round trip, in call order. Under a rate limit the batch goes out in
+    // chunks sized to whatever the shared budget allows at the time.
+    std::vector<json> sendScheduled(const std::vector<std::pair<std::string, json>> &calls)
+    {
+        if (!scheduler || calls.empty())
+            return sendBatch(calls);
 
-                    uint64_t min_output = order.getMinOutputWithSlippage(current_output);
-                    std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
-                                                           order.input_amount, min_output);
+        std::vector<json> responses;
+        responses.reserve(calls.size());
+        size_t sent = 0;
+        while (sent < calls.size())
+        {
+            size_t chunk = scheduler->acquire(priority, calls.size() - sent, true, RpcDeadline::current());
+            std::vector<std::pair<std::string, json>> part(calls.begin() + sent, calls.begin() + sent + chunk);
+            for (auto &reply : sendBatch(part))
+                responses.push_back(std::move(reply));
+            sent += chunk;
+        }
+        return responses;
+    }
 
-                    order.transaction_hash = tx_hash;
-                    order.filled_amount = order.input_amount;
-                    order.received_amount = current_output;
-                    order.updateStatus(OrderStatus::FILLED);
+public:
+    json call(const std::string &method, const json &params)
+    {
+        if (!coalescable(method))
+            return send(method, params);
+        return withinDeadline([&]
+                              { return flights->run(flightKey(method, params), [&]
+                                                    { return send(method, params); },
+                                                    RpcDeadline::current()); });
+    }
 
-                    std::cout << "🎉 ORDER FILLED! Transaction: " << tx_hash << std::endl;
-                    return;
-                }
+    // Batched calls; identical reads are sent once, whether they repeat inside the batch or are
+    // already in flight from another caller (those are waited on after our own batch is back)
+    std::vector<json> callBatch(const std::vector<std::pair<std::string, json>> &calls)
+    {
+        using Flight = SingleFlight<json>::Flight;
+        std::vector<json> responses(calls.size());
+        std::vector<std::pair<std::string, json>> outgoing;
+        std::vector<size_t> outgoing_index;
+        std::vector<std::pair<size_t, std::shared_ptr<Flight>>> led, followed;
+        std::vector<std::pair<size_t, size_t>> repeats; // (call, first identical call in batch)
+        std::vector<std::string> keys(calls.size());
+        std::map<std::string, size_t> first_seen;
+
+        for (size_t k = 0; k < calls.size(); ++k)
+        {
+            if (!coalescable(calls[k].first))
+            {
+                outgoing.push_back(calls[k]);
+                outgoing_index.push_back(k);
+                continue;
+            }
+            keys[k] = flightKey(calls[k].first, calls[k].second);
+            auto seen = first_seen.find(keys[k]);
+            if (seen != first_seen.end())
+            {
+                repeats.push_back({k, seen->second});
+                continue;
+            }
+            first_seen[keys[k]] = k;
 
-                check_count++;
-                std::this_thread::sleep_for(std::chrono::seconds(2)); // Wait 2 seconds between checks
+            bool leader = false;
+            std::shared_ptr<Flight> flight = flights->join(keys[k], leader);
+            if (leader)
+            {
+                led.push_back({k, flight});
+                outgoing.push_back(calls[k]);
+                outgoing_index.push_back(k);
             }
-            catch (const std::exception &e)
+            else
             {
-                std::cerr << "❌ Error in GTC execution: " << e.what() << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(5));
+                followed.push_back({k, flight});
             }
         }
 
-        if (check_count >= max_checks)
+        try
         {
-            order.updateStatus(OrderStatus::CANCELED, "Demo limit reached");
-            std::cout << "⏰ GTC Order stopped after " << max_checks << " price checks (demo mode)" << std::endl;
+            std::vector<json> replies = sendScheduled(outgoing);
+            for (size_t n = 0; n < replies.size(); ++n)
+                responses[outgoing_index[n]] = std::move(replies[n]);
+        }
+        catch (...)
+        {
+            for (auto &[k, flight] : led)
+                flights->fail(keys[k], flight, std::current_exception());
+            throw;
         }
+        for (auto &[k, flight] : led)
+            flights->complete(keys[k], flight, responses[k]);
+
+        for (auto &[k, flight] : followed)
+            responses[k] = withinDeadline([&]
+                                          { return SingleFlight<json>::wait(flight, RpcDeadline::current()); });
+        for (auto &[k, first] : repeats)
+            responses[k] = responses[first];
+        return responses;
     }
 
-    // Execute GTT policy: Monitor until expiry
-    void executeGTT(LimitOrder &order)
+    const SingleFlight<json> &getFlights() const
     {
-        std::cout << "\n⏰ Executing GTT Policy for " << order.order_id << std::endl;
+        return *flights;
+    }
 
-        CurvePool pool(order.pool_address, rpc);
+    void setPriority(RpcPriority cls)
+    {
+        priority = cls;
+    }
 
-        while (order.isExecutable() && !order.isExpired())
-        {
-            try
-            {
-                uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
-                order.recordPriceCheck(current_output);
+    const RpcScheduler *getScheduler() const
+    {
+        return scheduler.get();
+    }
 
-                if (order.isPriceMet(current_output))
-                {
-                    std::cout << "✅ GTT ORDER FILLED before expiry!" << std::endl;
+    CircuitBreaker &getBreaker()
+    {
+        return *breaker;
+    }
 
-                    uint64_t min_output = order.getMinOutputWithSlippage(current_output);
-                    std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
-                                                           order.input_amount, min_output);
+    uint64_t retryCount() const
+    {
+        return retries;
+    }
 
-                    order.transaction_hash = tx_hash;
-                    order.filled_amount = order.input_amount;
-                    order.updateStatus(OrderStatus::FILLED);
-                    return;
-                }
+    const std::string &getUrl() const
+    {
+        return rpc_url;
+    }
+};
 
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-            }
-            catch (const std::exception &e)
-            {
-                std::cerr << "❌ Error in GTT execution: " << e.what() << std::endl;
+// The wallet's pending transaction count; approvals and swaps take nonces from one allocator
+uint64_t pendingNonce(EthereumRPC *rpc)
+{
+    json response = rpc->call("eth_getTransactionCount", json::array({SepoliaConfig::Wallet::ADDRESS, "pending"}));
+    if (!response.contains("result"))
+        throw std::runtime_error("No pending nonce from RPC");
+    return hexToUint64(response["result"]);
+}
+
+class ERC20Token
+{
+private:
+    std::string token_address;
+    EthereumRPC *rpc;
+    const GasOracle *gas_oracle;
+
+public:
+    ERC20Token(const std::string &address, EthereumRPC *ethereum_rpc, const GasOracle *oracle = nullptr)
+        : token_address(address), rpc(ethereum_rpc), gas_oracle(oracle) {}
+
+    // allowance(address owner, address spender) - 0xdd62ed3e
+    uint64_t allowance(const std::string &owner, const std::string &spender)
+    {
+        std::string call_data = "0xdd62ed3e" + encodeAddress(owner) + encodeAddress(spender);
+        json call_params = {{{"to", token_address}, {"data", call_data}}, "latest"};
+        auto result = rpc->call("eth_call", call_params);
+
+        if (result.contains("error"))
+        {
+            throw std::runtime_error("RPC Error: " + result["error"]["message"].get<std::string>());
+        }
+
+        return hexToUint64(result["result"]);
+    }
+
+    // approve(address spender, uint256 amount) - 0x095ea7b3
+    std::string approve(const std::string &spender, uint64_t amount)
+    {
+        std::string data = "0x095ea7b3" + encodeAddress(spender) + encodeUint256(amount);
+
+        const RuntimeSettings &config = RuntimeConfig::get();
+        if (!config.execute_onchain)
+        {
+            return "0x" + std::string(64, 'b');
+        }
+
+        TransactionSigner signer(SepoliaConfig::Wallet::PRIVATE_KEY);
+
+        // Same nonce source as swaps, so a queued approve and the next swap don't collide
+        NonceAllocator &nonces = NonceAllocator::forWallet(SepoliaConfig::Wallet::ADDRESS);
+        uint64_t nonce = nonces.acquire([this]
+                                        { return pendingNonce(rpc); },
+                                        [&signer]
+                                        { return signer.getCurrentNonce(SepoliaConfig::Wallet::ADDRESS); });
+
+        EthereumTransaction tx;
+        tx.nonce = nonce;
+        tx.to_address = token_address;
+        tx.data = data;
+        tx.gas_limit = SepoliaConfig::Gas::APPROVE_GAS_LIMIT;
+        tx.chain_id = SepoliaConfig::SEPOLIA_CHAIN_ID;
+
+        // Approvals are pipelined ahead of fills, so passive fees are enough
+        if (gas_oracle)
+        {
+            FeeQuote fees = gas_oracle->quote(FeeUrgency::PASSIVE);
+            tx.max_fee_per_gas = fees.max_fee_per_gas;
+            tx.max_priority_fee_per_gas = fees.max_priority_fee_per_gas;
+        }
+
+        std::string raw_tx = signer.signTransaction(tx);
+
+        if (!config.broadcast_tx)
+        {
+            nonces.release(nonce);
+            return signer.broadcastTransaction(raw_tx);
+        }
+
+        json send_resp;
+        try
+        {
+            send_resp = rpc->call("eth_sendRawTransaction", json::array({raw_tx}));
+        }
+        catch (...)
+        {
+            nonces.release(nonce);
+            throw;
+        }
+        if (!send_resp.contains("result"))
+        {
+            nonces.release(nonce);
+            std::string message = send_resp.contains("error") ? send_resp["error"].value("message", "unknown error") : "no result";
+            throw std::runtime_error("Approve broadcast failed: " + message);
+        }
+        return send_resp["result"];
+    }
+};
+
+// Curve Pool Interface (simplified from original)
+class CurvePool
+{
+private:
+    std::string pool_address;
+    EthereumRPC *rpc;
+    const GasOracle *gas_oracle;
+    GasModel *gas_model;
+    bool underlying; // Metapool underlying-coin indices: get_dy_underlying / exchange_underlying
+
+public:
+    CurvePool(const std::string &address, EthereumRPC *ethereum_rpc,
+              const GasOracle *oracle = nullptr, GasModel *model = nullptr, bool underlying_coins = false)
+        : pool_address(address), rpc(ethereum_rpc), gas_oracle(oracle), gas_model(model), underlying(underlying_coins) {}
+
+    // Check if we should use mock mode for demo purposes
+    static bool usesMockPricing()
+    {
+        return RuntimeConfig::get().use_mock_pricing;
+    }
+
+    // CryptoSwap (v2) pools index coins as uint256 in get_dy; StableSwap uses int128
+    struct CryptoSwapRegistry
+    {
+        std::mutex mutex;
+        std::set<std::string> pools; // Lowercased addresses
+    };
+
+    static CryptoSwapRegistry &cryptoSwapRegistry()
+    {
+        static CryptoSwapRegistry registry;
+        return registry;
+    }
+
+    static std::string lowercase(std::string address)
+    {
+        std::transform(address.begin(), address.end(), address.begin(), ::tolower);
+        return address;
+    }
+
+    static void markCryptoSwap(const std::string &address)
+    {
+        CryptoSwapRegistry &registry = cryptoSwapRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.pools.insert(lowercase(address));
+    }
+
+    static bool isCryptoSwap(const std::string &address)
+    {
+        CryptoSwapRegistry &registry = cryptoSwapRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.pools.count(lowercase(address)) > 0;
+    }
+
+    // eth_call params for get_dy(i, j, dx) on a pool, or get_dy_underlying on a metapool
+    static json getDyParams(const std::string &address, int32_t i, int32_t j, uint64_t dx, bool underlying = false)
+    {
+        std::string function_signature = CurveSelectors::getDy(isCryptoSwap(address), underlying);
+        std::string encoded_i = encodeUint256(static_cast<uint64_t>(i));
+        std::string encoded_j = encodeUint256(static_cast<uint64_t>(j));
+        std::string encoded_dx = encodeUint256(dx);
+        std::string call_data = function_signature + encoded_i + encoded_j + encoded_dx;
+
+        return {{{"to", address}, {"data", call_data}}, "latest"};
+    }
+
+    static uint64_t decodeGetDy(const json &result)
+    {
+        if (result.contains("error"))
+        {
+            throw std::runtime_error("RPC Error: " + result["error"]["message"].get<std::string>());
+        }
+        if (!result.contains("result"))
+        {
+            throw std::runtime_error("RPC response without result");
+        }
+
+        return hexToUint64(result["result"]);
+    }
+
+    // Read a StableSwap pool's full pricing state in one batch (up to MAX_COINS coins; the coin
+    // count is where balances(i) starts reverting). The A ramp is read as stored and brought to
+    // plain A by the pool's A_PRECISION, which pools with A_precise() keep at A_precise() / A().
+    static PoolState fetchState(EthereumRPC &ethereum_rpc, const std::string &address)
+    {
+        static constexpr size_t MAX_COINS = 4;
+        static const std::string balances_selector = Keccak::functionSelector("balances(uint256)");
+        static const std::string coins_selector = Keccak::functionSelector("coins(uint256)");
+        static const char *const fields[] = {"initial_A()", "future_A()", "initial_A_time()", "future_A_time()",
+                                             "fee()", "admin_fee()", "A()", "A_precise()"};
+        static constexpr size_t FIELDS = std::size(fields);
+        auto view = [&address](const std::string &data) -> json
+        { return json::array({{{"to", address}, {"data", data}}, "latest"}); };
+
+        std::vector<std::pair<std::string, json>> calls;
+        calls.push_back({"eth_blockNumber", json::array()});
+        for (const char *field : fields)
+            calls.push_back({"eth_call", view(Keccak::functionSelector(field))});
+        for (size_t i = 0; i < MAX_COINS; ++i)
+            calls.push_back({"eth_call", view(balances_selector + encodeUint256(i))});
+        for (size_t i = 0; i < MAX_COINS; ++i)
+            calls.push_back({"eth_call", view(coins_selector + encodeUint256(i))});
+        std::vector<json> replies = ethereum_rpc.callBatch(calls);
+
+        auto amount = [&replies](size_t index, PoolAmount &value)
+        {
+            const json &reply = replies[index];
+            return !reply.contains("error") && reply.contains("result") && reply["result"].is_string() &&
+                   reply["result"].get<std::string>().size() > 2 &&
+                   PoolStateStore::parseAmount(reply["result"].get<std::string>(), value);
+        };
+
+        PoolState state;
+        PoolAmount value = 0;
+        if (!amount(0, value))
+            throw std::runtime_error("eth_blockNumber failed while reading " + address);
+        state.block = static_cast<uint64_t>(value);
+        uint64_t read[FIELDS] = {};
+        for (size_t k = 0; k < FIELDS - 1; ++k)
+        {
+            if (!amount(1 + k, value))
+                throw std::runtime_error("Pool " + address + " does not look like a StableSwap pool");
+            read[k] = static_cast<uint64_t>(value);
+        }
+        // Older pools have no A_precise(): their ramp is stored in plain A
+        uint64_t a = read[FIELDS - 2];
+        if (amount(FIELDS, value) && a > 0)
+        {
+            uint64_t ratio = static_cast<uint64_t>(value) / a;
+            while (state.a_precision * 10 <= ratio)
+                state.a_precision *= 10;
+        }
+        state.initial_A = read[0] / state.a_precision;
+        state.future_A = read[1] / state.a_precision;
+        state.initial_A_time = read[2];
+        state.future_A_time = read[3];
+        state.fee = read[4];
+        state.admin_fee = read[5];
+        for (size_t i = 0; i < MAX_COINS && amount(1 + FIELDS + i, value); ++i)
+            state.balances.push_back(value);
+        if (state.balances.size() < 2)
+            throw std::runtime_error("Pool " + address + " exposes fewer than two balances");
+
+        // Precision multipliers from each coin's decimals(); left empty (unknown) if any coin
+        // can't be resolved, so nothing downstream trusts normalized balances for this pool
+        state.rates = precisionsOf(ethereum_rpc, std::vector<json>(replies.begin() + 1 + FIELDS + MAX_COINS,
+                                                                   replies.begin() + 1 + FIELDS + MAX_COINS + state.balances.size()));
+        return state;
+    }
+
+    // Read a CryptoSwap pool's pricing state in one batch: two-coin pools expose price_scale(),
+    // tricrypto price_scale(k). Coin decimals are looked up too unless `precisions` is given.
+    // Throws if the pool doesn't answer like a v2 pool.
+    static CryptoPoolState fetchCryptoState(EthereumRPC &ethereum_rpc, const std::string &address,
+                                            const std::vector<uint64_t> &precisions = {})
+    {
+        static constexpr size_t MAX_COINS = 3;
+        static const std::string balances_selector = Keccak::functionSelector("balances(uint256)");
+        static const std::string price_scale_selector = Keccak::functionSelector("price_scale(uint256)");
+        static const std::string coins_selector = Keccak::functionSelector("coins(uint256)");
+        auto view = [&address](const std::string &data) -> json
+        { return json::array({{{"to", address}, {"data", data}}, "latest"}); };
+
+        std::vector<std::pair<std::string, json>> calls;
+        calls.push_back({"eth_blockNumber", json::array()});
+        for (const char *getter : {"A()", "gamma()", "D()", "mid_fee()", "out_fee()", "fee_gamma()", "price_scale()"})
+            calls.push_back({"eth_call", view(Keccak::functionSelector(getter))});
+        for (size_t i = 0; i < MAX_COINS; ++i)
+            calls.push_back({"eth_call", view(balances_selector + encodeUint256(i))});
+        for (size_t i = 0; i + 1 < MAX_COINS; ++i)
+            calls.push_back({"eth_call", view(price_scale_selector + encodeUint256(i))});
+        for (size_t i = 0; i < MAX_COINS; ++i)
+            calls.push_back({"eth_call", view(coins_selector + encodeUint256(i))});
+        std::vector<json> replies = ethereum_rpc.callBatch(calls);
+
+        auto amount = [&replies](size_t index, PoolAmount &value)
+        {
+            const json &reply = replies[index];
+            return !reply.contains("error") && reply.contains("result") && reply["result"].is_string() &&
+                   reply["result"].get<std::string>().size() > 2 &&
+                   PoolStateStore::parseAmount(reply["result"].get<std::string>(), value);
+        };
+
+        CryptoPoolState state;
+        PoolAmount value = 0;
+        if (!amount(0, value))
+            throw std::runtime_error("eth_blockNumber failed while reading " + address);
+        state.block = static_cast<uint64_t>(value);
+        PoolAmount fields[6];
+        for (size_t k = 0; k < 6; ++k)
+        {
+            if (!amount(1 + k, fields[k]))
+                throw std::runtime_error("Pool " + address + " does not look like a CryptoSwap pool");
+        }
+        state.A = static_cast<uint64_t>(fields[0]);
+        state.gamma = static_cast<uint64_t>(fields[1]);
+        state.D = fields[2];
+        state.mid_fee = static_cast<uint64_t>(fields[3]);
+        state.out_fee = static_cast<uint64_t>(fields[4]);
+        state.fee_gamma = static_cast<uint64_t>(fields[5]);
+
+        for (size_t i = 0; i < MAX_COINS && amount(8 + i, value); ++i)
+            state.balances.push_back(value);
+        if (state.balances.size() < 2)
+            throw std::runtime_error("Pool " + address + " exposes fewer than two balances");
+        if (state.balances.size() == 2 && amount(7, value))
+        {
+            state.price_scale.push_back(value);
+        }
+        else
+        {
+            for (size_t i = 0; i + 1 < state.balances.size() && amount(8 + MAX_COINS + i, value); ++i)
+                state.price_scale.push_back(value);
+        }
+        if (state.price_scale.size() + 1 != state.balances.size())
+            throw std::runtime_error("Pool " + address + " has no price_scale for every coin");
+
+        size_t coins_at = 8 + MAX_COINS + (MAX_COINS - 1);
+        state.precisions = precisions.size() == state.balances.size()
+                               ? precisions
+                               : precisionsOf(ethereum_rpc, std::vector<json>(replies.begin() + coins_at,
+                                                                              replies.begin() + coins_at + state.balances.size()));
+        if (state.precisions.empty())
+            throw std::runtime_error("Could not resolve coin decimals for " + address);
+        return state;
+    }
+
+    // A metapool's fixed wiring, resolved once: its base pool, the base LP token and both
+    // sides' coin precisions
+    struct MetapoolLayout
+    {
+        std::string base_pool;
+        std::string base_token;
+        std::vector<uint64_t> meta_rates; // [paired coin, LP token (18 decimals)]
+        std::vector<uint64_t> base_rates;
+    };
+
+    static MetapoolLayout fetchMetapoolLayout(EthereumRPC &ethereum_rpc, const std::string &address)
+    {
+        static constexpr size_t MAX_BASE_COINS = 4;
+        static const std::string coins_selector = Keccak::functionSelector("coins(uint256)");
+        auto view = [](const std::string &to, const std::string &data) -> json
+        { return json::array({{{"to", to}, {"data", data}}, "latest"}); };
+        auto addressOf = [](const json &reply) -> std::string
+        {
+            if (reply.contains("error") || !reply.contains("result") || !reply["result"].is_string() ||
+                reply["result"].get<std::string>().size() < 42)
+                return "";
+            std::string word = reply["result"].get<std::string>();
+            std::string address = "0x" + word.substr(word.size() - 40);
+            return address == "0x" + std::string(40, '0') ? "" : address;
+        };
+
+        std::vector<json> replies = ethereum_rpc.callBatch({{"eth_call", view(address, Keccak::functionSelector("base_pool()"))},
+                                                            {"eth_call", view(address, coins_selector + encodeUint256(0))},
+                                                            {"eth_call", view(address, coins_selector + encodeUint256(1))}});
+        MetapoolLayout layout;
+        layout.base_pool = addressOf(replies[0]);
+        layout.base_token = addressOf(replies[2]);
+        if (layout.base_pool.empty() || layout.base_token.empty())
+            throw std::runtime_error("Pool " + address + " does not look like a metapool");
+        layout.meta_rates = precisionsOf(ethereum_rpc, {replies[1]});
+        if (layout.meta_rates.empty())
+            throw std::runtime_error("Could not resolve coin decimals for " + address);
+        layout.meta_rates.push_back(1);
+
+        // The base pool's coin count is where coins(i) starts reverting
+        std::vector<std::pair<std::string, json>> calls;
+        for (size_t i = 0; i < MAX_BASE_COINS; ++i)
+            calls.push_back({"eth_call", view(layout.base_pool, coins_selector + encodeUint256(i))});
+        std::vector<json> base_coins = ethereum_rpc.callBatch(calls);
+        size_t count = 0;
+        while (count < base_coins.size() && !addressOf(base_coins[count]).empty())
+            count++;
+        if (count >= 2)
+            layout.base_rates = precisionsOf(ethereum_rpc, std::vector<json>(base_coins.begin(), base_coins.begin() + count));
+        if (layout.base_rates.empty())
+            throw std::runtime_error("Could not resolve base pool coins for " + address);
+        return layout;
+    }
+
+    // Read a metapool's pricing state in one batch, along with its base pool's (balances, A,
+    // fee, LP supply, virtual price) unless `base` already holds this block's. Block number and
+    // time come from the same batch, for the metapool's virtual price cache and A ramps.
+    static MetapoolState fetchMetapoolState(EthereumRPC &ethereum_rpc, const std::string &address,
+                                            const MetapoolLayout &layout, const BasePoolSnapshot *base = nullptr)
+    {
+        static const std::string balances_selector = Keccak::functionSelector("balances(uint256)");
+        auto view = [](const std::string &to, const std::string &data) -> json
+        { return json::array({{{"to", to}, {"data", data}}, "latest"}); };
+
+        std::vector<std::pair<std::string, json>> calls;
+        calls.push_back({"eth_getBlockByNumber", json::array({"latest", false})});
+        for (const char *getter : {"A()", "fee()", "base_virtual_price()", "base_cache_updated()"})
+            calls.push_back({"eth_call", view(address, Keccak::functionSelector(getter))});
+        for (size_t i = 0; i <= MetapoolState::MAX_COIN; ++i)
+            calls.push_back({"eth_call", view(address, balances_selector + encodeUint256(i))});
+        size_t base_at = calls.size();
+        if (!base)
+        {
+            for (const char *getter : {"A()", "fee()", "get_virtual_price()"})
+                calls.push_back({"eth_call", view(layout.base_pool, Keccak::functionSelector(getter))});
+            calls.push_back({"eth_call", view(layout.base_token, Keccak::functionSelector("totalSupply()"))});
+            for (size_t i = 0; i < layout.base_rates.size(); ++i)
+                calls.push_back({"eth_call", view(layout.base_pool, balances_selector + encodeUint256(i))});
+        }
+        std::vector<json> replies = ethereum_rpc.callBatch(calls);
+
+        auto amount = [&replies](size_t index, PoolAmount &value)
+        {
+            const json &reply = replies[index];
+            return !reply.contains("error") && reply.contains("result") && reply["result"].is_string() &&
+                   reply["result"].get<std::string>().size() > 2 &&
+                   PoolStateStore::parseAmount(reply["result"].get<std::string>(), value);
+        };
+
+        MetapoolState state;
+        const json &head = replies[0];
+        if (head.contains("error") || !head.contains("result") || !head["result"].is_object())
+            throw std::runtime_error("eth_getBlockByNumber failed while reading " + address);
+        state.block = hexToUint64(head["result"].value("number", "0x0"));
+        state.timestamp = hexToUint64(head["result"].value("timestamp", "0x0"));
+
+        PoolAmount fields[2];
+        for (size_t k = 0; k < 2; ++k)
+        {
+            if (!amount(1 + k, fields[k]))
+                throw std::runtime_error("Pool " + address + " does not look like a metapool");
+        }
+        state.meta.initial_A = state.meta.future_A = static_cast<uint64_t>(fields[0]);
+        state.meta.fee = static_cast<uint64_t>(fields[1]);
+        // Factory metapools keep no virtual price cache and always ask the base pool
+        PoolAmount cached = 0, updated = 0;
+        if (amount(3, cached) && amount(4, updated))
+        {
+            state.cached_virtual_price = cached;
+            state.cache_updated = static_cast<uint64_t>(updated);
+        }
+        PoolAmount value = 0;
+        for (size_t i = 0; i <= MetapoolState::MAX_COIN; ++i)
+        {
+            if (!amount(5 + i, value))
+                throw std::runtime_error("Pool " + address + " exposes fewer than two balances");
+            state.meta.balances.push_back(value);
+        }
+        state.meta.rates = layout.meta_rates;
+        state.meta.block = state.block;
+        if (base)
+        {
+            state.base = *base;
+            return state;
+        }
+
+        PoolAmount base_fields[4];
+        for (size_t k = 0; k < 4; ++k)
+        {
+            if (!amount(base_at + k, base_fields[k]))
+                throw std::runtime_error("Base pool " + layout.base_pool + " of " + address + " could not be read");
+        }
+        state.base.state.initial_A = state.base.state.future_A = static_cast<uint64_t>(base_fields[0]);
+        state.base.state.fee = static_cast<uint64_t>(base_fields[1]);
+        state.base.virtual_price = base_fields[2];
+        state.base.supply = base_fields[3];
+        for (size_t i = 0; i < layout.base_rates.size(); ++i)
+        {
+            if (!amount(base_at + 4 + i, value))
+                throw std::runtime_error("Base pool " + layout.base_pool + " of " + address + " could not be read");
+            state.base.state.balances.push_back(value);
+        }
+        state.base.state.rates = layout.base_rates;
+        state.base.state.block = state.block;
+        return state;
+    }
+
+    // 10^(18 - decimals) for each coin, given the pool's coins(i) replies; empty if any coin
+    // can't be resolved
+    static std::vector<uint64_t> precisionsOf(EthereumRPC &ethereum_rpc, const std::vector<json> &coin_replies)
+    {
+        std::vector<std::pair<std::string, json>> decimals_calls;
+        for (const json &reply : coin_replies)
+        {
+            if (reply.contains("error") || !reply.contains("result") || !reply["result"].is_string() ||
+                reply["result"].get<std::string>().size() < 42)
+                return {};
+            std::string coin = "0x" + reply["result"].get<std::string>().substr(reply["result"].get<std::string>().size() - 40);
+            decimals_calls.push_back({"eth_call", json::array({{{"to", coin}, {"data", Keccak::functionSelector("decimals()")}}, "latest"})});
+        }
+        std::vector<json> decimals = ethereum_rpc.callBatch(decimals_calls);
+        std::vector<uint64_t> rates;
+        for (const json &reply : decimals)
+        {
+            PoolAmount places = 0;
+            if (reply.contains("error") || !reply.contains("result") || !reply["result"].is_string() ||
+                reply["result"].get<std::string>().size() <= 2 ||
+                !PoolStateStore::parseAmount(reply["result"].get<std::string>(), places) || places > 18)
+                return {};
+            uint64_t rate = 1;
+            for (PoolAmount k = places; k < 18; ++k)
+                rate *= 10;
+            rates.push_back(rate);
+        }
+        return rates;
+    }
+
+    // Get exchange rate using get_dy
+    uint64_t get_dy(int32_t i, int32_t j, uint64_t dx)
+    {
+        if (usesMockPricing())
+        {
+            // Mock pricing for demo: return realistic values
+            // Simulate a market where 1 USDC ≈ 0.999 DAI (slight discount)
+            double mock_rate = 0.999;
+            return static_cast<uint64_t>(dx * mock_rate);
+        }
+
+        return decodeGetDy(rpc->call("eth_call", getDyParams(pool_address, i, j, dx, underlying)));
+    }
+
+    // Build function data for Curve pool exchange: exchange(i, j, dx, min_dy), with int128 coin
+    // indices on StableSwap and uint256 on CryptoSwap pools; metapool underlying coins go through
+    // exchange_underlying with the same arguments. Pre-flight simulates exactly this.
+    std::string exchangeCalldata(int32_t i, int32_t j, uint64_t dx, uint64_t min_dy) const
+    {
+        std::string function_selector = CurveSelectors::exchange(isCryptoSwap(pool_address), underlying);
+        return function_selector +
+               encodeUint256(static_cast<uint64_t>(i)) +
+               encodeUint256(static_cast<uint64_t>(j)) +
+               encodeUint256(dx) +
+               encodeUint256(min_dy);
+    }
+
+    // Mock swap execution (will be replaced with real implementation)
+    std::string executeSwap(int32_t i, int32_t j, uint64_t dx, uint64_t min_dy,
+                            FeeUrgency urgency = FeeUrgency::PASSIVE)
+    {
+        std::cout << "🔄 EXECUTING SWAP: " << dx << " tokens (" << i << " -> " << j << ")" << std::endl;
+        std::cout << "   Minimum output: " << min_dy << std::endl;
+        std::cout << "   Pool: " << pool_address << std::endl;
+
+        // If EXECUTE_ONCHAIN is not set, return mock tx hash (one snapshot for the whole swap)
+        const RuntimeSettings &config = RuntimeConfig::get();
+        if (!config.execute_onchain)
+        {
+            std::cout << "[INFO] EXECUTE_ONCHAIN not set. Returning mock transaction hash." << std::endl;
+            return "0x" + std::string(64, 'f');
+        }
+
+        std::string data = exchangeCalldata(i, j, dx, min_dy);
+
+        // An order out of RPC time doesn't start signing (throws DeadlineExceeded)
+        RpcDeadline::budgetMs();
+
+        // Create signer and transaction
+        TransactionSigner signer(SepoliaConfig::Wallet::PRIVATE_KEY);
+
+        // Wallet-wide nonce, shared with approvals and every other engine signing for the wallet
+        NonceAllocator &nonces = NonceAllocator::forWallet(SepoliaConfig::Wallet::ADDRESS);
+        uint64_t nonce = nonces.acquire([this]
+                                        { return pendingNonce(rpc); },
+                                        [&signer]
+                                        { return signer.getCurrentNonce(SepoliaConfig::Wallet::ADDRESS); });
+
+        EthereumTransaction tx;
+        tx.nonce = nonce;
+        tx.to_address = pool_address;
+        tx.data = data;
+        // Learned per-pool limit when we have one; the model never blocks on an estimate here
+        tx.gas_limit = gas_model ? gas_model->gasLimit(pool_address, data) : SepoliaConfig::Gas::SWAP_GAS_LIMIT;
+        tx.chain_id = SepoliaConfig::SEPOLIA_CHAIN_ID; // default to Sepolia
+
+        // EIP-1559 fees come from the oracle's cached per-block quote (no RPC here)
+        if (gas_oracle)
+        {
+            FeeQuote fees = gas_oracle->quote(urgency);
+            tx.max_fee_per_gas = fees.max_fee_per_gas;
+            tx.max_priority_fee_per_gas = fees.max_priority_fee_per_gas;
+        }
+
+        std::string raw_tx = signer.signTransaction(tx);
+
+        if (!config.broadcast_tx)
+        {
+            std::cout << "[INFO] BROADCAST_TX not set. Returning signed (demo) tx hash string." << std::endl;
+            nonces.release(nonce);
+            return signer.broadcastTransaction(raw_tx); // returns derived hash without network send
+        }
+
+        // Actually broadcast over RPC
+        try
+        {
+            json send_params = json::array({raw_tx});
+            json send_resp = rpc->call("eth_sendRawTransaction", send_params);
+            if (send_resp.contains("result"))
+            {
+                std::string tx_hash = send_resp["result"];
+                std::cout << "✅ Broadcast succeeded: " << tx_hash << std::endl;
+                if (gas_model)
+                {
+                    gas_model->trackReceipt(pool_address, data, tx_hash);
+                }
+                return tx_hash;
+            }
+            std::cout << "⚠️ Broadcast response without result; falling back to local hash." << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "⚠️ Broadcast failed: " << e.what() << ". Returning local hash." << std::endl;
+        }
+        nonces.release(nonce);
+
+        return signer.broadcastTransaction(raw_tx);
+    }
+};
+
+// 👛 WALLET SERVICES - the background workers that act for the wallet rather than for one
+// engine: fee sampling, gas estimates / receipt polling and allowance top-ups, each on its own
+// connection and thread. Every engine trading from the wallet can share one set, so sharding
+// doesn't start a copy per shard or track the same allowance several times over.
+class WalletServices
+{
+private:
+    EthereumRPC gas_rpc;
+    EthereumRPC gas_model_rpc;
+    EthereumRPC approval_rpc;
+    std::atomic<bool> was_onchain{RuntimeConfig::get().execute_onchain};
+
+    // Sampled on the oracle's thread; fee history is only fetched when the head moved
+    bool sampleFeeHistory(uint64_t last_block, FeeHistory &history)
+    {
+        // Fees only matter once we sign; off-chain runs keep the static defaults without RPC
+        if (!RuntimeConfig::get().execute_onchain)
+            return false;
+        json head = gas_rpc.call("eth_blockNumber", json::array());
+        if (!head.contains("result"))
+            return false;
+
+        uint64_t block = hexToUint64(head["result"]);
+        if (block <= last_block)
+            return false;
+
+        json percentiles = json::array({GasOracle::PASSIVE_PERCENTILE, GasOracle::URGENT_PERCENTILE});
+        json response = gas_rpc.call("eth_feeHistory",
+                                     json::array({toHexQuantity(SepoliaConfig::Gas::FEE_HISTORY_BLOCKS), "latest", percentiles}));
+        if (!response.contains("result") || !response["result"].contains("baseFeePerGas"))
+            return false;
+
+        const json &result = response["result"];
+        const json &base_fees = result["baseFeePerGas"];
+        if (base_fees.empty())
+            return false;
+
+        // baseFeePerGas carries one extra entry for the pending block
+        history.newest_block = hexToUint64(result["oldestBlock"]) + base_fees.size() - 2;
+        history.next_base_fee = hexToUint64(base_fees.back());
+
+        if (result.contains("reward"))
+        {
+            for (const auto &block_rewards : result["reward"])
+            {
+                if (block_rewards.size() < 2)
+                    continue;
+                history.passive_tips.push_back(hexToUint64(block_rewards[0]));
+                history.urgent_tips.push_back(hexToUint64(block_rewards[1]));
+            }
+        }
+        return true;
+    }
+
+public:
+    GasOracle gas_oracle;
+    std::unique_ptr<GasModel> gas_model;
+    std::unique_ptr<AllowanceTracker> allowances;
+
+    explicit WalletServices(const std::string &rpc_url)
+        : gas_rpc(rpc_url), gas_model_rpc(rpc_url), approval_rpc(rpc_url)
+    {
+        // Under a provider rate limit, side connections queue behind trigger quotes and broadcasts
+        gas_rpc.setPriority(RpcPriority::MONITORING);
+        gas_model_rpc.setPriority(RpcPriority::MONITORING);
+        approval_rpc.setPriority(RpcPriority::BACKGROUND);
+
+        gas_model = std::make_unique<GasModel>(
+            [this](const std::string &pool, const std::string &calldata)
+            {
+                json tx = {{"from", SepoliaConfig::Wallet::ADDRESS}, {"to", pool}, {"data", calldata}};
+                json response = gas_model_rpc.call("eth_estimateGas", json::array({tx}));
+                if (response.contains("error"))
+                {
+                    throw std::runtime_error("RPC Error: " + response["error"]["message"].get<std::string>());
+                }
+                return hexToUint64(response["result"]);
+            },
+            [this](const std::string &tx_hash, uint64_t &gas_used)
+            {
+                json response = gas_model_rpc.call("eth_getTransactionReceipt", json::array({tx_hash}));
+                if (!response.contains("result") || response["result"].is_null())
+                    return false;
+                // A revert stops early (slippage) or burns the whole limit (out of gas); neither is
+                // what the swap costs, so only successful receipts are learned from
+                const json &receipt = response["result"];
+                gas_used = hexToUint64(receipt.value("status", "0x0")) == 1 ? hexToUint64(receipt.value("gasUsed", "0x0")) : 0;
+                return true;
+            });
+
+        // Always running: EXECUTE_ONCHAIN can be switched on by a config reload, and signing
+        // should find live fees then rather than the static defaults
+        gas_oracle.start([this](uint64_t last_block, FeeHistory &history)
+                         { return sampleFeeHistory(last_block, history); },
+                         std::chrono::seconds(2));
+
+        // Bound either way for the same reason; off-chain approvals are mocks with nothing to read
+        allowances = std::make_unique<AllowanceTracker>(
+            [this](const std::string &token, const std::string &spender, uint64_t amount)
+            {
+                return ERC20Token(token, &approval_rpc, &gas_oracle).approve(spender, amount);
+            },
+            [this](const std::string &token, const std::string &spender) -> uint64_t
+            {
+                if (!RuntimeConfig::get().execute_onchain)
+                    return 0;
+                return ERC20Token(token, &approval_rpc).allowance(SepoliaConfig::Wallet::ADDRESS, spender);
+            });
+    }
+
+    // Allowances cached while EXECUTE_ONCHAIN was off are mock approvals; once a reload turns it
+    // on they are dropped and read from chain before anything fills against them
+    void syncExecutionMode()
+    {
+        bool onchain = RuntimeConfig::get().execute_onchain;
+        if (was_onchain.exchange(onchain) != onchain && onchain)
+        {
+            std::cout << "🔧 Now executing on-chain; re-reading allowances" << std::endl;
+            allowances->forgetAll();
+        }
+    }
+};
+
+// 🚀 MAIN LIMIT ORDER EXECUTION ENGINE
+class LimitOrderEngine
+{
+private:
+    EthereumRPC *rpc;
+    std::vector<std::unique_ptr<LimitOrder>> active_orders;
+
+    // Fee oracle, gas model and allowance tracker; shared with the other shards when sharded
+    std::shared_ptr<WalletServices> services;
+    GasOracle &gas_oracle;
+    GasModel *gas_model;
+    AllowanceTracker *allowances;
+    static constexpr std::chrono::milliseconds ALLOWANCE_WARMUP{30000}; // Before the first tick
+
+    // TWAP / ICEBERG parents are worked in child slices; batch ticks stand in for blocks
+    SliceScheduler slice_scheduler;
+    PriceImpactModel impact_model;
+    uint64_t tick_block = 0;
+
+    // Optional parallel quoting: one connection per executor worker
+    std::vector<std::unique_ptr<EthereumRPC>> quote_rpcs;
+    std::unique_ptr<WorkStealingExecutor> quote_executor;
+
+    // Optional push feed: newHeads drive the event loop, pool logs mark pools as changed
+    std::string subscription_url;
+    PoolActivity pool_activity;
+    const WebSocketSubscriber *head_feed = nullptr; // Set while processOrders() runs
+    static constexpr int MAX_QUIET_BLOCKS = 5;
+    static constexpr std::chrono::seconds HEAD_FALLBACK_INTERVAL{15};
+
+    // Event-sourced pool state, kept current from the same log feed and audited every so often
+    PoolStateStore pool_states;
+    static constexpr uint64_t STATE_AUDIT_BLOCKS = 50;
+
+    // GTC / GTT orders on a tracked pool rest on a pool-state threshold instead of being quoted
+    TriggerIndex triggers;
+
+    // Orders far from their limit in a quiet market are quoted less often than every block
+    PollScheduler poll_scheduler;
+
+    // Markets quoted at many sizes in one block are answered from a sampled get_dy ladder
+    ImpactCurveCache impact_curves;
+
+    // ...or, on CryptoSwap pools, from local math over state read once per block. Each read is
+    // checked against one on-chain get_dy; a pool that keeps disagreeing goes back to the ladder.
+    struct CryptoQuoting
+    {
+        CryptoPoolState state;
+        uint64_t block = 0;     // Quote block the state was read for
+        bool verified = false;  // This block's local quote matched the chain
+        bool supported = true;  // False once the pool turned out not to be CryptoSwap
+        int mismatches = 0;     // Consecutive failed checks
+    };
+    std::map<std::string, CryptoQuoting> crypto_pools;
+    uint64_t crypto_answered = 0;
+    uint64_t state_answered = 0; // Settled from event-sourced StableSwap state
+    uint64_t crypto_reads = 0;
+    static constexpr int MAX_CRYPTO_MISMATCHES = 3;
+
+    // Underlying-coin quotes on metapools come from local math over the metapool and its base
+    // pool, read and checked per block like CryptoSwap state. A base pool's state and virtual
+    // price are read once per block however many of its metapools are quoted.
+    struct MetapoolQuoting
+    {
+        CurvePool::MetapoolLayout layout; // Resolved on first use
+        MetapoolState state;
+        uint64_t block = 0;
+        bool verified = false;
+        bool supported = true;
+        int mismatches = 0;
+    };
+    struct BasePoolRead
+    {
+        BasePoolSnapshot snapshot;
+        uint64_t block = 0; // Quote block it was read for
+    };
+    std::map<std::string, MetapoolQuoting> metapools;
+    std::map<std::string, BasePoolRead> base_pools;
+    uint64_t metapool_answered = 0;
+    uint64_t metapool_reads = 0;
+    uint64_t base_pool_reads = 0;
+    static constexpr int MAX_METAPOOL_MISMATCHES = 3;
+
+    // Every exchange is simulated (eth_call, balance and allowance overridden) before it goes out
+    std::unique_ptr<SwapSimulator> simulator;
+
+    // Raised by the quote provider's circuit breaker: while it's open immediate orders are
+    // canceled without quoting and resting orders sit ticks out instead of failing them
+    std::atomic<bool> provider_down{false};
+    size_t breaker_subscription = 0;
+    static constexpr std::chrono::milliseconds ERROR_BACKOFF_BASE{1000};
+    static constexpr std::chrono::milliseconds ERROR_BACKOFF_CAP{30000};
+
+    static bool executesOnchain()
+    {
+        return RuntimeConfig::get().execute_onchain;
+    }
+
+    // Fills only go out once the background tracker has the allowance in place
+    bool allowanceReady(const LimitOrder &order, uint64_t amount)
+    {
+        services->syncExecutionMode();
+        if (!executesOnchain())
+            return true;
+        if (allowances->canSpend(order.input_token_address, order.pool_address, amount))
+            return true;
+
+        std::cout << "⏳ Allowance top-up still pending for " << order.order_id << ", not filling yet" << std::endl;
+        return false;
+    }
+
+    static bool isImmediate(const LimitOrder &order)
+    {
+        return order.tif_policy == TimeInForce::IOC || order.tif_policy == TimeInForce::FOK;
+    }
+
+    // The exchange a fill would send, as pre-flight simulates it
+    SwapSimulator::Swap simulatedSwap(const std::string &pool_address, const std::string &token, bool underlying,
+                                      int32_t i, int32_t j, uint64_t dx, uint64_t min_dy)
+    {
+        CurvePool pool(pool_address, rpc, nullptr, nullptr, underlying);
+        return {pool_address, token, pool.exchangeCalldata(i, j, dx, min_dy), dx, min_dy};
+    }
+
+    // Simulate swaps in one batch. Returns why each may not broadcast (empty = clear). Mock
+    // pricing has no chain to simulate against; an unreachable node lets swaps through as before.
+    std::vector<std::string> preflight(const std::vector<SwapSimulator::Swap> &swaps)
+    {
+        std::vector<std::string> rejections(swaps.size());
+        if (swaps.empty() || CurvePool::usesMockPricing())
+            return rejections;
+
+        std::vector<SwapSimulator::Outcome> outcomes;
+        try
+        {
+            outcomes = simulator->simulate(swaps);
+        }
+        catch (const DeadlineExceeded &e)
+        {
+            // Out of time: nothing goes out unchecked
+            std::fill(rejections.begin(), rejections.end(), e.what());
+            return rejections;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Pre-flight simulation unavailable: " << e.what() << std::endl;
+            return rejections;
+        }
+
+        for (size_t k = 0; k < outcomes.size(); ++k)
+        {
+            // Without overrides a dry run's unfunded wallet reverts everything; only live balances count
+            const SwapSimulator::Outcome &outcome = outcomes[k];
+            if (!outcome.passed && (outcome.overridden || executesOnchain()))
+                rejections[k] = "Pre-flight simulation failed: " + outcome.error;
+        }
+        return rejections;
+    }
+
+    // Pre-flight for one order's swap; throws like a failed broadcast so callers keep one error path
+    void requirePreflight(const LimitOrder &order, uint64_t amount, uint64_t min_output)
+    {
+        std::string rejection = preflight({simulatedSwap(order.pool_address, order.input_token_address, order.underlying,
+                                                         order.input_token_index, order.output_token_index, amount, min_output)})
+                                    .front();
+        if (!rejection.empty() && RpcDeadline::expired())
+            throw DeadlineExceeded(rejection);
+        if (!rejection.empty())
+            throw std::runtime_error(rejection);
+    }
+
+    // The coin an aggregated swap spends, from an order on its input side
+    static std::string inputTokenOf(const AggregatedSwap &swap)
+    {
+        for (const auto &fill : swap.allocations)
+        {
+            if (fill.order->input_token_index == swap.input_index)
+                return fill.order->input_token_address;
+        }
+        return swap.allocations.empty() ? std::string() : swap.allocations.front().order->input_token_address;
+    }
+
+    // A fill that didn't go out: resting orders retry next tick; immediate ones are done
+    // (canceled rather than failed when they ran out of RPC time)
+    void abandonFill(LimitOrder &order, const std::string &reason)
+    {
+        if (isImmediate(order))
+        {
+            order.updateStatus(RpcDeadline::expired() ? OrderStatus::CANCELED : OrderStatus::FAILED, reason);
+            settleAllowance(order);
+        }
+    }
+
+    // Execute one aggregated plan: at most one exchange, proceeds split pro rata. `rejection`
+    // is why pre-flight stopped its exchange, if it did.
+    void executeAggregated(const AggregatedSwap &swap, const std::string &rejection = "")
+    {
+        std::string tx_hash;
+        if (swap.needsSwap())
+        {
+            if (!rejection.empty())
+            {
+                std::cerr << "🛑 Aggregated swap not sent: " << rejection << std::endl;
+                for (const auto &fill : swap.allocations)
+                    abandonFill(*fill.order, rejection);
+                return;
+            }
+
+            bool urgent = std::any_of(swap.allocations.begin(), swap.allocations.end(),
+                                      [](const FillAllocation &fill)
+                                      { return isImmediate(*fill.order); });
+
+            std::cout << "🧺 AGGREGATED SWAP: " << swap.allocations.size() << " orders ("
+                      << swap.netted_orders << " netted) -> " << swap.dx << " in one exchange" << std::endl;
+
+            CurvePool pool(swap.pool_address, rpc, &gas_oracle, gas_model);
+            try
+            {
+                tx_hash = pool.executeSwap(swap.input_index, swap.output_index, swap.dx, swap.min_dy,
+                                           urgent ? FeeUrgency::IMMEDIATE : FeeUrgency::PASSIVE);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "❌ Aggregated swap failed: " << e.what() << std::endl;
+                for (const auto &fill : swap.allocations)
+                    abandonFill(*fill.order, e.what());
+                return;
+            }
+        }
+        else
+        {
+            std::cout << "🔁 FULLY NETTED: " << swap.allocations.size() << " orders crossed internally, no exchange needed" << std::endl;
+        }
+
+        // Only swap.dx left the wallet: the sending side spent it pro rata (rounding dust on the
+        // last one) and the rest of every fill was crossed internally
+        uint64_t sending_total = 0;
+        size_t senders = 0;
+        for (const auto &fill : swap.allocations)
+        {
+            if (!fill.fully_netted)
+            {
+                sending_total += fill.input_filled;
+                senders++;
+            }
+        }
+
+        OrderAggregator::applyFills(swap, tx_hash);
+        uint64_t sent = 0;
+        for (const auto &fill : swap.allocations)
+        {
+            uint64_t on_chain = 0;
+            if (!fill.fully_netted)
+            {
+                on_chain = --senders == 0 ? swap.dx - sent
+                                          : static_cast<uint64_t>(static_cast<PoolAmount>(swap.dx) * fill.input_filled / sending_total);
+                sent += on_chain;
+            }
+            settleAllowance(*fill.order, fill.input_filled - std::min(on_chain, fill.input_filled));
+            std::cout << "🎉 " << fill.order->order_id << " filled: " << fill.input_filled << " -> " << fill.output_received << std::endl;
+        }
+    }
+
+    // Execute a deferred order on its own at its own size
+    void executeSingle(LimitOrder &order, uint64_t quoted_output, const std::string &rejection = "")
+    {
+        if (!rejection.empty())
+        {
+            std::cerr << "🛑 Swap not sent for " << order.order_id << ": " << rejection << std::endl;
+            abandonFill(order, rejection);
+            return;
+        }
+
+        CurvePool pool(order.pool_address, rpc, &gas_oracle, gas_model, order.underlying);
+        uint64_t amount = order.input_amount - order.filled_amount;
+        try
+        {
+            std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                   amount, order.getMinOutputWithSlippage(quoted_output),
+                                                   urgencyForTif(order.tif_policy));
+            order.transaction_hash = tx_hash;
+            order.filled_amount += amount;
+            order.received_amount += quoted_output;
+            order.updateStatus(OrderStatus::FILLED);
+            settleAllowance(order);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "❌ Swap failed for " << order.order_id << ": " << e.what() << std::endl;
+            abandonFill(order, e.what());
+        }
+    }
+
+    static QuoteResult quoteOne(const QuoteRequest &request, EthereumRPC *quote_rpc)
+    {
+        QuoteResult result;
+        try
+        {
+            result.output = CurvePool(request.pool_address, quote_rpc, nullptr, nullptr, request.underlying)
+                                .get_dy(request.input_index, request.output_index, request.dx);
+            result.ok = true;
+        }
+        catch (const std::exception &e)
+        {
+            result.error = e.what();
+        }
+        return result;
+    }
+
+    // All get_dy calls in one batch round trip (pipelined on the raw HTTP transport)
+    void quoteInOneRoundTrip(const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+    {
+        std::vector<std::pair<std::string, json>> calls;
+        calls.reserve(requests.size());
+        for (const auto &request : requests)
+        {
+            calls.emplace_back("eth_call", CurvePool::getDyParams(request.pool_address, request.input_index,
+                                                                  request.output_index, request.dx, request.underlying));
+        }
+
+        try
+        {
+            std::vector<json> responses = rpc->callBatch(calls);
+            for (size_t k = 0; k < responses.size(); ++k)
+            {
+                try
+                {
+                    results[k] = {true, CurvePool::decodeGetDy(responses[k]), ""};
+                }
+                catch (const std::exception &e)
+                {
+                    results[k] = {false, 0, e.what()};
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            for (auto &result : results)
+                result = {false, 0, e.what()};
+        }
+    }
+
+    // Sample `market`'s get_dy ladder across [smallest, largest] in one batch and cache the fit
+    const ImpactCurve &sampleCurve(const std::string &market, const QuoteRequest &like, uint64_t smallest, uint64_t largest)
+    {
+        std::vector<uint64_t> sizes = ImpactCurve::ladder(smallest, largest);
+        std::vector<std::pair<std::string, json>> calls;
+        for (uint64_t size : sizes)
+            calls.emplace_back("eth_call", CurvePool::getDyParams(like.pool_address, like.input_index, like.output_index, size,
+                                                                  like.underlying));
+
+        ImpactCurve curve;
+        try
+        {
+            std::vector<json> responses = rpc->callBatch(calls);
+            std::vector<uint64_t> outputs;
+            for (const auto &response : responses)
+                outputs.push_back(CurvePool::decodeGetDy(response));
+            curve.fit(sizes, outputs);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "⚠️ Impact ladder for " << like.pool_address << " failed: " << e.what() << std::endl;
+        }
+        return impact_curves.store(market, like.block, curve, sizes.size());
+    }
+
+    // This block's CryptoSwap state for `probe`'s pool, checked by quoting `probe` both locally
+    // and on-chain. Null if the pool isn't CryptoSwap, the check failed, or it keeps failing.
+    const CryptoPoolState *cryptoState(const QuoteRequest &probe)
+    {
+        auto existing = crypto_pools.find(probe.pool_address);
+        if (existing != crypto_pools.end())
+        {
+            const CryptoQuoting &known = existing->second;
+            if (!known.supported || known.mismatches >= MAX_CRYPTO_MISMATCHES)
+                return nullptr;
+            if (known.block == probe.block)
+                return known.verified ? &known.state : nullptr;
+        }
+
+        CryptoQuoting &entry = crypto_pools[probe.pool_address];
+        entry.block = probe.block;
+        entry.verified = false;
+        try
+        {
+            entry.state = CurvePool::fetchCryptoState(*rpc, probe.pool_address, entry.state.precisions);
+            crypto_reads++;
+            CurvePool::markCryptoSwap(probe.pool_address);
+            uint64_t onchain = CurvePool::decodeGetDy(
+                rpc->call("eth_call", CurvePool::getDyParams(probe.pool_address, probe.input_index, probe.output_index, probe.dx)));
+            CryptoSwapMath::Real local = CryptoSwapMath::getDy(entry.state, static_cast<size_t>(probe.input_index),
+                                                               static_cast<size_t>(probe.output_index), probe.dx);
+            CryptoSwapMath::Real gap = std::fabs(local - static_cast<CryptoSwapMath::Real>(onchain));
+            if (gap > CryptoSwapMath::uncertainty(entry.state, static_cast<size_t>(probe.output_index)))
+            {
+                entry.mismatches++;
+                std::cerr << "⚠️ Local CryptoSwap quote for " << probe.pool_address << " off by " << static_cast<double>(gap)
+                          << " (" << entry.mismatches << "/" << MAX_CRYPTO_MISMATCHES << ")" << std::endl;
+                return nullptr;
+            }
+            entry.mismatches = 0;
+            entry.verified = true;
+            return &entry.state;
+        }
+        catch (const std::exception &)
+        {
+            // A pool that never produced a state is not CryptoSwap; a known one just missed a read
+            if (entry.state.balances.empty())
+                entry.supported = false;
+            return nullptr;
+        }
+    }
+
+    // This block's metapool and base pool state for `probe`'s (underlying-coin) market, checked
+    // by quoting `probe` both locally and on-chain. Null if the pool isn't a metapool, the check
+    // failed, or it keeps failing.
+    const MetapoolState *metapoolState(const QuoteRequest &probe)
+    {
+        auto existing = metapools.find(probe.pool_address);
+        if (existing != metapools.end())
+        {
+            const MetapoolQuoting &known = existing->second;
+            if (!known.supported || known.mismatches >= MAX_METAPOOL_MISMATCHES)
+                return nullptr;
+            if (known.block == probe.block)
+                return known.verified ? &known.state : nullptr;
+        }
+
+        MetapoolQuoting &entry = metapools[probe.pool_address];
+        entry.block = probe.block;
+        entry.verified = false;
+        try
+        {
+            if (entry.layout.base_pool.empty())
+                entry.layout = CurvePool::fetchMetapoolLayout(*rpc, probe.pool_address);
+            auto base = base_pools.find(entry.layout.base_pool);
+            bool base_current = base != base_pools.end() && base->second.block == probe.block;
+            entry.state = CurvePool::fetchMetapoolState(*rpc, probe.pool_address, entry.layout,
+                                                        base_current ? &base->second.snapshot : nullptr);
+            metapool_reads++;
+            if (!base_current)
+            {
+                base_pools[entry.layout.base_pool] = {entry.state.base, probe.block};
+                base_pool_reads++;
+            }
+
+            uint64_t onchain = CurvePool::decodeGetDy(rpc->call(
+                "eth_call", CurvePool::getDyParams(probe.pool_address, probe.input_index, probe.output_index, probe.dx, true)));
+            MetapoolMath::Real local = MetapoolMath::getDyUnderlying(entry.state, static_cast<size_t>(probe.input_index),
+                                                                     static_cast<size_t>(probe.output_index), probe.dx);
+            MetapoolMath::Real gap = std::fabs(local - static_cast<MetapoolMath::Real>(onchain));
+            if (gap > MetapoolMath::uncertainty(local))
+            {
+                entry.mismatches++;
+                std::cerr << "⚠️ Local metapool quote for " << probe.pool_address << " off by " << static_cast<double>(gap)
+                          << " (" << entry.mismatches << "/" << MAX_METAPOOL_MISMATCHES << ")" << std::endl;
+                return nullptr;
+            }
+            entry.mismatches = 0;
+            entry.verified = true;
+            return &entry.state;
+        }
+        catch (const std::exception &)
+        {
+            // Without a layout the pool isn't a metapool; a known one just missed a read
+            if (entry.layout.base_pool.empty())
+                entry.supported = false;
+            return nullptr;
+        }
+    }
+
+    // Settle a market's requests from a local model: `model(request)` is the output and how far
+    // the chain's get_dy may sit from it. Settled requests get results and count in `answered`;
+    // the rest are appended to `exact`.
+    template <typename Model>
+    void quoteFromModel(const std::vector<QuoteRequest> &requests, const std::vector<size_t> &indices,
+                        std::vector<QuoteResult> &results, std::vector<size_t> &exact, uint64_t &answered, Model model)
+    {
+        auto word = [](long double value)
+        {
+            return static_cast<uint64_t>(std::clamp<long double>(
+                value, 0, static_cast<long double>(std::numeric_limits<uint64_t>::max())));
+        };
+        for (size_t k : indices)
+        {
+            auto [output, band] = model(requests[k]);
+            ImpactCurve::Estimate bounds{word(output), word(output - band), word(std::ceil(output + band))};
+            ImpactCurve::Decision decision = ImpactCurve::decide(bounds, requests[k].decide_at);
+            if (decision == ImpactCurve::Decision::UNSURE)
+            {
+                exact.push_back(k);
+                continue;
+            }
+            results[k] = {true, decision == ImpactCurve::Decision::MET ? bounds.low : bounds.value, ""};
+            answered++;
+        }
+    }
+
+    // Quote a market's requests from local CryptoSwap math
+    void quoteFromCryptoState(const CryptoPoolState &state, const std::vector<QuoteRequest> &requests,
+                              const std::vector<size_t> &indices, std::vector<QuoteResult> &results, std::vector<size_t> &exact)
+    {
+        quoteFromModel(requests, indices, results, exact, crypto_answered, [&state](const QuoteRequest &request)
+                       {
+                           size_t j = static_cast<size_t>(request.output_index);
+                           return std::make_pair(CryptoSwapMath::getDy(state, static_cast<size_t>(request.input_index), j, request.dx),
+                                                 CryptoSwapMath::uncertainty(state, j)); });
+    }
+
+    // Quote a market's underlying-coin requests from local metapool math
+    void quoteFromMetapoolState(const MetapoolState &state, const std::vector<QuoteRequest> &requests,
+                                const std::vector<size_t> &indices, std::vector<QuoteResult> &results, std::vector<size_t> &exact)
+    {
+        quoteFromModel(requests, indices, results, exact, metapool_answered, [&state](const QuoteRequest &request)
+                       {
+                           MetapoolMath::Real output = MetapoolMath::getDyUnderlying(state, static_cast<size_t>(request.input_index),
+                                                                                     static_cast<size_t>(request.output_index), request.dx);
+                           return std::make_pair(output, MetapoolMath::uncertainty(output)); });
+    }
+
+    // Quote a market's requests on a tracked StableSwap pool in one batch evaluation of the
+    // event-sourced state, trusted to within the trigger index's margin plus the batch solver's
+    // error. Local state only settles misses: a met limit leads to a fill, so it is appended to
+    // `exact` with the undecided ones and confirmed by get_dy.
+    void quoteFromPoolState(const PoolState &state, const std::vector<QuoteRequest> &requests,
+                            const std::vector<size_t> &indices, std::vector<QuoteResult> &results, std::vector<size_t> &exact)
+    {
+        size_t i = static_cast<size_t>(requests[indices.front()].input_index);
+        size_t j = static_cast<size_t>(requests[indices.front()].output_index);
+        if (i == j || i >= state.balances.size() || j >= state.balances.size() || state.rates.size() != state.balances.size())
+        {
+            exact.insert(exact.end(), indices.begin(), indices.end());
+            return;
+        }
+
+        std::vector<StableSwapMath::Real> amounts;
+        amounts.reserve(indices.size());
+        for (size_t k : indices)
+            amounts.push_back(static_cast<StableSwapMath::Real>(requests[k].dx));
+        std::vector<StableSwapMath::Real> outputs = StableSwapMath::getDyBatch(state, i, j, amounts, pool_states.latestTimestamp());
+
+        auto word = [](double value)
+        { return static_cast<uint64_t>(std::clamp(value, 0.0, static_cast<double>(std::numeric_limits<uint64_t>::max()))); };
+        double solver_error = static_cast<double>(state.balances[j]) * static_cast<double>(StableSwapMath::BATCH_TOLERANCE);
+        for (size_t n = 0; n < indices.size(); ++n)
+        {
+            size_t k = indices[n];
+            double output = static_cast<double>(outputs[n]);
+            double band = output * static_cast<double>(TriggerIndex::TRIGGER_MARGIN) + solver_error;
+            ImpactCurve::Estimate bounds{word(output), word(output - band), word(std::ceil(output + band))};
+            if (ImpactCurve::decide(bounds, requests[k].decide_at) != ImpactCurve::Decision::NOT_MET)
+            {
+                exact.push_back(k);
+                continue;
+            }
+            results[k] = {true, bounds.value, ""};
+            state_answered++;
+        }
+    }
+
+    // Event-sourced state is only quoted from while the feed keeping it current is live; a pool
+    // flagged for resync (gap, reorg, dropped feed, unreplayable log) has no state until re-read
+    std::optional<PoolState> poolStateForQuotes(const std::string &pool) const
+    {
+        if (!head_feed || !head_feed->isLive())
+            return std::nullopt;
+        return pool_states.state(pool);
+    }
+
+    // Settle what local models can: quotes with a trigger threshold, grouped by market. Tracked
+    // StableSwap pools are evaluated from their event-sourced state and metapool underlying
+    // coins from the metapool and base pool state; elsewhere a market gets a ladder once more
+    // sizes want quoting this block than the ladder costs (CryptoSwap pools get their state
+    // read instead). Returns the indices that still need an exact get_dy.
+    std::vector<size_t> quoteFromCurves(const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+    {
+        std::vector<size_t> exact;
+        std::map<std::string, std::vector<size_t>> markets;
+        for (size_t k = 0; k < requests.size(); ++k)
+        {
+            const QuoteRequest &request = requests[k];
+            if (request.decide_at == 0 || request.dx == 0 || CurvePool::usesMockPricing())
+            {
+                exact.push_back(k);
+                continue;
+            }
+            markets[ImpactCurveCache::keyFor(request.pool_address, request.input_index, request.output_index,
+                                             request.underlying)]
+                .push_back(k);
+        }
+
+        for (const auto &[market, indices] : markets)
+        {
+            const QuoteRequest &first = requests[indices.front()];
+            if (first.underlying)
+            {
+                // One state read stands in for every get_dy_underlying (each a metapool call
+                // plus nested base pool calls) on the metapool and its base pool this block
+                if (const MetapoolState *state = metapoolState(first))
+                {
+                    quoteFromMetapoolState(*state, requests, indices, results, exact);
+                    continue;
+                }
+            }
+            else if (std::optional<PoolState> state = poolStateForQuotes(first.pool_address))
+            {
+                quoteFromPoolState(*state, requests, indices, results, exact);
+                continue;
+            }
+
+            std::set<uint64_t> sizes;
+            for (size_t k : indices)
+                sizes.insert(requests[k].dx);
+            bool worth_sampling = sizes.size() > ImpactCurve::LADDER_POINTS;
+
+            auto crypto = crypto_pools.find(first.pool_address);
+            bool crypto_read = crypto != crypto_pools.end() && crypto->second.block == first.block;
+            if (!first.underlying && (worth_sampling || crypto_read))
+            {
+                if (const CryptoPoolState *state = cryptoState(first))
+                {
+                    quoteFromCryptoState(*state, requests, indices, results, exact);
+                    continue;
+                }
+            }
+
+            const ImpactCurve *curve = impact_curves.find(market, first.block);
+            if (!curve && worth_sampling)
+                curve = &sampleCurve(market, first, *sizes.begin(), *sizes.rbegin());
+
+            for (size_t k : indices)
+            {
+                const QuoteRequest &request = requests[k];
+                ImpactCurve::Decision decision = curve ? curve->decide(request.dx, request.decide_at)
+                                                       : ImpactCurve::Decision::UNSURE;
+                if (decision == ImpactCurve::Decision::UNSURE)
+                {
+                    if (curve && curve->usable())
+                        impact_curves.recordFallback();
+                    exact.push_back(k);
+                    continue;
+                }
+                // A met trigger gets the guaranteed floor: it sizes the swap's minimum output
+                ImpactCurve::Estimate estimate = curve->estimate(request.dx);
+                results[k] = {true, decision == ImpactCurve::Decision::MET ? estimate.low : estimate.value, ""};
+                impact_curves.recordAnswered();
+            }
+        }
+        std::sort(exact.begin(), exact.end());
+        return exact;
+    }
+
+    // Resolve a batch of quotes: first from this block's impact curves, then exactly
+    void quoteBatch(const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+    {
+        results.resize(requests.size());
+        std::vector<size_t> exact = quoteFromCurves(requests, results);
+        if (exact.size() == requests.size())
+        {
+            quoteExact(requests, results);
+            return;
+        }
+
+        std::vector<QuoteRequest> remaining;
+        for (size_t k : exact)
+            remaining.push_back(requests[k]);
+        std::vector<QuoteResult> remaining_results;
+        quoteExact(remaining, remaining_results);
+        for (size_t n = 0; n < exact.size(); ++n)
+            results[exact[n]] = remaining_results[n];
+    }
+
+    // Exact get_dy for every request. With workers enabled each quote is an executor task aimed
+    // at its pool's home worker; idle workers steal from hot pools' backlogs.
+    void quoteExact(const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+    {
+        results.resize(requests.size());
+        if (requests.empty())
+            return;
+        if (requests.size() >= 2 && !quote_executor && !CurvePool::usesMockPricing())
+        {
+            quoteInOneRoundTrip(requests, results);
+            return;
+        }
+        if (!quote_executor || requests.size() < 2)
+        {
+            for (size_t k = 0; k < requests.size(); ++k)
+                results[k] = quoteOne(requests[k], rpc);
+            return;
+        }
+
+        // Workers quote under the caller's deadline
+        TaskGroup group;
+        RpcDeadline::Clock::time_point deadline = RpcDeadline::current();
+        for (size_t k = 0; k < requests.size(); ++k)
+        {
+            const QuoteRequest *request = &requests[k];
+            QuoteResult *slot = &results[k];
+            quote_executor->submit([this, request, slot, deadline](size_t worker)
+                                   {
+                                       RpcDeadline::Scope scope(deadline);
+                                       *slot = quoteOne(*request, quote_rpcs[worker].get());
+                                   },
+                                   ShardRouter::shardFor(request->pool_address, quote_executor->workerCount()),
+                                   &group);
+        }
+        group.wait();
+    }
+
+    // Quote every order for its remaining size; orders are only read, the caller applies results
+    std::vector<QuoteResult> quoteOrders(const std::vector<LimitOrder *> &orders, uint64_t block)
+    {
+        std::vector<QuoteRequest> requests;
+        requests.reserve(orders.size());
+        for (const LimitOrder *order : orders)
+        {
+            uint64_t remaining = order->input_amount - order->filled_amount;
+            uint64_t trigger = static_cast<uint64_t>(std::ceil(static_cast<double>(remaining) * order->limit_price));
+            requests.push_back({order->pool_address, order->input_token_index, order->output_token_index,
+                                remaining, trigger, block});
+            requests.back().underlying = order->underlying;
+        }
+
+        std::vector<QuoteResult> results;
+        quoteBatch(requests, results);
+        return results;
+    }
+
+    // Settle the tracker once an order reaches a terminal state. `netted` is the part of its fill
+    // that was crossed against our own orders and never left the wallet; it's released, not spent.
+    // Child slices spend against their parent's reservation; the parent only releases what is left
+    void settleAllowance(const LimitOrder &order, uint64_t netted = 0)
+    {
+        netted = std::min(netted, order.filled_amount);
+        uint64_t spent = order.filled_amount - netted;
+        if (spent > 0 && !order.isSliced())
+        {
+            allowances->recordSpend(order.input_token_address, order.pool_address, spent);
+        }
+        if (order.isChildSlice())
+        {
+            if (netted > 0)
+                allowances->release(order.input_token_address, order.pool_address, netted);
+            return;
+        }
+        allowances->release(order.input_token_address, order.pool_address, order.input_amount - order.filled_amount + netted);
+    }
+
+public:
+    // `shared` lets several engines on one wallet (the shards) run one set of wallet services
+    explicit LimitOrderEngine(EthereumRPC *ethereum_rpc, std::shared_ptr<WalletServices> shared = nullptr)
+        : rpc(ethereum_rpc),
+          services(shared ? std::move(shared) : std::make_shared<WalletServices>(ethereum_rpc->getUrl())),
+          gas_oracle(services->gas_oracle), gas_model(services->gas_model.get()),
+          allowances(services->allowances.get())
+    {
+        breaker_subscription = rpc->getBreaker().subscribe(
+            [this](const std::string &endpoint, CircuitBreaker::State from, CircuitBreaker::State to)
+            {
+                provider_down = to == CircuitBreaker::State::OPEN;
+                if (to == CircuitBreaker::State::OPEN)
+                    std::cerr << "🔌 RPC circuit open for " << endpoint << ": pausing quotes" << std::endl;
+                else if (from != CircuitBreaker::State::CLOSED && to == CircuitBreaker::State::CLOSED)
+                    std::cout << "🔌 RPC circuit closed for " << endpoint << ": provider recovered" << std::endl;
+            });
+
+        // Pre-flight runs on the tick thread, on the fill path like the broadcast it guards
+        simulator = std::make_unique<SwapSimulator>(
+            [this](const std::vector<SwapSimulator::Call> &calls)
+            {
+                std::vector<std::pair<std::string, json>> batch;
+                for (const auto &call : calls)
+                {
+                    json params = json::array({{{"from", call.from}, {"to", call.to}, {"data", call.data}}, "latest"});
+                    if (!call.state_diff.empty())
+                    {
+                        json overrides = json::object();
+                        for (const auto &[contract, slots] : call.state_diff)
+                            overrides[contract] = {{"stateDiff", slots}};
+                        params.push_back(overrides);
+                    }
+                    batch.push_back({"eth_call", params});
+                }
+                std::vector<SwapSimulator::CallResult> results;
+                for (const json &reply : rpc->callBatch(batch))
+                {
+                    SwapSimulator::CallResult result;
+                    if (reply.contains("result") && reply["result"].is_string())
+                    {
+                        result.ok = true;
+                        result.output = reply["result"];
+                    }
+                    else if (reply.contains("error") && reply["error"].is_object())
+                    {
+                        result.error = reply["error"].value("message", "execution reverted");
+                    }
+                    results.push_back(result);
+                }
+                return results;
+            },
+            SepoliaConfig::Wallet::ADDRESS);
+    }
+
+    ~LimitOrderEngine()
+    {
+        rpc->getBreaker().unsubscribe(breaker_subscription);
+    }
+
+    // Fan per-order quotes out over a work-stealing pool in batch mode.
+    // Signing and broadcast stay on the tick thread: one wallet means nonces go out in order.
+    void enableParallelQuotes(size_t workers)
+    {
+        quote_executor.reset();
+        quote_rpcs.clear();
+        if (workers < 2)
+            return;
+
+        for (size_t k = 0; k < workers; ++k)
+            quote_rpcs.push_back(std::make_unique<EthereumRPC>(rpc->getUrl()));
+        quote_executor = std::make_unique<WorkStealingExecutor>(workers);
+        std::cout << "⚙️  Quoting on " << workers << " work-stealing workers" << std::endl;
+    }
+
+    // Take blocks and pool logs from an eth_subscribe feed instead of assuming a block per interval
+    void enableHeadSubscription(const std::string &ws_url)
+    {
+        if (!WebSocketSubscriber::supportsUrl(ws_url))
+        {
+            std::cerr << "⚠️ WS_URL must be a ws:// endpoint; staying on polling" << std::endl;
+            return;
+        }
+        subscription_url = ws_url;
+    }
+
+    // Re-read pools from the chain and check the event-sourced state against them
+    void auditPoolStates(EthereumRPC &state_rpc, const std::vector<std::string> &pools)
+    {
+        for (const auto &pool : pools)
+        {
+            try
+            {
+                PoolState onchain = CurvePool::fetchState(state_rpc, pool);
+                if (!pool_states.verify(pool, onchain))
+                {
+                    std::cout << "🧮 Pool state for " << pool << " resynced from chain at block " << onchain.block << std::endl;
+                    refreshTriggers(pool);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "⚠️ Pool state audit failed for " << pool << ": " << e.what() << std::endl;
+            }
+        }
+    }
+
+    // Feed a quote into the volatility estimate; blocks to wait before quoting the order again
+    uint64_t nextCheckIn(const LimitOrder &order, uint64_t block, uint64_t amount, uint64_t output, bool price_met)
+    {
+        std::string market = PriceImpactModel::keyFor(order.pool_address, order.input_token_index, order.output_token_index);
+        if (amount > 0)
+            poll_scheduler.observe(market, block, static_cast<double>(output) / static_cast<double>(amount));
+        if (price_met)
+            return 1;
+        return poll_scheduler.schedule(order.order_id, market, block, static_cast<double>(output),
+                                       static_cast<double>(amount) * order.limit_price);
+    }
+
+    // Re-scan a pool's trigger thresholds against its latest tracked state
+    void refreshTriggers(const std::string &pool)
+    {
+        std::optional<PoolState> state = pool_states.state(pool);
+        if (state)
+            triggers.onState(pool, *state, pool_states.latestTimestamp());
+    }
+
+    // True while the order can rest on its trigger threshold instead of being quoted (live feed,
+    // tracked pool state). Arms it on first use; false once it fires (`fired` set), so the caller
+    // confirms with one exact quote. after_miss: the last quote didn't meet the limit, so only
+    // re-fire on improvement. Underlying-coin orders also move with the base pool, so they never rest.
+    bool restsOnTrigger(const LimitOrder &order, bool after_miss, bool &fired)
+    {
+        fired = false;
+        if (!head_feed || !head_feed->isLive() || order.underlying)
+            return false;
+        if (!triggers.isArmed(order.order_id))
+        {
+            std::optional<PoolState> state = pool_states.state(order.pool_address);
+            if (!state || order.input_token_index < 0 || order.output_token_index < 0)
+                return false;
+            TriggerIndex::Arm spec{order.order_id, order.pool_address,
+                                   static_cast<size_t>(order.input_token_index), static_cast<size_t>(order.output_token_index),
+                                   static_cast<TriggerIndex::Real>(order.input_amount),
+                                   static_cast<TriggerIndex::Real>(order.input_amount) * static_cast<TriggerIndex::Real>(order.limit_price)};
+            if (!triggers.arm(spec, *state, pool_states.latestTimestamp(), after_miss))
+                return false;
+            if (triggers.isArmed(order.order_id))
+                std::cout << "🎯 " << order.order_id << " armed: fires at balance ratio "
+                          << static_cast<double>(triggers.threshold(order.order_id)) << std::endl;
+        }
+        fired = triggers.consume(order.order_id);
+        return !fired;
+    }
+
+    // The same quote, answered by get_dy rather than any local model
+    static QuoteRequest exactly(QuoteRequest request)
+    {
+        request.decide_at = 0;
+        return request;
+    }
+
+    // With a live log feed, a pool that emitted nothing since our last quote has the same state,
+    // so its quote can't have moved. Capped, since a log can land just after its block's head,
+    // unless every head since carried a logsBloom that was screened for the pool.
+    bool poolUnchanged(const std::string &pool, uint64_t quoted_at, int &quiet_blocks) const
+    {
+        if (!head_feed || !head_feed->isLive() ||
+            (quiet_blocks >= MAX_QUIET_BLOCKS && !pool_activity.screenedSince(quoted_at)) ||
+            pool_activity.changedSince(pool, quoted_at))
+        {
+            quiet_blocks = 0;
+            return false;
+        }
+        quiet_blocks++;
+        return true;
+    }
+
+    // Add an order to the engine
+    void addOrder(std::unique_ptr<LimitOrder> order)
+    {
+        order->updateStatus(OrderStatus::ACTIVE);
+        allowances->reserve(order->input_token_address, order->pool_address, order->input_amount);
+        if (order->isSliced())
+        {
+            slice_scheduler.schedule(order.get(), tick_block);
+        }
+        std::cout << "\n📝 ORDER ADDED: " << order->order_id << " (" << order->getTifString() << ")" << std::endl;
+        order->printSummary();
+        active_orders.push_back(std::move(order));
+    }
+
+    // GTC lifecycle: check once per block until filled or canceled.
+    // A suspended order is just its coroutine frame; thousands share the loop's thread.
+    OrderTask runGTC(LimitOrder &order, EventLoop &loop)
+    {
+        std::cout << "\n🔄 Executing GTC Policy for " << order.order_id << std::endl;
+
+        // Create pool connection
+        CurvePool pool(order.pool_address, rpc, &gas_oracle, gas_model, order.underlying);
+
+        QuoteRequest request{order.pool_address, order.input_token_index, order.output_token_index, order.input_amount,
+                             static_cast<uint64_t>(order.input_amount * order.limit_price)};
+        request.underlying = order.underlying;
+        int check_count = 0;
+        const int max_checks = 10; // Limit for demo
+        uint64_t quoted_at = 0;
+        int quiet_blocks = 0;
+        bool quoted_last = false;
+        int errors = 0; // In a row; each backs off longer (jittered so orders don't retry in step)
+
+        while (order.isExecutable() && check_count < max_checks)
+        {
+            // Resting on a trigger threshold: no quote until the pool's state crosses it
+            bool fired = false;
+            if (restsOnTrigger(order, quoted_last, fired))
+            {
+                check_count++;
+                co_await loop.nextBlock();
+                continue;
+            }
+
+            // Get current price (batched with every other order quoting this turn); a fired
+            // trigger is confirmed by get_dy, not by the state that fired it
+            quoted_at = loop.currentBlock();
+            quoted_last = true;
+            QuoteRequest ask = fired ? exactly(request) : request;
+            QuoteResult quote = co_await loop.quote(ask);
+            bool failed = !quote.ok;
+            bool price_met = quote.ok && order.isPriceMet(quote.output);
+            if (quote.ok)
+            {
+                uint64_t current_output = quote.output;
+                order.recordPriceCheck(current_output);
+
+                std::cout << "💰 Price Check #" << (check_count + 1) << ": " << current_output << " output tokens" << std::endl;
+
+                // Check if price meets limit (and the pre-approved allowance is in place)
+                if (order.isPriceMet(current_output) && allowanceReady(order, order.input_amount))
+                {
+                    std::cout << "✅ PRICE TARGET MET! Executing swap..." << std::endl;
+                    try
+                    {
+                        RpcDeadline::Scope deadline(rpcBudgetForTif(order.tif_policy)); // No co_await inside
+                        uint64_t min_output = order.getMinOutputWithSlippage(current_output);
+                        requirePreflight(order, order.input_amount, min_output);
+                        std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                               order.input_amount, min_output,
+                                                               urgencyForTif(order.tif_policy));
+
+                        order.transaction_hash = tx_hash;
+                        order.filled_amount = order.input_amount;
+                        order.received_amount = current_output;
+                        order.updateStatus(OrderStatus::FILLED);
+
+                        std::cout << "🎉 ORDER FILLED! Transaction: " << tx_hash << std::endl;
+                        co_return;
+                    }
+                    catch (const std::exception &e)
+                    {
+                        quote.error = e.what();
+                        failed = true;
+                    }
+                }
+            }
+
+            if (failed)
+            {
+                std::cerr << "❌ Error in GTC execution: " << quote.error << std::endl;
+                co_await loop.sleepFor(RetryPolicy::jittered(ERROR_BACKOFF_BASE, ERROR_BACKOFF_CAP, ++errors));
+                continue;
+            }
+            errors = 0;
+
+            // Far from the limit in a quiet market: skip blocks (they still count toward the demo limit)
+            uint64_t wait_blocks = nextCheckIn(order, quoted_at, order.input_amount, quote.output, price_met);
+            for (uint64_t k = 0; k < wait_blocks && check_count < max_checks; ++k)
+            {
+                check_count++;
+                co_await loop.nextBlock(); // Wait for the next block between checks
+            }
+            while (!price_met && !order.underlying && poolUnchanged(order.pool_address, quoted_at, quiet_blocks))
+                co_await loop.nextBlock();
+        }
+
+        triggers.disarm(order.order_id);
+        poll_scheduler.forget(order.order_id);
+        if (check_count >= max_checks)
+        {
+            order.updateStatus(OrderStatus::CANCELED, "Demo limit reached");
+            std::cout << "⏰ GTC Order stopped after " << max_checks << " price checks (demo mode)" << std::endl;
+        }
+    }
+
+    // GTT lifecycle: check once per block until filled or expired
+    OrderTask runGTT(LimitOrder &order, EventLoop &loop)
+    {
+        std::cout << "\n⏰ Executing GTT Policy for " << order.order_id << std::endl;
+
+        CurvePool pool(order.pool_address, rpc, &gas_oracle, gas_model, order.underlying);
+        QuoteRequest request{order.pool_address, order.input_token_index, order.output_token_index, order.input_amount,
+                             static_cast<uint64_t>(order.input_amount * order.limit_price)};
+        request.underlying = order.underlying;
+
+        uint64_t quoted_at = 0;
+        int quiet_blocks = 0;
+        bool quoted_last = false;
+        int errors = 0;
+
+        while (order.isExecutable() && !order.isExpired())
+        {
+            bool fired = false;
+            if (restsOnTrigger(order, quoted_last, fired))
+            {
+                co_await loop.nextBlock();
+                continue;
+            }
+
+            quoted_at = loop.currentBlock();
+            quoted_last = true;
+            QuoteRequest ask = fired ? exactly(request) : request;
+            QuoteResult quote = co_await loop.quote(ask);
+            if (!quote.ok)
+            {
+                std::cerr << "❌ Error in GTT execution: " << quote.error << std::endl;
+                co_await loop.sleepFor(RetryPolicy::jittered(ERROR_BACKOFF_BASE, ERROR_BACKOFF_CAP, ++errors));
+                continue;
+            }
+            errors = 0;
+
+            uint64_t current_output = quote.output;
+            order.recordPriceCheck(current_output);
+
+            if (order.isPriceMet(current_output) && allowanceReady(order, order.input_amount))
+            {
+                std::cout << "✅ GTT ORDER FILLED before expiry!" << std::endl;
+                try
+                {
+                    RpcDeadline::Scope deadline(rpcBudgetForTif(order.tif_policy)); // No co_await inside
+                    uint64_t min_output = order.getMinOutputWithSlippage(current_output);
+                    requirePreflight(order, order.input_amount, min_output);
+                    std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                           order.input_amount, min_output,
+                                                           urgencyForTif(order.tif_policy));
+
+                    order.transaction_hash = tx_hash;
+                    order.filled_amount = order.input_amount;
+                    order.updateStatus(OrderStatus::FILLED);
+                    co_return;
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "❌ Error in GTT execution: " << e.what() << std::endl;
+                }
+            }
+
+            uint64_t wait_blocks = nextCheckIn(order, quoted_at, order.input_amount, current_output, order.isPriceMet(current_output));
+            for (uint64_t k = 0; k < wait_blocks && !order.isExpired(); ++k)
+                co_await loop.nextBlock();
+            while (!order.isPriceMet(current_output) && !order.isExpired() && !order.underlying &&
+                   poolUnchanged(order.pool_address, quoted_at, quiet_blocks))
+                co_await loop.nextBlock();
+        }
+
+        triggers.disarm(order.order_id);
+        poll_scheduler.forget(order.order_id);
+        if (order.isExpired())
+        {
+            order.updateStatus(OrderStatus::EXPIRED, "Order expired");
+            std::cout << "⏰ GTT Order EXPIRED without execution" << std::endl;
+        }
+    }
+
+    // Execute IOC policy: Single check with partial fill support
+    void executeIOC(LimitOrder &order)
+    {
+        std::cout << "\n⚡ Executing IOC Policy for " << order.order_id << std::endl;
+
+        CurvePool pool(order.pool_address, rpc, &gas_oracle, gas_model, order.underlying);
+        RpcDeadline::Scope deadline(rpcBudgetForTif(order.tif_policy));
+
+        try
+        {
+            uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
+            order.recordPriceCheck(current_output);
+
+            std::cout << "💰 IOC Price Check: " << current_output << " output tokens" << std::endl;
+
+            // Debug: Show price comparison
+            uint64_t expected_output = static_cast<uint64_t>(order.input_amount * order.limit_price);
+            std::cout << "🔍 Price Check: Current output = " << current_output << ", Expected output = " << expected_output << std::endl;
+            std::cout << "🔍 Price met? " << (order.isPriceMet(current_output) ? "YES" : "NO") << std::endl;
+
+            // IOC can't wait for a top-up; an approve never goes on the fill path
+            if (!allowanceReady(order, order.input_amount))
+            {
+                order.updateStatus(OrderStatus::CANCELED, "IOC: Allowance not ready");
+                std::cout << "❌ IOC Order CANCELED - allowance not ready" << std::endl;
+                return;
+            }
+
+            if (order.isPriceMet(current_output))
+            {
+                std::cout << "✅ IOC ORDER EXECUTED immediately!" << std::endl;
+
+                uint64_t min_output = order.getMinOutputWithSlippage(current_output);
+                requirePreflight(order, order.input_amount, min_output);
+                std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                       order.input_amount, min_output,
+                                                       urgencyForTif(order.tif_policy));
+
+                order.transaction_hash = tx_hash;
+                order.filled_amount = order.input_amount;
+                order.received_amount = current_output;
+                order.updateStatus(OrderStatus::FILLED);
+            }
+            else
+            {
+                // Check for partial fill possibility
+                uint64_t max_fillable = order.getMaxFillableAmount(current_output);
+
+                if (max_fillable > 0)
+                {
+                    std::cout << "🔄 IOC PARTIAL FILL: " << max_fillable << " of " << order.input_amount << " tokens" << std::endl;
+
+                    // Calculate output for partial fill
+                    uint64_t partial_output = pool.get_dy(order.input_token_index, order.output_token_index, max_fillable);
+                    uint64_t min_partial_output = order.getMinOutputWithSlippage(partial_output);
+                    requirePreflight(order, max_fillable, min_partial_output);
+
+                    std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                           max_fillable, min_partial_output,
+                                                           urgencyForTif(order.tif_policy));
+
+                    order.transaction_hash = tx_hash;
+                    order.filled_amount = max_fillable;
+                    order.received_amount = partial_output;
+                    order.updateStatus(OrderStatus::PARTIALLY_FILLED, "Partial fill executed");
+
+                    std::cout << "✅ IOC Partial fill completed: " << order.getFillPercentage() << "%" << std::endl;
+                }
+                else
+                {
+                    order.updateStatus(OrderStatus::CANCELED, "Price not met for any execution");
+                    std::cout << "❌ IOC Order CANCELED - price not met" << std::endl;
+                }
+            }
+        }
+        catch (const DeadlineExceeded &e)
+        {
+            order.updateStatus(OrderStatus::CANCELED, std::string("IOC: ") + e.what());
+            std::cout << "⏱️ IOC Order CANCELED - RPC deadline exceeded" << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            order.updateStatus(OrderStatus::FAILED, e.what());
+            std::cerr << "❌ IOC execution failed: " << e.what() << std::endl;
+        }
+    }
+
+    // Execute FOK policy: All-or-nothing single check, verified by simulating the swap
+    void executeFOK(LimitOrder &order)
+    {
+        std::cout << "\n💀 Executing FOK Policy for " << order.order_id << std::endl;
+
+        CurvePool pool(order.pool_address, rpc, &gas_oracle, gas_model, order.underlying);
+        RpcDeadline::Scope deadline(rpcBudgetForTif(order.tif_policy));
+
+        try
+        {
+            // First check: Price check
+            uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
+            order.recordPriceCheck(current_output);
+
+            std::cout << "💰 FOK Price Check: " << current_output << " output tokens" << std::endl;
+
+            if (!order.isPriceMet(current_output))
+            {
+                order.updateStatus(OrderStatus::CANCELED, "FOK: Price not met, order killed");
+                std::cout << "💀 FOK Order KILLED - price not met" << std::endl;
+                return;
+            }
+
+            // Second check: simulate the exact swap (optional). One eth_call of the real exchange
+            // at min_dy, balance and allowance overridden, says whether the full order fills.
+            uint64_t min_output = order.getMinOutputWithSlippage(current_output);
+            bool preflight_enabled = !RuntimeConfig::get().skip_liquidity_check;
+
+            if (preflight_enabled)
+            {
+                std::cout << "🔍 FOK Pre-flight: Simulating the full swap..." << std::endl;
+                std::string rejection = preflight({simulatedSwap(order.pool_address, order.input_token_address, order.underlying,
+                                                                 order.input_token_index, order.output_token_index,
+                                                                 order.input_amount, min_output)})
+                                            .front();
+                if (!rejection.empty())
+                {
+                    order.updateStatus(OrderStatus::CANCELED, "FOK: " + rejection);
+                    std::cout << "💀 FOK Order KILLED - swap would not fill in full" << std::endl;
+                    return;
+                }
+                std::cout << "✅ FOK Pre-flight: Full swap executes" << std::endl;
+            }
+
+            if (!allowanceReady(order, order.input_amount))
+            {
+                order.updateStatus(OrderStatus::CANCELED, "FOK: Allowance not ready, order killed");
+                std::cout << "💀 FOK Order KILLED - allowance not ready" << std::endl;
+                return;
+            }
+
+            // All checks passed - execute the order
+            std::cout << "✅ FOK ORDER FILLED completely!" << std::endl;
+
+            std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
+                                                   order.input_amount, min_output,
+                                                   urgencyForTif(order.tif_policy));
+
+            order.transaction_hash = tx_hash;
+            order.filled_amount = order.input_amount;
+            order.received_amount = current_output;
+            order.updateStatus(OrderStatus::FILLED);
+        }
+        catch (const DeadlineExceeded &e)
+        {
+            order.updateStatus(OrderStatus::CANCELED, std::string("FOK: ") + e.what());
+            std::cout << "⏱️ FOK Order KILLED - RPC deadline exceeded" << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            order.updateStatus(OrderStatus::FAILED, e.what());
+            std::cerr << "❌ FOK execution failed: " << e.what() << std::endl;
+        }
+    }
+
+    // Aggregate and execute everything that triggered this tick. The aggregator pairs orders by
+    // pool coin index, so underlying-coin orders go out on their own. Every exchange of the tick
+    // is simulated in one batch first; one that would revert isn't sent.
+    void executeTriggered(const std::vector<TriggeredOrder> &triggered)
+    {
+        std::vector<TriggeredOrder> pooled, singles;
+        for (const auto &t : triggered)
+        {
+            if (t.order->underlying)
+                singles.push_back(t);
+            else
+                pooled.push_back(t);
+        }
+
+        OrderAggregator aggregator;
+        AggregationResult plan = aggregator.aggregate(
+            pooled,
+            [this](const std::string &pool_address, int32_t i, int32_t j, uint64_t dx)
+            {
+                return CurvePool(pool_address, rpc).get_dy(i, j, dx);
+            });
+        singles.insert(singles.end(), plan.deferred.begin(), plan.deferred.end());
+
+        std::vector<SwapSimulator::Swap> checks;
+        for (const auto &swap : plan.swaps)
+        {
+            if (swap.needsSwap())
+                checks.push_back(simulatedSwap(swap.pool_address, inputTokenOf(swap), false,
+                                               swap.input_index, swap.output_index, swap.dx, swap.min_dy));
+        }
+        for (const auto &single : singles)
+        {
+            const LimitOrder &order = *single.order;
+            checks.push_back(simulatedSwap(order.pool_address, order.input_token_address, order.underlying,
+                                           order.input_token_index, order.output_token_index,
+                                           order.input_amount - order.filled_amount,
+                                           order.getMinOutputWithSlippage(single.quoted_output)));
+        }
+        std::vector<std::string> rejections = preflight(checks);
+
+        size_t check = 0;
+        for (const auto &swap : plan.swaps)
+        {
+            executeAggregated(swap, swap.needsSwap() ? rejections[check++] : std::string());
+        }
+        for (const auto &single : singles)
+        {
+            executeSingle(*single.order, single.quoted_output, rejections[check++]);
+        }
+    }
+
+    // Cut the next child slice for each due TWAP / ICEBERG parent and quote it
+    void prepareSlices(uint64_t block, std::vector<TriggeredOrder> &triggered,
+                       std::vector<std::pair<LimitOrder *, std::unique_ptr<LimitOrder>>> &slices)
+    {
+        // Small-size reference rate per pool direction, quoted at most once per tick
+        std::map<std::string, double> reference_rates;
+
+        for (LimitOrder *parent : slice_scheduler.popDue(block))
+        {
+            if (parent->status != OrderStatus::ACTIVE)
+            {
+                slice_scheduler.cancel(*parent);
+                continue;
+            }
+            if (parent->isExpired())
+            {
+                parent->updateStatus(OrderStatus::EXPIRED, "Order expired");
+                slice_scheduler.cancel(*parent);
+                settleAllowance(*parent);
+                continue;
+            }
+
+            std::string impact_key = PriceImpactModel::keyFor(parent->pool_address, parent->input_token_index,
+                                                              parent->output_token_index);
+            uint64_t size = slice_scheduler.nextSliceSize(*parent, block, impact_model, impact_key);
+            auto child = slice_scheduler.makeChild(*parent, size);
+
+            CurvePool pool(parent->pool_address, rpc, &gas_oracle, gas_model, parent->underlying);
+            try
+            {
+                uint64_t current_output = pool.get_dy(parent->input_token_index, parent->output_token_index, size);
+                child->recordPriceCheck(current_output);
+
+                // Reference at 1/20 of the slice keeps rounding noise out of the impact estimate
+                uint64_t reference_size = std::max<uint64_t>(size / 20, 1);
+                if (!reference_rates.count(impact_key))
+                {
+                    uint64_t reference_output = pool.get_dy(parent->input_token_index, parent->output_token_index, reference_size);
+                    reference_rates[impact_key] = static_cast<double>(reference_output) / static_cast<double>(reference_size);
+                }
+                impact_model.observe(impact_key, reference_rates[impact_key], size,
+                                     static_cast<double>(current_output) / static_cast<double>(size));
+
+                std::cout << "🧩 Slice " << child->order_id << ": " << size << " -> " << current_output << std::endl;
+
+                if (child->isPriceMet(current_output) && allowanceReady(*child, size))
+                {
+                    triggered.push_back({child.get(), current_output});
+                }
+                else
+                {
+                    child->updateStatus(OrderStatus::CANCELED, "Slice price not met");
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "❌ Slice quote failed for " << parent->order_id << ": " << e.what() << std::endl;
+                child->updateStatus(OrderStatus::FAILED, e.what());
+            }
+
+            slices.emplace_back(parent, std::move(child));
+        }
+    }
+
+    // One engine tick: quote every live order once, then aggregate and execute what triggered
+    void runTick()
+    {
+        uint64_t block = tick_block++;
+        std::vector<TriggeredOrder> triggered;
+        std::vector<std::pair<LimitOrder *, std::unique_ptr<LimitOrder>>> slices;
+
+        std::vector<LimitOrder *> to_quote;
+        for (auto &order : active_orders)
+        {
+            if (order->status != OrderStatus::ACTIVE || order->isSliced())
+                continue;
+
+            if (order->isExpired())
+            {
+                order->updateStatus(OrderStatus::EXPIRED, "Order expired");
+                settleAllowance(*order);
+                continue;
             }
+            if (!isImmediate(*order) && !poll_scheduler.due(order->order_id, block))
+                continue;
+            to_quote.push_back(order.get());
         }
 
-        if (order.isExpired())
+        // Provider circuit open: nothing would get through, so don't try. Immediate orders can't
+        // wait for it; resting ones are quoted again once the breaker lets probes through.
+        if (provider_down && rpc->getBreaker().refusing())
         {
-            order.updateStatus(OrderStatus::EXPIRED, "Order expired");
-            std::cout << "⏰ GTT Order EXPIRED without execution" << std::endl;
+            for (LimitOrder *order : to_quote)
+            {
+                if (!isImmediate(*order))
+                    continue;
+                order->updateStatus(OrderStatus::CANCELED, order->getTifString() + ": RPC provider unavailable");
+                settleAllowance(*order);
+            }
+            return;
         }
-    }
-
-    // Execute IOC policy: Single check with partial fill support
-    void executeIOC(LimitOrder &order)
-    {
-        std::cout << "\n⚡ Executing IOC Policy for " << order.order_id << std::endl;
 
-        CurvePool pool(order.pool_address, rpc);
+        // With an IOC / FOK in the tick, its quotes and fills share the immediate budget; resting
+        // orders caught in a missed round trip just try again next tick
+        bool immediate = std::any_of(to_quote.begin(), to_quote.end(), [](const LimitOrder *order)
+                                     { return isImmediate(*order); });
+        RpcDeadline::Scope deadline(immediate ? IMMEDIATE_RPC_BUDGET : RESTING_RPC_BUDGET);
 
-        try
+        std::vector<QuoteResult> quotes = quoteOrders(to_quote, block);
+        bool timed_out = RpcDeadline::expired();
+        for (size_t k = 0; k < to_quote.size(); ++k)
         {
-            uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
-            order.recordPriceCheck(current_output);
-
-            std::cout << "💰 IOC Price Check: " << current_output << " output tokens" << std::endl;
-
-            // Debug: Show price comparison
-            uint64_t expected_output = static_cast<uint64_t>(order.input_amount * order.limit_price);
-            std::cout << "🔍 Price Check: Current output = " << current_output << ", Expected output = " << expected_output << std::endl;
-            std::cout << "🔍 Price met? " << (order.isPriceMet(current_output) ? "YES" : "NO") << std::endl;
-
-            if (order.isPriceMet(current_output))
+            LimitOrder &order = *to_quote[k];
+            const QuoteResult &quote = quotes[k];
+            if (!quote.ok)
             {
-                std::cout << "✅ IOC ORDER EXECUTED immediately!" << std::endl;
+                std::cerr << "❌ Quote failed for " << order.order_id << ": " << quote.error << std::endl;
+                if (isImmediate(order))
+                {
+                    order.updateStatus(timed_out ? OrderStatus::CANCELED : OrderStatus::FAILED,
+                                       timed_out ? order.getTifString() + ": RPC deadline exceeded" : quote.error);
+                    settleAllowance(order);
+                }
+                continue;
+            }
 
-                uint64_t min_output = order.getMinOutputWithSlippage(current_output);
-                std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
-                                                       order.input_amount, min_output);
+            uint64_t remaining = order.input_amount - order.filled_amount;
+            order.recordPriceCheck(quote.output);
 
-                order.transaction_hash = tx_hash;
-                order.filled_amount = order.input_amount;
-                order.received_amount = current_output;
-                order.updateStatus(OrderStatus::FILLED);
+            bool price_met = order.isPriceMetForAmount(quote.output, remaining);
+            if (price_met && allowanceReady(order, remaining))
+            {
+                triggered.push_back({&order, quote.output});
+            }
+            else if (isImmediate(order))
+            {
+                order.updateStatus(OrderStatus::CANCELED, order.getTifString() + ": Price not met");
+                settleAllowance(order);
             }
             else
             {
-                // Check for partial fill possibility
-                uint64_t max_fillable = order.getMaxFillableAmount(current_output);
-
-                if (max_fillable > 0)
-                {
-                    std::cout << "🔄 IOC PARTIAL FILL: " << max_fillable << " of " << order.input_amount << " tokens" << std::endl;
-
-                    // Calculate output for partial fill
-                    uint64_t partial_output = pool.get_dy(order.input_token_index, order.output_token_index, max_fillable);
-                    uint64_t min_partial_output = order.getMinOutputWithSlippage(partial_output);
+                nextCheckIn(order, block, remaining, quote.output, price_met);
+            }
+        }
 
-                    std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
-                                                           max_fillable, min_partial_output);
+        prepareSlices(block, triggered, slices);
 
-                    order.transaction_hash = tx_hash;
-                    order.filled_amount = max_fillable;
-                    order.received_amount = partial_output;
-                    order.updateStatus(OrderStatus::PARTIALLY_FILLED, "Partial fill executed");
+        if (!triggered.empty())
+        {
+            executeTriggered(triggered);
+        }
 
-                    std::cout << "✅ IOC Partial fill completed: " << order.getFillPercentage() << "%" << std::endl;
-                }
-                else
-                {
-                    order.updateStatus(OrderStatus::CANCELED, "Price not met for any execution");
-                    std::cout << "❌ IOC Order CANCELED - price not met" << std::endl;
-                }
+        // Roll slice results into their parents and line up the next slice
+        for (auto &[parent, child] : slices)
+        {
+            slice_scheduler.completeSlice(*parent, *child, block);
+            if (parent->status != OrderStatus::ACTIVE)
+            {
+                settleAllowance(*parent);
             }
         }
-        catch (const std::exception &e)
+    }
+
+    // Top-ups queued by addOrder go out before the first tick: an IOC / FOK gets one look and
+    // would otherwise cancel on an approval still in flight
+    void warmAllowances()
+    {
+        if (!executesOnchain())
+            return;
+        bool immediate = std::any_of(active_orders.begin(), active_orders.end(),
+                                     [](const std::unique_ptr<LimitOrder> &order)
+                                     { return order->status == OrderStatus::ACTIVE && isImmediate(*order); });
+        if (immediate && !allowances->waitIdle(ALLOWANCE_WARMUP))
+            std::cerr << "⚠️ Allowance top-ups still pending after " << ALLOWANCE_WARMUP.count() / 1000 << " s" << std::endl;
+    }
+
+    bool hasActiveOrders() const
+    {
+        return std::any_of(active_orders.begin(), active_orders.end(),
+                           [](const std::unique_ptr<LimitOrder> &order)
+                           { return order->status == OrderStatus::ACTIVE; });
+    }
+
+    // End every order still working: partial fills keep what they got, the rest is canceled
+    void closeOutActive(const std::string &reason)
+    {
+        for (auto &order : active_orders)
         {
-            order.updateStatus(OrderStatus::FAILED, e.what());
-            std::cerr << "❌ IOC execution failed: " << e.what() << std::endl;
+            if (order->status != OrderStatus::ACTIVE)
+                continue;
+            slice_scheduler.cancel(*order);
+            order->updateStatus(order->filled_amount > 0 ? OrderStatus::PARTIALLY_FILLED : OrderStatus::CANCELED,
+                                reason);
+            settleAllowance(*order);
         }
     }
 
-    // Execute FOK policy: All-or-nothing single check with liquidity verification
-    void executeFOK(LimitOrder &order)
+    const std::vector<std::unique_ptr<LimitOrder>> &getOrders() const
     {
-        std::cout << "\n💀 Executing FOK Policy for " << order.order_id << std::endl;
+        return active_orders;
+    }
 
-        CurvePool pool(order.pool_address, rpc);
+    // Batch mode: all orders share ticks, so orders triggering together are netted and coalesced
+    void processOrdersBatched(int max_ticks, std::chrono::milliseconds tick_interval)
+    {
+        std::cout << "\n🚀 STARTING LIMIT ORDER ENGINE (batch mode)" << std::endl;
+        std::cout << "Processing " << active_orders.size() << " orders..." << std::endl;
+        warmAllowances();
 
-        try
+        for (int tick = 0; tick < max_ticks; ++tick)
         {
-            // First check: Price check
-            uint64_t current_output = pool.get_dy(order.input_token_index, order.output_token_index, order.input_amount);
-            order.recordPriceCheck(current_output);
+            runTick();
+            if (!hasActiveOrders())
+                break;
+            std::this_thread::sleep_for(tick_interval);
+        }
 
-            std::cout << "💰 FOK Price Check: " << current_output << " output tokens" << std::endl;
+        closeOutActive("Demo limit reached");
+        printRpcSchedule();
+        printPollingStats();
+        printImpactCurveStats();
+        for (auto &order : active_orders)
+        {
+            std::cout << "\n📊 FINAL ORDER STATUS:" << std::endl;
+            order->printSummary();
+            std::cout << std::string(50, '-') << std::endl;
+        }
+    }
 
-            if (!order.isPriceMet(current_output))
-            {
-                order.updateStatus(OrderStatus::CANCELED, "FOK: Price not met, order killed");
-                std::cout << "💀 FOK Order KILLED - price not met" << std::endl;
-                return;
-            }
+    void printPollingStats() const
+    {
+        if (poll_scheduler.deferredChecks() > 0)
+            std::cout << "⏱️ Adaptive polling skipped " << poll_scheduler.deferredChecks()
+                      << " order-block quotes on orders far from their limit" << std::endl;
+    }
+
+    void printImpactCurveStats() const
+    {
+        if (state_answered > 0)
+            std::cout << "🧮 StableSwap state settled " << state_answered << " quotes locally" << std::endl;
+        if (crypto_answered > 0)
+            std::cout << "🧮 CryptoSwap math settled " << crypto_answered << " quotes locally from "
+                      << crypto_reads << " pool state reads" << std::endl;
+        if (metapool_answered > 0)
+            std::cout << "🧮 Metapool math settled " << metapool_answered << " underlying quotes locally from "
+                      << metapool_reads << " metapool and " << base_pool_reads << " base pool state reads" << std::endl;
+        if (impact_curves.answeredCount() > 0)
+            std::cout << "📈 Impact curves settled " << impact_curves.answeredCount() << " quotes from "
+                      << impact_curves.sampleCount() << " ladder samples (" << impact_curves.fallbackCount()
+                      << " too close to call, quoted exactly)" << std::endl;
+        if (simulator->simulatedCount() > 0)
+            std::cout << "🛡️ Pre-flight simulated " << simulator->simulatedCount() << " swaps ("
+                      << simulator->rejectedCount() << " stopped before broadcast, "
+                      << simulator->probedTokens() << " token layouts probed)" << std::endl;
+    }
+
+    // Per-class admission stats of the shared rate limiter (if one is configured) and how many
+    // duplicate reads rode along on an identical in-flight request
+    void printRpcSchedule() const
+    {
+        if (uint64_t shared = rpc->getFlights().sharedCount(); shared > 0)
+            std::cout << "🔁 " << shared << " duplicate RPC reads shared an in-flight request" << std::endl;
+        if (uint64_t retries = rpc->retryCount(); retries > 0 || rpc->getBreaker().openCount() > 0)
+            std::cout << "🔌 " << retries << " RPC retries; circuit opened " << rpc->getBreaker().openCount()
+                      << " times, refusing " << rpc->getBreaker().deniedCount() << " requests" << std::endl;
+        const RpcScheduler *scheduler = rpc->getScheduler();
+        if (!scheduler)
+            return;
+        std::cout << "🚦 RPC budget " << scheduler->ratePerSecond() << "/s:";
+        for (RpcPriority cls : {RpcPriority::BROADCAST, RpcPriority::TRIGGER, RpcPriority::MONITORING, RpcPriority::BACKGROUND})
+        {
+            RpcScheduler::ClassStats stats = scheduler->classStats(cls);
+            std::cout << " " << RpcScheduler::className(cls) << " " << stats.granted << " calls (max queue "
+                      << stats.max_queued << ", max wait " << stats.max_wait.count() / 1000 << " ms)";
+        }
+        std::cout << std::endl;
+    }
 
-            // Second check: Liquidity verification (optional)
-            bool liquidity_check_enabled = true;
-            if (const char *env = std::getenv("SKIP_LIQUIDITY_CHECK"); env && std::string(env) == "1")
+    // Process all active orders: IOC/FOK run immediately, GTC/GTT lifecycles share one event loop
+    void processOrders()
+    {
+        std::cout << "\n🚀 STARTING LIMIT ORDER ENGINE" << std::endl;
+        std::cout << "Processing " << active_orders.size() << " orders..." << std::endl;
+        warmAllowances();
+
+        // With a head subscription the interval is only a fallback for a silent feed
+        bool subscribed = !subscription_url.empty();
+        EventLoop loop(subscribed ? std::chrono::milliseconds(HEAD_FALLBACK_INTERVAL) : std::chrono::milliseconds(2000),
+                       [this](const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+                       {
+                           // Only GTC / GTT quote through the loop; IOC / FOK run on their own
+                           RpcDeadline::Scope deadline(RESTING_RPC_BUDGET);
+                           quoteBatch(requests, results);
+                       });
+
+        // Pool state is seeded here and audited from the subscriber thread on its own connection
+        std::vector<std::string> pools;
+        std::unique_ptr<EthereumRPC> state_rpc;
+        uint64_t next_audit = 0;
+        std::unique_ptr<WebSocketSubscriber> subscriber;
+        if (subscribed)
+        {
+            for (const auto &order : active_orders)
             {
-                liquidity_check_enabled = false;
+                if (std::find(pools.begin(), pools.end(), order->pool_address) == pools.end())
+                    pools.push_back(order->pool_address);
             }
-
-            if (liquidity_check_enabled)
+            if (!CurvePool::usesMockPricing())
             {
-                std::cout << "🔍 FOK Liquidity Check: Verifying pool can handle full order..." << std::endl;
-
-                // Check if pool has sufficient liquidity by testing a slightly larger amount
-                uint64_t test_amount = static_cast<uint64_t>(order.input_amount * 1.01); // 1% larger test
-                try
+                state_rpc = std::make_unique<EthereumRPC>(rpc->getUrl());
+                state_rpc->setPriority(RpcPriority::MONITORING);
+                for (const auto &pool : pools)
                 {
-                    uint64_t test_output = pool.get_dy(order.input_token_index, order.output_token_index, test_amount);
+                    try
+                    {
+                        pool_states.seed(pool, CurvePool::fetchState(*state_rpc, pool));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        std::cerr << "⚠️ Not tracking state for " << pool << ": " << e.what() << std::endl;
+                    }
+                }
+            }
 
-                    // If we can get a quote for a larger amount, liquidity should be sufficient
-                    if (test_output > 0)
+            // A head's bloom marks possible pool logs before its block wakes the orders
+            std::vector<LogsBloom::Bits> pool_bits = LogsBloom::bitsOf(pools);
+            subscriber = std::make_unique<WebSocketSubscriber>(
+                subscription_url, pools,
+                [this, &loop, &pools, &state_rpc, &next_audit, pool_bits](const NewHead &head)
+                {
+                    LogsBloom bloom;
+                    if (LogsBloom::parse(head.logs_bloom, bloom))
                     {
-                        std::cout << "✅ FOK Liquidity Check: Pool has sufficient liquidity" << std::endl;
+                        for (size_t k = 0; k < pools.size(); ++k)
+                        {
+                            if (bloom.mayContain(pool_bits[k]))
+                                pool_activity.record(pools[k], head.number);
+                        }
+                        pool_activity.screened(head.number);
                     }
                     else
                     {
-                        order.updateStatus(OrderStatus::CANCELED, "FOK: Insufficient liquidity for full order");
-                        std::cout << "💀 FOK Order KILLED - insufficient liquidity" << std::endl;
+                        pool_activity.unscreened();
+                    }
+                    PoolStateStore::HeadCheck check = pool_states.onHead(head);
+                    if (check == PoolStateStore::HeadCheck::GAP)
+                    {
+                        std::cerr << "⚠️ Head " << head.number << " skipped blocks: pool state resyncs" << std::endl;
+                    }
+                    else if (check == PoolStateStore::HeadCheck::REORG)
+                    {
+                        std::cout << "🔀 Reorg at block " << head.number << ": orphaned pool state rolled back" << std::endl;
+                        for (const auto &pool : pools)
+                            refreshTriggers(pool);
+                    }
+                    loop.postBlock(head.number);
+                    if (!state_rpc)
                         return;
+                    if (next_audit == 0)
+                        next_audit = head.number + STATE_AUDIT_BLOCKS; // Just seeded
+                    bool resync = std::any_of(pools.begin(), pools.end(), [this](const std::string &pool)
+                                              { return pool_states.needsResync(pool); });
+                    if (resync || head.number >= next_audit)
+                    {
+                        auditPoolStates(*state_rpc, pools);
+                        next_audit = head.number + STATE_AUDIT_BLOCKS;
                     }
-                }
-                catch (const std::exception &e)
+                },
+                [this](const PoolLog &log)
                 {
-                    std::cout << "⚠️ FOK Liquidity Check: Could not verify liquidity, proceeding with caution" << std::endl;
-                }
-            }
-
-            // All checks passed - execute the order
-            std::cout << "✅ FOK ORDER FILLED completely!" << std::endl;
-
-            uint64_t min_output = order.getMinOutputWithSlippage(current_output);
-            std::string tx_hash = pool.executeSwap(order.input_token_index, order.output_token_index,
-                                                   order.input_amount, min_output);
-
-            order.transaction_hash = tx_hash;
-            order.filled_amount = order.input_amount;
-            order.received_amount = current_output;
-            order.updateStatus(OrderStatus::FILLED);
-        }
-        catch (const std::exception &e)
-        {
-            order.updateStatus(OrderStatus::FAILED, e.what());
-            std::cerr << "❌ FOK execution failed: " << e.what() << std::endl;
+                    pool_activity.record(log.address, log.block_number);
+                    PoolStateStore::ApplyResult result = pool_states.apply(log);
+                    if (result == PoolStateStore::ApplyResult::APPLIED || result == PoolStateStore::ApplyResult::ROLLED_BACK)
+                        refreshTriggers(log.address);
+                });
+            // Logs and heads sent while we were away are gone: re-read every pool on the next
+            // head, and quote again until a fresh run of screened heads covers the gap
+            subscriber->onDisconnect([this]
+                                     {
+                                         pool_states.resyncAll();
+                                         pool_activity.unscreened(); });
+            subscriber->start();
+            head_feed = subscriber.get();
+            std::cout << "📡 Subscribed to newHeads and logs on " << pools.size() << " pool(s) via " << subscription_url << std::endl;
         }
-    }
-
-    // Process all active orders
-    void processOrders()
-    {
-        std::cout << "\n🚀 STARTING LIMIT ORDER ENGINE" << std::endl;
-        std::cout << "Processing " << active_orders.size() << " orders..." << std::endl;
 
+        std::vector<LimitOrder *> processed;
         for (auto &order : active_orders)
         {
             if (!order->isExecutable())
                 continue;
 
+            if (order->isSliced())
+            {
+                std::cout << "⚠️ " << order->order_id << " is " << order->getExecutionStyleString()
+                          << "; sliced orders run in batch mode (ENGINE_MODE=batch)" << std::endl;
+                continue;
+            }
+
             switch (order->tif_policy)
             {
             case TimeInForce::GTC:
-                executeGTC(*order);
+                loop.spawn(runGTC(*order, loop));
                 break;
             case TimeInForce::GTT:
-                executeGTT(*order);
+                loop.spawn(runGTT(*order, loop));
                 break;
             case TimeInForce::IOC:
                 executeIOC(*order);
@@ -541,6 +3059,35 @@ public:
                 executeFOK(*order);
                 break;
             }
+            processed.push_back(order.get());
+        }
+
+        loop.run();
+
+        if (subscriber)
+        {
+            head_feed = nullptr;
+            subscriber->stop();
+            std::cout << "📡 Feed delivered " << subscriber->headsReceived() << " heads and "
+                      << subscriber->logsReceived() << " pool logs (" << pool_states.appliedCount() << " folded into pool state, "
+                      << pool_states.rollbackCount() << " reorg rollbacks, " << pool_states.resyncCount() << " resyncs)" << std::endl;
+            if (pool_states.gapCount() + pool_states.reorgCount() > 0)
+                std::cout << "📡 Head continuity: " << pool_states.gapCount() << " gaps, " << pool_states.reorgCount()
+                          << " reorgs, " << subscriber->connectCount() << " connections" << std::endl;
+            if (triggers.evaluationCount() > 0)
+                std::cout << "🎯 Trigger index: " << triggers.evaluationCount() << " threshold solves, "
+                          << triggers.rebaseCount() << " rebases, " << triggers.firedCount() << " fired" << std::endl;
+        }
+        printRpcSchedule();
+        printPollingStats();
+        printImpactCurveStats();
+
+        for (LimitOrder *order : processed)
+        {
+            if (order->status != OrderStatus::ACTIVE)
+            {
+                settleAllowance(*order);
+            }
 
             std::cout << "\n📊 FINAL ORDER STATUS:" << std::endl;
             order->printSummary();
@@ -549,6 +3096,135 @@ public:
     }
 };
 
+// 🧵 SHARDED ENGINE - one batch engine per worker thread, orders pinned to a shard by pool.
+// Each shard owns its orders and quote connection; the wallet's services (fee oracle, gas
+// model, allowance tracker) run once and are shared, and every signer takes its nonce from the
+// wallet's one NonceAllocator. Fills and status changes flow back to the coordinator over a
+// lock-free MPSC queue.
+class ShardedLimitOrderEngine
+{
+private:
+    struct Shard
+    {
+        std::unique_ptr<EthereumRPC> rpc;
+        std::unique_ptr<LimitOrderEngine> engine;
+        size_t order_count = 0;
+    };
+
+    std::shared_ptr<WalletServices> services;
+    std::vector<Shard> shards;
+    ShardCoordinator coordinator;
+
+    void runShard(size_t index, int max_ticks, std::chrono::milliseconds tick_interval)
+    {
+        LimitOrderEngine &engine = *shards[index].engine;
+        ShardPublisher publisher(index, coordinator.updates());
+        try
+        {
+            for (int tick = 0; tick < max_ticks && engine.hasActiveOrders(); ++tick)
+            {
+                engine.runTick();
+                publisher.publish(engine.getOrders());
+                if (engine.hasActiveOrders())
+                    std::this_thread::sleep_for(tick_interval);
+            }
+            engine.closeOutActive("Demo limit reached");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "❌ Shard " << index << " stopped: " << e.what() << std::endl;
+            engine.closeOutActive(std::string("Shard error: ") + e.what());
+        }
+        publisher.publish(engine.getOrders());
+        publisher.finish();
+    }
+
+public:
+    ShardedLimitOrderEngine(const std::string &rpc_url, size_t shard_count)
+        : services(std::make_shared<WalletServices>(rpc_url)), shards(std::max<size_t>(shard_count, 1)),
+          coordinator(std::max<size_t>(shard_count, 1))
+    {
+        for (auto &shard : shards)
+        {
+            shard.rpc = std::make_unique<EthereumRPC>(rpc_url);
+            shard.engine = std::make_unique<LimitOrderEngine>(shard.rpc.get(), services);
+        }
+    }
+
+    size_t shardCount() const
+    {
+        return shards.size();
+    }
+
+    // Must be called before processOrders(); the order moves to its pool's shard
+    void addOrder(std::unique_ptr<LimitOrder> order)
+    {
+        size_t index = ShardRouter::shardFor(order->pool_address, shards.size());
+        std::cout << "🧭 " << order->order_id << " -> shard " << index << std::endl;
+        shards[index].order_count++;
+        shards[index].engine->addOrder(std::move(order));
+    }
+
+    void processOrders(int max_ticks, std::chrono::milliseconds tick_interval)
+    {
+        std::cout << "\n🚀 STARTING LIMIT ORDER ENGINE (sharded, " << shards.size() << " shards)" << std::endl;
+
+        // One tracker serves every shard, so the first shard holding an IOC / FOK waits out all
+        // queued top-ups
+        for (auto &shard : shards)
+        {
+            if (shard.order_count > 0)
+                shard.engine->warmAllowances();
+        }
+
+        std::vector<std::thread> workers;
+        size_t idle_shards = 0;
+        for (size_t index = 0; index < shards.size(); ++index)
+        {
+            if (shards[index].order_count == 0)
+            {
+                // Nothing to watch; report done without spending a thread
+                ShardPublisher(index, coordinator.updates()).finish();
+                idle_shards++;
+                continue;
+            }
+            workers.emplace_back(&ShardedLimitOrderEngine::runShard, this, index, max_ticks, tick_interval);
+        }
+        std::cout << "   " << workers.size() << " active shards, " << idle_shards << " idle" << std::endl;
+
+        while (!coordinator.allDone())
+        {
+            size_t applied = coordinator.drain([](const OrderUpdate &update)
+                                               {
+                if (update.status == OrderStatus::FILLED || update.status == OrderStatus::PARTIALLY_FILLED)
+                {
+                    std::cout << "📬 [shard " << update.shard << "] " << update.order_id << " "
+                              << LimitOrder::statusString(update.status) << ": " << update.filled_amount
+                              << " -> " << update.received_amount << std::endl;
+                } });
+            if (applied == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        coordinator.drain();
+
+        std::cout << "\n📊 FINAL ORDER STATUS (all shards):" << std::endl;
+        for (const auto &[order_id, update] : coordinator.orders())
+        {
+            std::cout << "  " << order_id << " [shard " << update.shard << "] "
+                      << LimitOrder::statusString(update.status) << " filled " << update.filled_amount
+                      << " received " << update.received_amount;
+            if (!update.failure_reason.empty())
+                std::cout << " (" << update.failure_reason << ")";
+            std::cout << std::endl;
+        }
+    }
+};
+
 // 🎯 MAIN PROGRAM - This is what you'll run!
 int main(int argc, char **argv)
 {
@@ -566,11 +3242,26 @@ int main(int argc, char **argv)
             return 1;
         }
 
-        // Allow overriding RPC URL via environment variable RPC_URL
+        // Runtime settings: config file (--config / CONFIG_FILE), then environment, then --key=value
+        // options. Flags are re-read from the file whenever it changes; the order, engine and
+        // endpoint settings below are read from this first snapshot and apply on restart.
+        std::vector<std::string> args(argv + 1, argv + argc);
+        const RuntimeSettings &config = RuntimeConfig::load(args);
+        std::unique_ptr<ConfigWatcher> config_watcher;
+        if (const std::string config_path = RuntimeConfig::path(); !config_path.empty())
+        {
+            std::cout << "[INFO] Settings from " << config_path << " (watched for changes)" << std::endl;
+            config_watcher = std::make_unique<ConfigWatcher>(config_path, []
+                                                             {
+                if (RuntimeConfig::reload())
+                    std::cout << "🔧 Config reloaded (generation " << RuntimeConfig::get().generation << ")" << std::endl; });
+        }
+
+        // Allow overriding RPC URL via RPC_URL
         std::string rpc_url = SepoliaConfig::SEPOLIA_RPC_URL;
-        if (const char *rpc_env = std::getenv("RPC_URL"); rpc_env && std::string(rpc_env).size() > 0)
+        if (!config.rpc_url.empty())
         {
-            rpc_url = std::string(rpc_env);
+            rpc_url = config.rpc_url;
         }
 
         // Use configured wallet and real Sepolia addresses
@@ -579,36 +3270,27 @@ int main(int argc, char **argv)
 
         std::cout << "\n🏗️  CREATING REAL ORDERS FOR SEPOLIA..." << std::endl;
 
-        // Allow overriding pool and params via CLI/env
+        // Allow overriding pool and params via CLI/settings
         // Usage: curve_dex_limit_order_agent <pool_address> <token_in_index> <token_out_index> <input_amount>
-        auto getenv_str = [](const char *key) -> std::string
-        {
-            const char *val = std::getenv(key);
-            return val ? std::string(val) : std::string();
-        };
-
         std::string pool_address;
         int32_t in_idx = 0;
         int32_t out_idx = 1;
         uint64_t input_amount = 1000000; // default 1e6 units
 
-        if (argc >= 2)
-            pool_address = argv[1];
-        if (argc >= 3)
-            in_idx = static_cast<int32_t>(std::stol(argv[2]));
-        if (argc >= 4)
-            out_idx = static_cast<int32_t>(std::stol(argv[3]));
-        if (argc >= 5)
-            input_amount = static_cast<uint64_t>(std::stoull(argv[4]));
+        if (args.size() >= 1)
+            pool_address = args[0];
+        if (args.size() >= 2)
+            in_idx = static_cast<int32_t>(std::stol(args[1]));
+        if (args.size() >= 3)
+            out_idx = static_cast<int32_t>(std::stol(args[2]));
+        if (args.size() >= 4)
+            input_amount = static_cast<uint64_t>(std::stoull(args[3]));
 
         if (pool_address.empty())
-            pool_address = getenv_str("POOL_ADDRESS");
-        if (const std::string env_in = getenv_str("TOKEN_IN_INDEX"); !env_in.empty())
-            in_idx = static_cast<int32_t>(std::stol(env_in));
-        if (const std::string env_out = getenv_str("TOKEN_OUT_INDEX"); !env_out.empty())
-            out_idx = static_cast<int32_t>(std::stol(env_out));
-        if (const std::string env_amt = getenv_str("ORDER_INPUT_AMOUNT"); !env_amt.empty())
-            input_amount = static_cast<uint64_t>(std::stoull(env_amt));
+            pool_address = config.pool_address;
+        in_idx = config.token_in_index.value_or(in_idx);
+        out_idx = config.token_out_index.value_or(out_idx);
+        input_amount = config.order_input_amount.value_or(input_amount);
 
         if (pool_address.empty() || pool_address == "0xPool" || pool_address.length() < 42)
         {
@@ -627,32 +3309,25 @@ int main(int argc, char **argv)
             std::cout << "[INFO] No RPC_URL set; using public mainnet RPC for 3pool." << std::endl;
         }
 
-        EthereumRPC rpc(rpc_url);
-        LimitOrderEngine engine(&rpc);
-
-        // Parse TIF policy from command line or environment
+        // Parse TIF policy from command line or settings
         std::string tif_policy = "GTC"; // default
-        if (argc >= 6)
-            tif_policy = argv[5];
-        else if (const char *env_tif = std::getenv("TIF_POLICY"); env_tif)
-            tif_policy = std::string(env_tif);
-
-        // Parse limit price from command line or environment
-        double limit_price = 1.01; // default
-        if (argc >= 7)
-            limit_price = std::stod(argv[6]);
-        else if (const char *env_price = std::getenv("LIMIT_PRICE"); env_price)
-            limit_price = std::stod(env_price);
+        if (args.size() >= 5)
+            tif_policy = args[4];
+        else if (!config.tif_policy.empty())
+            tif_policy = config.tif_policy;
+
+        // Parse limit price from command line or settings
+        double limit_price = config.limit_price.value_or(1.01); // default 1.01
+        if (args.size() >= 6)
+            limit_price = std::stod(args[5]);
 
         // Parse additional parameters for GTT
         std::chrono::system_clock::time_point expiry_time;
         if (tif_policy == "GTT")
         {
-            int expiry_minutes = 60; // default 1 hour
-            if (argc >= 8)
-                expiry_minutes = std::stoi(argv[7]);
-            else if (const char *env_expiry = std::getenv("GTT_EXPIRY_MINUTES"); env_expiry)
-                expiry_minutes = std::stoi(env_expiry);
+            int expiry_minutes = config.gtt_expiry_minutes.value_or(60); // default 1 hour
+            if (args.size() >= 7)
+                expiry_minutes = std::stoi(args[6]);
 
             expiry_time = std::chrono::system_clock::now() + std::chrono::minutes(expiry_minutes);
         }
@@ -692,15 +3367,75 @@ int main(int argc, char **argv)
             return 1;
         }
 
+        // Optional slicing: EXECUTION_STYLE=TWAP (TWAP_SLICES) or ICEBERG (ICEBERG_CLIP)
+        if (config.execution_style == "TWAP")
+        {
+            order->execution_style = ExecutionStyle::TWAP;
+            order->twap_slices = config.twap_slices;
+        }
+        else if (config.execution_style == "ICEBERG")
+        {
+            order->execution_style = ExecutionStyle::ICEBERG;
+            order->iceberg_clip = config.iceberg_clip > 0 ? config.iceberg_clip : input_amount / 4;
+        }
+        bool sliced = order->isSliced();
+
         order->pool_address = pool_address;
         order->input_token_index = in_idx;
         order->output_token_index = out_idx;
-        engine.addOrder(std::move(order));
+        order->underlying = config.underlying_coins;
 
-        std::cout << "\n🎬 PROCESSING ALL ORDERS..." << std::endl;
+        // ENGINE_MODE=sharded spreads pools over worker threads; WATCH_POOLS adds the same
+        // order on further pools (comma-separated) so there is something to spread
+        const std::string &engine_mode = config.engine_mode;
+        if (engine_mode == "sharded")
+        {
+            size_t shard_count = config.engine_shards > 0 ? config.engine_shards
+                                                          : std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+            std::vector<std::unique_ptr<LimitOrder>> orders;
+            for (const std::string &extra_pool : config.watch_pools)
+            {
+                auto copy = std::make_unique<LimitOrder>(*order);
+                copy->order_id = order_id + "_" + std::to_string(orders.size() + 1);
+                copy->pool_address = extra_pool;
+                orders.push_back(std::move(copy));
+            }
+            orders.insert(orders.begin(), std::move(order));
 
-        // Process all orders according to their TIF policies
-        engine.processOrders();
+            ShardedLimitOrderEngine engine(rpc_url, shard_count);
+            for (auto &pending : orders)
+            {
+                engine.addOrder(std::move(pending));
+            }
+
+            std::cout << "\n🎬 PROCESSING ALL ORDERS..." << std::endl;
+            engine.processOrders(10, std::chrono::seconds(2));
+        }
+        else
+        {
+            EthereumRPC rpc(rpc_url);
+            LimitOrderEngine engine(&rpc);
+            if (config.engine_workers > 0)
+                engine.enableParallelQuotes(config.engine_workers);
+            if (!config.ws_url.empty())
+                engine.enableHeadSubscription(config.ws_url);
+            engine.addOrder(std::move(order));
+
+            std::cout << "\n🎬 PROCESSING ALL ORDERS..." << std::endl;
+
+            // Process all orders according to their TIF policies
+            // ENGINE_MODE=batch evaluates orders in shared ticks so same-block triggers are aggregated;
+            // sliced orders always run there since the tick scheduler owns their child slices
+            if (sliced || engine_mode == "batch")
+            {
+                engine.processOrdersBatched(10, std::chrono::seconds(2));
+            }
+            else
+            {
+                engine.processOrders();
+            }
+        }
 
         std::cout << "\n🏁 LIMIT ORDER AGENT COMPLETE!" << std::endl;
         std::cout << "✅ " << tif_policy << " order created and processed" << std::endl;
@@ -715,6 +3450,7 @@ int main(int argc, char **argv)
         std::cout << "  ./build/curve_dex_limit_order_agent 0xPool 1 0 1000000 FOK 1.01" << std::endl;
         std::cout << "  ./build/curve_dex_limit_order_agent 0xPool 1 0 1000000 IOC 2.0  # High limit (cancels)" << std::endl;
         std::cout << "  TIF_POLICY=IOC LIMIT_PRICE=2.0 ./build/curve_dex_limit_order_agent  # Environment variables" << std::endl;
+        std::cout << "  ./build/curve_dex_limit_order_agent --config agent.conf --use-mock-pricing=1  # Settings file + override" << std::endl;
 
         curl_global_cleanup();
     }
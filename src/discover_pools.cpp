@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <nlohmann/json.hpp>
 #include "../include/sepolia_config.h"
+#include "../include/keccak.h"
+#include "../include/logs_bloom.h"
 
 using json = nlohmann::json;
 
@@ -117,6 +119,23 @@ public:
         return 0;
     }
 
+    // topic0 of the events only a Curve pool or pool factory emits
+    static std::vector<std::string> curveEventTopics()
+    {
+        std::vector<std::string> topics = {
+            Keccak::eventTopic("TokenExchange(address,int128,uint256,int128,uint256)"),
+            Keccak::eventTopic("TokenExchangeUnderlying(address,int128,uint256,int128,uint256)"),
+            Keccak::eventTopic("PlainPoolDeployed(address[4],uint256,uint256,address)"),
+            Keccak::eventTopic("MetaPoolDeployed(address,address,uint256,uint256,address)")};
+        for (int n = 2; n <= 4; ++n)
+        {
+            std::string array = "uint256[" + std::to_string(n) + "]";
+            topics.push_back(Keccak::eventTopic("AddLiquidity(address," + array + "," + array + ",uint256,uint256)"));
+            topics.push_back(Keccak::eventTopic("RemoveLiquidity(address," + array + "," + array + ",uint256)"));
+        }
+        return topics;
+    }
+
     // Scan for pools by checking known addresses and testing for liquidity
     std::vector<std::string> discoverPools()
     {
@@ -165,7 +184,8 @@ public:
             }
         }
 
-        // Also try to find pools by scanning recent blocks for pool creation events
+        // Also try to find pools by scanning recent blocks for Curve pool events. Only the
+        // header's logsBloom is read per block; logs are fetched only where it may match.
         std::cout << "\n🔍 Scanning recent blocks for pool events..." << std::endl;
 
         try
@@ -179,6 +199,10 @@ public:
 
                 std::cout << "  Latest block: " << latest_block << std::endl;
 
+                std::vector<std::string> topics = curveEventTopics();
+                std::vector<LogsBloom::Bits> topic_bits = LogsBloom::bitsOf(topics);
+                uint64_t scanned = 0, bloom_hits = 0;
+
                 // Scan last 100 blocks for potential pool addresses
                 for (uint64_t i = 0; i < 100 && i < latest_block; i++)
                 {
@@ -189,32 +213,33 @@ public:
                     try
                     {
                         json block_response = call("eth_getBlockByNumber", {ss.str(), false});
-                        if (block_response.contains("result") && block_response["result"].contains("transactions"))
+                        if (!block_response.contains("result") || !block_response["result"].is_object())
+                            continue;
+                        scanned++;
+
+                        // A block whose bloom rules out every Curve event can't hold a pool
+                        LogsBloom bloom;
+                        if (LogsBloom::parse(block_response["result"].value("logsBloom", ""), bloom) &&
+                            !bloom.mayContainAny(topic_bits))
+                            continue;
+                        bloom_hits++;
+
+                        json filter = {{"fromBlock", ss.str()}, {"toBlock", ss.str()}, {"topics", json::array({topics})}};
+                        json logs_response = call("eth_getLogs", json::array({filter}));
+                        if (!logs_response.contains("result") || !logs_response["result"].is_array())
+                            continue;
+                        for (const auto &log : logs_response["result"])
                         {
-                            auto transactions = block_response["result"]["transactions"];
-                            for (const auto &tx : transactions)
-                            {
-                                if (tx.contains("to") && !tx["to"].is_null())
-                                {
-                                    std::string to_address = tx["to"];
-                                    if (to_address.length() == 42)
-                                    {
-                                        // Check if this address might be a pool
-                                        if (isContract(to_address))
-                                        {
-                                            uint64_t usdc_balance = getTokenBalance(to_address, SepoliaConfig::Tokens::USDC);
-                                            if (usdc_balance > 1000000)
-                                            { // More than 1 USDC
-                                                std::cout << "    🎯 Found potential pool in block " << block_num
-                                                          << ": " << to_address << " (USDC: " << usdc_balance << ")" << std::endl;
-                                                if (std::find(pools.begin(), pools.end(), to_address) == pools.end())
-                                                {
-                                                    pools.push_back(to_address);
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
+                            std::string emitter = log.value("address", "");
+                            if (emitter.length() != 42 || std::find(pools.begin(), pools.end(), emitter) != pools.end())
+                                continue;
+
+                            uint64_t usdc_balance = getTokenBalance(emitter, SepoliaConfig::Tokens::USDC);
+                            if (usdc_balance > 1000000)
+                            { // More than 1 USDC
+                                std::cout << "    🎯 Found potential pool in block " << block_num
+                                          << ": " << emitter << " (USDC: " << usdc_balance << ")" << std::endl;
+                                pools.push_back(emitter);
                             }
                         }
                     }
@@ -224,6 +249,9 @@ public:
                         continue;
                     }
                 }
+
+                std::cout << "  Bloom prefilter: " << bloom_hits << " of " << scanned
+                          << " blocks needed their logs fetched" << std::endl;
             }
         }
         catch (const std::exception &e)
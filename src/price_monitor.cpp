@@ -5,7 +5,10 @@
 #include <thread>
 #include <vector>
 #include <iomanip>
+#include <mutex>
+#include <condition_variable>
 #include "../include/sepolia_config.h"
+#include "../include/ws_subscriber.h"
 
 using json = nlohmann::json;
 
@@ -187,6 +190,25 @@ public:
         }
     }
 
+    void reportPrice(int poll_count, uint64_t current_output, uint64_t last_price)
+    {
+        auto now = std::chrono::system_clock::now();
+        auto time_t = std::chrono::system_clock::to_time_t(now);
+
+        std::cout << "[" << std::put_time(std::localtime(&time_t), "%H:%M:%S") << "] "
+                  << "Poll #" << poll_count << " | "
+                  << "Input: " << test_amount << " -> "
+                  << "Output: " << current_output;
+
+        if (last_price > 0 && current_output > 0)
+        {
+            double price_change = ((static_cast<double>(current_output) - static_cast<double>(last_price)) / static_cast<double>(last_price)) * 100.0;
+            std::cout << " | Change: " << std::fixed << std::setprecision(4) << price_change << "%";
+        }
+
+        std::cout << std::endl;
+    }
+
     // Start monitoring prices in a loop
     void startMonitoring(int duration_seconds = 60, int poll_interval_ms = 1000)
     {
@@ -212,46 +234,93 @@ public:
                 recordPrice(current_output);
 
                 poll_count++;
+                reportPrice(poll_count, current_output, last_price);
+                last_price = current_output;
 
-                // Calculate price change
-                double price_change = 0.0;
-                if (last_price > 0 && current_output > 0)
-                {
-                    price_change = ((static_cast<double>(current_output) - static_cast<double>(last_price)) / static_cast<double>(last_price)) * 100.0;
-                }
+                // Sleep for the specified interval
+                std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Price monitoring error: " << e.what() << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+            }
+        }
 
-                // Print current price info
-                auto now = std::chrono::system_clock::now();
-                auto time_t = std::chrono::system_clock::to_time_t(now);
+        monitoring = false;
+        std::cout << "\n=== Price Monitoring Complete ===" << std::endl;
+        std::cout << "Total polls: " << poll_count << std::endl;
+        std::cout << "Price history size: " << price_history.size() << std::endl;
+    }
 
-                std::cout << "[" << std::put_time(std::localtime(&time_t), "%H:%M:%S") << "] "
-                          << "Poll #" << poll_count << " | "
-                          << "Input: " << test_amount << " -> "
-                          << "Output: " << current_output;
+    // Push-driven monitoring: re-quote when a new head arrives and the pool logged a swap or
+    // liquidity change since the last quote, instead of polling on a timer
+    void startStreaming(const std::string &ws_url, int duration_seconds = 60)
+    {
+        std::cout << "\n=== Starting Streaming Price Monitor ===" << std::endl;
+        std::cout << "Pool: " << pool_address << std::endl;
+        std::cout << "Feed: " << ws_url << std::endl;
+
+        std::mutex head_mutex;
+        std::condition_variable head_cv;
+        uint64_t latest_head = 0;
+        PoolActivity activity;
 
-                if (last_price > 0)
+        WebSocketSubscriber subscriber(
+            ws_url, {pool_address},
+            [&](const NewHead &head)
+            {
                 {
-                    std::cout << " | Change: " << std::fixed << std::setprecision(4) << price_change << "%";
+                    std::lock_guard<std::mutex> lock(head_mutex);
+                    latest_head = std::max(latest_head, head.number);
                 }
+                head_cv.notify_one();
+            },
+            [&activity](const PoolLog &log)
+            { activity.record(log.address, log.block_number); });
+        subscriber.start();
 
-                std::cout << std::endl;
+        monitoring = true;
+        auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(duration_seconds);
+        int poll_count = 0;
+        uint64_t last_price = 0;
+        uint64_t seen_head = 0;
+        uint64_t quoted_at = 0;
 
-                last_price = current_output;
+        while (monitoring)
+        {
+            {
+                std::unique_lock<std::mutex> lock(head_mutex);
+                if (!head_cv.wait_until(lock, end_time, [&]
+                                        { return latest_head > seen_head; }))
+                    break;
+                seen_head = latest_head;
+            }
 
-                // Sleep for the specified interval
-                std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+            if (poll_count > 0 && !activity.changedSince(pool_address, quoted_at))
+                continue; // Pool state untouched since the last quote
+
+            try
+            {
+                quoted_at = seen_head;
+                uint64_t current_output = getCurrentPrice();
+                recordPrice(current_output);
+                poll_count++;
+                std::cout << "Block " << seen_head << " ";
+                reportPrice(poll_count, current_output, last_price);
+                last_price = current_output;
             }
             catch (const std::exception &e)
             {
                 std::cerr << "Price monitoring error: " << e.what() << std::endl;
-                std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
             }
         }
 
         monitoring = false;
-        std::cout << "\n=== Price Monitoring Complete ===" << std::endl;
-        std::cout << "Total polls: " << poll_count << std::endl;
-        std::cout << "Price history size: " << price_history.size() << std::endl;
+        subscriber.stop();
+        std::cout << "\n=== Streaming Price Monitor Complete ===" << std::endl;
+        std::cout << "Heads: " << subscriber.headsReceived() << ", pool logs: " << subscriber.logsReceived()
+                  << ", quotes: " << poll_count << std::endl;
     }
 
     // Stop monitoring
@@ -427,7 +496,11 @@ int main(int argc, char **argv)
 
         try
         {
-            monitor.startMonitoring(10, 2000); // 10 seconds, poll every 2 seconds
+            // WS_URL (ws://) switches from timer polling to the node's newHeads/logs feed
+            if (const std::string ws_url = getenv_str("WS_URL"); WebSocketSubscriber::supportsUrl(ws_url))
+                monitor.startStreaming(ws_url, 60);
+            else
+                monitor.startMonitoring(10, 2000); // 10 seconds, poll every 2 seconds
             monitor.printPriceStats();
         }
         catch (const std::exception &e)
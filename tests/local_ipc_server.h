@@ -0,0 +1,164 @@
+#ifndef LOCAL_IPC_SERVER_H
+#define LOCAL_IPC_SERVER_H
+
+// Local stand-in for a node's IPC socket (tests only). Listens on a Unix socket under /tmp,
+// one thread per connection. Every complete message in a read is answered in REVERSE order,
+// so clients must match replies by id rather than by position.
+
+#include "../include/ipc_transport.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+class LocalIpcServer
+{
+public:
+    using Handler = std::function<std::string(const std::string &body)>;
+
+private:
+    Handler handler;
+    std::string socket_path;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> connections{0};
+    std::thread acceptor;
+    std::mutex clients_mutex;
+    std::vector<std::thread> clients;
+    std::vector<int> client_fds;
+    size_t close_after = 0; // Close each connection after this many requests (0 = never)
+
+    static bool sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    void serve(int fd)
+    {
+        JsonStreamFramer framer;
+        char chunk[16384];
+        size_t served = 0;
+        std::string message;
+        while (!stopping)
+        {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                break;
+            framer.append(chunk, static_cast<size_t>(n));
+
+            std::vector<std::string> replies;
+            while (framer.next(message))
+                replies.push_back(handler(message));
+            requests += replies.size();
+            served += replies.size();
+
+            // Replies written back to back with no separator, last request first
+            std::string outgoing;
+            for (auto it = replies.rbegin(); it != replies.rend(); ++it)
+                outgoing += *it;
+            if (!sendAll(fd, outgoing) || (close_after > 0 && served >= close_after))
+            {
+                ::shutdown(fd, SHUT_RDWR);
+                return;
+            }
+        }
+    }
+
+    void acceptLoop()
+    {
+        while (!stopping)
+        {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+                break;
+            connections++;
+
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            client_fds.push_back(fd);
+            clients.emplace_back(&LocalIpcServer::serve, this, fd);
+        }
+    }
+
+public:
+    explicit LocalIpcServer(Handler reply) : handler(std::move(reply))
+    {
+        static std::atomic<int> instances{0};
+        socket_path = "/tmp/curve_agent_test_" + std::to_string(::getpid()) + "_" + std::to_string(instances++) + ".ipc";
+        ::unlink(socket_path.c_str());
+
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd, 64) != 0)
+            throw std::runtime_error(std::string("IPC stand-in server: ") + std::strerror(errno));
+        acceptor = std::thread(&LocalIpcServer::acceptLoop, this);
+    }
+
+    ~LocalIpcServer()
+    {
+        stopping = true;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (int fd : client_fds)
+            ::shutdown(fd, SHUT_RDWR);
+        for (auto &client : clients)
+            client.join();
+        for (int fd : client_fds)
+            ::close(fd);
+        ::unlink(socket_path.c_str());
+    }
+
+    void closeAfter(size_t request_count)
+    {
+        close_after = request_count;
+    }
+
+    // Push a message to every connected client (e.g. a subscription notification)
+    void broadcast(const std::string &message)
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (int fd : client_fds)
+            sendAll(fd, message);
+    }
+
+    const std::string &path() const
+    {
+        return socket_path;
+    }
+
+    uint64_t requestCount() const
+    {
+        return requests.load();
+    }
+
+    uint64_t connectionCount() const
+    {
+        return connections.load();
+    }
+};
+
+#endif // LOCAL_IPC_SERVER_H
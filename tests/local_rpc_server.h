@@ -0,0 +1,212 @@
+#ifndef LOCAL_RPC_SERVER_H
+#define LOCAL_RPC_SERVER_H
+
+// Local stand-in for a node's HTTP JSON-RPC endpoint (tests and benchmarks only).
+// Keep-alive HTTP/1.1 on 127.0.0.1, one thread per connection, requests answered in order
+// so pipelined clients can be exercised. Replies come from a handler on the raw body.
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+class LocalRpcServer
+{
+public:
+    using Handler = std::function<std::string(const std::string &body)>;
+
+private:
+    Handler handler;
+    int listen_fd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> connections{0};
+    std::thread acceptor;
+    std::mutex clients_mutex;
+    std::vector<std::thread> clients;
+    std::vector<int> client_fds;
+    bool chunked_replies = false;
+    size_t close_after = 0; // Close each connection after this many requests (0 = never)
+
+    static bool sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    std::string frame(const std::string &body, bool close) const
+    {
+        std::string reply = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n";
+        if (close)
+            reply += "Connection: close\r\n";
+        if (!chunked_replies)
+        {
+            reply += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            return reply;
+        }
+
+        // Two chunks so clients have to stitch the body back together
+        size_t half = body.size() / 2;
+        char size_line[32];
+        reply += "Transfer-Encoding: chunked\r\n\r\n";
+        std::snprintf(size_line, sizeof(size_line), "%zx\r\n", half);
+        reply += size_line + body.substr(0, half) + "\r\n";
+        std::snprintf(size_line, sizeof(size_line), "%zx\r\n", body.size() - half);
+        reply += size_line + body.substr(half) + "\r\n0\r\n\r\n";
+        return reply;
+    }
+
+    void serve(int fd)
+    {
+        std::string buffer;
+        char chunk[16384];
+        size_t served = 0;
+        while (!stopping)
+        {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                break;
+            buffer.append(chunk, static_cast<size_t>(n));
+
+            // Answer every complete request in the buffer, in order
+            while (true)
+            {
+                size_t header_end = buffer.find("\r\n\r\n");
+                if (header_end == std::string::npos)
+                    break;
+                size_t length_at = buffer.find("Content-Length: ");
+                size_t length = length_at < header_end ? std::stoul(buffer.substr(length_at + 16)) : 0;
+                if (buffer.size() < header_end + 4 + length)
+                    break;
+
+                std::string body = buffer.substr(header_end + 4, length);
+                buffer.erase(0, header_end + 4 + length);
+                requests++;
+                served++;
+
+                bool close = close_after > 0 && served >= close_after;
+                if (!sendAll(fd, frame(handler(body), close)) || close)
+                {
+                    ::shutdown(fd, SHUT_RDWR);
+                    return;
+                }
+            }
+        }
+    }
+
+    void acceptLoop()
+    {
+        while (!stopping)
+        {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+                break;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connections++;
+
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            client_fds.push_back(fd);
+            clients.emplace_back(&LocalRpcServer::serve, this, fd);
+        }
+    }
+
+public:
+    explicit LocalRpcServer(Handler reply) : handler(std::move(reply))
+    {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0; // Ephemeral
+        if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd, 64) != 0)
+            throw std::runtime_error(std::string("stand-in server: ") + std::strerror(errno));
+
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd, reinterpret_cast<sockaddr *>(&address), &length);
+        port = ntohs(address.sin_port);
+        acceptor = std::thread(&LocalRpcServer::acceptLoop, this);
+    }
+
+    ~LocalRpcServer()
+    {
+        stopping = true;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (int fd : client_fds)
+            ::shutdown(fd, SHUT_RDWR);
+        for (auto &client : clients)
+            client.join();
+        for (int fd : client_fds)
+            ::close(fd);
+    }
+
+    // Must be set before clients connect
+    void useChunkedReplies(bool chunked)
+    {
+        chunked_replies = chunked;
+    }
+
+    void closeAfter(size_t request_count)
+    {
+        close_after = request_count;
+    }
+
+    std::string url() const
+    {
+        return "http://127.0.0.1:" + std::to_string(port) + "/";
+    }
+
+    uint64_t requestCount() const
+    {
+        return requests.load();
+    }
+
+    uint64_t connectionCount() const
+    {
+        return connections.load();
+    }
+
+    // Echo the request's JSON-RPC id back with a fixed result, without a JSON library
+    static std::string echoIdReply(const std::string &body, const std::string &result)
+    {
+        size_t id_at = body.find("\"id\":");
+        std::string id = "1";
+        if (id_at != std::string::npos)
+        {
+            size_t start = id_at + 5;
+            size_t end = body.find_first_of(",}", start);
+            id = body.substr(start, end - start);
+        }
+        return "{\"id\":" + id + ",\"jsonrpc\":\"2.0\",\"result\":\"" + result + "\"}";
+    }
+};
+
+#endif // LOCAL_RPC_SERVER_H
@@ -0,0 +1,346 @@
+#ifndef LOCAL_WS_SERVER_H
+#define LOCAL_WS_SERVER_H
+
+// Local stand-in for a node's WebSocket JSON-RPC endpoint (tests only). Accepts the upgrade,
+// answers eth_subscribe for newHeads / logs, and lets the test push notifications, fragment
+// them around a ping, send malformed or oversized messages, or drop every connection to
+// exercise reconnect and resubscribe.
+// The Sec-WebSocket-Accept value is a placeholder; the client only checks for 101.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+class LocalWsServer
+{
+private:
+    struct Client
+    {
+        int fd = -1;
+        std::mutex write_mutex;
+        std::string heads_subscription;
+        std::string logs_subscription;
+        std::string logs_filter;
+    };
+
+    int listen_fd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> connections{0};
+    std::atomic<uint64_t> subscribes{0};
+    std::atomic<uint64_t> pongs{0};
+    std::atomic<bool> fragment_notifications{false};
+    std::atomic<bool> reject_logs{false};
+    std::thread acceptor;
+    std::mutex clients_mutex;
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<std::thread> threads;
+
+    static bool sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Server frames are unmasked
+    static std::string frame(uint8_t first_byte, const std::string &payload)
+    {
+        std::string out(1, static_cast<char>(first_byte));
+        if (payload.size() < 126)
+        {
+            out.push_back(static_cast<char>(payload.size()));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(126));
+            out.push_back(static_cast<char>(payload.size() >> 8));
+            out.push_back(static_cast<char>(payload.size() & 0xFF));
+        }
+        return out + payload;
+    }
+
+    void sendText(Client &client, const std::string &payload)
+    {
+        std::lock_guard<std::mutex> lock(client.write_mutex);
+        if (!fragment_notifications)
+        {
+            sendAll(client.fd, frame(0x81, payload));
+            return;
+        }
+        // Text start, a ping in between, then the final continuation
+        size_t half = payload.size() / 2;
+        sendAll(client.fd, frame(0x01, payload.substr(0, half)) + frame(0x89, "hb") + frame(0x80, payload.substr(half)));
+    }
+
+    void onText(Client &client, const std::string &text)
+    {
+        size_t id_at = text.find("\"id\":");
+        std::string id = id_at == std::string::npos ? "0" : text.substr(id_at + 5, text.find_first_of(",}", id_at) - id_at - 5);
+        std::string subscription = "0x" + std::to_string(connections.load()) + (text.find("newHeads") != std::string::npos ? "a" : "b");
+        subscribes++;
+        if (reject_logs && text.find("newHeads") == std::string::npos)
+        {
+            sendText(client, "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"error\":{\"code\":-32602,\"message\":\"filter not supported\"}}");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            if (text.find("newHeads") != std::string::npos)
+            {
+                client.heads_subscription = subscription;
+            }
+            else
+            {
+                client.logs_subscription = subscription;
+                client.logs_filter = text;
+            }
+        }
+        sendText(client, "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"result\":\"" + subscription + "\"}");
+    }
+
+    void serve(std::shared_ptr<Client> client)
+    {
+        std::string buffer;
+        char chunk[16384];
+        bool upgraded = false;
+        while (!stopping)
+        {
+            ssize_t n = ::recv(client->fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                break;
+            buffer.append(chunk, static_cast<size_t>(n));
+
+            if (!upgraded)
+            {
+                size_t header_end = buffer.find("\r\n\r\n");
+                if (header_end == std::string::npos)
+                    continue;
+                buffer.erase(0, header_end + 4);
+                upgraded = true;
+                std::lock_guard<std::mutex> lock(client->write_mutex);
+                sendAll(client->fd, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                    "Sec-WebSocket-Accept: stand-in\r\n\r\n");
+            }
+
+            // Client frames: always masked, small enough for 7- or 16-bit lengths here
+            while (buffer.size() >= 6)
+            {
+                const unsigned char *bytes = reinterpret_cast<const unsigned char *>(buffer.data());
+                uint8_t opcode = bytes[0] & 0x0F;
+                size_t length = bytes[1] & 0x7F;
+                size_t header = 2;
+                if (length == 126)
+                {
+                    length = (static_cast<size_t>(bytes[2]) << 8) | bytes[3];
+                    header = 4;
+                }
+                if (buffer.size() < header + 4 + length)
+                    break;
+                std::string payload = buffer.substr(header + 4, length);
+                for (size_t k = 0; k < length; ++k)
+                    payload[k] ^= buffer[header + (k % 4)];
+                buffer.erase(0, header + 4 + length);
+
+                if (opcode == 0x1)
+                    onText(*client, payload);
+                else if (opcode == 0xA)
+                    pongs++;
+                else if (opcode == 0x8)
+                    return;
+            }
+        }
+    }
+
+    void acceptLoop()
+    {
+        while (!stopping)
+        {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+                break;
+            connections++;
+
+            auto client = std::make_shared<Client>();
+            client->fd = fd;
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            clients.push_back(client);
+            threads.emplace_back(&LocalWsServer::serve, this, client);
+        }
+    }
+
+public:
+    LocalWsServer()
+    {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0; // Ephemeral
+        if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd, 64) != 0)
+            throw std::runtime_error(std::string("WS stand-in server: ") + std::strerror(errno));
+
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd, reinterpret_cast<sockaddr *>(&address), &length);
+        port = ntohs(address.sin_port);
+        acceptor = std::thread(&LocalWsServer::acceptLoop, this);
+    }
+
+    ~LocalWsServer()
+    {
+        stopping = true;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            for (auto &client : clients)
+                ::shutdown(client->fd, SHUT_RDWR);
+        }
+        // Joined unlocked: a serving thread may be waiting on clients_mutex
+        for (auto &thread : threads)
+            thread.join();
+        for (auto &client : clients)
+            ::close(client->fd);
+    }
+
+    std::string url() const
+    {
+        return "ws://127.0.0.1:" + std::to_string(port) + "/";
+    }
+
+    void fragmentNotifications(bool fragment)
+    {
+        fragment_notifications = fragment;
+    }
+
+    // Answer logs subscriptions with an error, as a provider without log filters would
+    void rejectLogs(bool reject)
+    {
+        reject_logs = reject;
+    }
+
+    // Notify every subscribed client of a new head (with a logsBloom if one is given)
+    void pushHead(uint64_t number, const std::string &logs_bloom = "")
+    {
+        char hex[32];
+        std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(number));
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto &client : clients)
+        {
+            if (client->heads_subscription.empty())
+                continue;
+            sendText(*client, "{\"jsonrpc\":\"2.0\",\"method\":\"eth_subscription\",\"params\":{\"subscription\":\"" +
+                                  client->heads_subscription + "\",\"result\":{\"number\":\"" + hex +
+                                  "\",\"hash\":\"0xh" + std::to_string(number) + "\",\"parentHash\":\"0xh" +
+                                  std::to_string(number - 1) + "\"" +
+                                  (logs_bloom.empty() ? "" : ",\"logsBloom\":\"" + logs_bloom + "\"") + "}}}");
+        }
+    }
+
+    // Notify every logs subscriber of a log on `pool`
+    void pushLog(const std::string &pool, uint64_t block, const std::string &topic0, bool removed = false)
+    {
+        char hex[32];
+        std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(block));
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto &client : clients)
+        {
+            if (client->logs_subscription.empty())
+                continue;
+            sendText(*client, "{\"jsonrpc\":\"2.0\",\"method\":\"eth_subscription\",\"params\":{\"subscription\":\"" +
+                                  client->logs_subscription + "\",\"result\":{\"address\":\"" + pool +
+                                  "\",\"topics\":[\"" + topic0 + "\"],\"data\":\"0x01\",\"blockNumber\":\"" + hex +
+                                  "\",\"blockHash\":\"0xh" + std::to_string(block) +
+                                  "\",\"transactionHash\":\"0xt1\",\"logIndex\":\"0x2\",\"removed\":" +
+                                  (removed ? "true" : "false") + "}}}");
+        }
+    }
+
+    // Notify every heads (or logs) subscriber with a hand-written result, e.g. a malformed one
+    void pushResult(bool logs, const std::string &result)
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto &client : clients)
+        {
+            const std::string &subscription = logs ? client->logs_subscription : client->heads_subscription;
+            if (subscription.empty())
+                continue;
+            sendText(*client, "{\"jsonrpc\":\"2.0\",\"method\":\"eth_subscription\",\"params\":{\"subscription\":\"" +
+                                  subscription + "\",\"result\":" + result + "}}");
+        }
+    }
+
+    // Announce a text frame of `length` bytes with a 64-bit length and send none of it
+    void pushFrameHeader(uint64_t length)
+    {
+        std::string header(1, static_cast<char>(0x81));
+        header.push_back(static_cast<char>(127));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            header.push_back(static_cast<char>((length >> shift) & 0xFF));
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto &client : clients)
+        {
+            std::lock_guard<std::mutex> write_lock(client->write_mutex);
+            sendAll(client->fd, header);
+        }
+    }
+
+    // Drop every open connection (clients should reconnect and resubscribe)
+    void dropClients()
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto &client : clients)
+        {
+            ::shutdown(client->fd, SHUT_RDWR);
+            client->heads_subscription.clear();
+            client->logs_subscription.clear();
+        }
+    }
+
+    std::string lastLogsFilter()
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        return clients.empty() ? std::string() : clients.back()->logs_filter;
+    }
+
+    uint64_t connectionCount() const
+    {
+        return connections.load();
+    }
+
+    uint64_t subscribeCount() const
+    {
+        return subscribes.load();
+    }
+
+    uint64_t pongCount() const
+    {
+        return pongs.load();
+    }
+};
+
+#endif // LOCAL_WS_SERVER_H
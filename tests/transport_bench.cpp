@@ -0,0 +1,78 @@
+// Benchmark: raw epoll HTTP/1.1 transport vs libcurl against the local stand-in node.
+// Usage: ./build/transport_bench [requests]
+
+#include <curl/curl.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../include/http_transport.h"
+#include "local_rpc_server.h"
+
+static size_t collect(void *contents, size_t size, size_t nmemb, std::string *response)
+{
+    response->append(static_cast<char *>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+template <typename Fn>
+static double timeMicrosPerRequest(size_t requests, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(requests);
+}
+
+int main(int argc, char **argv)
+{
+    size_t requests = argc > 1 ? std::stoul(argv[1]) : 5000;
+    const size_t pipeline_depth = 50;
+    const std::string body = R"({"jsonrpc":"2.0","method":"eth_call","params":[{"to":"0xbEbc44782C7dB0a1A60Cb6fe97d0b483032FF1C7","data":"0x5e0d443f"},"latest"],"id":1})";
+
+    LocalRpcServer server([](const std::string &request)
+                          { return LocalRpcServer::echoIdReply(request, "0x00000000000000000000000000000000000000000000000000000000000f3e58"); });
+
+    std::cout << "⏱️  RPC TRANSPORT BENCHMARK (" << requests << " requests to " << server.url() << ")" << std::endl;
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    CURL *curl = curl_easy_init();
+    struct curl_slist *headers = curl_slist_append(nullptr, "Content-Type: application/json");
+    std::string url = server.url();
+    double curl_us = timeMicrosPerRequest(requests, [&]
+                                          {
+        for (size_t k = 0; k < requests; ++k)
+        {
+            std::string response;
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, collect);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+            curl_easy_perform(curl);
+        } });
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    curl_global_cleanup();
+
+    HttpTransport transport(url);
+    double raw_us = timeMicrosPerRequest(requests, [&]
+                                         {
+        for (size_t k = 0; k < requests; ++k)
+            transport.post(body); });
+
+    std::vector<std::string> batch(pipeline_depth, body);
+    double pipelined_us = timeMicrosPerRequest(requests, [&]
+                                               {
+        for (size_t k = 0; k < requests; k += pipeline_depth)
+            transport.pipeline(batch); });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  curl (keep-alive easy handle): " << curl_us << " us/request" << std::endl;
+    std::cout << "  epoll raw HTTP/1.1:            " << raw_us << " us/request (" << curl_us / raw_us << "x)" << std::endl;
+    std::cout << "  epoll pipelined x" << pipeline_depth << ":           " << pipelined_us << " us/request ("
+              << curl_us / pipelined_us << "x)" << std::endl;
+    return 0;
+}
@@ -1,5 +1,37 @@
 #include "../include/limit_order.h"
 #include "../include/transaction_signer.h"
+#include "../include/allowance_tracker.h"
+#include "../include/gas_oracle.h"
+#include "../include/gas_model.h"
+#include "../include/order_aggregator.h"
+#include "../include/slice_scheduler.h"
+#include "../include/order_shards.h"
+#include "../include/work_stealing_executor.h"
+#include "../include/order_coroutines.h"
+#include "../include/http_transport.h"
+#include "../include/ipc_transport.h"
+#include "../include/ws_subscriber.h"
+#include "../include/keccak.h"
+#include "../include/pool_state.h"
+#include "../include/stableswap_math.h"
+#include "../include/trigger_index.h"
+#include "../include/logs_bloom.h"
+#include "../include/rpc_scheduler.h"
+#include "../include/single_flight.h"
+#include "../include/poll_scheduler.h"
+#include "../include/impact_curve.h"
+#include "../include/cryptoswap_math.h"
+#include "../include/metapool_math.h"
+#include "../include/swap_simulator.h"
+#include "../include/rpc_deadline.h"
+#include "../include/retry_policy.h"
+#include "../include/circuit_breaker.h"
+#include "../include/runtime_config.h"
+#include "../include/nonce_allocator.h"
+#include "../include/curve_selectors.h"
+#include "local_rpc_server.h"
+#include "local_ipc_server.h"
+#include "local_ws_server.h"
 #include <iostream>
 #include <cassert>
 #include <vector>
@@ -264,6 +296,1824 @@ void test_partial_fill_logic(TestFramework &tf)
     tf.assert_equal("Max Fillable at Bad Price", static_cast<uint64_t>(0), max_fillable);
 }
 
+void test_allowance_tracker(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Allowance Tracker" << std::endl;
+
+    int approvals = 0;
+    AllowanceTracker tracker([&approvals](const std::string &, const std::string &, uint64_t)
+                             {
+                                 approvals++;
+                                 return std::string("0xapprove");
+                             });
+
+    tf.assert_false("Unknown Allowance Not Spendable", tracker.canSpend("0xToken", "0xPool", 1000));
+
+    // Reserving spend triggers one background top-up with headroom
+    tracker.reserve("0xToken", "0xPool", 1000);
+    tracker.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("One Approval Sent", 1, approvals);
+    tf.assert_true("Allowance Covers Order", tracker.canSpend("0xTOKEN", "0xpool", 1000));
+    tf.assert_equal("Allowance Includes Headroom", static_cast<uint64_t>(4000), tracker.getAllowance("0xToken", "0xPool"));
+
+    // A second order within the headroom needs no new approval
+    tracker.reserve("0xToken", "0xPool", 1000);
+    tracker.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Headroom Avoids Re-Approval", 1, approvals);
+
+    // Spending decrements the cached allowance without any I/O
+    tracker.recordSpend("0xToken", "0xPool", 1000);
+    tracker.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Spend Recorded", static_cast<uint64_t>(3000), tracker.getAllowance("0xToken", "0xPool"));
+
+    // Seeded allowances skip the approve entirely
+    tracker.setAllowance("0xOther", "0xPool", 5000);
+    tracker.reserve("0xOther", "0xPool", 2000);
+    tracker.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Seeded Allowance Needs No Approval", 1, approvals);
+
+    // Forgetting drops cached (e.g. mock-approved) allowances; committed spend is re-read from chain
+    std::atomic<uint64_t> on_chain{0};
+    std::atomic<int> reads{0};
+    AllowanceTracker reading([&approvals](const std::string &, const std::string &, uint64_t)
+                             {
+                                 approvals++;
+                                 return std::string("0xapprove");
+                             },
+                             [&](const std::string &, const std::string &)
+                             {
+                                 reads++;
+                                 return on_chain.load();
+                             });
+    reading.reserve("0xToken", "0xPool", 1000);
+    reading.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Phantom Allowance Cached", static_cast<uint64_t>(4000), reading.getAllowance("0xToken", "0xPool"));
+
+    on_chain = 2500;
+    reading.forgetAll();
+    tf.assert_false("Phantom Headroom Gone", reading.canSpend("0xToken", "0xPool", 3000));
+    reading.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Allowance Re-Read", 2, reads.load());
+    tf.assert_equal("Re-Read Allowance Replaces Phantom", static_cast<uint64_t>(2500), reading.getAllowance("0xToken", "0xPool"));
+    tf.assert_equal("Covered Re-Read Needs No Approval", 2, approvals);
+}
+
+void test_gas_oracle(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Gas Oracle" << std::endl;
+
+    GasOracle oracle;
+
+    // Before any sample, quotes fall back to static config
+    FeeQuote fallback = oracle.quote(FeeUrgency::IMMEDIATE);
+    tf.assert_equal("Fallback Max Fee", SepoliaConfig::Gas::DEFAULT_GAS_PRICE, fallback.max_fee_per_gas);
+    tf.assert_equal("Fallback Block", static_cast<uint64_t>(0), fallback.block_number);
+
+    FeeHistory history;
+    history.newest_block = 100;
+    history.next_base_fee = 10000000000; // 10 gwei
+    history.passive_tips = {1000000000, 2000000000, 3000000000};
+    history.urgent_tips = {4000000000, 5000000000, 6000000000};
+    oracle.update(history);
+
+    FeeQuote urgent = oracle.quote(urgencyForTif(TimeInForce::IOC));
+    FeeQuote passive = oracle.quote(urgencyForTif(TimeInForce::GTC));
+    tf.assert_equal("Urgent Tip Uses High Percentile", static_cast<uint64_t>(5000000000), urgent.max_priority_fee_per_gas);
+    tf.assert_equal("Urgent Max Fee", static_cast<uint64_t>(25000000000), urgent.max_fee_per_gas);
+    tf.assert_equal("Passive Tip Floored", static_cast<uint64_t>(2000000000), passive.max_priority_fee_per_gas);
+    tf.assert_equal("Passive Max Fee", static_cast<uint64_t>(14500000000), passive.max_fee_per_gas);
+    tf.assert_true("FOK Is Urgent", urgencyForTif(TimeInForce::FOK) == FeeUrgency::IMMEDIATE);
+
+    // Same block again is ignored
+    history.next_base_fee = 1;
+    oracle.update(history);
+    tf.assert_equal("Stale Block Ignored", static_cast<uint64_t>(100), oracle.quote(FeeUrgency::PASSIVE).block_number);
+    tf.assert_equal("Stale Block Keeps Fees", static_cast<uint64_t>(25000000000), oracle.quote(FeeUrgency::IMMEDIATE).max_fee_per_gas);
+
+    // EIP-1559 fees make it into the signed transaction
+    TransactionSigner signer("test_private_key_123");
+    EthereumTransaction tx;
+    tx.to_address = "0x1234567890123456789012345678901234567890";
+    tx.max_fee_per_gas = urgent.max_fee_per_gas;
+    tx.max_priority_fee_per_gas = urgent.max_priority_fee_per_gas;
+    tf.assert_true("Type 2 Transaction", tx.isEip1559());
+    tf.assert_true("Type 2 Encoding", signer.signTransaction(tx).find("02:") != std::string::npos);
+}
+
+void test_gas_model(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Gas Model" << std::endl;
+
+    int estimates = 0;
+    GasModel model(
+        [&estimates](const std::string &, const std::string &)
+        {
+            estimates++;
+            return static_cast<uint64_t>(150000);
+        },
+        [](const std::string &tx_hash, uint64_t &gas_used)
+        {
+            gas_used = tx_hash == "0xmined" ? 120000 : 0;
+            return tx_hash == "0xmined" || tx_hash == "0xreverted"; // Reverted: mined, nothing to learn
+        },
+        std::chrono::milliseconds(10));
+
+    std::string swap_data = "0x394747c5" + std::string(64 * 5, '0');
+
+    // Unknown pool: static limit now, async estimate queued for next time
+    tf.assert_equal("Cold Limit Is Static", SepoliaConfig::Gas::SWAP_GAS_LIMIT, model.gasLimit("0xPool", swap_data));
+    model.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("One Estimate Issued", 1, estimates);
+    tf.assert_equal("Estimate Limit Padded", static_cast<uint64_t>(180000), model.gasLimit("0xPool", swap_data));
+    tf.assert_equal("Estimate Cached Per Pool", 1, estimates);
+
+    // Receipts replace the estimate once enough samples exist
+    model.recordGasUsed("0xPool", swap_data, 100000);
+    model.recordGasUsed("0xPool", swap_data, 100000);
+    model.trackReceipt("0xPool", swap_data, "0xmined");
+    model.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Receipt Sample Recorded", static_cast<uint64_t>(3), model.sampleCount("0xPool", "0x394747c5"));
+    model.trackReceipt("0xPool", swap_data, "0xreverted");
+    model.waitIdle(std::chrono::seconds(2));
+    tf.assert_equal("Reverted Receipt Not Learned", static_cast<uint64_t>(3), model.sampleCount("0xPool", "0x394747c5"));
+
+    uint64_t learned = model.gasLimit("0xPool", swap_data);
+    tf.assert_true("Learned Limit Covers Max", learned >= 132000);
+    tf.assert_true("Learned Limit Below Static", learned < SepoliaConfig::Gas::SWAP_GAS_LIMIT);
+}
+
+void test_order_aggregation(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Order Netting and Aggregation" << std::endl;
+
+    auto makeOrder = [](const std::string &id, int32_t in, int32_t out, uint64_t amount, double limit)
+    {
+        auto order = OrderFactory::createGTC(id, "0xA", "0xB", amount, limit, 0.01, "0xUser", "key");
+        order->pool_address = "0xPool";
+        order->input_token_index = in;
+        order->output_token_index = out;
+        order->updateStatus(OrderStatus::ACTIVE);
+        return order;
+    };
+
+    int quotes = 0;
+    OrderAggregator::Quoter quoter = [&quotes](const std::string &, int32_t, int32_t, uint64_t dx)
+    {
+        quotes++;
+        return dx * 99 / 100;
+    };
+
+    // Same direction: coalesced into one exchange, proceeds split pro rata
+    auto a = makeOrder("A", 0, 1, 1000, 0.98);
+    auto b = makeOrder("B", 0, 1, 3000, 0.98);
+    OrderAggregator aggregator;
+    AggregationResult same = aggregator.aggregate({{a.get(), 990}, {b.get(), 2970}}, quoter);
+    tf.assert_equal("Same Direction One Swap", static_cast<size_t>(1), same.swaps.size());
+    tf.assert_equal("Coalesced Input", static_cast<uint64_t>(4000), same.swaps[0].dx);
+    OrderAggregator::applyFills(same.swaps[0], "0xagg");
+    tf.assert_equal("Pro Rata Small Order", static_cast<uint64_t>(990), a->received_amount);
+    tf.assert_equal("Pro Rata Large Order", static_cast<uint64_t>(2970), b->received_amount);
+    tf.assert_equal("Shared Transaction", std::string("0xagg"), b->transaction_hash);
+
+    // Opposite directions: the smaller side crosses internally, only the net goes on-chain
+    auto fwd = makeOrder("FWD", 0, 1, 1000, 0.98);
+    auto rev = makeOrder("REV", 1, 0, 400, 0.98);
+    AggregationResult netted = aggregator.aggregate({{fwd.get(), 990}, {rev.get(), 396}}, quoter);
+    tf.assert_equal("Netted One Swap", static_cast<size_t>(1), netted.swaps.size());
+    tf.assert_equal("Net Amount On Chain", static_cast<uint64_t>(600), netted.swaps[0].dx);
+    tf.assert_equal("Net Direction", 0, netted.swaps[0].input_index);
+    OrderAggregator::applyFills(netted.swaps[0], "0xnet");
+    tf.assert_equal("Reverse Fully Netted", std::string("internal-netting"), rev->transaction_hash);
+    tf.assert_equal("Reverse Output At Mid", static_cast<uint64_t>(400), rev->received_amount);
+    tf.assert_equal("Forward Gets Cross Plus Swap", static_cast<uint64_t>(994), fwd->received_amount);
+
+    // Aggregate size breaks a strict limit: that order is deferred to execute alone
+    quotes = 0;
+    OrderAggregator::Quoter steep = [&quotes](const std::string &, int32_t, int32_t, uint64_t dx)
+    {
+        quotes++;
+        return dx > 2000 ? dx * 95 / 100 : dx * 99 / 100;
+    };
+    auto loose = makeOrder("LOOSE", 0, 1, 2000, 0.90);
+    auto strict = makeOrder("STRICT", 0, 1, 2000, 0.98);
+    AggregationResult split = aggregator.aggregate({{loose.get(), 1980}, {strict.get(), 1980}}, steep);
+    tf.assert_equal("Strict Order Deferred", static_cast<size_t>(1), split.deferred.size());
+    tf.assert_equal("Deferred Is Strict", std::string("STRICT"), split.deferred[0].order->order_id);
+    tf.assert_equal("Loose Order Still Swapped", static_cast<uint64_t>(2000), split.swaps[0].dx);
+}
+
+void test_sliced_orders(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing TWAP and Iceberg Slicing" << std::endl;
+
+    SliceScheduler scheduler;
+    PriceImpactModel impact;
+    std::string key = PriceImpactModel::keyFor("0xPool", 0, 1);
+
+    // TWAP: even slices over the window, last block takes the remainder
+    auto twap = OrderFactory::createTWAP("TWAP", "0xA", "0xB", 1000000, 0.99, 0.01, 4, "0xUser", "key");
+    twap->pool_address = "0xPool";
+    twap->updateStatus(OrderStatus::ACTIVE);
+    tf.assert_true("TWAP Is Sliced", twap->isSliced());
+    scheduler.schedule(twap.get(), 10);
+
+    tf.assert_equal("Nothing Due Early", static_cast<size_t>(0), scheduler.popDue(9).size());
+    tf.assert_equal("TWAP Due At Start", static_cast<size_t>(1), scheduler.popDue(10).size());
+    tf.assert_equal("TWAP Even Slice", static_cast<uint64_t>(250000), scheduler.nextSliceSize(*twap, 10, impact, key));
+
+    auto child = scheduler.makeChild(*twap, 250000);
+    tf.assert_true("Child Knows Parent", child->isChildSlice());
+    tf.assert_equal("Child Is IOC", TimeInForce::IOC, child->tif_policy);
+    child->filled_amount = 250000;
+    child->received_amount = 249000;
+    scheduler.completeSlice(*twap, *child, 10);
+    tf.assert_equal("Parent Rolled Up", static_cast<uint64_t>(250000), twap->filled_amount);
+    tf.assert_equal("Next Slice Next Block", static_cast<size_t>(1), scheduler.popDue(11).size());
+
+    // Thin pool: estimated impact beyond the budget halves the slice
+    impact.observe(key, 1.0, 250000, 0.98); // 2% impact at 250k
+    tf.assert_equal("Impact Shrinks Slice", static_cast<uint64_t>(125000), scheduler.nextSliceSize(*twap, 11, impact, key));
+    tf.assert_equal("Final Block Takes Rest", static_cast<uint64_t>(750000), scheduler.nextSliceSize(*twap, 13, impact, key));
+
+    // Iceberg: visible clip, trimmed by the impact budget but never below a quarter clip
+    auto iceberg = OrderFactory::createIceberg("ICE", "0xA", "0xB", 1000000, 0.99, 0.01, 400000, "0xUser", "key");
+    scheduler.schedule(iceberg.get(), 0);
+    PriceImpactModel no_impact;
+    tf.assert_equal("Iceberg Clip", static_cast<uint64_t>(400000), scheduler.nextSliceSize(*iceberg, 0, no_impact, key));
+    tf.assert_equal("Iceberg Impact Capped", static_cast<uint64_t>(100000), scheduler.nextSliceSize(*iceberg, 0, impact, key));
+
+    // Thousands of schedules: a tick only pops the parents that are due
+    SliceScheduler big;
+    std::vector<std::unique_ptr<LimitOrder>> parents;
+    for (int k = 0; k < 5000; ++k)
+    {
+        parents.push_back(OrderFactory::createIceberg("P" + std::to_string(k), "0xA", "0xB", 1000, 1.0, 0.01, 100, "0xUser", "key"));
+        big.schedule(parents.back().get(), static_cast<uint64_t>(k % 50));
+    }
+    tf.assert_equal("Schedules Tracked", static_cast<size_t>(5000), big.activeSchedules());
+    tf.assert_equal("Only Due Parents Popped", static_cast<size_t>(100), big.popDue(0).size());
+    tf.assert_equal("Next Block Pops Next Batch", static_cast<size_t>(100), big.popDue(1).size());
+}
+
+void test_sharded_engine(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Pool Sharding and MPSC Queue" << std::endl;
+
+    // Pools always land on the same shard regardless of checksum casing
+    tf.assert_equal("Shard Stable Across Case",
+                    ShardRouter::shardFor("0xbEbc44782C7dB0a1A60Cb6fe97d0b483032FF1C7", 8),
+                    ShardRouter::shardFor("0xbebc44782c7db0a1a60cb6fe97d0b483032ff1c7", 8));
+    tf.assert_equal("Single Shard", static_cast<size_t>(0), ShardRouter::shardFor("0xPool", 1));
+
+    std::vector<size_t> per_shard(8, 0);
+    for (int k = 0; k < 1000; ++k)
+    {
+        per_shard[ShardRouter::shardFor("0xPool" + std::to_string(k), 8)]++;
+    }
+    tf.assert_true("Pools Spread Over Shards",
+                   *std::min_element(per_shard.begin(), per_shard.end()) > 60);
+
+    // Concurrent producers, one consumer draining while they push
+    const int producers = 4;
+    const uint64_t per_producer = 20000;
+    MpscQueue<std::pair<int, uint64_t>> queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, p, per_producer]
+                             {
+            for (uint64_t n = 0; n < per_producer; ++n)
+                queue.push({p, n}); });
+    }
+
+    std::vector<uint64_t> next_expected(producers, 0);
+    bool in_order = true;
+    uint64_t received = 0;
+    std::pair<int, uint64_t> item;
+    while (received < producers * per_producer)
+    {
+        if (!queue.tryPop(item))
+            continue;
+        in_order = in_order && item.second == next_expected[item.first];
+        next_expected[item.first] = item.second + 1;
+        received++;
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    tf.assert_equal("MPSC Received All", producers * per_producer, received);
+    tf.assert_true("MPSC Per-Producer FIFO", in_order);
+    tf.assert_true("MPSC Drained", queue.empty());
+
+    // Publisher sends only changes; coordinator keeps the latest view and counts finished shards
+    ShardCoordinator coordinator(2);
+    ShardPublisher publisher(1, coordinator.updates());
+    std::vector<std::unique_ptr<LimitOrder>> orders;
+    orders.push_back(OrderFactory::createGTC("S1", "0xA", "0xB", 1000, 0.99, 0.01, "0xUser", "key"));
+    orders.push_back(OrderFactory::createGTC("S2", "0xA", "0xB", 1000, 0.99, 0.01, "0xUser", "key"));
+
+    tf.assert_equal("First Publish Sends All", static_cast<size_t>(2), publisher.publish(orders));
+    tf.assert_equal("Unchanged Sends Nothing", static_cast<size_t>(0), publisher.publish(orders));
+    orders[0]->filled_amount = 1000;
+    orders[0]->received_amount = 999;
+    orders[0]->updateStatus(OrderStatus::FILLED);
+    tf.assert_equal("Fill Sends One", static_cast<size_t>(1), publisher.publish(orders));
+    publisher.finish();
+
+    tf.assert_equal("Coordinator Applied", static_cast<size_t>(3), coordinator.drain());
+    tf.assert_equal("Latest Status Kept", OrderStatus::FILLED, coordinator.orders().at("S1").status);
+    tf.assert_equal("Fill Carried", static_cast<uint64_t>(999), coordinator.orders().at("S1").received_amount);
+    tf.assert_false("Waits For Other Shard", coordinator.allDone());
+    ShardPublisher(0, coordinator.updates()).finish();
+    coordinator.drain();
+    tf.assert_true("All Shards Done", coordinator.allDone());
+}
+
+void test_work_stealing_executor(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Work-Stealing Executor" << std::endl;
+
+    WorkStealingExecutor executor(4);
+    tf.assert_equal("Worker Count", static_cast<size_t>(4), executor.workerCount());
+
+    // Skewed load: every task pinned to worker 0 (one hot pool); idle workers must steal
+    const size_t task_count = 200;
+    std::atomic<size_t> completed{0};
+    std::vector<size_t> ran_on(task_count, WorkStealingExecutor::NO_AFFINITY);
+    TaskGroup group;
+    for (size_t k = 0; k < task_count; ++k)
+    {
+        executor.submit([&completed, &ran_on, k](size_t worker)
+                        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Stand-in for an RPC round trip
+            ran_on[k] = worker;
+            completed++; },
+                        0, &group);
+    }
+    group.wait();
+
+    tf.assert_equal("All Tasks Completed", task_count, completed.load());
+    tf.assert_true("Idle Workers Stole", executor.stealCount() > 0);
+    size_t workers_used = 0;
+    for (size_t w = 0; w < executor.workerCount(); ++w)
+        workers_used += executor.executedBy(w) > 0 ? 1 : 0;
+    tf.assert_true("Hot Pool Spread Over Workers", workers_used > 1);
+    tf.assert_true("Task Saw Worker Index",
+                   std::all_of(ran_on.begin(), ran_on.end(), [](size_t w)
+                               { return w < 4; }));
+
+    // A throwing task doesn't take its worker down or hang the group
+    TaskGroup failing;
+    executor.submit([](size_t)
+                    { throw std::runtime_error("rpc timeout"); },
+                    WorkStealingExecutor::NO_AFFINITY, &failing);
+    failing.wait();
+    std::atomic<bool> after{false};
+    TaskGroup again;
+    executor.submit([&after](size_t)
+                    { after = true; },
+                    1, &again);
+    again.wait();
+    tf.assert_true("Executor Survives Task Failure", after.load());
+}
+
+// Minimal GTC-style lifecycle: quote once per block until the limit is met
+OrderTask watchOrder(EventLoop &loop, LimitOrder &order, int &checks)
+{
+    QuoteRequest request{order.pool_address, 0, 1, order.input_amount};
+    while (order.status == OrderStatus::ACTIVE)
+    {
+        QuoteResult quote = co_await loop.quote(request);
+        checks++;
+        if (quote.ok && order.isPriceMet(quote.output))
+        {
+            order.filled_amount = order.input_amount;
+            order.received_amount = quote.output;
+            order.updateStatus(OrderStatus::FILLED);
+            co_return;
+        }
+        co_await loop.nextBlock();
+    }
+}
+
+OrderTask sleepThenRecord(EventLoop &loop, int delay_ms, std::vector<int> &wake_order)
+{
+    co_await loop.sleepFor(std::chrono::milliseconds(delay_ms));
+    wake_order.push_back(delay_ms);
+}
+
+void test_order_coroutines(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Coroutine Order Lifecycles" << std::endl;
+
+    // The pool price improves by 10 bps per block; each order fills once it crosses its limit
+    uint64_t block_price_bps = 9900;
+    size_t resolver_calls = 0;
+    size_t largest_batch = 0;
+    EventLoop loop(std::chrono::milliseconds(1),
+                   [&](const std::vector<QuoteRequest> &requests, std::vector<QuoteResult> &results)
+                   {
+                       resolver_calls++;
+                       largest_batch = std::max(largest_batch, requests.size());
+                       for (size_t k = 0; k < requests.size(); ++k)
+                           results[k] = {true, requests[k].dx * (block_price_bps + 10 * loop.currentBlock()) / 10000, ""};
+                   });
+
+    const size_t order_count = 2000;
+    std::vector<std::unique_ptr<LimitOrder>> orders;
+    std::vector<int> checks(order_count, 0);
+    size_t frame_bytes_before = OrderTask::liveFrameBytes();
+    for (size_t k = 0; k < order_count; ++k)
+    {
+        // Limits from 0.990 to 0.994: fills spread over the first few blocks
+        orders.push_back(OrderFactory::createGTC("CO" + std::to_string(k), "0xA", "0xB", 1000000,
+                                                 0.990 + 0.001 * static_cast<double>(k % 5), 0.01, "0xUser", "key"));
+        orders.back()->pool_address = "0xPool";
+        orders.back()->updateStatus(OrderStatus::ACTIVE);
+        loop.spawn(watchOrder(loop, *orders.back(), checks[k]));
+    }
+
+    size_t bytes_per_order = (OrderTask::liveFrameBytes() - frame_bytes_before) / order_count;
+    std::cout << "   Coroutine frame per order: " << bytes_per_order << " bytes" << std::endl;
+    tf.assert_true("Order Costs A Small Frame", bytes_per_order > 0 && bytes_per_order < 512);
+
+    loop.run();
+
+    tf.assert_equal("All Lifecycles Finished", static_cast<size_t>(0), loop.liveTasks());
+    tf.assert_true("All Orders Filled",
+                   std::all_of(orders.begin(), orders.end(), [](const std::unique_ptr<LimitOrder> &order)
+                               { return order->status == OrderStatus::FILLED; }));
+    tf.assert_equal("Strictest Order Waited 4 Blocks", 5, checks[4]);
+    tf.assert_equal("Quotes Batched Per Turn", order_count, largest_batch);
+    tf.assert_equal("One Resolver Call Per Block", static_cast<size_t>(5), resolver_calls);
+    tf.assert_equal("Frames Freed", frame_bytes_before, OrderTask::liveFrameBytes());
+
+    // Timers wake in deadline order regardless of spawn order
+    EventLoop timer_loop(std::chrono::milliseconds(1));
+    std::vector<int> wake_order;
+    timer_loop.spawn(sleepThenRecord(timer_loop, 6, wake_order));
+    timer_loop.spawn(sleepThenRecord(timer_loop, 2, wake_order));
+    timer_loop.spawn(sleepThenRecord(timer_loop, 4, wake_order));
+    timer_loop.run();
+    tf.assert_true("Timers Fire In Order", wake_order == std::vector<int>({2, 4, 6}));
+}
+
+void test_http_transport(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Raw HTTP Keep-Alive Transport" << std::endl;
+
+    LocalRpcServer server([](const std::string &body)
+                          { return LocalRpcServer::echoIdReply(body, "0x3e8"); });
+    HttpTransport transport(server.url());
+
+    std::string_view single = transport.post(R"({"jsonrpc":"2.0","method":"eth_blockNumber","params":[],"id":7})");
+    tf.assert_equal("Single Request Body", std::string(R"({"id":7,"jsonrpc":"2.0","result":"0x3e8"})"), std::string(single));
+
+    // Pipelined: every request goes out before the first response is read; order is preserved
+    std::vector<std::string> bodies;
+    for (int k = 1; k <= 200; ++k)
+        bodies.push_back(R"({"jsonrpc":"2.0","method":"eth_call","params":[],"id":)" + std::to_string(k) + "}");
+    const std::vector<std::string_view> &replies = transport.pipeline(bodies);
+    bool ordered = replies.size() == bodies.size();
+    for (size_t k = 0; ordered && k < replies.size(); ++k)
+        ordered = replies[k].find("\"id\":" + std::to_string(k + 1) + ",") != std::string_view::npos;
+    tf.assert_true("Pipelined Replies In Order", ordered);
+    tf.assert_equal("Connection Kept Alive", static_cast<uint64_t>(1), transport.connectCount());
+    tf.assert_equal("Server Saw All Requests", static_cast<uint64_t>(201), server.requestCount());
+
+    // Chunked replies are stitched back together in place
+    LocalRpcServer chunked([](const std::string &body)
+                           { return LocalRpcServer::echoIdReply(body, "0xabcdef"); });
+    chunked.useChunkedReplies(true);
+    HttpTransport chunked_transport(chunked.url());
+    std::vector<std::string> two = {bodies[0], bodies[1]};
+    const std::vector<std::string_view> &chunked_replies = chunked_transport.pipeline(two);
+    tf.assert_equal("Chunked Body Decoded", std::string(R"({"id":2,"jsonrpc":"2.0","result":"0xabcdef"})"),
+                    std::string(chunked_replies[1]));
+
+    // Server closing after each response: the next call reconnects transparently
+    LocalRpcServer closing([](const std::string &body)
+                           { return LocalRpcServer::echoIdReply(body, "0x1"); });
+    closing.closeAfter(1);
+    HttpTransport reconnecting(closing.url());
+    reconnecting.post(bodies[0]);
+    std::string_view after_close = reconnecting.post(bodies[2]);
+    tf.assert_true("Reconnects After Close", after_close.find("\"id\":3,") != std::string_view::npos);
+    tf.assert_equal("Second Connection Opened", static_cast<uint64_t>(2), reconnecting.connectCount());
+
+    bool refused = false;
+    try
+    {
+        HttpTransport nowhere("http://127.0.0.1:1/", 500);
+        nowhere.post(bodies[0]);
+    }
+    catch (const std::exception &)
+    {
+        refused = true;
+    }
+    tf.assert_true("Connection Refused Throws", refused);
+}
+
+void test_ipc_transport(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing IPC Socket Transport" << std::endl;
+
+    // Framing: messages split across reads, brackets and escaped quotes inside strings
+    JsonStreamFramer framer;
+    std::string stream = R"({"id":1,"result":"a}\"]{"} [{"id":2}]  {"method":"eth_subscription","params":{"id":"x"}})";
+    std::vector<std::string> framed;
+    std::string message;
+    for (size_t k = 0; k < stream.size(); k += 7)
+    {
+        framer.append(stream.data() + k, std::min<size_t>(7, stream.size() - k));
+        while (framer.next(message))
+            framed.push_back(message);
+    }
+    tf.assert_equal("Framer Splits Three Messages", static_cast<size_t>(3), framed.size());
+    tf.assert_equal("String Brackets Ignored", std::string(R"({"id":1,"result":"a}\"]{"})"), framed[0]);
+    tf.assert_equal("Top Level Id", std::string("1"), JsonStreamFramer::topLevelId(framed[0]));
+    tf.assert_equal("Nested Id Ignored", std::string(), JsonStreamFramer::topLevelId(framed[2]));
+
+    // Replies carry an id-derived result (with brackets in it) so mix-ups are visible
+    LocalIpcServer server([](const std::string &body)
+                          {
+        std::string id = JsonStreamFramer::topLevelId(body);
+        return "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"result\":\"r" + id + "}]\"}"; });
+    std::atomic<int> notifications{0};
+    IpcTransport transport(server.path(), IpcTransport::DEFAULT_TIMEOUT_MS, [&notifications](const std::string &)
+                           { notifications++; });
+
+    std::string single = transport.call(R"({"jsonrpc":"2.0","method":"eth_blockNumber","params":[],"id":7})", 7);
+    tf.assert_equal("Single Call Reply", std::string(R"({"jsonrpc":"2.0","id":7,"result":"r7}]"})"), single);
+
+    // The stand-in answers each read in reverse; replies must still line up with requests
+    std::vector<std::string> bodies;
+    std::vector<uint64_t> ids;
+    for (uint64_t id = 100; id < 200; ++id)
+    {
+        bodies.push_back(R"({"jsonrpc":"2.0","method":"eth_call","params":[],"id":)" + std::to_string(id) + "}");
+        ids.push_back(id);
+    }
+    std::vector<std::string> replies = transport.exchange(bodies, ids);
+    bool matched = replies.size() == ids.size();
+    for (size_t k = 0; matched && k < replies.size(); ++k)
+        matched = JsonStreamFramer::topLevelId(replies[k]) == std::to_string(ids[k]);
+    tf.assert_true("Batch Replies Matched By Id", matched);
+
+    // Concurrent callers share the connection
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> callers;
+    for (uint64_t t = 0; t < 8; ++t)
+    {
+        callers.emplace_back([&transport, &mismatches, t]
+                             {
+            for (uint64_t k = 0; k < 50; ++k)
+            {
+                uint64_t id = 1000 + t * 100 + k;
+                std::string reply = transport.call(R"({"jsonrpc":"2.0","method":"eth_call","params":[],"id":)" + std::to_string(id) + "}", id);
+                if (reply.find("\"result\":\"r" + std::to_string(id) + "}") == std::string::npos)
+                    mismatches++;
+            } });
+    }
+    for (auto &caller : callers)
+        caller.join();
+    tf.assert_equal("Concurrent Callers Demultiplexed", 0, mismatches.load());
+    tf.assert_equal("One Connection Shared", static_cast<uint64_t>(1), transport.connectCount());
+    tf.assert_equal("Server Saw All Requests", static_cast<uint64_t>(501), server.requestCount());
+
+    // Messages without an id go to the notification handler, not a caller
+    server.broadcast(R"({"jsonrpc":"2.0","method":"eth_subscription","params":{"subscription":"0x1","result":{}}})");
+    for (int spin = 0; spin < 200 && notifications.load() == 0; ++spin)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    tf.assert_equal("Notification Delivered", 1, notifications.load());
+
+    // Node closing the socket: the next call reconnects
+    LocalIpcServer closing([](const std::string &body)
+                           { return LocalRpcServer::echoIdReply(body, "0x1"); });
+    closing.closeAfter(1);
+    IpcTransport reconnecting(closing.path());
+    reconnecting.call(bodies[0], ids[0]);
+    bool reconnected = false;
+    for (int attempt = 0; attempt < 50 && !reconnected; ++attempt)
+    {
+        try
+        {
+            reconnected = reconnecting.call(bodies[1], ids[1]).find("\"id\":101,") != std::string::npos;
+        }
+        catch (const std::exception &)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Close raced the write
+        }
+    }
+    tf.assert_true("Reconnects After Close", reconnected);
+    tf.assert_equal("Second Connection Opened", static_cast<uint64_t>(2), reconnecting.connectCount());
+
+    bool refused = false;
+    try
+    {
+        IpcTransport nowhere("/tmp/curve_agent_no_such_node.ipc", 500);
+        nowhere.call(bodies[0], ids[0]);
+    }
+    catch (const std::exception &)
+    {
+        refused = true;
+    }
+    tf.assert_true("Missing Socket Throws", refused);
+}
+
+OrderTask recordNextBlock(EventLoop &loop, uint64_t &seen)
+{
+    seen = co_await loop.nextBlock();
+}
+
+void test_ws_subscriber(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing WebSocket Head And Log Subscription" << std::endl;
+
+    auto waitUntil = [](auto condition)
+    {
+        for (int spin = 0; spin < 400 && !condition(); ++spin)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return condition();
+    };
+
+    LocalWsServer server;
+    std::mutex seen_mutex;
+    std::vector<NewHead> heads;
+    std::vector<PoolLog> logs;
+    WebSocketSubscriber::Options options;
+    options.initial_backoff = std::chrono::milliseconds(20);
+    WebSocketSubscriber subscriber(
+        server.url(), {"0xBEBC44782C7DB0A1A60CB6FE97D0B483032FF1C7"},
+        [&](const NewHead &head)
+        {
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            heads.push_back(head);
+        },
+        [&](const PoolLog &log)
+        {
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            logs.push_back(log);
+        },
+        options);
+    std::atomic<int> drops{0};
+    subscriber.onDisconnect([&drops]
+                            { drops++; });
+    subscriber.start();
+
+    tf.assert_true("Subscribed To Heads And Logs", waitUntil([&]
+                                                             { return server.subscribeCount() == 2; }));
+    tf.assert_true("Live Once Both Confirmed", waitUntil([&]
+                                                         { return subscriber.isLive(); }));
+    tf.assert_true("Logs Filtered By Pool", server.lastLogsFilter().find("0xbebc44782c7db0a1a60cb6fe97d0b483032ff1c7") != std::string::npos);
+
+    // Subscription confirmations can trail the subscribe count by a frame; push until one lands
+    waitUntil([&]
+              { server.pushHead(100); std::lock_guard<std::mutex> lock(seen_mutex); return !heads.empty(); });
+    server.pushLog("0xBEBC44782C7DB0A1A60CB6FE97D0B483032FF1C7", 100, "0x8b3e96f2");
+    tf.assert_true("Log Delivered", waitUntil([&]
+                                              { std::lock_guard<std::mutex> lock(seen_mutex); return !logs.empty(); }));
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        tf.assert_equal("Head Number Decoded", static_cast<uint64_t>(100), heads.front().number);
+        tf.assert_equal("Head Parent Decoded", std::string("0xh99"), heads.front().parent_hash);
+        tf.assert_equal("Log Address Lowercased", std::string("0xbebc44782c7db0a1a60cb6fe97d0b483032ff1c7"), logs.front().address);
+        tf.assert_equal("Log Block Decoded", static_cast<uint64_t>(100), logs.front().block_number);
+        tf.assert_equal("Log Topic Decoded", std::string("0x8b3e96f2"), logs.front().topics.front());
+    }
+
+    // Fragmented notification with a ping between the fragments
+    server.fragmentNotifications(true);
+    server.pushHead(101);
+    tf.assert_true("Fragmented Head Reassembled", waitUntil([&]
+                                                           { std::lock_guard<std::mutex> lock(seen_mutex); return heads.back().number == 101; }));
+    tf.assert_true("Ping Answered", waitUntil([&]
+                                              { return server.pongCount() >= 1; }));
+    server.fragmentNotifications(false);
+
+    // Dropped connection: reconnect, resubscribe, keep delivering
+    server.dropClients();
+    tf.assert_true("Resubscribed After Drop", waitUntil([&]
+                                                        { return server.subscribeCount() == 4; }));
+    waitUntil([&]
+              { server.pushHead(102); std::lock_guard<std::mutex> lock(seen_mutex); return heads.back().number == 102; });
+    tf.assert_equal("Second Connection Opened", static_cast<uint64_t>(2), subscriber.connectCount());
+    tf.assert_equal("Drop Reported Once", 1, drops.load());
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        tf.assert_equal("Heads Continue After Reconnect", static_cast<uint64_t>(102), heads.back().number);
+        tf.assert_true("Head Without Bloom", heads.back().logs_bloom.empty());
+    }
+    std::string bloom_hex = "0x" + std::string(510, '0') + "01";
+    server.pushHead(103, bloom_hex);
+    tf.assert_true("Head Bloom Decoded", waitUntil([&]
+                                                  { std::lock_guard<std::mutex> lock(seen_mutex); return heads.back().logs_bloom == bloom_hex; }));
+
+    // Malformed notifications are dropped without ending the session
+    size_t heads_before = 0, logs_before = 0;
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        heads_before = heads.size();
+        logs_before = logs.size();
+    }
+    server.pushResult(false, "{\"number\":\"0xzz\",\"hash\":\"0xbad\"}");
+    server.pushResult(false, "{\"number\":\"0x10000000000000000\"}");
+    server.pushResult(true, "{\"address\":\"0xabc\",\"topics\":[1,2],\"blockNumber\":\"0x68\",\"logIndex\":\"0x0\"}");
+    server.pushResult(true, "{\"address\":7,\"topics\":[],\"blockNumber\":\"0x68\",\"logIndex\":\"0x0\"}");
+    server.pushHead(104);
+    tf.assert_true("Head After Malformed Ones", waitUntil([&]
+                                                          { std::lock_guard<std::mutex> lock(seen_mutex); return heads.back().number == 104; }));
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        tf.assert_equal("Malformed Heads Dropped", heads_before + 1, heads.size());
+        tf.assert_equal("Malformed Logs Dropped", logs_before, logs.size());
+    }
+    tf.assert_equal("Malformed Input Keeps Session", 1, drops.load());
+
+    // A frame announcing more than the message cap fails the session instead of growing the buffer
+    server.pushFrameHeader(1ULL << 62);
+    tf.assert_true("Oversized Frame Fails Session", waitUntil([&]
+                                                              { return drops.load() == 2; }));
+    tf.assert_true("Resubscribed After Oversized Frame", waitUntil([&]
+                                                                   { return server.subscribeCount() == 6; }));
+    subscriber.stop();
+
+    // A provider refusing the logs filter: never live, and every attempt ends as a drop
+    LocalWsServer refusing;
+    refusing.rejectLogs(true);
+    std::atomic<int> refused{0};
+    WebSocketSubscriber partial(
+        refusing.url(), {"0xbebc44782c7db0a1a60cb6fe97d0b483032ff1c7"}, [](const NewHead &) {}, nullptr, options);
+    partial.onDisconnect([&refused]
+                         { refused++; });
+    partial.start();
+    tf.assert_true("Rejected Subscription Fails Session", waitUntil([&]
+                                                                    { return refused >= 2; }));
+    tf.assert_false("Not Live Without Logs Stream", partial.isLive());
+    partial.stop();
+
+    PoolActivity activity;
+    activity.record("0xABC", 7);
+    tf.assert_true("Pool Changed After Earlier Quote", activity.changedSince("0xabc", 6));
+    tf.assert_false("Pool Quiet Since Quote", activity.changedSince("0xabc", 7));
+    tf.assert_false("Unseen Pool Quiet", activity.changedSince("0xdef", 0));
+
+    // A head posted from another thread wakes the loop long before its fallback interval
+    EventLoop loop(std::chrono::seconds(60));
+    uint64_t seen_block = 0;
+    loop.spawn(recordNextBlock(loop, seen_block));
+    std::thread poster([&loop]
+                       {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        loop.postBlock(500); });
+    auto started = std::chrono::steady_clock::now();
+    loop.run();
+    poster.join();
+    tf.assert_equal("Posted Head Wakes Waiters", static_cast<uint64_t>(500), seen_block);
+    tf.assert_true("Woken Without Fallback Wait", std::chrono::steady_clock::now() - started < std::chrono::seconds(5));
+}
+
+// ABI-encode amounts as a log's data field
+std::string encodeLogWords(const std::vector<PoolAmount> &words)
+{
+    static const char *digits = "0123456789abcdef";
+    std::string data = "0x";
+    for (PoolAmount word : words)
+    {
+        std::string hex(64, '0');
+        for (int k = 63; k >= 32 && word > 0; --k, word >>= 4)
+            hex[k] = digits[static_cast<int>(word & 0xF)];
+        data += hex;
+    }
+    return data;
+}
+
+void test_pool_state(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Event-Sourced Pool State" << std::endl;
+
+    tf.assert_equal("Keccak Empty Input", std::string("0xc5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"), Keccak::eventTopic(""));
+    tf.assert_equal("TokenExchange Topic", std::string("0x8b3e96f2b889fa771c53c981b40daf005f63f637f1869f707052d15a3dd97140"),
+                    Keccak::eventTopic("TokenExchange(address,int128,uint256,int128,uint256)"));
+    tf.assert_equal("get_dy Selector", std::string("0x5e0d443f"), Keccak::functionSelector("get_dy(int128,int128,uint256)"));
+
+    const std::string pool = "0xbEbc44782C7dB0a1A60Cb6fe97d0b483032FF1C7";
+    const PoolAmount e24 = static_cast<PoolAmount>(1000000000000ULL) * 1000000000000ULL;
+    PoolState seed;
+    seed.balances = {e24, 1000000000000ULL, 1000000000000ULL};
+    seed.fee = 4000000;          // 0.04%
+    seed.admin_fee = 5000000000; // 50% of fees
+    seed.initial_A = seed.future_A = 2000;
+    seed.block = 100;
+
+    PoolStateStore store;
+    store.seed(pool, seed);
+
+    auto makeLog = [&pool](const std::string &signature, uint64_t block, uint64_t index, const std::vector<PoolAmount> &words)
+    {
+        PoolLog log;
+        log.address = pool;
+        log.topics = {Keccak::eventTopic(signature)};
+        log.data = encodeLogWords(words);
+        log.block_number = block;
+        log.block_hash = "0xb" + std::to_string(block);
+        log.log_index = index;
+        return log;
+    };
+    const std::string exchange = "TokenExchange(address,int128,uint256,int128,uint256)";
+
+    // 1 USDC in, 0.999 DAI out: DAI balance also loses the admin half of the fee
+    PoolLog swap = makeLog(exchange, 101, 0, {1, 1000000, 0, 999000000000000000ULL});
+    tf.assert_true("Exchange Applied", store.apply(swap) == PoolStateStore::ApplyResult::APPLIED);
+    tf.assert_true("Sold Balance Increased", store.state(pool)->balances[1] == 1000001000000ULL);
+    tf.assert_true("Bought Balance Less Admin Fee", store.state(pool)->balances[0] == e24 - 999199879951980792ULL);
+    tf.assert_true("Duplicate Log Skipped", store.apply(swap) == PoolStateStore::ApplyResult::DUPLICATE);
+    tf.assert_true("Seeded Block Ignored", store.apply(makeLog(exchange, 100, 3, {1, 5, 0, 5})) == PoolStateStore::ApplyResult::IGNORED);
+
+    PoolLog deposit = makeLog("AddLiquidity(address,uint256[3],uint256[3],uint256,uint256)", 102, 0,
+                              {1000000000000000000ULL, 0, 0, 100000000000000ULL, 0, 0, 0, 0});
+    tf.assert_true("AddLiquidity Applied", store.apply(deposit) == PoolStateStore::ApplyResult::APPLIED);
+    tf.assert_true("Deposit Less Admin Fee", store.state(pool)->balances[0] == e24 - 999199879951980792ULL + 1000000000000000000ULL - 50000000000000ULL);
+
+    // Reorg: removed logs undo their block and everything after it
+    PoolLog removed = deposit;
+    removed.removed = true;
+    tf.assert_true("Removed Log Rolls Back", store.apply(removed) == PoolStateStore::ApplyResult::ROLLED_BACK);
+    tf.assert_true("State Back To Block 101", store.state(pool)->balances[0] == e24 - 999199879951980792ULL && store.state(pool)->block == 101);
+    removed = swap;
+    removed.removed = true;
+    store.apply(removed);
+    tf.assert_true("State Back To Seed", store.state(pool)->balances[0] == e24 && store.state(pool)->block == 100);
+    tf.assert_equal("Undo Log Emptied", static_cast<size_t>(0), store.undoDepth(pool));
+
+    // Undo history past the reorg horizon is dropped; a reorg deeper than that forces a resync
+    store.apply(swap);
+    NewHead head;
+    head.number = 101 + PoolStateStore::DEFAULT_UNDO_DEPTH;
+    store.onHead(head);
+    tf.assert_equal("Undo Pruned At Horizon", static_cast<size_t>(0), store.undoDepth(pool));
+    tf.assert_true("Deep Reorg Needs Resync", store.apply(removed) == PoolStateStore::ApplyResult::NEEDS_RESYNC);
+    tf.assert_false("No State While Resyncing", store.state(pool).has_value());
+
+    // The checksum audit adopts the chain's values
+    tf.assert_false("Audit Resyncs Drifted Pool", store.verify(pool, seed));
+    tf.assert_false("Resync Cleared", store.needsResync(pool));
+    tf.assert_true("Audit Matches After Resync", store.verify(pool, seed));
+
+    // RemoveLiquidityOne doesn't say which coin left: resync instead of guessing
+    PoolLog withdraw_one = makeLog("RemoveLiquidityOne(address,uint256,uint256)", 102, 0, {1000, 1000});
+    tf.assert_true("RemoveLiquidityOne Needs Resync", store.apply(withdraw_one) == PoolStateStore::ApplyResult::NEEDS_RESYNC);
+    store.seed(pool, seed);
+
+    // RampA: A moves linearly between the ramp's endpoints
+    store.apply(makeLog("RampA(uint256,uint256,uint256,uint256)", 103, 0, {2000, 4000, 1000, 2000}));
+    tf.assert_equal("A Mid Ramp", static_cast<uint64_t>(3000), store.state(pool)->amplification(1500));
+    tf.assert_equal("A After Ramp", static_cast<uint64_t>(4000), store.state(pool)->amplification(2500));
+    tf.assert_true("Checksum Tracks A", store.state(pool)->checksum(1500) != store.state(pool)->checksum(2500));
+
+    // Pools with A_PRECISION log their ramps as A * 100; the state keeps plain A either way
+    PoolStateStore precise;
+    PoolState precise_seed = seed;
+    precise_seed.a_precision = 100;
+    precise.seed(pool, precise_seed);
+    precise.apply(makeLog("RampA(uint256,uint256,uint256,uint256)", 103, 0, {200000, 400000, 1000, 2000}));
+    tf.assert_equal("Precise A Mid Ramp", static_cast<uint64_t>(3000), precise.state(pool)->amplification(1500));
+    precise.apply(makeLog("StopRampA(uint256,uint256)", 104, 0, {350000, 1750}));
+    tf.assert_equal("Precise A Stopped", static_cast<uint64_t>(3500), precise.state(pool)->amplification(2500));
+
+    // Head continuity: a replaced block rolls back, a skipped height forces a resync
+    PoolStateStore chain;
+    chain.seed(pool, seed);
+    auto makeHead = [](uint64_t number, const std::string &hash, const std::string &parent)
+    {
+        NewHead next;
+        next.number = number;
+        next.hash = hash;
+        next.parent_hash = parent;
+        return next;
+    };
+    using HeadCheck = PoolStateStore::HeadCheck;
+    tf.assert_true("First Head In Sequence", chain.onHead(makeHead(100, "0xa100", "0xa99")) == HeadCheck::IN_SEQUENCE);
+    chain.apply(swap);
+    tf.assert_true("Next Head In Sequence", chain.onHead(makeHead(101, "0xb101", "0xa100")) == HeadCheck::IN_SEQUENCE);
+    tf.assert_true("Repeated Head In Sequence", chain.onHead(makeHead(101, "0xb101", "0xa100")) == HeadCheck::IN_SEQUENCE);
+    tf.assert_true("New Parent Is Reorg", chain.onHead(makeHead(102, "0xc102", "0xc101")) == HeadCheck::REORG);
+    tf.assert_true("Orphaned Block Rolled Back", chain.state(pool)->block == 100 && chain.state(pool)->balances[0] == e24);
+    tf.assert_equal("Reorg Counted", static_cast<uint64_t>(1), chain.reorgCount());
+
+    PoolLog early = makeLog(exchange, 103, 0, {1, 1000000, 0, 999000000000000000ULL});
+    early.block_hash = "0xd103";
+    chain.apply(early);
+    tf.assert_true("Head On New Chain Is Reorg", chain.onHead(makeHead(103, "0xd103", "0xd102")) == HeadCheck::REORG);
+    tf.assert_true("New-Chain Log Forces Resync", chain.needsResync(pool));
+
+    chain.seed(pool, seed);
+    tf.assert_true("Skipped Heights Are A Gap", chain.onHead(makeHead(106, "0xd106", "0xd105")) == HeadCheck::GAP);
+    tf.assert_true("Gap Forces Resync", chain.needsResync(pool));
+    chain.seed(pool, seed);
+    chain.resyncAll();
+    tf.assert_true("Feed Drop Forces Resync", chain.needsResync(pool));
+
+    PoolAmount parsed = 0;
+    tf.assert_true("Parses 128-bit Amount", PoolStateStore::parseAmount("0x" + std::string(32, 'f'), parsed) && parsed == ~static_cast<PoolAmount>(0));
+    tf.assert_false("Rejects 129-bit Amount", PoolStateStore::parseAmount("0x1" + std::string(32, '0'), parsed));
+}
+
+void test_trigger_index(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Inverse Trigger Thresholds" << std::endl;
+
+    // DAI (18 decimals) / USDC (6 decimals), 1M each, A = 100, 0.04% fee
+    const std::string pool = "0xPoolDaiUsdc";
+    const PoolAmount e24 = static_cast<PoolAmount>(1000000000000ULL) * 1000000000000ULL;
+    PoolState balanced;
+    balanced.balances = {e24, 1000000000000ULL};
+    balanced.rates = {1, 1000000000000ULL};
+    balanced.fee = 4000000;
+    balanced.initial_A = balanced.future_A = 100;
+
+    StableSwapMath::Real dy = StableSwapMath::getDy(balanced, 0, 1, 1e21L, 0);
+    tf.assert_true("Balanced Pool Quotes Near Par Less Fee", dy > 999.5e6L && dy < 999.6e6L);
+
+    // 1000 DAI -> USDC at 1.0005: out of reach until the pool holds more USDC than DAI
+    TriggerIndex triggers;
+    TriggerIndex::Arm order{"ORDER_A", pool, 0, 1, 1e21L, 1000.5e6L};
+    tf.assert_true("Order Armed", triggers.arm(order, balanced, 0));
+    tf.assert_true("Threshold Above Current Ratio", triggers.threshold("ORDER_A") > 1.0L);
+    TriggerIndex::Arm unreachable{"ORDER_B", pool, 0, 1, 1e21L, 1e12L}; // All the pool's USDC
+    triggers.arm(unreachable, balanced, 0);
+    tf.assert_true("Unreachable Limit Never Fires", std::isinf(triggers.threshold("ORDER_B")));
+    TriggerIndex::Arm immediate{"ORDER_C", pool, 0, 1, 1e21L, 990e6L};
+    triggers.arm(immediate, balanced, 0);
+    tf.assert_true("Already Met Fires On Arm", triggers.consume("ORDER_C") && !triggers.isArmed("ORDER_C"));
+
+    PoolState unknown_decimals = balanced;
+    unknown_decimals.rates.clear();
+    tf.assert_false("Unknown Decimals Not Armed", triggers.arm({"ORDER_D", pool, 0, 1, 1e21L, 1000.5e6L}, unknown_decimals, 0));
+
+    // A small swap along the curve: range scan only, no re-solve, nothing fires
+    uint64_t solves = triggers.evaluationCount();
+    PoolState nudged = balanced;
+    nudged.balances = {e24 / 1000 * 999, 1001000000000ULL};
+    tf.assert_equal("Small Move Fires Nothing", static_cast<size_t>(0), triggers.onState(pool, nudged, 0));
+    tf.assert_equal("No Re-solve On Same Curve", solves, triggers.evaluationCount());
+
+    // Deposits change D: thresholds are re-solved against the new curve
+    PoolState deposited = balanced;
+    deposited.balances = {e24 * 2, 2000000000000ULL};
+    triggers.onState(pool, deposited, 0);
+    tf.assert_equal("Deposit Rebases Book", static_cast<uint64_t>(1), triggers.rebaseCount());
+    tf.assert_true("Re-solved Both Orders", triggers.evaluationCount() == solves + 2);
+    triggers.onState(pool, balanced, 0);
+
+    // Pool swings to 0.9M DAI / 1.1M USDC: the order fires, and the quote there does meet it
+    PoolState swung = balanced;
+    swung.balances = {e24 / 10 * 9, 1100000000000ULL};
+    tf.assert_equal("Crossing Fires One Order", static_cast<size_t>(1), triggers.onState(pool, swung, 0));
+    tf.assert_true("Fired Quote Meets Limit", StableSwapMath::getDy(swung, 0, 1, 1e21L, 0) >= 1000.5e6L);
+    tf.assert_true("Fired Order Consumed Once", triggers.consume("ORDER_A") && !triggers.consume("ORDER_A"));
+    tf.assert_equal("Unreachable Order Still Armed", static_cast<size_t>(1), triggers.armedCount());
+
+    // Re-armed after a missed confirmation: waits for the ratio to improve past where it stands
+    triggers.arm(order, swung, 0, true);
+    tf.assert_true("Missed Order Waits For Improvement", triggers.isArmed("ORDER_A") && !triggers.consume("ORDER_A"));
+    triggers.disarm("ORDER_A");
+    triggers.disarm("ORDER_B");
+    tf.assert_equal("Disarmed", static_cast<size_t>(0), triggers.armedCount());
+}
+
+void test_logs_bloom(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Logs Bloom Prefilter" << std::endl;
+
+    const std::string pool = "0xbebc44782c7db0a1a60cb6fe97d0b483032ff1c7";
+    const std::string other_pool = "0xdc24316b9ae028f1497c275eb9192a3ea0f67022";
+    const std::string exchange = Keccak::eventTopic("TokenExchange(address,int128,uint256,int128,uint256)");
+
+    LogsBloom::Bits pool_bits = LogsBloom::bitsOf(pool);
+    for (uint16_t position : pool_bits.positions)
+        tf.assert_true("Bit Position In Range", position < 2048);
+    tf.assert_true("Address Case Ignored", LogsBloom::bitsOf("0xBEBC44782C7DB0A1A60CB6FE97D0B483032FF1C7").positions == pool_bits.positions);
+
+    // A block holding one TokenExchange on the pool
+    LogsBloom block;
+    block.add(pool_bits);
+    block.add(LogsBloom::bitsOf(exchange));
+    tf.assert_true("Pool May Be Present", block.mayContain(pool_bits));
+    tf.assert_true("Topic May Be Present", block.mayContainAny(LogsBloom::bitsOf(std::vector<std::string>{other_pool, exchange})));
+    tf.assert_false("Other Pool Ruled Out", block.mayContain(LogsBloom::bitsOf(other_pool)));
+    tf.assert_false("Empty Bloom Rules Out Everything", LogsBloom().mayContain(pool_bits));
+
+    LogsBloom parsed;
+    tf.assert_true("Header Bloom Round Trips", LogsBloom::parse(block.toHex(), parsed) && parsed.mayContain(pool_bits));
+    tf.assert_equal("Bloom Is 256 Bytes", static_cast<size_t>(514), block.toHex().size());
+    tf.assert_false("Short Bloom Rejected", LogsBloom::parse("0x00ff", parsed));
+    tf.assert_false("Malformed Bloom Rejected", LogsBloom::parse("0x" + std::string(512, 'z'), parsed));
+
+    // Screened heads prove quiet blocks; one head without a bloom breaks the run
+    PoolActivity activity;
+    tf.assert_false("Unscreened By Default", activity.screenedSince(10));
+    activity.screened(11);
+    activity.screened(12);
+    tf.assert_true("Screened Since Quote", activity.screenedSince(10));
+    tf.assert_false("Block Before Run Not Screened", activity.screenedSince(9));
+    activity.unscreened();
+    tf.assert_false("Run Broken By Bloomless Head", activity.screenedSince(10));
+    activity.screened(13);
+    activity.screened(16);
+    tf.assert_false("Run Broken By Skipped Heads", activity.screenedSince(13));
+    tf.assert_true("New Run From Head After Gap", activity.screenedSince(15));
+}
+
+void test_rpc_scheduler(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Priority RPC Scheduler" << std::endl;
+
+    // 50 calls/s, burst 10: one token held back for broadcasts
+    RpcScheduler scheduler(50, 10);
+    auto started = std::chrono::steady_clock::now();
+    for (int k = 0; k < 9; ++k)
+        scheduler.acquire(RpcPriority::BACKGROUND);
+    tf.assert_true("Burst Admitted Without Waiting", std::chrono::steady_clock::now() - started < std::chrono::milliseconds(15));
+    tf.assert_equal("Burst Never Queued", static_cast<uint64_t>(0), scheduler.classStats(RpcPriority::BACKGROUND).waited);
+
+    // Bucket drained for everyone else: a broadcast still goes out on the reserve
+    started = std::chrono::steady_clock::now();
+    scheduler.acquire(RpcPriority::BROADCAST);
+    tf.assert_true("Broadcast Uses Reserve", std::chrono::steady_clock::now() - started < std::chrono::milliseconds(15));
+
+    // A background caller queued first still yields to a trigger quote that arrives later
+    std::mutex order_mutex;
+    std::vector<std::string> release_order;
+    std::thread background([&]
+                           {
+        scheduler.acquire(RpcPriority::BACKGROUND, 3);
+        std::lock_guard<std::mutex> lock(order_mutex);
+        release_order.push_back("background"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    tf.assert_equal("Queue Depth Reported", static_cast<size_t>(1), scheduler.queueDepth(RpcPriority::BACKGROUND));
+    std::thread trigger([&]
+                        {
+        scheduler.acquire(RpcPriority::TRIGGER);
+        std::lock_guard<std::mutex> lock(order_mutex);
+        release_order.push_back("trigger"); });
+    trigger.join();
+    background.join();
+    tf.assert_true("Higher Class Released First", release_order.size() == 2 && release_order.front() == "trigger");
+    tf.assert_equal("Max Queue Depth Kept", static_cast<size_t>(1), scheduler.classStats(RpcPriority::BACKGROUND).max_queued);
+    tf.assert_equal("Queues Drained", static_cast<size_t>(0), scheduler.totalQueueDepth());
+    tf.assert_true("Background Wait Recorded", scheduler.classStats(RpcPriority::BACKGROUND).max_wait > std::chrono::milliseconds(20));
+
+    // Batches take what the budget allows now and send the rest as it refills
+    RpcScheduler batch_budget(50, 10);
+    size_t chunk = batch_budget.acquire(RpcPriority::TRIGGER, 25, true);
+    tf.assert_equal("Batch Chunked To Budget", static_cast<size_t>(9), chunk);
+    tf.assert_equal("Granted Calls Counted", static_cast<uint64_t>(9), batch_budget.classStats(RpcPriority::TRIGGER).granted);
+
+    // A caller whose deadline passes in the queue leaves it instead of waiting out the refill
+    RpcScheduler slow(1, 1);
+    slow.acquire(RpcPriority::TRIGGER);
+    started = std::chrono::steady_clock::now();
+    bool deadline_hit = false;
+    try
+    {
+        slow.acquire(RpcPriority::TRIGGER, 1, false, started + std::chrono::milliseconds(30));
+    }
+    catch (const DeadlineExceeded &)
+    {
+        deadline_hit = true;
+    }
+    tf.assert_true("Queued Past Deadline Throws", deadline_hit);
+    tf.assert_true("Deadline Bounds The Wait", std::chrono::steady_clock::now() - started < std::chrono::milliseconds(500));
+    tf.assert_equal("Expired Caller Dequeued", static_cast<size_t>(0), slow.totalQueueDepth());
+    tf.assert_equal("Expired Caller Not Granted", static_cast<uint64_t>(1), slow.classStats(RpcPriority::TRIGGER).granted);
+
+    // Connections to one provider share one bucket; no limit configured means no scheduler
+    tf.assert_true("Unlimited Without Config", RpcScheduler::shared("http://node-a", 0) == nullptr);
+    auto first = RpcScheduler::shared("http://node-a", 25);
+    tf.assert_true("Shared Per Provider", first && first == RpcScheduler::shared("http://node-a", 25));
+    tf.assert_true("Separate Per Provider", first != RpcScheduler::shared("http://node-b", 25));
+}
+
+void test_single_flight(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Single-Flight Request Coalescing" << std::endl;
+
+    // Eight callers ask for the same eth_call while the first is still waiting on the node
+    SingleFlight<std::string> flights;
+    std::atomic<int> round_trips{0};
+    std::atomic<bool> release{false};
+    std::vector<std::string> answers(8);
+    std::vector<std::thread> callers;
+    for (size_t k = 0; k < answers.size(); ++k)
+    {
+        callers.emplace_back([&, k]
+                             { answers[k] = flights.run("eth_call:[{\"data\":\"0x5e0d443f\"},\"latest\"]", [&]
+                                                        {
+                round_trips++;
+                while (!release)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return std::string("0x3b9aca00"); }); });
+    }
+    for (int spin = 0; spin < 400 && flights.sharedCount() < answers.size() - 1; ++spin)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release = true;
+    for (auto &caller : callers)
+        caller.join();
+
+    tf.assert_equal("One Round Trip For Identical Calls", 1, round_trips.load());
+    tf.assert_equal("Followers Counted", static_cast<uint64_t>(7), flights.sharedCount());
+    tf.assert_true("Every Caller Got The Reply", std::all_of(answers.begin(), answers.end(), [](const std::string &answer)
+                                                             { return answer == "0x3b9aca00"; }));
+    tf.assert_equal("Nothing Left In Flight", static_cast<size_t>(0), flights.inFlight());
+
+    // Not a cache: the next request after completion goes out again
+    flights.run("eth_call:[{\"data\":\"0x5e0d443f\"},\"latest\"]", [&]
+                { round_trips++; return std::string("0x3b9aca01"); });
+    tf.assert_equal("Completed Flight Not Reused", 2, round_trips.load());
+
+    // Different keys never share
+    bool leader_a = false, leader_b = false;
+    auto flight_a = flights.join("eth_call:a", leader_a);
+    auto flight_b = flights.join("eth_call:b", leader_b);
+    tf.assert_true("Distinct Keys Both Lead", leader_a && leader_b);
+
+    // A follower sees the leader's failure
+    bool leader = true;
+    auto follower = flights.join("eth_call:a", leader);
+    tf.assert_false("Second Caller Follows", leader);
+    flights.fail("eth_call:a", flight_a, std::make_exception_ptr(std::runtime_error("CURL request failed")));
+    bool rethrown = false;
+    try
+    {
+        SingleFlight<std::string>::wait(follower);
+    }
+    catch (const std::runtime_error &)
+    {
+        rethrown = true;
+    }
+    tf.assert_true("Leader Failure Shared", rethrown);
+    flights.complete("eth_call:b", flight_b, "0x1");
+    tf.assert_equal("Completed Value Shared", std::string("0x1"), SingleFlight<std::string>::wait(flight_b));
+}
+
+void test_poll_scheduler(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Adaptive Order Polling" << std::endl;
+
+    tf.assert_equal("At The Limit Always Crosses", 1.0, PollScheduler::crossProbability(0.0, 0.001, 1));
+    tf.assert_true("Crossing Odds Grow With Time", PollScheduler::crossProbability(0.002, 0.001, 1) <
+                                                       PollScheduler::crossProbability(0.002, 0.001, 8));
+    tf.assert_true("Two Sigma Gap Near 4.6%", std::fabs(PollScheduler::crossProbability(0.002, 0.001, 1) - 0.0455) < 0.001);
+
+    // 1000 in for ~999 out; a limit of 1.05 is 5% away at 10 bps per-block volatility
+    PollScheduler polling;
+    const std::string market = PriceImpactModel::keyFor("0xpool", 1, 0);
+    std::vector<uint64_t> intervals;
+    uint64_t block = 100;
+    for (int k = 0; k < 6; ++k)
+    {
+        intervals.push_back(polling.schedule("FAR", market, block, 999.0, 1050.0));
+        block += intervals.back();
+    }
+    tf.assert_true("Far Order Backs Off Exponentially", intervals == std::vector<uint64_t>({2, 4, 8, 16, 32, 32}));
+    tf.assert_false("Not Due Before Interval", polling.due("FAR", block - 1));
+    tf.assert_true("Due At Interval", polling.due("FAR", block));
+    tf.assert_true("Unknown Order Always Due", polling.due("NEW", 0));
+    tf.assert_equal("Deferred Checks Counted", static_cast<uint64_t>(1 + 3 + 7 + 15 + 31 + 31), polling.deferredChecks());
+
+    tf.assert_equal("Near Order Checked Every Block", static_cast<uint64_t>(1),
+                    polling.schedule("NEAR", market, block, 999.0, 999.5));
+
+    // The market wakes up: ~2% moves per block pull the far order back to every block
+    double price = 0.999;
+    for (uint64_t b = 200; b < 210; ++b)
+    {
+        price *= (b % 2 == 0) ? 1.02 : 0.98;
+        polling.observe(market, b, price);
+    }
+    tf.assert_true("Realized Volatility Tracked", polling.sigma(market) > 0.015 && polling.sigma(market) < 0.025);
+    tf.assert_equal("Volatile Market Polls Every Block", static_cast<uint64_t>(1),
+                    polling.schedule("FAR", market, 210, 999.0, 1050.0));
+
+    // Flat quotes drive the estimate to its floor, never to zero
+    PollScheduler flat;
+    for (uint64_t b = 1; b <= 20; ++b)
+        flat.observe("flat", b, 0.999);
+    tf.assert_equal("Flat Market Hits Volatility Floor", PollScheduler::MIN_SIGMA, flat.sigma("flat"));
+    polling.forget("FAR");
+    tf.assert_true("Forgotten Order Due Again", polling.due("FAR", 0));
+}
+
+void test_impact_curve(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Price-Impact Curve Cache" << std::endl;
+
+    std::vector<uint64_t> sizes = ImpactCurve::ladder(1000, 64000);
+    tf.assert_true("Ladder Is Geometric With A Rung Above", sizes == std::vector<uint64_t>({1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000}));
+    tf.assert_true("Degenerate Ladder Collapses", ImpactCurve::ladder(500, 500) == std::vector<uint64_t>({500}));
+
+    // Constant-product pool with 30 bps fee and 10M of depth on each side
+    auto swap = [](uint64_t dx)
+    {
+        long double depth = 10000000.0L;
+        return static_cast<uint64_t>(depth * dx * 0.997L / (depth + dx * 0.997L));
+    };
+    std::vector<uint64_t> outputs;
+    for (uint64_t size : sizes)
+        outputs.push_back(swap(size));
+    ImpactCurve curve;
+    tf.assert_true("Concave Samples Fit", curve.fit(sizes, outputs));
+
+    bool bracketed = true;
+    double widest = 0;
+    for (uint64_t dx = 300; dx < 200000; dx = dx * 21 / 20)
+    {
+        ImpactCurve::Estimate bounds = curve.estimate(dx);
+        uint64_t truth = swap(dx);
+        bracketed = bracketed && bounds.low <= truth && truth <= bounds.high && bounds.low <= bounds.value && bounds.value <= bounds.high;
+        if (dx >= 10000 && dx <= 64000)
+            widest = std::max(widest, static_cast<double>(bounds.high - bounds.low) / truth);
+    }
+    tf.assert_true("True Output Inside Bracket", bracketed);
+    tf.assert_true("Bracket Within 25 bps Inside Ladder", widest < 0.0025);
+
+    uint64_t exact = swap(50000);
+    tf.assert_true("Clear Pass Decided", curve.decide(50000, exact - 1000) == ImpactCurve::Decision::MET);
+    tf.assert_true("Clear Miss Decided", curve.decide(50000, exact + 1000) == ImpactCurve::Decision::NOT_MET);
+    tf.assert_true("Close Call Needs Exact Quote", curve.decide(50000, exact) == ImpactCurve::Decision::UNSURE);
+    tf.assert_true("Beyond Ladder Stays Conservative", curve.decide(400000, swap(400000)) == ImpactCurve::Decision::UNSURE);
+
+    // Output that accelerates with size is no AMM curve; nothing is answered from it
+    ImpactCurve convex;
+    tf.assert_false("Convex Samples Rejected", convex.fit({1000, 2000, 4000}, {1000, 2100, 4600}));
+    tf.assert_true("Rejected Curve Never Decides", convex.decide(2000, 1) == ImpactCurve::Decision::UNSURE);
+    tf.assert_false("Falling Output Rejected", curve.fit({1000, 2000}, {900, 800}) || curve.usable());
+
+    ImpactCurveCache cache;
+    std::string market = ImpactCurveCache::keyFor("0xpool", 0, 1);
+    ImpactCurve fitted;
+    fitted.fit(sizes, outputs);
+    cache.store(market, 42, fitted, sizes.size());
+    tf.assert_true("Curve Found For Its Block", cache.find(market, 42) && cache.find(market, 42)->usable());
+    tf.assert_true("Curve Expires Next Block", cache.find(market, 43) == nullptr);
+    tf.assert_true("Other Direction Separate", cache.find(ImpactCurveCache::keyFor("0xpool", 1, 0), 42) == nullptr);
+    tf.assert_equal("Ladder Samples Counted", static_cast<uint64_t>(8), cache.sampleCount());
+}
+
+void test_cryptoswap_math(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Local CryptoSwap Pricing" << std::endl;
+
+    const PoolAmount E18 = 1000000000000000000ULL;
+    auto within = [](CryptoSwapMath::Real local, CryptoSwapMath::Real recorded, CryptoSwapMath::Real band)
+    { return std::fabs(local - recorded) <= band; };
+
+    // tricrypto (USDT / WBTC / WETH) with mainnet-like parameters; recorded values are get_dy
+    // from an integer port of the contract's views
+    CryptoPoolState tricrypto;
+    tricrypto.balances = {static_cast<PoolAmount>(30000000) * 1000000, static_cast<PoolAmount>(1000) * 100000000,
+                          static_cast<PoolAmount>(15000) * E18};
+    tricrypto.precisions = {1000000000000ULL, 10000000000ULL, 1};
+    tricrypto.price_scale = {30000 * E18, 2000 * E18};
+    tricrypto.A = 1707629;
+    tricrypto.gamma = 11809167828997ULL;
+    tricrypto.mid_fee = 3000000;
+    tricrypto.out_fee = 30000000;
+    tricrypto.fee_gamma = 500000000000000ULL;
+    tricrypto.D = 90000000 * E18;
+
+    CryptoSwapMath::Real d = CryptoSwapMath::newtonD(
+        CryptoSwapMath::scaledBalances(tricrypto, {3e13L, 1e11L, 1.5e22L}), 170.7629L, 11809167828997e-18L);
+    tf.assert_true("newton_D Of Balanced Pool", std::fabs(d / 9e25L - 1) < 1e-15L);
+
+    CryptoSwapMath::Real band = CryptoSwapMath::uncertainty(tricrypto, 2);
+    tf.assert_true("USDT To WBTC Matches get_dy", within(CryptoSwapMath::getDy(tricrypto, 0, 1, 1e9L), 3332331.0L, CryptoSwapMath::uncertainty(tricrypto, 1)));
+    tf.assert_true("USDT To WETH Matches get_dy", within(CryptoSwapMath::getDy(tricrypto, 0, 2, 250000e6L), 124600122657860507260.0L, band));
+    tf.assert_true("WETH To USDT Matches get_dy", within(CryptoSwapMath::getDy(tricrypto, 2, 0, 10e18L), 19993704924.0L, CryptoSwapMath::uncertainty(tricrypto, 0)));
+    tf.assert_true("WBTC To WETH Matches get_dy", within(CryptoSwapMath::getDy(tricrypto, 1, 2, 5e8L), 74921045700715362772.0L, band));
+    tf.assert_true("Uncertainty Far Below Fee", band < 124600122657860507260.0L * 1e-9L);
+
+    // Two-coin pool holding more ETH than its price scale implies
+    CryptoPoolState twocoin;
+    twocoin.balances = {static_cast<PoolAmount>(2500000) * 1000000, static_cast<PoolAmount>(1400) * E18};
+    twocoin.precisions = {1000000000000ULL, 1};
+    twocoin.price_scale = {2000 * E18};
+    twocoin.A = 400000;
+    twocoin.gamma = 145000000000000ULL;
+    twocoin.mid_fee = 26000000;
+    twocoin.out_fee = 45000000;
+    twocoin.fee_gamma = 230000000000000ULL;
+    twocoin.D = static_cast<PoolAmount>(5293875764180129ULL) * 1000000000ULL + 194226236ULL;
+    tf.assert_true("Two-Coin Small Swap Matches get_dy", within(CryptoSwapMath::getDy(twocoin, 0, 1, 1e9L), 549500583676000854.0L, CryptoSwapMath::uncertainty(twocoin, 1)));
+    tf.assert_true("Two-Coin Large Swap Matches get_dy", within(CryptoSwapMath::getDy(twocoin, 0, 1, 500000e6L), 233243791217398346409.0L, CryptoSwapMath::uncertainty(twocoin, 1)));
+    tf.assert_true("Two-Coin Reverse Matches get_dy", within(CryptoSwapMath::getDy(twocoin, 1, 0, 400e18L), 557702359460.0L, CryptoSwapMath::uncertainty(twocoin, 0)));
+
+    // Fee slides from mid_fee toward out_fee as the pool is pushed off balance
+    std::vector<CryptoSwapMath::Real> balanced = CryptoSwapMath::scaledBalances(tricrypto, {3e13L, 1e11L, 1.5e22L});
+    std::vector<CryptoSwapMath::Real> skewed = CryptoSwapMath::scaledBalances(tricrypto, {6e13L, 0.5e11L, 1.5e22L});
+    tf.assert_equal("Balanced Pool Charges mid_fee", 3000000.0, static_cast<double>(CryptoSwapMath::feeRate(tricrypto, balanced)));
+    tf.assert_true("Skewed Pool Charges More", CryptoSwapMath::feeRate(tricrypto, skewed) > 3000000.0L);
+
+    tf.assert_true("Same Coin Quotes Nothing", CryptoSwapMath::getDy(tricrypto, 1, 1, 1e8L) == 0);
+    tf.assert_true("Output Grows Less Than Input", CryptoSwapMath::getDy(tricrypto, 0, 2, 2e12L) < 2 * CryptoSwapMath::getDy(tricrypto, 0, 2, 1e12L));
+}
+
+void test_stableswap_batch(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Batch StableSwap Evaluation" << std::endl;
+
+    // 3pool-like: 20M USDC / 25M DAI / 18M USDT, A = 2000, 4 bps fee
+    PoolState state;
+    state.balances = {static_cast<PoolAmount>(20000000) * 1000000,
+                      static_cast<PoolAmount>(25000000) * 1000000000000000000ULL,
+                      static_cast<PoolAmount>(18000000) * 1000000};
+    state.rates = {1000000000000ULL, 1, 1000000000000ULL};
+    state.fee = 4000000;
+    state.initial_A = state.future_A = 2000;
+
+    // An odd count leaves the last SIMD block half full
+    std::vector<StableSwapMath::Real> amounts;
+    for (int k = 0; k < 301; ++k)
+        amounts.push_back(1e6L * std::pow(1.04L, k));
+    std::vector<StableSwapMath::Real> batch = StableSwapMath::getDyBatch(state, 0, 1, amounts, 0);
+    tf.assert_equal("One Output Per Amount", amounts.size(), batch.size());
+
+    bool agrees = true;
+    for (size_t k = 0; k < amounts.size(); ++k)
+    {
+        StableSwapMath::Real scalar = StableSwapMath::getDy(state, 0, 1, amounts[k], 0);
+        agrees = agrees && std::fabs(batch[k] - scalar) <= scalar * 1e-10L;
+    }
+    tf.assert_true("Batch Matches Scalar get_dy", agrees);
+    tf.assert_true("Batch Output Increasing", std::is_sorted(batch.begin(), batch.end()));
+
+    std::vector<StableSwapMath::Real> reverse = StableSwapMath::getDyBatch(state, 2, 0, {1e12L, 1e6L}, 0);
+    tf.assert_true("Other Direction Matches", std::fabs(reverse[0] - StableSwapMath::getDy(state, 2, 0, 1e12L, 0)) < 1e12L * 1e-10L &&
+                                                  std::fabs(reverse[1] - StableSwapMath::getDy(state, 2, 0, 1e6L, 0)) < 1.0L);
+    // The solver's error is absolute: even a few-wei output stays within the balance tolerance
+    std::vector<StableSwapMath::Real> tiny = StableSwapMath::getDyBatch(state, 1, 0, {1e6L, 1e12L}, 0);
+    StableSwapMath::Real tolerance = static_cast<StableSwapMath::Real>(state.balances[0]) * StableSwapMath::BATCH_TOLERANCE;
+    tf.assert_true("Tiny Outputs Within Tolerance", std::fabs(tiny[0] - StableSwapMath::getDy(state, 1, 0, 1e6L, 0)) <= tolerance &&
+                                                        std::fabs(tiny[1] - StableSwapMath::getDy(state, 1, 0, 1e12L, 0)) <= tolerance);
+    tf.assert_true("Empty Batch", StableSwapMath::getDyBatch(state, 0, 1, {}, 0).empty());
+    tf.assert_true("Same Coin Quotes Nothing", StableSwapMath::getDyBatch(state, 1, 1, {1e18L}, 0)[0] == 0);
+}
+
+void test_curve_selectors(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Curve Call Selectors" << std::endl;
+
+    tf.assert_equal("CryptoSwap Exchange Is uint256", Keccak::functionSelector("exchange(uint256,uint256,uint256,uint256)"),
+                    CurveSelectors::exchange(true, false));
+    tf.assert_equal("StableSwap Exchange Is int128", Keccak::functionSelector("exchange(int128,int128,uint256,uint256)"),
+                    CurveSelectors::exchange(false, false));
+    tf.assert_equal("Underlying Exchange", Keccak::functionSelector("exchange_underlying(int128,int128,uint256,uint256)"),
+                    CurveSelectors::exchange(false, true));
+    tf.assert_equal("CryptoSwap Quote Is uint256", Keccak::functionSelector("get_dy(uint256,uint256,uint256)"),
+                    CurveSelectors::getDy(true, false));
+    tf.assert_equal("StableSwap Quote Is int128", Keccak::functionSelector("get_dy(int128,int128,uint256)"),
+                    CurveSelectors::getDy(false, false));
+    tf.assert_equal("Underlying Quote", Keccak::functionSelector("get_dy_underlying(int128,int128,uint256)"),
+                    CurveSelectors::getDy(false, true));
+}
+
+void test_metapool_math(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Local Metapool Pricing" << std::endl;
+
+    const PoolAmount E18 = 1000000000000000000ULL;
+    const PoolAmount E6 = 1000000;
+    auto within = [](MetapoolMath::Real local, MetapoolMath::Real recorded)
+    { return std::fabs(local - recorded) <= MetapoolMath::uncertainty(recorded); };
+
+    // A metapool (18-decimal coin, A 200, 4 bps) on a 3pool-like base (DAI / USDC / USDT);
+    // recorded values are get_dy_underlying from an integer port of both contracts
+    MetapoolState pool;
+    pool.base.state.balances = {180000000 * E18, 150000000 * E6, 120000000 * E6};
+    pool.base.state.rates = {1, 1000000000000ULL, 1000000000000ULL};
+    pool.base.state.initial_A = pool.base.state.future_A = 2000;
+    pool.base.state.fee = 1000000;
+    pool.base.supply = 440000000 * E18;
+    pool.base.virtual_price = 1022720174200938586ULL;
+    pool.meta.balances = {40000000 * E18, 35000000 * E18};
+    pool.meta.rates = {1, 1};
+    pool.meta.initial_A = pool.meta.future_A = 200;
+    pool.meta.fee = 4000000;
+
+    tf.assert_true("Coin To DAI Matches", within(MetapoolMath::getDyUnderlying(pool, 0, 1, 1000e18L), 999093514670251531305.0L));
+    tf.assert_true("Coin To USDC Matches", within(MetapoolMath::getDyUnderlying(pool, 0, 2, 250000e18L), 249742064478.0L));
+    tf.assert_true("Large Coin To USDT Matches", within(MetapoolMath::getDyUnderlying(pool, 0, 3, 5000000e18L), 4990790380495.0L));
+    tf.assert_true("DAI To Coin Matches", within(MetapoolMath::getDyUnderlying(pool, 1, 0, 1000e18L), 1000011462483543478680.0L));
+    tf.assert_true("USDC To Coin Matches", within(MetapoolMath::getDyUnderlying(pool, 2, 0, 500000e6L), 500015551059610418053090.0L));
+    tf.assert_true("USDT To Coin Matches", within(MetapoolMath::getDyUnderlying(pool, 3, 0, 2000000e6L), 1999919055849574012359093.0L));
+    tf.assert_true("Base Pair Uses Base get_dy", within(MetapoolMath::getDyUnderlying(pool, 2, 3, 100000e6L), 99976943756.0L));
+    tf.assert_true("calc_withdraw_one_coin Matches", within(MetapoolMath::calcWithdrawOneCoin(pool.base, 1e24L, 1, 0), 1022674921935.0L));
+    tf.assert_true("calc_token_amount Matches", within(MetapoolMath::calcTokenAmount(pool.base, {1e21L, 0, 0}, 0), 977692946923816197287.0L));
+
+    // The metapool's stored virtual price stands until it is BASE_CACHE_EXPIRES old
+    pool.cached_virtual_price = 1020000000000000000ULL;
+    pool.cache_updated = 1000000;
+    pool.timestamp = pool.cache_updated + MetapoolState::BASE_CACHE_EXPIRES;
+    tf.assert_true("Fresh Cache Prices The LP", pool.virtualPrice() == pool.cached_virtual_price);
+    MetapoolMath::Real cached_quote = MetapoolMath::getDyUnderlying(pool, 0, 1, 1000e18L);
+    pool.timestamp++;
+    tf.assert_true("Stale Cache Asks The Base Pool", pool.virtualPrice() == pool.base.virtual_price);
+    tf.assert_true("Cheaper LP Buys More DAI", cached_quote > MetapoolMath::getDyUnderlying(pool, 0, 1, 1000e18L));
+
+    tf.assert_true("Same Coin Quotes Nothing", MetapoolMath::getDyUnderlying(pool, 2, 2, 1e6L) == 0);
+    tf.assert_true("Unknown Coin Quotes Nothing", MetapoolMath::getDyUnderlying(pool, 0, 4, 1e18L) == 0);
+}
+
+void test_swap_simulator(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Swap Pre-flight Simulation" << std::endl;
+
+    using Layout = SwapSimulator::MappingLayout;
+    const std::string zero = "0x0000000000000000000000000000000000000000";
+
+    // mapping[address(0)] at slot 0 in Solidity is keccak of 64 zero bytes
+    tf.assert_equal("Solidity Mapping Key",
+                    std::string("0xad3228b676f7d3cd4284a5443f17f1962b36e491b30a40b2405849e597ba5fb5"),
+                    SwapSimulator::balanceKey(zero, 0, Layout::SOLIDITY));
+    std::string owner = "0x00000000000000000000000000000000000000A1";
+    std::string spender = "0x00000000000000000000000000000000000000b2";
+    tf.assert_true("Vyper Key Order Differs",
+                   SwapSimulator::balanceKey(owner, 2, Layout::SOLIDITY) != SwapSimulator::balanceKey(owner, 2, Layout::VYPER));
+    tf.assert_equal("Nested Allowance Key",
+                    SwapSimulator::mappingKey(spender, SwapSimulator::mappingKey(owner, SwapSimulator::wordHex(3), Layout::VYPER), Layout::VYPER),
+                    SwapSimulator::allowanceKey(owner, spender, 3, Layout::VYPER));
+    tf.assert_equal("Address Word", std::string("0x00000000000000000000000000000000000000000000000000000000000000a1"),
+                    SwapSimulator::wordHex(owner));
+
+    // A token keeping balances at Solidity slot 9 and allowances at slot 10 (FiatToken's layout),
+    // and a pool that returns 0.999 dx when both are in place and reverts otherwise
+    const std::string token = "0x00000000000000000000000000000000000000c3";
+    const std::string pool = "0x00000000000000000000000000000000000000d4";
+    const std::string sender = "0x00000000000000000000000000000000000000e5";
+    std::string balance_key = SwapSimulator::balanceKey(sender, 9, Layout::SOLIDITY);
+    std::string allowance_key = SwapSimulator::allowanceKey(sender, pool, 10, Layout::SOLIDITY);
+    int round_trips = 0;
+    SwapSimulator simulator(
+        [&](const std::vector<SwapSimulator::Call> &calls)
+        {
+            round_trips++;
+            std::vector<SwapSimulator::CallResult> results;
+            for (const auto &call : calls)
+            {
+                SwapSimulator::CallResult result;
+                auto diff = call.state_diff.find(token);
+                auto read = [&](const std::string &key)
+                {
+                    if (diff == call.state_diff.end() || !diff->second.count(key))
+                        return std::string();
+                    return diff->second.at(key);
+                };
+                if (call.to == token)
+                {
+                    std::string value = read(call.data.rfind("0x70a08231", 0) == 0 ? balance_key : allowance_key);
+                    result.ok = true;
+                    result.output = value.empty() ? SwapSimulator::wordHex(0) : value;
+                }
+                else if (read(balance_key).empty() || read(allowance_key).empty())
+                {
+                    result.error = "execution reverted: insufficient balance";
+                }
+                else
+                {
+                    uint64_t dx = std::stoull(read(balance_key).substr(50), nullptr, 16);
+                    result.ok = true;
+                    result.output = SwapSimulator::wordHex(dx - dx / 1000);
+                }
+                results.push_back(result);
+            }
+            return results;
+        },
+        sender);
+
+    std::vector<SwapSimulator::Swap> swaps{{pool, token, "0x394747c5", 1000000, 990000},
+                                           {pool, token, "0x394747c5", 2000000, 1999000}};
+    auto outcomes = simulator.simulate(swaps);
+    tf.assert_equal("Probe Then Simulate", 2, round_trips);
+    tf.assert_true("Slots Overridden", outcomes[0].overridden && outcomes[1].overridden);
+    tf.assert_true("Passing Swap Clears", outcomes[0].passed && outcomes[0].has_output && outcomes[0].output == 999000);
+    tf.assert_true("Output Under Min Dy Stopped", !outcomes[1].passed && outcomes[1].output == 1998000);
+
+    outcomes = simulator.simulate({{pool, token, "0x394747c5", 500000, 499000}});
+    tf.assert_equal("Layout Cached", 3, round_trips);
+    tf.assert_true("Cached Layout Passes", outcomes[0].passed);
+    tf.assert_equal("Simulated Count", static_cast<uint64_t>(3), simulator.simulatedCount());
+    tf.assert_equal("Rejected Count", static_cast<uint64_t>(1), simulator.rejectedCount());
+
+    // A token the probe can't read (rebasing, proxied storage) simulates against real balances
+    outcomes = simulator.simulate({{pool, "0x00000000000000000000000000000000000000f6", "0x394747c5", 1000, 0}});
+    tf.assert_true("Unknown Layout Not Overridden", !outcomes[0].overridden);
+    tf.assert_true("Revert Reported", !outcomes[0].passed && outcomes[0].error.find("reverted") != std::string::npos);
+    tf.assert_equal("Tokens Probed", static_cast<uint64_t>(2), simulator.probedTokens());
+}
+
+void test_rpc_deadline(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing RPC Deadline Propagation" << std::endl;
+
+    using namespace std::chrono;
+    tf.assert_false("No Deadline By Default", RpcDeadline::expired());
+    tf.assert_equal("Default Call Budget", RpcDeadline::DEFAULT_CALL_MS, RpcDeadline::budgetMs());
+    tf.assert_true("Immediate TIFs Get Tighter Budgets",
+                   rpcBudgetForTif(TimeInForce::IOC) < rpcBudgetForTif(TimeInForce::GTC) &&
+                       rpcBudgetForTif(TimeInForce::FOK) == rpcBudgetForTif(TimeInForce::IOC));
+
+    {
+        RpcDeadline::Scope order(milliseconds(2000));
+        int budget = RpcDeadline::budgetMs();
+        tf.assert_true("Budget Bounded By Deadline", budget > 0 && budget <= 2000);
+        {
+            RpcDeadline::Scope looser(milliseconds(60000));
+            tf.assert_true("Inner Scope Cannot Loosen", RpcDeadline::budgetMs() <= 2000);
+            RpcDeadline::Scope tighter(milliseconds(50));
+            tf.assert_true("Inner Scope Tightens", RpcDeadline::budgetMs() <= 50);
+        }
+        tf.assert_true("Outer Deadline Restored", RpcDeadline::budgetMs() > 50);
+
+        bool other_thread_free = false;
+        std::thread([&]
+                    { other_thread_free = RpcDeadline::current() == RpcDeadline::Clock::time_point::max(); })
+            .join();
+        tf.assert_true("Deadline Is Per Thread", other_thread_free);
+    }
+    tf.assert_true("Deadline Cleared After Scope", RpcDeadline::current() == RpcDeadline::Clock::time_point::max());
+
+    bool refused = false;
+    {
+        RpcDeadline::Scope spent(RpcDeadline::Clock::now() - milliseconds(1));
+        tf.assert_true("Passed Deadline Expired", RpcDeadline::expired());
+        try
+        {
+            RpcDeadline::budgetMs();
+        }
+        catch (const DeadlineExceeded &)
+        {
+            refused = true;
+        }
+    }
+    tf.assert_true("Nothing Sent After Deadline", refused);
+
+    // A hung endpoint: the request gives up at its own budget instead of the transport's 10 s
+    LocalRpcServer slow([](const std::string &body)
+                        {
+        std::this_thread::sleep_for(milliseconds(400));
+        return LocalRpcServer::echoIdReply(body, "0x1"); });
+    HttpTransport transport(slow.url());
+    auto started = steady_clock::now();
+    bool timed_out = false;
+    try
+    {
+        transport.post(R"({"jsonrpc":"2.0","method":"eth_blockNumber","params":[],"id":1})", 50);
+    }
+    catch (const std::exception &)
+    {
+        timed_out = true;
+    }
+    tf.assert_true("Per-Call Timeout Honoured", timed_out && steady_clock::now() - started < milliseconds(350));
+
+    // A follower with a tighter deadline than the leader stops waiting on it
+    SingleFlight<std::string> flights;
+    bool leader = false;
+    auto flight = flights.join("eth_call:slow", leader);
+    bool gave_up = false;
+    try
+    {
+        SingleFlight<std::string>::wait(flight, steady_clock::now() + milliseconds(20));
+    }
+    catch (const std::runtime_error &)
+    {
+        gave_up = true;
+    }
+    tf.assert_true("Follower Gives Up At Its Deadline", gave_up);
+    flights.complete("eth_call:slow", flight, "0x1");
+}
+
+void test_retry_policy_and_breaker(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Retry Policy and Circuit Breaker" << std::endl;
+
+    using namespace std::chrono;
+    tf.assert_true("Refused Connection Is Transport", RetryPolicy::classify("CURL request failed: Couldn't connect to server") == RpcErrorClass::TRANSPORT);
+    tf.assert_true("HTTP 429 Is Rate Limited", RetryPolicy::classify("HTTP 429 from RPC endpoint") == RpcErrorClass::RATE_LIMITED);
+    tf.assert_true("HTTP 503 Is Server", RetryPolicy::classify("HTTP 503 from RPC endpoint") == RpcErrorClass::SERVER);
+    tf.assert_true("HTTP 400 Is Rejected", RetryPolicy::classify("HTTP 400 from RPC endpoint") == RpcErrorClass::REJECTED);
+    tf.assert_true("Revert Is Rejected", RetryPolicy::classify("RPC Error: execution reverted") == RpcErrorClass::REJECTED);
+    tf.assert_true("Deadline Is Final", RetryPolicy::classify("RPC deadline exceeded: timed out") == RpcErrorClass::DEADLINE);
+    tf.assert_true("Code -32005 Is Rate Limited", RetryPolicy::classifyCode(-32005, "limit exceeded") == RpcErrorClass::RATE_LIMITED);
+    tf.assert_true("Code -32603 Is Server", RetryPolicy::classifyCode(-32603, "internal error") == RpcErrorClass::SERVER);
+    tf.assert_true("Code 3 Is Rejected", RetryPolicy::classifyCode(3, "execution reverted") == RpcErrorClass::REJECTED);
+    tf.assert_false("Rejections Not Retried", RetryPolicy::retryable(RpcErrorClass::REJECTED));
+    tf.assert_false("Rate Limits Spare The Breaker", RetryPolicy::countsAgainstProvider(RpcErrorClass::RATE_LIMITED));
+    tf.assert_true("Transport Retried Then Given Up", RetryPolicy::shouldRetry(RpcErrorClass::TRANSPORT, 1) &&
+                                                          !RetryPolicy::shouldRetry(RpcErrorClass::TRANSPORT, 3));
+
+    bool bounded = true;
+    for (int k = 0; k < 200; ++k)
+    {
+        bounded = bounded && RetryPolicy::jittered(milliseconds(100), milliseconds(2000), 3) <= milliseconds(400) &&
+                  RetryPolicy::jittered(milliseconds(100), milliseconds(2000), 30) <= milliseconds(2000);
+    }
+    tf.assert_true("Jitter Within Exponential Ceiling And Cap", bounded);
+
+    using State = CircuitBreaker::State;
+    using Admission = CircuitBreaker::Admission;
+    CircuitBreaker breaker("test://provider", milliseconds(50), milliseconds(400));
+    std::vector<std::pair<State, State>> events;
+    breaker.subscribe([&](const std::string &, State from, State to)
+                      { events.push_back({from, to}); });
+
+    for (int k = 0; k + 1 < CircuitBreaker::FAILURE_THRESHOLD; ++k)
+        breaker.record(breaker.admit(), false);
+    breaker.record(breaker.admit(), true);
+    tf.assert_true("Success Resets Failure Streak", breaker.currentState() == State::CLOSED);
+    for (int k = 0; k < CircuitBreaker::FAILURE_THRESHOLD; ++k)
+        breaker.record(breaker.admit(), false);
+    tf.assert_true("Threshold Opens Circuit", breaker.currentState() == State::OPEN && breaker.refusing());
+    tf.assert_true("Open Circuit Denies", breaker.admit() == Admission::DENIED);
+
+    std::this_thread::sleep_for(milliseconds(70));
+    Admission probe = breaker.admit();
+    tf.assert_true("Cooldown Lets One Probe Through", probe == Admission::PROBE && breaker.currentState() == State::HALF_OPEN);
+    tf.assert_true("Second Probe Waits", breaker.admit() == Admission::DENIED);
+    breaker.record(probe, false);
+    tf.assert_true("Failed Probe Reopens", breaker.currentState() == State::OPEN);
+
+    std::this_thread::sleep_for(milliseconds(70));
+    tf.assert_true("Reopened Cooldown Doubles", breaker.refusing());
+    std::this_thread::sleep_for(milliseconds(50));
+    int probes = 0;
+    while (breaker.currentState() != State::CLOSED && probes < 20)
+    {
+        std::vector<Admission> window;
+        for (Admission admission = breaker.admit(); admission == Admission::PROBE; admission = breaker.admit())
+            window.push_back(admission);
+        for (Admission admission : window)
+            breaker.record(admission, true);
+        probes += static_cast<int>(window.size());
+    }
+    tf.assert_equal("Probe Windows Double Until Closed", CircuitBreaker::PROBES_TO_CLOSE, probes);
+    tf.assert_equal("Circuit Opened Twice", static_cast<uint64_t>(2), breaker.openCount());
+    tf.assert_true("Listener Saw Every Transition",
+                   events == std::vector<std::pair<State, State>>({{State::CLOSED, State::OPEN},
+                                                                   {State::OPEN, State::HALF_OPEN},
+                                                                   {State::HALF_OPEN, State::OPEN},
+                                                                   {State::OPEN, State::HALF_OPEN},
+                                                                   {State::HALF_OPEN, State::CLOSED}}));
+}
+
+void test_runtime_config(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Runtime Config" << std::endl;
+
+    std::string path = "/tmp/curve_agent_runtime_config_test.conf";
+    {
+        std::ofstream file(path);
+        file << "# agent settings\nUSE_MOCK_PRICING = 1\nEXECUTE_ONCHAIN=0\nRPC_URL=http://file-node\n";
+    }
+    RuntimeConfig::Values file = RuntimeConfig::readFile(path);
+    tf.assert_equal("File Values Trimmed", std::string("1"), file["USE_MOCK_PRICING"]);
+
+    std::vector<std::string> args = {"0xPool", "--config", path, "--execute-onchain=true", "1", "--rpc-url=http://cli-node"};
+    std::string config_path;
+    RuntimeConfig::Values options = RuntimeConfig::fromArgs(args, config_path);
+    tf.assert_equal("Config Path From CLI", path, config_path);
+    tf.assert_true("Positional Args Kept In Order", args == std::vector<std::string>({"0xPool", "1"}));
+
+    RuntimeSettings settings = RuntimeConfig::build(file, {{"RPC_URL", "http://env-node"}, {"BROADCAST_TX", "yes"}}, options);
+    tf.assert_true("File Flag Applied", settings.use_mock_pricing);
+    tf.assert_true("CLI Overrides File", settings.execute_onchain);
+    tf.assert_true("Environment Overrides File", settings.broadcast_tx);
+    tf.assert_equal("CLI Overrides Environment", std::string("http://cli-node"), settings.rpc_url);
+    tf.assert_false("Unset Flag Defaults Off", settings.skip_liquidity_check);
+
+    bool rejected = false;
+    try
+    {
+        RuntimeConfig::build({{"EXECUTE_ONCHAIN", "maybe"}}, {}, {});
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    tf.assert_true("Malformed Flag Rejected", rejected);
+
+    // Order, engine and provider settings come from the same layers
+    RuntimeSettings startup = RuntimeConfig::build({{"RPC_RATE_LIMIT", "25"}, {"WATCH_POOLS", "0xA, 0xB,,"}, {"TOKEN_IN_INDEX", "2"}},
+                                                   {{"LIMIT_PRICE", "1.5"}}, {{"ENGINE_SHARDS", "4"}});
+    tf.assert_true("Rate Limit Parsed", startup.rpc_rate_limit == 25.0 && startup.rpc_burst == 0.0);
+    tf.assert_true("Watch Pools Split", startup.watch_pools == std::vector<std::string>({"0xA", "0xB"}));
+    tf.assert_true("Index Set, Other Unset", startup.token_in_index == 2 && !startup.token_out_index);
+    tf.assert_true("Limit Price Parsed", startup.limit_price == 1.5);
+    tf.assert_equal("Shards Parsed", static_cast<size_t>(4), startup.engine_shards);
+    tf.assert_equal("TWAP Slices Default", static_cast<uint32_t>(5), startup.twap_slices);
+    auto rejects = [](const RuntimeConfig::Values &file)
+    {
+        try
+        {
+            RuntimeConfig::build(file, {}, {});
+        }
+        catch (const std::invalid_argument &)
+        {
+            return true;
+        }
+        return false;
+    };
+    tf.assert_true("Malformed Number Rejected", rejects({{"ENGINE_SHARDS", "two"}}) && rejects({{"LIMIT_PRICE", "1.5x"}}));
+    tf.assert_true("Negative Index Rejected", rejects({{"TOKEN_IN_INDEX", "-1"}}));
+
+    // A reload applies flags only; startup-only values stay as the agent started with them
+    RuntimeSettings edited = RuntimeConfig::build({{"USE_MOCK_PRICING", "1"}, {"POOL_ADDRESS", "0xNew"}, {"RPC_RATE_LIMIT", "5"}}, {}, {});
+    RuntimeSettings reloaded = startup.withReloadable(edited);
+    tf.assert_true("Reload Applies Flag", reloaded.use_mock_pricing);
+    tf.assert_true("Reload Keeps Startup Values", reloaded.pool_address.empty() && reloaded.rpc_rate_limit == 25.0);
+    tf.assert_true("Flags Reloadable", RuntimeConfig::reloadable("EXECUTE_ONCHAIN"));
+    tf.assert_false("Pool Startup-Only", RuntimeConfig::reloadable("POOL_ADDRESS"));
+
+    std::vector<std::string> bad = {"--no-such-setting=1"};
+    rejected = false;
+    try
+    {
+        RuntimeConfig::fromArgs(bad, config_path);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    tf.assert_true("Unknown Option Rejected", rejected);
+
+    // Replaced by rename, as editors and deploy tools do
+    std::atomic<int> changes{0};
+    {
+        ConfigWatcher watcher(path, [&]
+                              { changes++; });
+        {
+            std::ofstream file(path + ".new");
+            file << "USE_MOCK_PRICING=0\n";
+        }
+        std::rename((path + ".new").c_str(), path.c_str());
+        for (int k = 0; k < 100 && changes == 0; ++k)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    tf.assert_true("Watcher Sees Replaced File", changes > 0);
+    tf.assert_equal("Replacement Read Back", std::string("0"), RuntimeConfig::readFile(path)["USE_MOCK_PRICING"]);
+    std::remove(path.c_str());
+}
+
+void test_nonce_allocator(TestFramework &tf)
+{
+    std::cout << "\n🧪 Testing Nonce Allocator" << std::endl;
+
+    NonceAllocator nonces;
+    uint64_t node_pending = 7;
+    auto pending = [&]
+    { return node_pending; };
+    auto fallback = []
+    { return static_cast<uint64_t>(42); };
+    auto unreachable = []() -> uint64_t
+    { throw std::runtime_error("node down"); };
+
+    // An approve and a swap signed before either is mined: the node still says 7 for both
+    tf.assert_equal("First Nonce From Node", static_cast<uint64_t>(7), nonces.acquire(pending, fallback));
+    tf.assert_equal("Unmined Nonce Not Reused", static_cast<uint64_t>(8), nonces.acquire(pending, fallback));
+
+    // A nonce signed but never sent is handed out again before any higher one
+    uint64_t unsent = nonces.acquire(pending, fallback);
+    uint64_t after = nonces.acquire(pending, fallback);
+    nonces.release(unsent);
+    tf.assert_equal("Released Nonce Reissued First", unsent, nonces.acquire(pending, fallback));
+    nonces.release(after);
+    tf.assert_equal("Last Nonce Rolled Back", after, nonces.acquire(pending, fallback));
+
+    node_pending = 20; // Sent from elsewhere meanwhile
+    tf.assert_equal("Node Count Wins When Ahead", static_cast<uint64_t>(20), nonces.acquire(pending, fallback));
+    tf.assert_equal("Local Count When Node Down", static_cast<uint64_t>(21), nonces.acquire(unreachable, fallback));
+
+    NonceAllocator cold;
+    tf.assert_equal("Fallback Before Node Answers", static_cast<uint64_t>(42), cold.acquire(unreachable, fallback));
+    tf.assert_equal("Fallback Count Advances", static_cast<uint64_t>(43), cold.acquire(unreachable, fallback));
+    tf.assert_equal("Node Replaces Guess", static_cast<uint64_t>(20), cold.acquire(pending, fallback));
+
+    std::vector<uint64_t> issued(64);
+    std::vector<std::thread> signers;
+    for (size_t t = 0; t < 4; ++t)
+        signers.emplace_back([&, t]
+                             {
+            for (size_t k = 0; k < 16; ++k)
+                issued[t * 16 + k] = nonces.acquire(pending, fallback); });
+    for (auto &signer : signers)
+        signer.join();
+    std::sort(issued.begin(), issued.end());
+    tf.assert_true("Concurrent Signers Never Share A Nonce",
+                   std::adjacent_find(issued.begin(), issued.end()) == issued.end() && issued.front() == 22);
+    tf.assert_true("One Allocator Per Wallet",
+                   &NonceAllocator::forWallet("0xABC") == &NonceAllocator::forWallet("0xabc"));
+}
+
 int main()
 {
     std::cout << "🧪 COMPREHENSIVE UNIT TEST SUITE" << std::endl;
@@ -282,6 +2132,33 @@ int main()
     test_transaction_signing(tf);
     test_price_check_recording(tf);
     test_partial_fill_logic(tf);
+    test_allowance_tracker(tf);
+    test_gas_oracle(tf);
+    test_gas_model(tf);
+    test_order_aggregation(tf);
+    test_sliced_orders(tf);
+    test_sharded_engine(tf);
+    test_work_stealing_executor(tf);
+    test_order_coroutines(tf);
+    test_http_transport(tf);
+    test_ipc_transport(tf);
+    test_ws_subscriber(tf);
+    test_pool_state(tf);
+    test_trigger_index(tf);
+    test_logs_bloom(tf);
+    test_rpc_scheduler(tf);
+    test_single_flight(tf);
+    test_poll_scheduler(tf);
+    test_impact_curve(tf);
+    test_cryptoswap_math(tf);
+    test_curve_selectors(tf);
+    test_stableswap_batch(tf);
+    test_metapool_math(tf);
+    test_swap_simulator(tf);
+    test_rpc_deadline(tf);
+    test_retry_policy_and_breaker(tf);
+    test_runtime_config(tf);
+    test_nonce_allocator(tf);
 
     // Print final results
     tf.print_summary();